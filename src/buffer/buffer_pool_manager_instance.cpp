@@ -51,13 +51,15 @@ BufferPoolManagerInstance::~BufferPoolManagerInstance() {
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
+  std::scoped_lock guard{latch_};
   // Make sure you call DiskManager::WritePage!
   class Page *page;
   try {
     frame_id_t frame_id = page_table_.at(page_id);
     page = &pages_[frame_id];
     if (page->IsDirty()) {
-      disk_manager_->WritePage(page_id, page->GetData());
+      WriteBack(page);
+      page->UnsetPageIsDirty();
       // printf("flush page %d: %s\n\n",page_id,page->GetData());
     }
     return true;
@@ -67,15 +69,14 @@ auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
+  std::scoped_lock guard{latch_};
   // You can do it!
   class Page *page;
   frame_id_t frame_id;
-  page_id_t page_id;
   for (auto &mapping : page_table_) {
-    page_id = mapping.first;
     frame_id = mapping.second;
     page = &pages_[frame_id];
-    disk_manager_->WritePage(page_id, page->GetData());
+    WriteBack(page);
     page->WPinLatch();
     page->UnsetPageIsDirty();
     page->WUnPinLatch();
@@ -83,6 +84,7 @@ void BufferPoolManagerInstance::FlushAllPgsImp() {
 }
 
 auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
+  std::scoped_lock guard{latch_};
   // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
@@ -101,7 +103,8 @@ auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
   page_table_.erase(page_id_tmp);
 
   if (page->IsDirty()) {
-    disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    WriteBack(page);
+    page->UnsetPageIsDirty();
   }
   page->ResetMemory();
 
@@ -119,11 +122,15 @@ auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
 }
 
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
+  std::scoped_lock guard{latch_};
   frame_id_t frame_id;
   class Page *page;
   try {
     frame_id = page_table_.at(page_id);
     page = &pages_[frame_id];
+    page->WPinLatch();
+    page->ModifyPinCount(1);
+    page->WUnPinLatch();
   } catch (const std::out_of_range &e) {
   
     frame_id = GetFrameID();
@@ -133,9 +140,11 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
 
     page = &pages_[frame_id];
     if (page->IsDirty()) {
-      disk_manager_->WritePage(page->GetPageId(), page->GetData());
+      WriteBack(page);
+      page->UnsetPageIsDirty();
     }
-
+    // The victim's old mapping must go, or a later fetch of that page would land on this frame.
+    page_table_.erase(page->GetPageId());
     page_table_.insert({page_id, frame_id});
 
     page->WLatch();
@@ -152,6 +161,7 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
+  std::scoped_lock guard{latch_};
   frame_id_t frame_id;
   class Page *page;
   try {
@@ -167,10 +177,13 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
     }
 
     if (page->IsDirty()) {
-      disk_manager_->WritePage(page_id, page->GetData());
+      WriteBack(page);
     }
     page->ResetMemory();
+    page->UnsetPageIsDirty();
+    page->SetPageId(INVALID_PAGE_ID);
     page_table_.erase(page_id);
+    replacer_->Pin(frame_id);
     free_list_.push_front(frame_id);
     return true;
   } catch (const std::out_of_range &e) {
@@ -180,6 +193,7 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  std::scoped_lock guard{latch_};
   frame_id_t frame_id;
   class Page *page;
   int pin_count;
@@ -204,6 +218,15 @@ auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) ->
   }
 }
 
+void BufferPoolManagerInstance::WriteBack(Page *page) {
+  // Write-ahead logging: the log records of the changes to a page reach the disk before the page does. A page other
+  // than a table page may hold anything where the LSN goes, which at worst flushes the log early.
+  if (enable_logging && log_manager_ != nullptr && page->GetLSN() > log_manager_->GetPersistentLSN()) {
+    log_manager_->Flush(page->GetLSN());
+  }
+  disk_manager_->WritePage(page->GetPageId(), page->GetData());
+}
+
 auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
   // next_page_id_latch_.lock();
   const page_id_t next_page_id = next_page_id_.fetch_add(num_instances_,std::memory_order_relaxed);
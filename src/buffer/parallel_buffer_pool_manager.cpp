@@ -44,9 +44,7 @@ auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
   // Fetch page for page_id from responsible BufferPoolManagerInstance
   Page *ret;
   BufferPoolManagerInstance *bpmi = GetBufferPoolManager(page_id);
-  bpmi->Latch();
   ret = bpmi->FetchPage(page_id);
-  bpmi->UnLatch();
 
   return ret;
 }
@@ -64,9 +62,7 @@ auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
   bool ret;
   BufferPoolManagerInstance *bpmi = GetBufferPoolManager(page_id);
 
-  bpmi->Latch();
   ret = bpmi->FlushPage(page_id);
-  bpmi->UnLatch();
 
   return ret;
 }
@@ -82,9 +78,7 @@ auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
 
   for (size_t i = 0; i < num_instances_; i++) {
     BufferPoolManagerInstance *bpmi = GetBufferPoolManager(i);
-    bpmi->Latch();
     ret = bpmi->NewPage(page_id);
-    bpmi->UnLatch();
     if (ret != nullptr) {
       break;
     }
@@ -96,18 +90,14 @@ auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
   // Delete page_id from responsible BufferPoolManagerInstance
   bool ret;
   BufferPoolManagerInstance *bpmi = GetBufferPoolManager(page_id);
-  bpmi->Latch();
   ret = bpmi->DeletePage(page_id);
-  bpmi->UnLatch();
   return ret;
 }
 
 void ParallelBufferPoolManager::FlushAllPgsImp() {
   for (size_t i = 0; i < num_instances_; i++) {
     BufferPoolManagerInstance *bpmi = GetBufferPoolManager(i);
-    bpmi->Latch();
     bpmi->FlushAllPages();
-    bpmi->UnLatch();
   }
   // flush all pages from all BufferPoolManagerInstances
 }
@@ -0,0 +1,176 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_pool.cpp
+//
+// Identification: src/common/thread_pool.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/thread_pool.h"
+
+#include <utility>
+
+namespace bustub {
+
+namespace {
+/** The pool the calling thread works for, and its index there */
+thread_local const ThreadPool *current_pool = nullptr;
+thread_local size_t current_index = 0;
+}  // namespace
+
+ThreadPool::ThreadPool(size_t num_threads) {
+  BUSTUB_ASSERT(num_threads > 0, "A thread pool needs at least one thread.");
+  for (size_t i = 0; i < num_threads; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::scoped_lock lock(sleep_latch_);
+    stop_ = true;
+  }
+  wakeup_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  size_t index = GetWorkerIndex();
+  if (index == workers_.size()) {
+    index = next_worker_++ % workers_.size();
+  }
+  // Count the task before it becomes visible, so queued_ never drops below the tasks a worker could take.
+  queued_++;
+  {
+    std::scoped_lock lock(workers_[index]->latch_);
+    workers_[index]->tasks_.push_back(std::move(task));
+  }
+  // Taking sleep_latch_ orders this wakeup after a worker that saw queued_ == 0 went to sleep.
+  { std::scoped_lock lock(sleep_latch_); }
+  wakeup_.notify_one();
+}
+
+auto ThreadPool::GetWorkerIndex() const -> size_t { return current_pool == this ? current_index : workers_.size(); }
+
+auto ThreadPool::Take(size_t self, std::function<void()> *task) -> bool {
+  if (queued_ == 0) {
+    return false;
+  }
+  if (self < workers_.size()) {
+    Worker &own = *workers_[self];
+    std::scoped_lock lock(own.latch_);
+    if (!own.tasks_.empty()) {
+      *task = std::move(own.tasks_.back());
+      own.tasks_.pop_back();
+      queued_--;
+      return true;
+    }
+  }
+  for (size_t i = 1; i <= workers_.size(); i++) {
+    Worker &victim = *workers_[(self + i) % workers_.size()];
+    std::scoped_lock lock(victim.latch_);
+    if (!victim.tasks_.empty()) {
+      *task = std::move(victim.tasks_.front());
+      victim.tasks_.pop_front();
+      queued_--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+  current_pool = this;
+  current_index = index;
+  std::function<void()> task;
+  while (true) {
+    if (Take(index, &task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_latch_);
+    if (queued_ > 0) {
+      continue;
+    }
+    if (stop_) {
+      return;
+    }
+    wakeup_.wait(lock, [&] { return queued_ > 0 || stop_; });
+  }
+}
+
+TaskGroup::~TaskGroup() {
+  try {
+    Wait();
+  } catch (...) {
+  }
+}
+
+void TaskGroup::Submit(std::function<void()> task) {
+  {
+    std::scoped_lock lock(state_->latch_);
+    state_->tasks_.push_back(std::move(task));
+    state_->pending_++;
+  }
+  state_->changed_.notify_all();
+  // The task may already have been run by a waiting thread when this one gets to it.
+  pool_->Submit([state = state_] {
+    std::unique_lock<std::mutex> lock(state->latch_);
+    state->RunQueued(&lock);
+  });
+}
+
+auto TaskGroup::State::RunQueued(std::unique_lock<std::mutex> *lock) -> bool {
+  if (tasks_.empty()) {
+    return false;
+  }
+  std::function<void()> task = std::move(tasks_.front());
+  tasks_.pop_front();
+  lock->unlock();
+  std::exception_ptr error;
+  try {
+    task();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  task = nullptr;
+  lock->lock();
+  if (error && !error_) {
+    error_ = error;
+  }
+  pending_--;
+  changed_.notify_all();
+  return true;
+}
+
+void TaskGroup::WaitBelow(size_t max_pending) {
+  std::unique_lock<std::mutex> lock(state_->latch_);
+  while (state_->pending_ > max_pending) {
+    if (!state_->RunQueued(&lock)) {
+      // The remaining tasks are running, wait for one to finish or to queue another.
+      state_->changed_.wait(lock);
+    }
+  }
+}
+
+void TaskGroup::Wait() {
+  WaitBelow(0);
+  std::scoped_lock lock(state_->latch_);
+  if (state_->error_) {
+    std::exception_ptr error = state_->error_;
+    state_->error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace bustub
@@ -14,178 +14,521 @@
 
 #include <utility>
 #include <vector>
-// #include <mutex>
+
 namespace bustub {
 
-auto LockManager::LockShared(Transaction *txn, const RID &rid) -> bool {
-  std::unique_lock<std::mutex> lock_(latch_);
-  if(ValidateTxnBeforeLock(txn)==false){
-    return false;
+LockManager::LockManager(DeadlockPolicy policy, size_t escalation_threshold)
+    : policy_(policy), escalation_threshold_(escalation_threshold) {
+  if (policy_ == DeadlockPolicy::DETECTION) {
+    enable_cycle_detection_ = true;
+    cycle_detection_thread_ = std::thread(&LockManager::RunCycleDetection, this);
   }
+}
 
-  IsolationLevel policy=txn->GetIsolationLevel();
-  if(policy==IsolationLevel::READ_UNCOMMITTED) {
-    throw TransactionAbortException(txn->GetTransactionId(),AbortReason::LOCKSHARED_ON_READ_UNCOMMITTED);
-  }
-  txn_id_t tid=txn->GetTransactionId();
-  auto lock_table_elem=lock_table_.find(rid);
-  LockRequestQueue* lock_request_queue;
-
-  if(lock_table_elem!=lock_table_.end()){
-    lock_request_queue=&lock_table_elem->second;
-    auto reqeust_queue=lock_request_queue->request_queue_;
-    reqeust_queue.emplace_back(tid,LockMode::SHARED);
-
-    size_t i;
-    size_t cur_q_size=reqeust_queue.size();
-    for(i=0;i<cur_q_size-1; i++) {
-      LockRequest* lock_request=&reqeust_queue[i];
-      // if(lock_request->txn_id_==tid){
-      //   lock_request->granted_=true;
-      //   break;
-      // }
-      if(lock_request->lock_mode_==LockMode::EXCLUSIVE){
-        if(lock_request->txn_id_>tid) {
-          lock_request->granted_=false;
-          Transaction* invalid_txn=txn_table_.find(lock_request->txn_id_)->second;
-          invalid_txn->SetState(TransactionState::ABORTED);
-        }else{
-          // ?
-          lock_request_queue->cv_.wait(lock_,[&] {
-                                    return lock_request->granted_==false;});
-        
-        }
-      }
+LockManager::~LockManager() {
+  if (cycle_detection_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> latch(cycle_detection_latch_);
+      enable_cycle_detection_ = false;
     }
-    reqeust_queue[i].granted_=true;
-  }else{
-    lock_table_.emplace(std::piecewise_construct, std::forward_as_tuple(rid), std::forward_as_tuple());
-    lock_table_elem=lock_table_.find(rid);
-    lock_request_queue=&lock_table_elem->second;
-    // LockRequest lock_request(tid,LockMode::SHARED,true);
-  
-    // lock_request_queue->request_queue_.push_back(lock_request); //error point
-    lock_request_queue->request_queue_.emplace_back(tid,LockMode::SHARED,true);
-  }
-  IsItAborted(txn,lock_request_queue);
-  txn_table_.insert({tid,txn});
-  txn->GetSharedLockSet()->emplace(rid);
+    cycle_detection_cv_.notify_all();
+    cycle_detection_thread_.join();
+  }
+}
+
+auto LockManager::AreCompatible(LockMode a, LockMode b) -> bool {
+  // Indexed by INTENTION_SHARED, INTENTION_EXCLUSIVE, SHARED, SHARED_INTENTION_EXCLUSIVE, EXCLUSIVE.
+  static constexpr bool COMPATIBLE[5][5] = {{true, true, true, true, false},
+                                            {true, true, false, false, false},
+                                            {true, false, true, false, false},
+                                            {true, false, false, false, false},
+                                            {false, false, false, false, false}};
+  return COMPATIBLE[static_cast<int>(a)][static_cast<int>(b)];
+}
+
+auto LockManager::Combine(LockMode held, LockMode requested) -> LockMode {
+  if (held == requested) {
+    return held;
+  }
+  if (held == LockMode::EXCLUSIVE || requested == LockMode::EXCLUSIVE) {
+    return LockMode::EXCLUSIVE;
+  }
+  if (held == LockMode::INTENTION_SHARED) {
+    return requested;
+  }
+  if (requested == LockMode::INTENTION_SHARED) {
+    return held;
+  }
+  // Two different modes out of INTENTION_EXCLUSIVE, SHARED and SHARED_INTENTION_EXCLUSIVE.
+  return LockMode::SHARED_INTENTION_EXCLUSIVE;
+}
+
+auto LockManager::ValidateTxnBeforeLock(Transaction *txn, LockMode lock_mode) -> bool {
+  TransactionState state = txn->GetState();
+  if (state == TransactionState::ABORTED) {
+    return false;
+  }
+  if (state == TransactionState::SHRINKING) {
+    txn->SetState(TransactionState::ABORTED);
+    throw TransactionAbortException(txn->GetTransactionId(), AbortReason::LOCK_ON_SHRINKING);
+  }
+  if (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED &&
+      (lock_mode == LockMode::SHARED || lock_mode == LockMode::INTENTION_SHARED ||
+       lock_mode == LockMode::SHARED_INTENTION_EXCLUSIVE)) {
+    txn->SetState(TransactionState::ABORTED);
+    throw TransactionAbortException(txn->GetTransactionId(), AbortReason::LOCKSHARED_ON_READ_UNCOMMITTED);
+  }
   return true;
 }
 
-auto LockManager::LockExclusive(Transaction *txn, const RID &rid) -> bool {
-  std::unique_lock<std::mutex> lock_(latch_);
-  if(ValidateTxnBeforeLock(txn)==false){
+auto LockManager::LockShared(Transaction *txn, const RID &rid, table_oid_t table_oid) -> bool {
+  return LockRow(txn, LockMode::SHARED, rid, table_oid);
+}
+
+auto LockManager::LockExclusive(Transaction *txn, const RID &rid, table_oid_t table_oid) -> bool {
+  return LockRow(txn, LockMode::EXCLUSIVE, rid, table_oid);
+}
+
+auto LockManager::LockUpgrade(Transaction *txn, const RID &rid, table_oid_t table_oid) -> bool {
+  // The shared request of the transaction is upgraded in place, see Acquire.
+  return LockRow(txn, LockMode::EXCLUSIVE, rid, table_oid);
+}
+
+auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const RID &rid, table_oid_t table_oid) -> bool {
+  if (!ValidateTxnBeforeLock(txn, lock_mode)) {
     return false;
   }
-  size_t i;
-  txn_id_t tid=txn->GetTransactionId();
-  auto lock_table_elem=lock_table_.find(rid);
-  LockRequestQueue* lock_request_queue;
-  if(lock_table_elem!=lock_table_.end()){
-    lock_request_queue=&lock_table_elem->second;
-    auto reqeust_queue=lock_request_queue->request_queue_;
-    reqeust_queue.push_back(LockRequest(tid,LockMode::EXCLUSIVE));
-
-    size_t cur_q_size=reqeust_queue.size();
-    for(i=0;i<cur_q_size-1;i++){
-      LockRequest* lock_request=&reqeust_queue[i];
-
-      if(lock_request->txn_id_>tid&&lock_request->granted_==true) {
-        lock_request->granted_=false;
-        Transaction* invalid_txn=txn_table_.find(lock_request->txn_id_)->second;
-        invalid_txn->SetState(TransactionState::ABORTED);
-      }else{
-         lock_request_queue->cv_.wait(lock_,[&] {
-                                    return lock_request->granted_==false;});
+
+  if (table_oid != INVALID_TABLE_OID) {
+    // A lock on the table may cover the row already. Otherwise announce the row lock on the table.
+    auto table_locks = txn->GetTableLockSet();
+    auto held = table_locks->find(table_oid);
+    if (held != table_locks->end() && Combine(held->second, lock_mode) == held->second) {
+      RecordRow(txn, lock_mode, rid);
+      return true;
+    }
+    LockMode intention = lock_mode == LockMode::SHARED ? LockMode::INTENTION_SHARED : LockMode::INTENTION_EXCLUSIVE;
+    if ((held == table_locks->end() || Combine(held->second, intention) != held->second) &&
+        !AcquireTable(txn, intention, table_oid)) {
+      return false;
+    }
+    // Past the threshold, lock the whole table in the mode of the strongest row lock instead.
+    auto txn_rows = txn->GetTableRowLockSet();
+    auto rows = txn_rows->find(table_oid);
+    if (rows != txn_rows->end() && rows->second.size() >= escalation_threshold_) {
+      LockMode current = table_locks->at(table_oid);
+      bool writes = lock_mode == LockMode::EXCLUSIVE || current == LockMode::INTENTION_EXCLUSIVE ||
+                    current == LockMode::SHARED_INTENTION_EXCLUSIVE;
+      if (!AcquireTable(txn, writes ? LockMode::EXCLUSIVE : LockMode::SHARED, table_oid)) {
+        return false;
       }
+      Escalate(txn, table_oid);
+      RecordRow(txn, lock_mode, rid);
+      return true;
     }
-    reqeust_queue[i].granted_=true;
-  }else{
-    lock_table_.emplace(std::piecewise_construct, std::forward_as_tuple(rid), std::forward_as_tuple());
-    lock_table_elem=lock_table_.find(rid);
-    lock_request_queue=&lock_table_elem->second;
-    // LockRequest lock_request(tid,LockMode::EXCLUSIVE,true);
-    lock_request_queue->request_queue_.emplace_back(tid,LockMode::EXCLUSIVE,true);
-  }
-  IsItAborted(txn,lock_request_queue);
-  txn_table_.insert({tid,txn});
-  txn->GetExclusiveLockSet()->emplace(rid);
+  }
+
+  LockTablePartition<RID> *partition = RowPartition(rid);
+  LockRequestQueue *queue = Pin(partition, rid, true);
+  bool granted;
+  {
+    std::unique_lock<std::mutex> latch(queue->latch_);
+    granted = Acquire(txn, queue, lock_mode, table_oid, &latch);
+  }
+  Unpin(partition, rid, queue);
+  if (!granted) {
+    // A failed upgrade takes the shared lock with it.
+    ForgetRow(txn, table_oid, rid);
+    return false;
+  }
+  RecordRow(txn, lock_mode, rid);
+  if (table_oid != INVALID_TABLE_OID) {
+    (*txn->GetTableRowLockSet())[table_oid].emplace(rid);
+  }
   return true;
 }
 
-auto LockManager::LockUpgrade(Transaction *txn, const RID &rid) -> bool {
-  std::unique_lock<std::mutex> lock_(latch_);
-  if(ValidateTxnBeforeLock(txn)==false){
+void LockManager::RecordRow(Transaction *txn, LockMode lock_mode, const RID &rid) {
+  if (lock_mode == LockMode::EXCLUSIVE) {
+    txn->GetSharedLockSet()->erase(rid);
+    txn->GetExclusiveLockSet()->emplace(rid);
+  } else if (!txn->IsExclusiveLocked(rid)) {
+    txn->GetSharedLockSet()->emplace(rid);
+  }
+}
+
+auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, table_oid_t table_oid) -> bool {
+  if (!ValidateTxnBeforeLock(txn, lock_mode)) {
     return false;
   }
-  txn_id_t tid=txn->GetTransactionId();
-  auto lock_table_elem=lock_table_.find(rid);
-  LockRequestQueue* lock_request_queue;
-  LockRequest lock_request;
-  if(lock_table_elem!=lock_table_.end()){
-    lock_request_queue=&lock_table_elem->second;
-    auto reqeust_queue=lock_request_queue->request_queue_;
-
-    for(size_t i=0;i<reqeust_queue.size();i++) {
-      LockRequest* lock_request=&reqeust_queue[i];
-      if(lock_request->granted_==true){
-        if(lock_request->txn_id_==tid) {
-          if(lock_request->lock_mode_==LockMode::SHARED){
-            IsItAborted(txn,lock_request_queue);
-            lock_request->lock_mode_=LockMode::EXCLUSIVE;
-            txn->GetSharedLockSet()->erase(rid);
-            txn->GetExclusiveLockSet()->emplace(rid);
-            return true;
-          }else{
-            throw TransactionAbortException(tid,AbortReason::UPGRADE_CONFLICT);
-          }
-
-        }else if(lock_request->txn_id_>tid){
-          lock_request->granted_=false;
-          Transaction* invalid_txn=txn_table_.find(lock_request->txn_id_)->second;
-          invalid_txn->SetState(TransactionState::ABORTED);
-        }else {
-         lock_request_queue->cv_.wait(lock_,[&] {
-                                    return lock_request->granted_==false;});
-        }       
+  return AcquireTable(txn, lock_mode, table_oid);
+}
+
+auto LockManager::AcquireTable(Transaction *txn, LockMode lock_mode, table_oid_t table_oid) -> bool {
+  LockRequestQueue *queue = Pin(&table_partition_, table_oid, true);
+  bool granted;
+  {
+    std::unique_lock<std::mutex> latch(queue->latch_);
+    granted = Acquire(txn, queue, lock_mode, INVALID_TABLE_OID, &latch);
+  }
+  Unpin(&table_partition_, table_oid, queue);
+  if (!granted) {
+    return false;
+  }
+  auto table_locks = txn->GetTableLockSet();
+  auto held = table_locks->find(table_oid);
+  (*table_locks)[table_oid] = held == table_locks->end() ? lock_mode : Combine(held->second, lock_mode);
+  return true;
+}
+
+template <typename K>
+auto LockManager::Pin(LockTablePartition<K> *partition, const K &key, bool create) -> LockRequestQueue * {
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  LockRequestQueue *queue;
+  if (create) {
+    queue = &partition->queues_[key];
+  } else {
+    auto it = partition->queues_.find(key);
+    if (it == partition->queues_.end()) {
+      return nullptr;
+    }
+    queue = &it->second;
+  }
+  queue->users_++;
+  return queue;
+}
+
+template <typename K>
+void LockManager::Unpin(LockTablePartition<K> *partition, const K &key, LockRequestQueue *queue) {
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  // With no other user around nobody holds the latch of the queue.
+  if (--queue->users_ == 0 && queue->request_queue_.empty()) {
+    partition->queues_.erase(key);
+  }
+}
+
+auto LockManager::Acquire(Transaction *txn, LockRequestQueue *queue, LockMode lock_mode, table_oid_t table_oid,
+                          std::unique_lock<std::mutex> *latch) -> bool {
+  txn_id_t txn_id = txn->GetTransactionId();
+  auto &requests = queue->request_queue_;
+  auto request = std::find_if(requests.begin(), requests.end(),
+                              [txn_id](const LockRequest &request) { return request.txn_id_ == txn_id; });
+  if (request != requests.end()) {
+    // The transaction holds the resource already. An upgrade waits ahead of the requests not granted yet, for the
+    // other holders only.
+    LockMode combined = Combine(request->lock_mode_, lock_mode);
+    if (combined == request->lock_mode_) {
+      return true;
+    }
+    auto first_waiting = std::find_if(requests.begin(), requests.end(),
+                                      [](const LockRequest &request) { return !request.granted_; });
+    requests.splice(first_waiting, requests, request);
+    request->lock_mode_ = combined;
+    request->granted_ = false;
+    // The requests behind it may have to wound it.
+    queue->cv_.notify_all();
+  } else {
+    requests.emplace_back(txn, lock_mode, table_oid);
+    request = std::prev(requests.end());
+  }
+
+  Wound(queue, request, latch);
+  // The latch is let go of while registering, the request may have to wait again afterwards.
+  while (!IsGrantable(queue, request) && txn->GetState() != TransactionState::ABORTED) {
+    SetWaiting(txn, queue, latch);
+    // An abort is signalled under the latch of this queue, so it can't slip in between checking and waiting.
+    while (!IsGrantable(queue, request) && txn->GetState() != TransactionState::ABORTED) {
+      queue->cv_.wait(*latch);
+      Wound(queue, request, latch);
+    }
+    SetWaiting(txn, nullptr, latch);
+  }
+  if (!IsGrantable(queue, request)) {
+    // Aborted while waiting.
+    requests.erase(request);
+    queue->cv_.notify_all();
+    return false;
+  }
+  request->granted_ = true;
+  return true;
+}
+
+void LockManager::SetWaiting(Transaction *txn, LockRequestQueue *queue, std::unique_lock<std::mutex> *latch) {
+  latch->unlock();
+  {
+    std::lock_guard<std::mutex> waiting_latch(waiting_latch_);
+    if (queue != nullptr) {
+      waiting_[txn->GetTransactionId()] = {txn, queue};
+    } else {
+      waiting_.erase(txn->GetTransactionId());
+    }
+  }
+  latch->lock();
+}
+
+void LockManager::Wound(LockRequestQueue *queue, std::list<LockRequest>::iterator request,
+                        std::unique_lock<std::mutex> *latch) {
+  if (policy_ != DeadlockPolicy::WOUND_WAIT) {
+    return;
+  }
+  bool wounded = false;
+  for (auto it = queue->request_queue_.begin(); it != request; ++it) {
+    if (it->txn_id_ < request->txn_id_ || AreCompatible(it->lock_mode_, request->lock_mode_)) {
+      continue;
+    }
+    TransactionState state = it->txn_->GetState();
+    if (state != TransactionState::GROWING && state != TransactionState::SHRINKING) {
+      continue;
+    }
+    it->txn_->SetState(TransactionState::ABORTED);
+    deadlock_aborts_++;
+    wounded = true;
+  }
+  if (!wounded) {
+    return;
+  }
+  // The victims let go of their locks when they are aborted. Those waiting in this queue notice under its latch, the
+  // ones waiting elsewhere are woken up under the latch of their queue, which comes after waiting_latch_.
+  queue->cv_.notify_all();
+  latch->unlock();
+  {
+    std::lock_guard<std::mutex> waiting_latch(waiting_latch_);
+    for (auto &[txn_id, waiting] : waiting_) {
+      if (waiting.second != queue && waiting.first->GetState() == TransactionState::ABORTED) {
+        std::lock_guard<std::mutex> victim_latch(waiting.second->latch_);
+        waiting.second->cv_.notify_all();
       }
     }
-    
+  }
+  latch->lock();
+}
+
+void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) { waits_for_[t1].insert(t2); }
+
+void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {
+  auto edges = waits_for_.find(t1);
+  if (edges == waits_for_.end()) {
+    return;
+  }
+  edges->second.erase(t2);
+  if (edges->second.empty()) {
+    waits_for_.erase(edges);
+  }
+}
+
+auto LockManager::HasCycle(txn_id_t *txn_id) -> bool {
+  std::set<txn_id_t> visited;
+  for (const auto &[from, to] : waits_for_) {
+    std::vector<txn_id_t> path;
+    if (visited.count(from) == 0 && FindCycle(from, &path, &visited, txn_id)) {
+      return true;
+    }
   }
   return false;
 }
 
-auto LockManager::Unlock(Transaction *txn, const RID &rid) -> bool {
-  std::lock_guard<std::mutex> lock(latch_);
-  TransactionState tstate=txn->GetState();
-  
-  if(tstate==TransactionState::GROWING){
-    txn->SetState(TransactionState::SHRINKING);
+auto LockManager::FindCycle(txn_id_t txn_id, std::vector<txn_id_t> *path, std::set<txn_id_t> *visited,
+                            txn_id_t *victim) -> bool {
+  visited->insert(txn_id);
+  path->push_back(txn_id);
+  auto edges = waits_for_.find(txn_id);
+  if (edges != waits_for_.end()) {
+    for (txn_id_t next : edges->second) {
+      auto on_path = std::find(path->begin(), path->end(), next);
+      if (on_path != path->end()) {
+        *victim = *std::max_element(on_path, path->end());
+        return true;
+      }
+      // A transaction visited before and off the path leads to no cycle, or the cycle would have been found then.
+      if (visited->count(next) == 0 && FindCycle(next, path, visited, victim)) {
+        return true;
+      }
+    }
   }
+  path->pop_back();
+  return false;
+}
 
-  txn_id_t tid=txn->GetTransactionId();
-  LockRequestQueue* lock_request_queue;
-  LockRequest lock_request;
-  
-  auto lock_table_elem=lock_table_.find(rid);
-  if(lock_table_elem!=lock_table_.end()) {
-    lock_request_queue=&lock_table_elem->second;
-    auto reqeust_queue=lock_request_queue->request_queue_;
-    for(size_t i=0;i<reqeust_queue.size();i++) {
-      LockRequest* lock_request=&reqeust_queue[i];
-      if(lock_request->txn_id_==tid&&lock_request->granted_==true) {
-        lock_request->granted_=false;
-        txn->GetSharedLockSet()->erase(rid);
-        txn->GetExclusiveLockSet()->erase(rid);
-        break;
+auto LockManager::GetEdgeList() -> std::vector<std::pair<txn_id_t, txn_id_t>> {
+  std::vector<std::pair<txn_id_t, txn_id_t>> edges;
+  for (const auto &[from, to] : waits_for_) {
+    for (txn_id_t txn_id : to) {
+      edges.emplace_back(from, txn_id);
+    }
+  }
+  return edges;
+}
+
+void LockManager::BuildWaitsForGraph() {
+  auto add_queue = [this](LockRequestQueue *queue) {
+    std::lock_guard<std::mutex> latch(queue->latch_);
+    auto &requests = queue->request_queue_;
+    for (auto request = requests.begin(); request != requests.end(); ++request) {
+      if (request->granted_) {
+        continue;
       }
+      // A waiting request waits for the granted requests it conflicts with and for the waiting ones ahead of it, see
+      // IsGrantable.
+      bool ahead = true;
+      for (auto other = requests.begin(); other != requests.end(); ++other) {
+        if (other == request) {
+          ahead = false;
+        } else if (other->granted_ ? !AreCompatible(other->lock_mode_, request->lock_mode_) : ahead) {
+          AddEdge(request->txn_id_, other->txn_id_);
+        }
+      }
+    }
+  };
+  for (auto &partition : row_partitions_) {
+    std::lock_guard<std::mutex> latch(partition.latch_);
+    for (auto &[rid, queue] : partition.queues_) {
+      add_queue(&queue);
+    }
+  }
+  std::lock_guard<std::mutex> latch(table_partition_.latch_);
+  for (auto &[table_oid, queue] : table_partition_.queues_) {
+    add_queue(&queue);
+  }
+}
+
+void LockManager::RunCycleDetection() {
+  std::unique_lock<std::mutex> latch(cycle_detection_latch_);
+  while (enable_cycle_detection_) {
+    cycle_detection_cv_.wait_for(latch, cycle_detection_interval);
+    if (!enable_cycle_detection_) {
+      break;
+    }
+    std::lock_guard<std::mutex> waits_for_latch(waits_for_latch_);
+    BuildWaitsForGraph();
+    txn_id_t victim;
+    while (HasCycle(&victim)) {
+      // The victim is waiting, which keeps it alive while it is in waiting_. A victim gone from there got its lock,
+      // the cycle was not there anymore.
+      {
+        std::lock_guard<std::mutex> waiting_latch(waiting_latch_);
+        auto waiting = waiting_.find(victim);
+        if (waiting != waiting_.end() && waiting->second.first->GetState() != TransactionState::ABORTED) {
+          deadlocks_detected_++;
+          deadlock_aborts_++;
+          std::lock_guard<std::mutex> victim_latch(waiting->second.second->latch_);
+          waiting->second.first->SetState(TransactionState::ABORTED);
+          waiting->second.second->cv_.notify_all();
+        }
+      }
+      waits_for_.erase(victim);
+      for (auto &[from, to] : waits_for_) {
+        to.erase(victim);
+      }
+    }
+    waits_for_.clear();
+  }
+}
+
+auto LockManager::IsGrantable(LockRequestQueue *queue, std::list<LockRequest>::iterator request) -> bool {
+  bool ahead = true;
+  for (auto it = queue->request_queue_.begin(); it != queue->request_queue_.end(); ++it) {
+    if (it == request) {
+      ahead = false;
+      continue;
+    }
+    if (it->granted_ ? !AreCompatible(it->lock_mode_, request->lock_mode_) : ahead) {
+      return false;
     }
   }
-  // IsItAborted(txn,lock_request_queue);
-  txn->GetSharedLockSet()->erase(rid);
-  txn->GetExclusiveLockSet()->erase(rid);
   return true;
 }
 
+auto LockManager::Unlock(Transaction *txn, const RID &rid) -> bool {
+  if (txn->GetState() == TransactionState::GROWING) {
+    txn->SetState(TransactionState::SHRINKING);
+  }
+  // A row covered by a table lock has no request of its own.
+  bool held = txn->GetSharedLockSet()->erase(rid) + txn->GetExclusiveLockSet()->erase(rid) > 0;
+  return ReleaseRow(txn, rid) || held;
+}
+
+auto LockManager::UnlockTable(Transaction *txn, table_oid_t table_oid) -> bool {
+  txn_id_t txn_id = txn->GetTransactionId();
+  if (txn->GetTableRowLockSet()->count(table_oid) != 0) {
+    txn->SetState(TransactionState::ABORTED);
+    throw TransactionAbortException(txn_id, AbortReason::TABLE_UNLOCKED_BEFORE_UNLOCKING_ROWS);
+  }
+  if (txn->GetState() == TransactionState::GROWING) {
+    txn->SetState(TransactionState::SHRINKING);
+  }
+  txn->GetTableLockSet()->erase(table_oid);
+  LockRequestQueue *queue = Pin(&table_partition_, table_oid, false);
+  if (queue == nullptr) {
+    return false;
+  }
+  bool released = false;
+  {
+    std::lock_guard<std::mutex> latch(queue->latch_);
+    auto &requests = queue->request_queue_;
+    auto request = std::find_if(requests.begin(), requests.end(),
+                                [txn_id](const LockRequest &request) { return request.txn_id_ == txn_id; });
+    if (request != requests.end()) {
+      requests.erase(request);
+      queue->cv_.notify_all();
+      released = true;
+    }
+  }
+  Unpin(&table_partition_, table_oid, queue);
+  return released;
+}
+
+auto LockManager::ReleaseRow(Transaction *txn, const RID &rid) -> bool {
+  txn_id_t txn_id = txn->GetTransactionId();
+  LockTablePartition<RID> *partition = RowPartition(rid);
+  LockRequestQueue *queue = Pin(partition, rid, false);
+  if (queue == nullptr) {
+    return false;
+  }
+  table_oid_t table_oid = INVALID_TABLE_OID;
+  bool released = false;
+  {
+    std::lock_guard<std::mutex> latch(queue->latch_);
+    auto &requests = queue->request_queue_;
+    auto request = std::find_if(requests.begin(), requests.end(),
+                                [txn_id](const LockRequest &request) { return request.txn_id_ == txn_id; });
+    if (request != requests.end()) {
+      table_oid = request->table_oid_;
+      requests.erase(request);
+      queue->cv_.notify_all();
+      released = true;
+    }
+  }
+  Unpin(partition, rid, queue);
+
+  ForgetRow(txn, table_oid, rid);
+  return released;
+}
+
+void LockManager::ForgetRow(Transaction *txn, table_oid_t table_oid, const RID &rid) {
+  if (table_oid == INVALID_TABLE_OID) {
+    return;
+  }
+  auto txn_rows = txn->GetTableRowLockSet();
+  auto rows = txn_rows->find(table_oid);
+  if (rows == txn_rows->end()) {
+    return;
+  }
+  rows->second.erase(rid);
+  if (rows->second.empty()) {
+    txn_rows->erase(rows);
+  }
+}
+
+void LockManager::Escalate(Transaction *txn, table_oid_t table_oid) {
+  auto txn_rows = txn->GetTableRowLockSet();
+  auto rows = txn_rows->find(table_oid);
+  if (rows == txn_rows->end()) {
+    return;
+  }
+  std::vector<RID> released(rows->second.begin(), rows->second.end());
+  for (const RID &rid : released) {
+    ReleaseRow(txn, rid);
+  }
+}
+
 }  // namespace bustub
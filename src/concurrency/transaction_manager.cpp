@@ -14,6 +14,8 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "catalog/catalog.h"
 #include "storage/table/table_heap.h"
@@ -33,12 +35,39 @@ auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level)
   txn_map_mutex.lock();
   txn_map[txn->GetTransactionId()] = txn;
   txn_map_mutex.unlock();
+
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
+
+  // A snapshot sees every transaction that committed before it began, and none of those that commit after.
+  if (txn->GetIsolationLevel() == IsolationLevel::SNAPSHOT) {
+    std::scoped_lock latch(commit_latch_);
+    txn->SetReadTs(last_commit_ts_);
+    active_read_ts_.insert(last_commit_ts_);
+  }
   return txn;
 }
 
 void TransactionManager::Commit(Transaction *txn) {
   txn->SetState(TransactionState::COMMITTED);
 
+  // The versions the transaction wrote begin at its commit timestamp. This happens before its deletes are applied and
+  // its locks are released, the rows are not written again until then.
+  {
+    std::scoped_lock latch(commit_latch_);
+    UnregisterSnapshot(txn);
+    timestamp_t commit_ts = last_commit_ts_ + 1;
+    timestamp_t watermark = active_read_ts_.empty() ? commit_ts : *active_read_ts_.begin();
+    if (enable_logging) {
+      for (const auto &item : *txn->GetWriteSet()) {
+        item.table_->GetVersionStore()->Commit(item.rid_, txn, commit_ts, watermark);
+      }
+    }
+    last_commit_ts_ = commit_ts;
+  }
+
   // Perform all deletes before we commit.
   auto write_set = txn->GetWriteSet();
   while (!write_set->empty()) {
@@ -47,11 +76,22 @@ void TransactionManager::Commit(Transaction *txn) {
     if (item.wtype_ == WType::DELETE) {
       // Note that this also releases the lock when holding the page latch.
       table->ApplyDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::UPDATE) {
+      // The replaced version is gone for good, and with it the overflow pages only it pointed to.
+      table->FreeOverflow(item.tuple_);
     }
     write_set->pop_back();
   }
   write_set->clear();
 
+  // The transaction is durable once its COMMIT record is on disk. The committers waiting meanwhile share the write.
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetPrevLSN(lsn);
+    log_manager_->Flush(lsn);
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
@@ -62,20 +102,32 @@ void TransactionManager::Abort(Transaction *txn) {
   txn->SetState(TransactionState::ABORTED);
   // Rollback before releasing the lock.
   auto table_write_set = txn->GetWriteSet();
+  std::vector<std::pair<TableHeap *, RID>> rolled_back;
   while (!table_write_set->empty()) {
     auto &item = table_write_set->back();
     auto table = item.table_;
+    rolled_back.emplace_back(table, item.rid_);
     if (item.wtype_ == WType::DELETE) {
       table->RollbackDelete(item.rid_, txn);
     } else if (item.wtype_ == WType::INSERT) {
       // Note that this also releases the lock when holding the page latch.
       table->ApplyDelete(item.rid_, txn);
     } else if (item.wtype_ == WType::UPDATE) {
-      table->UpdateTuple(item.tuple_, item.rid_, txn);
+      table->RollbackUpdate(item.tuple_, item.rid_, txn);
     }
     table_write_set->pop_back();
   }
   table_write_set->clear();
+  // The heap is back to the versions the transaction recorded.
+  if (enable_logging) {
+    for (const auto &[table, rid] : rolled_back) {
+      table->GetVersionStore()->Rollback(rid, txn);
+    }
+  }
+  {
+    std::scoped_lock latch(commit_latch_);
+    UnregisterSnapshot(txn);
+  }
   // Rollback index updates
 
   auto index_write_set = txn->GetIndexWriteSet();
@@ -85,8 +137,7 @@ void TransactionManager::Abort(Transaction *txn) {
     // Metadata identifying the table that should be deleted from.
     TableInfo *table_info = catalog->GetTable(item.table_oid_);
     IndexInfo *index_info = catalog->GetIndex(item.index_oid_);
-    auto new_key = item.tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetKeySchema()),
-                                            index_info->index_->GetKeyAttrs());
+    auto new_key = index_info->index_->EntryFromTuple(item.tuple_, table_info->schema_);
     if (item.wtype_ == WType::DELETE) {
       index_info->index_->InsertEntry(new_key, item.rid_, txn);
     } else if (item.wtype_ == WType::INSERT) {
@@ -94,8 +145,7 @@ void TransactionManager::Abort(Transaction *txn) {
     } else if (item.wtype_ == WType::UPDATE) {
       // Delete the new key and insert the old key
       index_info->index_->DeleteEntry(new_key, item.rid_, txn);
-      auto old_key = item.old_tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetKeySchema()),
-                                                  index_info->index_->GetKeyAttrs());
+      auto old_key = index_info->index_->EntryFromTuple(item.old_tuple_, table_info->schema_);
       index_info->index_->InsertEntry(old_key, item.rid_, txn);
     }
     index_write_set->pop_back();
@@ -103,6 +153,11 @@ void TransactionManager::Abort(Transaction *txn) {
   table_write_set->clear();
   index_write_set->clear();
 
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
+
   // Release all the locks.
   
   ReleaseLocks(txn);
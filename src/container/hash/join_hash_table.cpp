@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table.cpp
+//
+// Identification: src/container/hash/join_hash_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/join_hash_table.h"
+
+#include <cstring>
+
+namespace bustub {
+
+void JoinHashTable::Insert(hash_t hash, const Tuple &tuple) {
+  size_t offset = arena_.size();
+  arena_.resize(offset + sizeof(uint32_t) + tuple.GetLength());
+  tuple.SerializeTo(arena_.data() + offset);
+  rows_.push_back({hash, offset});
+}
+
+void JoinHashTable::Build() {
+  size_t num_slots = 1;
+  while (num_slots < rows_.size() * 2) {
+    num_slots <<= 1;
+  }
+  slots_.assign(num_slots, {0, EMPTY_SLOT});
+  slot_mask_ = num_slots - 1;
+  filter_.Reset(rows_.size());
+
+  for (const auto &row : rows_) {
+    size_t slot = row.hash_ & slot_mask_;
+    while (slots_[slot].offset_ != EMPTY_SLOT) {
+      slot = (slot + 1) & slot_mask_;
+    }
+    slots_[slot] = row;
+    filter_.Insert(row.hash_);
+  }
+}
+
+void JoinHashTable::Clear() {
+  arena_.clear();
+  rows_.clear();
+  slots_.clear();
+  slot_mask_ = 0;
+  filter_.Clear();
+}
+
+auto JoinHashTable::GetMemoryUsage() const -> size_t {
+  return arena_.size() + (rows_.size() + slots_.size()) * sizeof(Entry) + filter_.GetMemoryUsage();
+}
+
+auto JoinHashTable::FindNext(hash_t hash, size_t *slot, Tuple *tuple) const -> bool {
+  if (slots_.empty()) {
+    return false;
+  }
+  while (slots_[*slot].offset_ != EMPTY_SLOT) {
+    const Entry &entry = slots_[*slot];
+    *slot = (*slot + 1) & slot_mask_;
+    if (entry.hash_ == hash) {
+      MakeView(entry.offset_, tuple);
+      return true;
+    }
+  }
+  return false;
+}
+
+void JoinHashTable::MakeView(size_t offset, Tuple *tuple) const {
+  if (tuple->allocated_) {
+    delete[] tuple->data_;
+  }
+  memcpy(&tuple->size_, arena_.data() + offset, sizeof(uint32_t));
+  tuple->data_ = const_cast<char *>(arena_.data()) + offset + sizeof(uint32_t);
+  tuple->allocated_ = false;
+  tuple->rid_ = RID();
+}
+
+}  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// row_hash_set.cpp
+//
+// Identification: src/container/hash/row_hash_set.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/row_hash_set.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+auto RowHashSet::Insert(hash_t hash, const Tuple &tuple) -> bool {
+  if ((rows_.size() + 1) * 2 > slots_.size()) {
+    Grow();
+  }
+  uint32_t size = tuple.GetLength();
+  size_t slot = hash & slot_mask_;
+  for (; slots_[slot] != EMPTY_SLOT; slot = (slot + 1) & slot_mask_) {
+    const Row &row = rows_[slots_[slot]];
+    if (row.hash_ != hash) {
+      continue;
+    }
+    uint32_t row_size;
+    memcpy(&row_size, arena_.data() + row.offset_, sizeof(uint32_t));
+    if (row_size == size && memcmp(arena_.data() + row.offset_ + sizeof(uint32_t), tuple.GetData(), size) == 0) {
+      return false;
+    }
+  }
+
+  size_t offset = arena_.size();
+  arena_.resize(offset + sizeof(uint32_t) + size);
+  tuple.SerializeTo(arena_.data() + offset);
+  slots_[slot] = rows_.size();
+  rows_.push_back({hash, offset});
+  return true;
+}
+
+void RowHashSet::Grow() {
+  size_t num_slots = std::max<size_t>(slots_.size() * 2, 16);
+  slots_.assign(num_slots, EMPTY_SLOT);
+  slot_mask_ = num_slots - 1;
+  for (size_t idx = 0; idx < rows_.size(); idx++) {
+    size_t slot = rows_[idx].hash_ & slot_mask_;
+    while (slots_[slot] != EMPTY_SLOT) {
+      slot = (slot + 1) & slot_mask_;
+    }
+    slots_[slot] = idx;
+  }
+}
+
+void RowHashSet::Clear() {
+  arena_.clear();
+  rows_.clear();
+  slots_.clear();
+  slot_mask_ = 0;
+}
+
+auto RowHashSet::GetMemoryUsage() const -> size_t {
+  return arena_.size() + rows_.size() * sizeof(Row) + slots_.size() * sizeof(size_t);
+}
+
+void RowHashSet::GetTuple(size_t idx, Tuple *tuple) const {
+  if (tuple->allocated_) {
+    delete[] tuple->data_;
+  }
+  memcpy(&tuple->size_, arena_.data() + rows_[idx].offset_, sizeof(uint32_t));
+  tuple->data_ = const_cast<char *>(arena_.data()) + rows_[idx].offset_ + sizeof(uint32_t);
+  tuple->allocated_ = false;
+  tuple->rid_ = RID();
+}
+
+}  // namespace bustub
@@ -9,75 +9,363 @@
 // Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <cstring>
 #include <memory>
 #include <vector>
 
 #include "execution/executors/aggregation_executor.h"
+#include "common/thread_pool.h"
 
 namespace bustub {
 
+namespace {
+
+/** Two group by values are the same group if they are equal or both NULL. */
+auto SameGroupBy(const Value &left, const Value &right) -> bool {
+  if (left.IsNull() || right.IsNull()) {
+    return left.IsNull() && right.IsNull();
+  }
+  return left.CompareEquals(right) == CmpBool::CmpTrue;
+}
+
+}  // namespace
+
+auto AggregationHashTable::HashGroupBys(const std::vector<Value> &group_bys) -> hash_t {
+  hash_t hash = 0;
+  for (const auto &value : group_bys) {
+    if (!value.IsNull()) {
+      hash = HashUtil::CombineHashes(hash, HashUtil::HashValue(&value));
+    }
+  }
+  return HashUtil::MixHash(hash);
+}
+
+auto AggregationHashTable::GenerateInitialAggregateValue() const -> std::vector<Value> {
+  std::vector<Value> values{};
+  for (const auto &agg_type : *agg_types_) {
+    switch (agg_type) {
+      case AggregationType::CountAggregate:
+        // Count starts at zero.
+        values.emplace_back(ValueFactory::GetIntegerValue(0));
+        break;
+      case AggregationType::SumAggregate:
+        // Sum starts at zero.
+        values.emplace_back(ValueFactory::GetIntegerValue(0));
+        break;
+      case AggregationType::MinAggregate:
+        // Min starts at INT_MAX.
+        values.emplace_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MAX));
+        break;
+      case AggregationType::MaxAggregate:
+        // Max starts at INT_MIN.
+        values.emplace_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MIN));
+        break;
+    }
+  }
+  return values;
+}
+
+auto AggregationHashTable::FindOrInsert(hash_t hash, const Value *group_bys) -> size_t {
+  if ((hashes_.size() + 1) * 2 > slots_.size()) {
+    Grow();
+  }
+  size_t slot = hash & slot_mask_;
+  for (; slots_[slot].group_ != EMPTY_SLOT; slot = (slot + 1) & slot_mask_) {
+    if (slots_[slot].hash_ != hash) {
+      continue;
+    }
+    size_t group = slots_[slot].group_;
+    const Value *existing = &group_bys_[group * num_group_bys_];
+    bool same = true;
+    for (size_t i = 0; i < num_group_bys_ && same; i++) {
+      same = SameGroupBy(existing[i], group_bys[i]);
+    }
+    if (same) {
+      return group;
+    }
+  }
+
+  size_t group = hashes_.size();
+  slots_[slot] = {hash, group};
+  hashes_.push_back(hash);
+  group_bys_.insert(group_bys_.end(), group_bys, group_bys + num_group_bys_);
+  auto initial = GenerateInitialAggregateValue();
+  aggregates_.insert(aggregates_.end(), initial.begin(), initial.end());
+  return group;
+}
+
+void AggregationHashTable::Grow() {
+  size_t num_slots = std::max<size_t>(slots_.size() * 2, 16);
+  slots_.assign(num_slots, {0, EMPTY_SLOT});
+  slot_mask_ = num_slots - 1;
+  for (size_t group = 0; group < hashes_.size(); group++) {
+    size_t slot = hashes_[group] & slot_mask_;
+    while (slots_[slot].group_ != EMPTY_SLOT) {
+      slot = (slot + 1) & slot_mask_;
+    }
+    slots_[slot] = {hashes_[group], group};
+  }
+}
+
+void AggregationHashTable::Accumulate(hash_t hash, const std::vector<Value> &group_bys,
+                                      const std::vector<Value> &inputs) {
+  Value *result = &aggregates_[FindOrInsert(hash, group_bys.data()) * agg_types_->size()];
+  for (uint32_t i = 0; i < agg_types_->size(); i++) {
+    switch ((*agg_types_)[i]) {
+      case AggregationType::CountAggregate:
+        // Count increases by one.
+        result[i] = result[i].Add(ValueFactory::GetIntegerValue(1));
+        break;
+      case AggregationType::SumAggregate:
+        // Sum increases by addition.
+        result[i] = result[i].Add(inputs[i]);
+        break;
+      case AggregationType::MinAggregate:
+        // Min is just the min.
+        result[i] = result[i].Min(inputs[i]);
+        break;
+      case AggregationType::MaxAggregate:
+        // Max is just the max.
+        result[i] = result[i].Max(inputs[i]);
+        break;
+    }
+  }
+}
+
+void AggregationHashTable::Merge(hash_t hash, const Value *group_bys, const Value *aggregates) {
+  Value *result = &aggregates_[FindOrInsert(hash, group_bys) * agg_types_->size()];
+  for (uint32_t i = 0; i < agg_types_->size(); i++) {
+    switch ((*agg_types_)[i]) {
+      case AggregationType::CountAggregate:
+      case AggregationType::SumAggregate:
+        // Partial counts and sums add up.
+        result[i] = result[i].Add(aggregates[i]);
+        break;
+      case AggregationType::MinAggregate:
+        result[i] = result[i].Min(aggregates[i]);
+        break;
+      case AggregationType::MaxAggregate:
+        result[i] = result[i].Max(aggregates[i]);
+        break;
+    }
+  }
+}
+
+void AggregationHashTable::SerializeGroup(size_t group, std::vector<char> *out) const {
+  auto append = [out](const Value &value) {
+    out->push_back(static_cast<char>(value.GetTypeId()));
+    size_t offset = out->size();
+    uint32_t size = value.GetTypeId() == TypeId::VARCHAR
+                        ? sizeof(uint32_t) + (value.IsNull() ? 0 : value.GetLength())
+                        : static_cast<uint32_t>(Type::GetTypeSize(value.GetTypeId()));
+    out->resize(offset + size);
+    value.SerializeTo(out->data() + offset);
+  };
+  size_t offset = out->size();
+  out->resize(offset + sizeof(hash_t));
+  memcpy(out->data() + offset, &hashes_[group], sizeof(hash_t));
+  for (size_t i = 0; i < num_group_bys_; i++) {
+    append(group_bys_[group * num_group_bys_ + i]);
+  }
+  for (size_t i = 0; i < agg_types_->size(); i++) {
+    append(aggregates_[group * agg_types_->size() + i]);
+  }
+}
+
+void AggregationHashTable::MergeSerialized(const char *data) {
+  hash_t hash;
+  memcpy(&hash, data, sizeof(hash_t));
+  data += sizeof(hash_t);
+  std::vector<Value> values;
+  values.reserve(num_group_bys_ + agg_types_->size());
+  for (size_t i = 0; i < num_group_bys_ + agg_types_->size(); i++) {
+    auto type_id = static_cast<TypeId>(*data++);
+    values.push_back(Value::DeserializeFrom(data, type_id));
+    if (type_id == TypeId::VARCHAR) {
+      uint32_t length;
+      memcpy(&length, data, sizeof(uint32_t));
+      data += sizeof(uint32_t) + (length == BUSTUB_VALUE_NULL ? 0 : length);
+    } else {
+      data += Type::GetTypeSize(type_id);
+    }
+  }
+  Merge(hash, values.data(), values.data() + num_group_bys_);
+}
+
+void AggregationHashTable::Clear() {
+  slots_.clear();
+  slot_mask_ = 0;
+  hashes_.clear();
+  group_bys_.clear();
+  aggregates_.clear();
+}
+
+auto AggregationHashTable::GetMemoryUsage() const -> size_t {
+  return slots_.size() * sizeof(Slot) + hashes_.size() * sizeof(hash_t) +
+         (group_bys_.size() + aggregates_.size()) * sizeof(Value);
+}
+
 AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
                                          std::unique_ptr<AbstractExecutor> &&child)
-    : AbstractExecutor(exec_ctx), plan_(plan) , child_(std::move(child)), agg_hash_table_(plan->GetAggregates(),plan_->GetAggregateTypes()), iterator_(agg_hash_table_.Begin()) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)) {}
 
 void AggregationExecutor::Init() {
-    key_schema_=plan_->OutputSchema();
-    having=plan_->GetHaving();
-    child_->Init();
-
-    Tuple tp;
-    RID r;
-    while(child_->Next(&tp,&r)) {
-        auto key=MakeAggregateKey(&tp);
-        auto value=MakeAggregateValue(&tp,r);
-        value.rid=r;
-        agg_hash_table_.InsertCombine(key,value);
-    }
-    iterator_=agg_hash_table_.Begin();
-}
-
-auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool { 
-    
-    while(iterator_!=agg_hash_table_.End()){
-   
-
-        auto key=iterator_.Key();
-        auto value=iterator_.Val();
-        std::vector<Value> merged;
-        std::vector<Value> result;
-      
-        merged.reserve(key.group_bys_.size()+value.aggregates_.size());
-        merged.insert(merged.end(),key.group_bys_.begin(),key.group_bys_.end());
-        merged.insert(merged.end(),value.aggregates_.begin(),value.aggregates_.end());
-
-        for(auto column: key_schema_->GetColumns()) {
-           auto agg_expr=reinterpret_cast<const AggregateValueExpression*>(column.GetExpr());
-           auto val=agg_expr->EvaluateAggregate(key.group_bys_,merged);
-           result.push_back(val);
-        }
-
-        if(having!=nullptr) {
-            if(having->EvaluateAggregate(key.group_bys_,value.aggregates_).GetAs<bool>()){
-                *rid=value.rid;
-                assert(key_schema_!=nullptr);
-                *tuple=Tuple(result,key_schema_);
-                iterator_.Next();
-                return true;                    
-            }
-        } else {
-            *rid=value.rid;
-            *tuple=Tuple(result,key_schema_);
-            iterator_.Next();
-            return true;    
-        }
-
-
-        iterator_.Next();
-
-
-
-    }
-    return false; 
+  child_->Init();
+  size_t num_threads = exec_ctx_->GetNumThreads();
+  ThreadPool *pool = num_threads == 1 ? nullptr : exec_ctx_->GetThreadPool();
+  locals_.clear();
+  // Pool workers keep their state at their index, the calling thread helps out with the last one.
+  locals_.resize(pool == nullptr ? 1 : pool->GetNumThreads() + 1);
+  for (auto &local : locals_) {
+    local.tables_.assign(NUM_PARTITIONS,
+                         AggregationHashTable(&plan_->GetAggregateTypes(), plan_->GetGroupBys().size()));
+    local.spills_.resize(NUM_PARTITIONS);
+  }
+  size_t budget = exec_ctx_->GetWorkMemory() / locals_.size();
+  batch_.clear();
+  next_partition_ = 0;
+  batch_idx_ = 0;
+  group_idx_ = 0;
+
+  auto next_morsel = [&](std::vector<Tuple> *morsel) {
+    morsel->clear();
+    morsel->reserve(MORSEL_SIZE);
+    Tuple tuple;
+    RID rid;
+    while (morsel->size() < MORSEL_SIZE && child_->Next(&tuple, &rid)) {
+      morsel->push_back(std::move(tuple));
+    }
+    return !morsel->empty();
+  };
+
+  std::vector<Tuple> morsel;
+  if (pool == nullptr) {
+    while (next_morsel(&morsel)) {
+      ProcessMorsel(morsel, &locals_[0], budget);
+    }
+    return;
+  }
+
+  // The child is not thread safe, so this thread drains it while the pool aggregates. Waiting for the backlog to
+  // shrink runs queued morsels here, which bounds the morsels in memory to a few per worker.
+  TaskGroup group(pool);
+  while (next_morsel(&morsel)) {
+    group.WaitBelow(num_threads * 2);
+    group.Submit([this, pool, budget, work = std::move(morsel)] {
+      ProcessMorsel(work, &locals_[pool->GetWorkerIndex()], budget);
+    });
+    morsel = std::vector<Tuple>();
+  }
+  group.Wait();
+}
+
+void AggregationExecutor::ProcessMorsel(const std::vector<Tuple> &morsel, LocalAggregation *local, size_t budget) {
+  size_t memory = 0;
+  for (const auto &tuple : morsel) {
+    auto key = MakeAggregateKey(&tuple);
+    auto value = MakeAggregateValue(&tuple);
+    hash_t hash = AggregationHashTable::HashGroupBys(key.group_bys_);
+    local->tables_[PartitionOf(hash)].Accumulate(hash, key.group_bys_, value.aggregates_);
+  }
+  for (const auto &table : local->tables_) {
+    memory += table.GetMemoryUsage();
+  }
+  if (memory > budget) {
+    Spill(local);
+  }
+}
+
+void AggregationExecutor::Spill(LocalAggregation *local) {
+  std::vector<char> buffer;
+  for (size_t partition = 0; partition < NUM_PARTITIONS; partition++) {
+    auto &table = local->tables_[partition];
+    if (table.Size() == 0) {
+      continue;
+    }
+    auto &run = local->spills_[partition];
+    if (run == nullptr) {
+      run = std::make_unique<TmpTupleHeap>(exec_ctx_->GetBufferPoolManager());
+    }
+    for (size_t group = 0; group < table.Size(); group++) {
+      buffer.clear();
+      table.SerializeGroup(group, &buffer);
+      run->Append(buffer.data(), static_cast<uint32_t>(buffer.size()));
+    }
+    table.Clear();
+  }
+}
+
+void AggregationExecutor::MergePartition(size_t partition, AggregationHashTable *result) {
+  for (auto &local : locals_) {
+    auto &table = local.tables_[partition];
+    for (size_t group = 0; group < table.Size(); group++) {
+      auto group_bys = table.GetGroupBys(group);
+      auto aggregates = table.GetAggregates(group);
+      result->Merge(table.GetHash(group), group_bys.data(), aggregates.data());
+    }
+    table.Clear();
+    if (local.spills_[partition] != nullptr) {
+      Tuple spilled;
+      while (local.spills_[partition]->Next(&spilled)) {
+        result->MergeSerialized(spilled.GetData());
+      }
+      local.spills_[partition].reset();
+    }
+  }
+}
+
+auto AggregationExecutor::LoadNextBatch() -> bool {
+  if (next_partition_ == NUM_PARTITIONS) {
+    return false;
+  }
+  size_t batch_size = std::min(exec_ctx_->GetNumThreads(), NUM_PARTITIONS - next_partition_);
+  batch_.assign(batch_size, AggregationHashTable(&plan_->GetAggregateTypes(), plan_->GetGroupBys().size()));
+  if (batch_size == 1) {
+    MergePartition(next_partition_, &batch_[0]);
+  } else {
+    TaskGroup group(exec_ctx_->GetThreadPool());
+    for (size_t i = 0; i < batch_size; i++) {
+      group.Submit([this, i] { MergePartition(next_partition_ + i, &batch_[i]); });
+    }
+    group.Wait();
+  }
+  next_partition_ += batch_size;
+  batch_idx_ = 0;
+  group_idx_ = 0;
+  return true;
+}
+
+auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  const AbstractExpression *having = plan_->GetHaving();
+  while (true) {
+    if (batch_idx_ == batch_.size()) {
+      if (!LoadNextBatch()) {
+        return false;
+      }
+      continue;
+    }
+    const auto &table = batch_[batch_idx_];
+    if (group_idx_ == table.Size()) {
+      batch_idx_++;
+      group_idx_ = 0;
+      continue;
+    }
+
+    size_t group = group_idx_++;
+    auto group_bys = table.GetGroupBys(group);
+    auto aggregates = table.GetAggregates(group);
+    if (having != nullptr && !having->EvaluateAggregate(group_bys, aggregates).GetAs<bool>()) {
+      continue;
+    }
+    std::vector<Value> values;
+    values.reserve(GetOutputSchema()->GetColumnCount());
+    for (const auto &column : GetOutputSchema()->GetColumns()) {
+      values.push_back(column.GetExpr()->EvaluateAggregate(group_bys, aggregates));
+    }
+    *tuple = Tuple(values, GetOutputSchema());
+    *rid = RID();
+    return true;
+  }
 }
 
 auto AggregationExecutor::GetChildExecutor() const -> const AbstractExecutor * { return child_.get(); }
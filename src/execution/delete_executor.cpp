@@ -46,7 +46,9 @@ void DeleteExecutor::Init() {
             // std::cout<<child_rid_result_set[i].ToString();
             table_info_->table_->ApplyDelete(child_rid_result_set[i],txn_);
             for(auto index_info : index_infos_) {
-                index_info->index_->DeleteEntry(child_tp_result_set[i],child_rid_result_set[i],txn_);
+                index_info->index_->DeleteEntry(
+                    index_info->index_->EntryFromTuple(child_tp_result_set[i], table_info_->schema_),
+                    child_rid_result_set[i], txn_);
             }
         }
 
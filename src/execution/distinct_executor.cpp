@@ -12,36 +12,122 @@
 
 #include "execution/executors/distinct_executor.h"
 
+#include <algorithm>
+
 namespace bustub {
 
 DistinctExecutor::DistinctExecutor(ExecutorContext *exec_ctx, const DistinctPlanNode *plan,
                                    std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx), plan_(plan) , child_executor_(std::move(child_executor)), child_schema_(nullptr) {
-
-    }
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
 
 void DistinctExecutor::Init() {
-    child_schema_=child_executor_->GetOutputSchema();
-    child_executor_->Init();
+  child_executor_->Init();
+  seen_.Clear();
+  resident_rows_.assign(PARTITION_FANOUT, 0);
+  spilled_.clear();
+  spilled_.resize(PARTITION_FANOUT);
+  depth_ = 0;
+  pending_.clear();
+  input_.reset();
+  child_done_ = false;
 }
 
-auto DistinctExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-    Tuple tp;
-    RID r;
-    while(child_executor_->Next(&tp,&r)){
+auto DistinctExecutor::PartitionOf(hash_t hash, uint32_t depth) -> uint32_t {
+  return static_cast<uint32_t>(HashUtil::MixHash(HashUtil::CombineHashes(hash, depth)) % PARTITION_FANOUT);
+}
+
+auto DistinctExecutor::Admit(const Tuple &tuple, bool input) -> bool {
+  hash_t hash = RowHashSet::HashRow(tuple);
+  uint32_t partition = PartitionOf(hash, depth_);
+  if (spilled_[partition] != nullptr) {
+    (input ? spilled_[partition]->input_ : spilled_[partition]->seen_)->Append(tuple);
+    return false;
+  }
+  if (!seen_.Insert(hash, tuple)) {
+    return false;
+  }
+  resident_rows_[partition]++;
+  if (depth_ < MAX_PARTITION_DEPTH && seen_.GetMemoryUsage() > exec_ctx_->GetWorkMemory()) {
+    SpillLargestPartition();
+  }
+  return input;
+}
+
+void DistinctExecutor::SpillLargestPartition() {
+  auto largest = static_cast<uint32_t>(
+      std::max_element(resident_rows_.begin(), resident_rows_.end()) - resident_rows_.begin());
+  if (resident_rows_[largest] == 0) {
+    return;
+  }
+  BufferPoolManager *bpm = exec_ctx_->GetBufferPoolManager();
+  auto partition = std::make_unique<Partition>();
+  partition->seen_ = std::make_unique<TmpTupleHeap>(bpm);
+  partition->input_ = std::make_unique<TmpTupleHeap>(bpm);
+  partition->depth_ = depth_ + 1;
 
-        Value distinct_value=tp.GetValue(child_schema_,0); // distinct value index is not exists in test
+  RowHashSet kept;
+  Tuple row;
+  for (size_t idx = 0; idx < seen_.Size(); idx++) {
+    seen_.GetTuple(idx, &row);
+    if (PartitionOf(seen_.GetHash(idx), depth_) == largest) {
+      partition->seen_->Append(row);
+    } else {
+      kept.Insert(seen_.GetHash(idx), row);
+    }
+  }
+  seen_ = std::move(kept);
+  resident_rows_[largest] = 0;
+  spilled_[largest] = std::move(partition);
+}
+
+auto DistinctExecutor::LoadNextPartition() -> bool {
+  for (auto &partition : spilled_) {
+    if (partition != nullptr) {
+      pending_.push_back(std::move(*partition));
+      partition.reset();
+    }
+  }
+  input_.reset();
+  seen_.Clear();
+  if (pending_.empty()) {
+    return false;
+  }
 
-        hash_t hash_key=hash_util_.HashValue(&distinct_value);
+  Partition partition = std::move(pending_.back());
+  pending_.pop_back();
+  depth_ = partition.depth_;
+  resident_rows_.assign(PARTITION_FANOUT, 0);
+  Tuple row;
+  while (partition.seen_->Next(&row)) {
+    Admit(row, false);
+  }
+  input_ = std::move(partition.input_);
+  return true;
+}
 
-        if(encounterd_.count(hash_key)==0){
-            encounterd_.insert(hash_key);
-            *tuple=tp;
-            *rid=r;
-            return true;
-        }
+auto DistinctExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  Tuple row;
+  RID child_rid;
+  while (true) {
+    bool found;
+    if (!child_done_) {
+      found = child_executor_->Next(&row, &child_rid);
+      child_done_ = !found;
+    } else {
+      found = input_ != nullptr && input_->Next(&row);
+    }
+    if (!found) {
+      if (!LoadNextPartition()) {
+        return false;
+      }
+      continue;
+    }
+    if (Admit(row, true)) {
+      *tuple = std::move(row);
+      *rid = RID();
+      return true;
     }
-    return false; 
+  }
 }
 
 }  // namespace bustub
@@ -0,0 +1,230 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// gather_executor.cpp
+//
+// Identification: src/execution/gather_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/gather_executor.h"
+
+#include <utility>
+
+#include "common/config.h"
+#include "execution/executor_factory.h"
+#include "execution/executors/repartition_executor.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/distinct_plan.h"
+#include "execution/plans/gather_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/repartition_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+
+namespace bustub {
+
+GatherExecutor::GatherExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *pipeline)
+    : AbstractExecutor(exec_ctx), pipeline_(pipeline) {}
+
+GatherExecutor::~GatherExecutor() { StopDrivers(); }
+
+auto GatherExecutor::FindDrivingLeaf(const AbstractPlanNode *plan) -> const AbstractPlanNode * {
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+    case PlanType::Repartition:
+      return plan;
+    case PlanType::HashJoin:
+      return FindDrivingLeaf(dynamic_cast<const HashJoinPlanNode *>(plan)->GetRightPlan());
+    case PlanType::NestedLoopJoin:
+      return FindDrivingLeaf(dynamic_cast<const NestedLoopJoinPlanNode *>(plan)->GetLeftPlan());
+    case PlanType::NestedIndexJoin:
+      return FindDrivingLeaf(dynamic_cast<const NestedIndexJoinPlanNode *>(plan)->GetChildPlan());
+    case PlanType::Gather:
+      return FindDrivingLeaf(dynamic_cast<const GatherPlanNode *>(plan)->GetChildPlan());
+    case PlanType::Aggregation:
+    case PlanType::Distinct: {
+      // Every copy would emit its own groups, which is only right if no two copies see the same group.
+      const AbstractPlanNode *leaf = FindDrivingLeaf(plan->GetChildAt(0));
+      return leaf != nullptr && leaf->GetType() == PlanType::Repartition ? leaf : nullptr;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+void GatherExecutor::Init() {
+  StopDrivers();
+  inline_.reset();
+  size_t num_workers = exec_ctx_->GetNumThreads();
+  const AbstractPlanNode *leaf = FindDrivingLeaf(pipeline_);
+  // Copies would take tuple locks on behalf of the transaction concurrently, which it does not support.
+  if (num_workers <= 1 || enable_logging || leaf == nullptr) {
+    inline_ = ExecutorFactory::CreateExecutor(exec_ctx_, pipeline_);
+    inline_->Init();
+    return;
+  }
+
+  stopped_ = false;
+  error_ = nullptr;
+  batch_.clear();
+  batch_pos_ = 0;
+  state_ = std::make_unique<PipelineState>(num_workers);
+  PrepareLeaf(state_.get(), leaf);
+
+  exchange_ = std::make_unique<TupleExchange>(num_workers * 2, num_workers);
+  group_ = std::make_unique<TaskGroup>(exec_ctx_->GetThreadPool());
+  // Tasks point into drivers_, so it must not reallocate from here on.
+  drivers_ = std::vector<Driver>(num_workers);
+  for (size_t i = 0; i < num_workers; i++) {
+    drivers_[i].ctx_ = MakeWorkerContext(state_.get(), i);
+    drivers_[i].executor_ = ExecutorFactory::CreateExecutor(drivers_[i].ctx_.get(), pipeline_);
+  }
+  for (auto &driver : drivers_) {
+    SubmitDriver(&driver);
+  }
+}
+
+auto GatherExecutor::MakeWorkerContext(PipelineState *state, size_t worker_id) -> std::unique_ptr<ExecutorContext> {
+  auto ctx = std::make_unique<ExecutorContext>(exec_ctx_, state, worker_id);
+  ctx->SetWorkMemory(exec_ctx_->GetWorkMemory() / state->GetNumWorkers());
+  return ctx;
+}
+
+void GatherExecutor::PrepareLeaf(PipelineState *state, const AbstractPlanNode *leaf) {
+  if (leaf->GetType() == PlanType::SeqScan) {
+    auto table_oid = dynamic_cast<const SeqScanPlanNode *>(leaf)->GetTableOid();
+    state->AddScan(leaf, exec_ctx_->GetCatalog()->GetTable(table_oid)->table_->GetPageIds());
+    return;
+  }
+
+  // Run the child of the Repartition as a stage of its own, split at its own driving leaf if it has one.
+  auto repartition = dynamic_cast<const RepartitionPlanNode *>(leaf);
+  const AbstractPlanNode *child = repartition->GetChildPlan();
+  const AbstractPlanNode *child_leaf = FindDrivingLeaf(child);
+  size_t num_producers = child_leaf == nullptr ? 1 : state->GetNumWorkers();
+  PipelineState stage(num_producers);
+  if (child_leaf != nullptr) {
+    PrepareLeaf(&stage, child_leaf);
+  }
+  RepartitionState *runs = state->AddRepartition(leaf, exec_ctx_->GetBufferPoolManager(), num_producers);
+  TaskGroup group(exec_ctx_->GetThreadPool());
+  for (size_t producer = 0; producer < num_producers; producer++) {
+    group.Submit([&, producer] {
+      auto ctx = MakeWorkerContext(&stage, producer);
+      auto executor = ExecutorFactory::CreateExecutor(ctx.get(), child);
+      executor->Init();
+      Tuple tuple;
+      RID rid;
+      while (executor->Next(&tuple, &rid)) {
+        size_t partition =
+            RepartitionExecutor::PartitionOf(repartition, tuple, executor->GetOutputSchema(), state->GetNumWorkers());
+        runs->GetRun(producer, partition)->Append(tuple);
+      }
+    });
+  }
+  group.Wait();
+}
+
+void GatherExecutor::SubmitDriver(Driver *driver) {
+  group_->Submit([this, driver] { RunDriver(driver); });
+}
+
+void GatherExecutor::RunDriver(Driver *driver) {
+  if (stopped_) {
+    return;
+  }
+  try {
+    if (!driver->initialized_) {
+      driver->executor_->Init();
+      driver->initialized_ = true;
+    }
+    std::vector<Tuple> &batch = driver->batch_;
+    if (batch.empty()) {
+      batch.reserve(BATCH_SIZE);
+      Tuple tuple;
+      RID rid;
+      while (batch.size() < BATCH_SIZE) {
+        if (!driver->executor_->Next(&tuple, &rid)) {
+          driver->done_ = true;
+          break;
+        }
+        tuple.SetRid(rid);
+        batch.push_back(std::move(tuple));
+      }
+    }
+    if (driver->done_) {
+      // The last batch may overshoot the capacity, the copy holds nothing else anymore.
+      if (!batch.empty()) {
+        exchange_->Push(std::move(batch), nullptr);
+      }
+      exchange_->Finish();
+      return;
+    }
+    // A full exchange keeps the resume and calls it once Next made room, the batch waits in the driver until then.
+    if (!exchange_->Push(std::move(batch), [this, driver] { SubmitDriver(driver); })) {
+      return;
+    }
+    batch.clear();
+    SubmitDriver(driver);
+  } catch (...) {
+    Fail(std::current_exception());
+  }
+}
+
+void GatherExecutor::Fail(std::exception_ptr error) {
+  {
+    std::scoped_lock lock(error_latch_);
+    if (!error_) {
+      error_ = std::move(error);
+    }
+  }
+  stopped_ = true;
+  exchange_->Cancel();
+}
+
+void GatherExecutor::StopDrivers() {
+  stopped_ = true;
+  if (exchange_ != nullptr) {
+    exchange_->Cancel();
+  }
+  // Wait for the tasks still queued or running before the group goes away, they may resubmit themselves until they
+  // see stopped_. RunDriver catches every error, so this does not throw.
+  if (group_ != nullptr) {
+    group_->Wait();
+    group_.reset();
+  }
+  drivers_.clear();
+  exchange_.reset();
+  state_.reset();
+}
+
+auto GatherExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (inline_ != nullptr) {
+    return inline_->Next(tuple, rid);
+  }
+  while (batch_pos_ == batch_.size()) {
+    if (exchange_ == nullptr) {
+      return false;
+    }
+    batch_.clear();
+    batch_pos_ = 0;
+    if (!exchange_->Pop(&batch_)) {
+      StopDrivers();
+      std::scoped_lock lock(error_latch_);
+      if (error_) {
+        std::rethrow_exception(error_);
+      }
+      return false;
+    }
+  }
+  *tuple = std::move(batch_[batch_pos_++]);
+  *rid = tuple->GetRid();
+  return true;
+}
+
+}  // namespace bustub
@@ -17,62 +17,208 @@ namespace bustub {
 HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
                                    std::unique_ptr<AbstractExecutor> &&left_child,
                                    std::unique_ptr<AbstractExecutor> &&right_child)
-    : AbstractExecutor(exec_ctx), plan_(plan), left_executor_(std::move(left_child)), right_executor_(std::move(right_child)) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_executor_(std::move(left_child)),
+      right_executor_(std::move(right_child)) {}
 
 void HashJoinExecutor::Init() {
-    // insert left_child
-    hash_map_.clear();
-    left_join_column_expr_=reinterpret_cast<const ColumnValueExpression*>(plan_->LeftJoinKeyExpression());
-    right_join_column_expr_=reinterpret_cast<const ColumnValueExpression*>(plan_->RightJoinKeyExpression());
-    
-    left_schema_=plan_->GetLeftPlan()->OutputSchema();
-    right_schema_=plan_->GetRightPlan()->OutputSchema();
-    left_executor_->Init();
-    key_schema_=plan_->OutputSchema();
-    Tuple tp;
-    RID r;
-    while(left_executor_->Next(&tp,&r)) {
-        // insert 
-        Value join_value=tp.GetValue(left_schema_,left_join_column_expr_->GetColIdx());
-        hash_t hash_key=hash_util_.HashValue(&join_value);
-
-        // if there is overlapped left hash key ?
-        hash_map_.insert({hash_key,{r,tp}});
-        
+  left_schema_ = plan_->GetLeftPlan()->OutputSchema();
+  right_schema_ = plan_->GetRightPlan()->OutputSchema();
+  hash_table_.Clear();
+  spilled_ = false;
+  spill_filter_.Clear();
+  pending_.clear();
+  probe_partition_.reset();
+  probing_ = false;
+
+  left_executor_->Init();
+  right_executor_->Init();
+
+  Tuple tuple;
+  RID rid;
+  while (left_executor_->Next(&tuple, &rid)) {
+    Build(tuple);
+    if (hash_table_.GetMemoryUsage() > exec_ctx_->GetWorkMemory()) {
+      PartitionInputs();
+      LoadNextPartition();
+      return;
+    }
+  }
+  hash_table_.Build();
+}
+
+auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  Tuple left;
+  while (true) {
+    while (probing_ && hash_table_.FindNext(probe_hash_, &probe_slot_, &left)) {
+      // Different keys may share a hash, so compare the real keys before emitting.
+      if (LeftKey(left).CompareEquals(probe_key_) == CmpBool::CmpTrue) {
+        *tuple = MergeTuple(left, probe_tuple_);
+        *rid = RID();
+        return true;
+      }
+    }
+    probing_ = false;
+
+    if (!NextProbeTuple(&probe_tuple_)) {
+      if (!spilled_ || !LoadNextPartition()) {
+        return false;
+      }
+      continue;
+    }
+    probe_key_ = RightKey(probe_tuple_);
+    if (probe_key_.IsNull()) {
+      continue;
+    }
+    probe_hash_ = HashKey(probe_key_);
+    if (!hash_table_.MayContain(probe_hash_)) {
+      continue;
     }
+    probe_slot_ = hash_table_.ProbeStart(probe_hash_);
+    probing_ = true;
+  }
+}
+
+auto HashJoinExecutor::LeftKey(const Tuple &tuple) const -> Value {
+  return plan_->LeftJoinKeyExpression()->Evaluate(&tuple, left_schema_);
+}
+
+auto HashJoinExecutor::RightKey(const Tuple &tuple) const -> Value {
+  return plan_->RightJoinKeyExpression()->Evaluate(&tuple, right_schema_);
+}
 
-    right_executor_->Init();
+auto HashJoinExecutor::PartitionOf(hash_t hash, uint32_t depth) -> uint32_t {
+  return static_cast<uint32_t>(HashUtil::MixHash(HashUtil::CombineHashes(hash, depth)) % PARTITION_FANOUT);
 }
 
-auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool { 
-    Tuple tp;
-    RID r;
-
-    while(right_executor_->Next(&tp,&r)) {
-        // find in hash table
-        Value join_value=tp.GetValue(right_schema_,right_join_column_expr_->GetColIdx());
-        hash_t hash_key=hash_util_.HashValue(&join_value);
-        auto left_child=hash_map_.find(hash_key);
-        if(left_child!=hash_map_.end()){
-            *rid=left_child->second.first;
-            *tuple=MergeTuple(left_child->second.second,tp);
-            return true;
-        }
+void HashJoinExecutor::Build(const Tuple &tuple) {
+  Value key = LeftKey(tuple);
+  if (key.IsNull()) {
+    // NULL never joins with anything.
+    return;
+  }
+  hash_table_.Insert(HashKey(key), tuple);
+}
+
+void HashJoinExecutor::PartitionInputs() {
+  auto *bpm = exec_ctx_->GetBufferPoolManager();
+  std::vector<Partition> partitions(PARTITION_FANOUT);
+  for (auto &partition : partitions) {
+    partition.left_ = std::make_unique<TmpTupleHeap>(bpm);
+    partition.right_ = std::make_unique<TmpTupleHeap>(bpm);
+    partition.depth_ = 1;
+  }
+  // We do not know how large the left input is; size the filter as if it were a full budget per partition.
+  spill_filter_.Reset(hash_table_.Size() * PARTITION_FANOUT);
+
+  Tuple tuple;
+  for (size_t i = 0; i < hash_table_.Size(); i++) {
+    hash_table_.GetTuple(i, &tuple);
+    hash_t hash = HashKey(LeftKey(tuple));
+    spill_filter_.Insert(hash);
+    partitions[PartitionOf(hash, 1)].left_->Append(tuple);
+  }
+  hash_table_.Clear();
+
+  RID rid;
+  while (left_executor_->Next(&tuple, &rid)) {
+    Value key = LeftKey(tuple);
+    if (!key.IsNull()) {
+      hash_t hash = HashKey(key);
+      spill_filter_.Insert(hash);
+      partitions[PartitionOf(hash, 1)].left_->Append(tuple);
     }
-    return false; 
+  }
+  while (right_executor_->Next(&tuple, &rid)) {
+    Value key = RightKey(tuple);
+    if (key.IsNull()) {
+      continue;
+    }
+    hash_t hash = HashKey(key);
+    if (spill_filter_.MayContain(hash)) {
+      partitions[PartitionOf(hash, 1)].right_->Append(tuple);
+    }
+  }
+  spill_filter_.Clear();
+
+  spilled_ = true;
+  for (auto &partition : partitions) {
+    // An inner join of an empty side produces nothing.
+    if (partition.left_->GetTupleCount() > 0 && partition.right_->GetTupleCount() > 0) {
+      pending_.push_back(std::move(partition));
+    }
+  }
 }
 
-auto HashJoinExecutor::MergeTuple(Tuple& left, Tuple& right) -> Tuple {
-    std::vector<Value> values;
-    for(auto& column: plan_->OutputSchema()->GetColumns()) {
-        auto column_expr=reinterpret_cast<const ColumnValueExpression*>(column.GetExpr());
-        if(column_expr->GetTupleIdx()==0) {
-            values.push_back(left.GetValue(left_schema_,column_expr->GetColIdx()));
-        }else {
-            values.push_back(right.GetValue(right_schema_,column_expr->GetColIdx()));
-        }
+void HashJoinExecutor::Repartition(Partition *partition) {
+  auto *bpm = exec_ctx_->GetBufferPoolManager();
+  uint32_t depth = partition->depth_ + 1;
+  std::vector<Partition> children(PARTITION_FANOUT);
+  for (auto &child : children) {
+    child.left_ = std::make_unique<TmpTupleHeap>(bpm);
+    child.right_ = std::make_unique<TmpTupleHeap>(bpm);
+    child.depth_ = depth;
+  }
+
+  Tuple tuple;
+  while (partition->left_->Next(&tuple)) {
+    children[PartitionOf(HashKey(LeftKey(tuple)), depth)].left_->Append(tuple);
+  }
+  while (partition->right_->Next(&tuple)) {
+    children[PartitionOf(HashKey(RightKey(tuple)), depth)].right_->Append(tuple);
+  }
+  // Free the parent's pages before the children are read back.
+  partition->left_.reset();
+  partition->right_.reset();
+
+  for (auto &child : children) {
+    if (child.left_->GetTupleCount() > 0 && child.right_->GetTupleCount() > 0) {
+      pending_.push_back(std::move(child));
     }
-    return Tuple(values,key_schema_);
+  }
+}
+
+auto HashJoinExecutor::LoadNextPartition() -> bool {
+  hash_table_.Clear();
+  probe_partition_.reset();
+
+  while (!pending_.empty()) {
+    Partition partition = std::move(pending_.back());
+    pending_.pop_back();
+
+    if (partition.left_->GetByteSize() > exec_ctx_->GetWorkMemory() && partition.depth_ < MAX_PARTITION_DEPTH) {
+      Repartition(&partition);
+      continue;
+    }
+
+    // Either it fits, or every tuple shares so few keys that splitting again would not help.
+    Tuple tuple;
+    while (partition.left_->Next(&tuple)) {
+      Build(tuple);
+    }
+    hash_table_.Build();
+    probe_partition_ = std::move(partition.right_);
+    return true;
+  }
+  return false;
+}
+
+auto HashJoinExecutor::NextProbeTuple(Tuple *tuple) -> bool {
+  if (!spilled_) {
+    RID rid;
+    return right_executor_->Next(tuple, &rid);
+  }
+  return probe_partition_ != nullptr && probe_partition_->Next(tuple);
+}
+
+auto HashJoinExecutor::MergeTuple(const Tuple &left, const Tuple &right) -> Tuple {
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema()->GetColumnCount());
+  for (const auto &column : GetOutputSchema()->GetColumns()) {
+    values.push_back(column.GetExpr()->EvaluateJoin(&left, left_schema_, &right, right_schema_));
+  }
+  return Tuple(values, GetOutputSchema());
 }
 
 }  // namespace bustub
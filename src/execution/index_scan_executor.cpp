@@ -11,12 +11,148 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include <memory>
+#include <utility>
+
+#include "common/exception.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "type/value_factory.h"
+
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  Catalog *catalog = exec_ctx_->GetCatalog();
+  index_info_ = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info_->table_name_);
+
+  const Schema &schema = table_info_->schema_;
+  entry_positions_.assign(schema.GetColumnCount(), -1);
+  const auto &entry_attrs = index_info_->index_->GetMetadata()->GetEntryAttrs();
+  for (size_t i = 0; i < entry_attrs.size(); i++) {
+    entry_positions_[entry_attrs[i]] = static_cast<int>(i);
+  }
+  std::vector<bool> columns(schema.GetColumnCount(), false);
+  TableIterator::CollectColumns(plan_->GetPredicate(), &columns);
+  for (const auto &column : GetOutputSchema()->GetColumns()) {
+    if (column.GetExpr() != nullptr) {
+      TableIterator::CollectColumns(column.GetExpr(), &columns);
+    } else {
+      columns[schema.GetColIdx(column.GetName())] = true;
+    }
+  }
+  index_only_ = true;
+  for (size_t i = 0; i < columns.size(); i++) {
+    index_only_ = index_only_ && (!columns[i] || entry_positions_[i] >= 0);
+  }
+  // The index only knows the latest version of a row, a SNAPSHOT transaction reads the version it sees from the heap.
+  if (enable_logging && exec_ctx_->GetTransaction()->GetIsolationLevel() == IsolationLevel::SNAPSHOT) {
+    index_only_ = false;
+  }
+
+  switch (index_info_->key_size_) {
+    case 4:
+      cursor_ = MakeCursor<4>();
+      break;
+    case 8:
+      cursor_ = MakeCursor<8>();
+      break;
+    case 16:
+      cursor_ = MakeCursor<16>();
+      break;
+    case 32:
+      cursor_ = MakeCursor<32>();
+      break;
+    case 64:
+      cursor_ = MakeCursor<64>();
+      break;
+    default:
+      throw NotImplementedException("index scan needs a key size of 4, 8, 16, 32 or 64 bytes");
+  }
+}
+
+template <size_t KeySize>
+auto IndexScanExecutor::MakeCursor() -> EntryCursor {
+  auto *index = dynamic_cast<BPlusTreeIndex<GenericKey<KeySize>, RID, GenericComparator<KeySize>> *>(
+      index_info_->index_.get());
+  if (index == nullptr) {
+    throw NotImplementedException("index scan needs a B+ tree index");
+  }
+  auto iterator = std::make_shared<IndexIterator<GenericKey<KeySize>, RID, GenericComparator<KeySize>>>(
+      index->GetBeginIterator());
+  Schema *entry_schema = index->GetMetadata()->GetEntrySchema();
+  return [iterator, entry_schema](std::vector<Value> *entry, RID *rid) {
+    if (iterator->IsEnd()) {
+      return false;
+    }
+    const auto &[key, value] = **iterator;
+    if (entry != nullptr) {
+      entry->clear();
+      for (uint32_t i = 0; i < entry_schema->GetColumnCount(); i++) {
+        entry->push_back(key.ToValue(entry_schema, i));
+      }
+    }
+    *rid = value;
+    ++(*iterator);
+    return true;
+  };
+}
+
+auto IndexScanExecutor::RowFromEntry(const std::vector<Value> &entry) const -> Tuple {
+  const Schema &schema = table_info_->schema_;
+  std::vector<Value> values;
+  values.reserve(schema.GetColumnCount());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    if (entry_positions_[i] >= 0) {
+      values.push_back(entry[entry_positions_[i]]);
+    } else if (schema.GetColumn(i).GetType() == TypeId::VARCHAR) {
+      // A null varchar would not serialize into a tuple, and the column is never read anyway.
+      values.push_back(ValueFactory::GetVarcharValue(""));
+    } else {
+      values.push_back(ValueFactory::GetNullValueByType(schema.GetColumn(i).GetType()));
+    }
+  }
+  return Tuple(values, &schema);
+}
 
-void IndexScanExecutor::Init() {}
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  const Schema *schema = &table_info_->schema_;
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  std::vector<Value> entry;
+  RID entry_rid;
+  Tuple row;
+  while (cursor_(index_only_ ? &entry : nullptr, &entry_rid)) {
+    if (index_only_) {
+      // The tuple is locked as a heap read would have done, which needs its RID only.
+      LockManager *lock_manager = exec_ctx_->GetLockManager();
+      if (enable_logging && !txn->IsSharedLocked(entry_rid) && !txn->IsExclusiveLocked(entry_rid) &&
+          !lock_manager->LockShared(txn, entry_rid, table_info_->oid_)) {
+        return false;
+      }
+      row = RowFromEntry(entry);
+    } else if (!table_info_->table_->GetTuple(entry_rid, &row, txn)) {
+      continue;
+    }
+    if (predicate != nullptr && !predicate->Evaluate(&row, schema).GetAs<bool>()) {
+      continue;
+    }
 
-auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+    std::vector<Value> values;
+    values.reserve(GetOutputSchema()->GetColumnCount());
+    for (const auto &column : GetOutputSchema()->GetColumns()) {
+      if (column.GetExpr() != nullptr) {
+        values.push_back(column.GetExpr()->Evaluate(&row, schema));
+      } else {
+        values.push_back(row.GetValue(schema, schema->GetColIdx(column.GetName())));
+      }
+    }
+    *tuple = Tuple(std::move(values), GetOutputSchema());
+    *rid = entry_rid;
+    return true;
+  }
+  return false;
+}
 
 }  // namespace bustub
@@ -10,9 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <memory>
+#include <string>
 
 #include "execution/executors/insert_executor.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/sort_key.h"
 
 namespace bustub {
 
@@ -21,47 +27,103 @@ InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *
     : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
 
 void InsertExecutor::Init() {
-    
-    table_info_=exec_ctx_->GetCatalog()->GetTable(plan_->TableOid());
-    index_infos_=exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
-    
-    [[maybe_unused]] RID rid;
+  table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->TableOid());
+  index_infos_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
+  next_raw_ = 0;
+  spool_.reset();
+  if (plan_->IsRawInsert()) {
+    return;
+  }
 
-    if(plan_->IsRawInsert()) {
+  child_executor_->Init();
+  if (ReadsTable(plan_->GetChildPlan(), plan_->TableOid())) {
+    // INSERT INTO t SELECT ... FROM t must not insert what it inserted, so take everything before the first insert.
+    spool_ = std::make_unique<TmpTupleHeap>(exec_ctx_->GetBufferPoolManager());
+    Tuple tuple;
+    RID rid;
+    while (child_executor_->Next(&tuple, &rid)) {
+      spool_->Append(tuple);
+    }
+  }
+}
 
-        assert(child_executor_.get()==nullptr);
-        size_t insert_size=plan_->RawValues().size();
-        for(size_t i=0;i<insert_size;i++) {
-            Tuple tp(plan_->RawValuesAt(i),&table_info_->schema_);
-            
-            table_info_->table_->InsertTuple(tp,&rid,exec_ctx_->GetTransaction());
-            for(auto index_info: index_infos_ ) {
-                index_info->index_->InsertEntry(tp.KeyFromTuple(table_info_->schema_,index_info->key_schema_,
-                                                                index_info->index_->GetKeyAttrs()),rid,exec_ctx_->GetTransaction());
-            } 
-        }
-    } else {
-        assert(child_executor_.get()!=nullptr);
-        std::vector<Tuple> child_result_set;
+auto InsertExecutor::ReadsTable(const AbstractPlanNode *plan, table_oid_t oid) const -> bool {
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+      return dynamic_cast<const SeqScanPlanNode *>(plan)->GetTableOid() == oid;
+    case PlanType::IndexScan: {
+      auto index_oid = dynamic_cast<const IndexScanPlanNode *>(plan)->GetIndexOid();
+      return exec_ctx_->GetCatalog()->GetIndex(index_oid)->table_name_ == table_info_->name_;
+    }
+    case PlanType::NestedIndexJoin:
+      if (dynamic_cast<const NestedIndexJoinPlanNode *>(plan)->GetInnerTableOid() == oid) {
+        return true;
+      }
+      break;
+    default:
+      break;
+  }
+  return std::any_of(plan->GetChildren().begin(), plan->GetChildren().end(),
+                     [&](const AbstractPlanNode *child) { return ReadsTable(child, oid); });
+}
 
-        child_executor_->Init();
+auto InsertExecutor::NextBatch(std::vector<Tuple> *batch) -> bool {
+  batch->clear();
+  if (plan_->IsRawInsert()) {
+    for (; next_raw_ < plan_->RawValues().size() && batch->size() < BATCH_SIZE; next_raw_++) {
+      batch->emplace_back(plan_->RawValuesAt(next_raw_), &table_info_->schema_);
+    }
+    return !batch->empty();
+  }
 
-        Tuple tuple;
-        RID rid;
-        while (child_executor_->Next(&tuple, &rid)) {
-            child_result_set.push_back(tuple);
-        }
+  Tuple tuple;
+  RID rid;
+  while (batch->size() < BATCH_SIZE) {
+    bool found = spool_ != nullptr ? spool_->Next(&tuple) : child_executor_->Next(&tuple, &rid);
+    if (!found) {
+      break;
+    }
+    batch->push_back(std::move(tuple));
+  }
+  return !batch->empty();
+}
+
+auto InsertExecutor::InsertBatch(const std::vector<Tuple> &batch) -> bool {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  std::vector<RID> rids;
+  if (!table_info_->table_->InsertTuples(batch, &rids, txn)) {
+    return false;
+  }
 
-        for(auto tp : child_result_set) {
-            table_info_->table_->InsertTuple(tp,&rid,exec_ctx_->GetTransaction());
-            for(auto index_info: index_infos_ ) {
-                index_info->index_->InsertEntry(tp.KeyFromTuple(index_info->key_schema_,
-                                                table_info_->schema_,index_info->index_->GetKeyAttrs()),rid,exec_ctx_->GetTransaction());
-            }     
-        }
+  // Insert each index's keys in key order, so that consecutive inserts go to neighbouring index pages.
+  std::vector<Tuple> keys;
+  std::vector<std::pair<std::string, size_t>> order;
+  for (auto index_info : index_infos_) {
+    keys.clear();
+    order.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+      keys.push_back(index_info->index_->EntryFromTuple(batch[i], table_info_->schema_));
+      order[i].first.clear();
+      SortKey::Encode(keys[i], *index_info->index_->GetKeySchema(), &order[i].first);
+      order[i].second = i;
+    }
+    std::sort(order.begin(), order.end());
+    for (const auto &[key, i] : order) {
+      index_info->index_->InsertEntry(keys[i], rids[i], txn);
     }
+  }
+  return true;
 }
 
-auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool { return false; }
+auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
+  std::vector<Tuple> batch;
+  batch.reserve(BATCH_SIZE);
+  while (NextBatch(&batch)) {
+    if (!InsertBatch(batch)) {
+      break;
+    }
+  }
+  return false;
+}
 
 }  // namespace bustub
@@ -6,20 +6,172 @@
 //
 // Identification: src/execution/nested_index_join_executor.cpp
 //
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
 
 #include "execution/executors/nested_index_join_executor.h"
 
+#include <algorithm>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/sort_key.h"
+#include "storage/index/b_plus_tree_index.h"
+
 namespace bustub {
 
 NestIndexJoinExecutor::NestIndexJoinExecutor(ExecutorContext *exec_ctx, const NestedIndexJoinPlanNode *plan,
                                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void NestIndexJoinExecutor::Init() {
+  child_executor_->Init();
+  Catalog *catalog = exec_ctx_->GetCatalog();
+  inner_table_ = catalog->GetTable(plan_->GetInnerTableOid());
+  index_ = catalog->GetIndex(plan_->GetIndexName(), inner_table_->name_);
+  if (index_ == Catalog::NULL_INDEX_INFO || index_->index_->GetIndexColumnCount() != 1) {
+    throw NotImplementedException("index join needs a single column index on the inner table");
+  }
+
+  // The predicate is an equality between a column of each side; the outer one gives the probe key.
+  const AbstractExpression *predicate = plan_->Predicate();
+  if (predicate == nullptr || predicate->GetChildren().size() != 2) {
+    throw NotImplementedException("index join needs an equality predicate");
+  }
+  const AbstractExpression *outer_key = predicate->GetChildAt(0);
+  auto column = dynamic_cast<const ColumnValueExpression *>(outer_key);
+  if (column != nullptr && column->GetTupleIdx() != 0) {
+    outer_key = predicate->GetChildAt(1);
+  }
+  outer_key_ = {{OrderByType::Asc, outer_key}};
+  results_.clear();
+  next_result_ = 0;
+}
+
+auto NestIndexJoinExecutor::MakeProbe() -> KeyProbe {
+  switch (index_->key_size_) {
+    case 4:
+      return MakeProbe<4>();
+    case 8:
+      return MakeProbe<8>();
+    case 16:
+      return MakeProbe<16>();
+    case 32:
+      return MakeProbe<32>();
+    case 64:
+      return MakeProbe<64>();
+    default:
+      return MakeScanProbe();
+  }
+}
+
+template <size_t KeySize>
+auto NestIndexJoinExecutor::MakeProbe() -> KeyProbe {
+  using TreeIndex = BPlusTreeIndex<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+  auto *index = dynamic_cast<TreeIndex *>(index_->index_.get());
+  if (index == nullptr) {
+    return MakeScanProbe();
+  }
+  // Compares the key columns only, any entry with the probe's key matches.
+  GenericComparator<KeySize> comparator(index->GetMetadata()->GetKeySchema());
+  auto iterator = std::make_shared<IndexIterator<GenericKey<KeySize>, RID, GenericComparator<KeySize>>>();
+  return [index, comparator, iterator](const Tuple &key, std::vector<RID> *rids) {
+    GenericKey<KeySize> probe;
+    probe.SetFromKey(key);
+    // The probes come in ascending order, so the next key is usually a few entries ahead in the leaf already copied.
+    size_t skipped = 0;
+    while (!iterator->IsEnd() && comparator((**iterator).first, probe) < 0 && skipped < MAX_PROBE_SKIP) {
+      ++(*iterator);
+      skipped++;
+    }
+    if (iterator->IsEnd() || comparator((**iterator).first, probe) != 0) {
+      *iterator = index->GetBeginIterator(probe);
+    }
+    for (; !iterator->IsEnd() && comparator((**iterator).first, probe) == 0; ++(*iterator)) {
+      rids->push_back((**iterator).second);
+    }
+  };
+}
+
+auto NestIndexJoinExecutor::MakeScanProbe() -> KeyProbe {
+  return [this](const Tuple &key, std::vector<RID> *rids) {
+    index_->index_->ScanKey(key, rids, exec_ctx_->GetTransaction());
+  };
+}
+
+auto NestIndexJoinExecutor::JoinNextBatch() -> bool {
+  results_.clear();
+  next_result_ = 0;
+
+  std::vector<Tuple> outer;
+  outer.reserve(BATCH_SIZE);
+  Tuple tuple;
+  RID rid;
+  while (outer.size() < BATCH_SIZE && child_executor_->Next(&tuple, &rid)) {
+    outer.push_back(std::move(tuple));
+  }
+  if (outer.empty()) {
+    return false;
+  }
+
+  const Schema *outer_schema = child_executor_->GetOutputSchema();
+  std::vector<std::pair<std::string, size_t>> keys(outer.size());
+  for (size_t i = 0; i < outer.size(); i++) {
+    SortKey::Encode(outer_key_, outer[i], *outer_schema, &keys[i].first);
+    keys[i].second = i;
+  }
+  std::sort(keys.begin(), keys.end());
+
+  // Probe once per distinct key; the keys are sorted, so duplicates are adjacent.
+  KeyProbe probe = MakeProbe();
+  std::vector<std::pair<RID, size_t>> matches;
+  std::vector<RID> rids;
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (i == 0 || keys[i].first != keys[i - 1].first) {
+      rids.clear();
+      Value key = outer_key_[0].second->Evaluate(&outer[keys[i].second], outer_schema);
+      if (!key.IsNull()) {
+        probe(Tuple({key}, &index_->key_schema_), &rids);
+      }
+    }
+    for (const auto &match : rids) {
+      matches.emplace_back(match, keys[i].second);
+    }
+  }
+  std::sort(matches.begin(), matches.end(),
+            [](const auto &left, const auto &right) { return left.first.Get() < right.first.Get(); });
 
-void NestIndexJoinExecutor::Init() {}
+  // Read the matches in heap order, which visits each inner page once. The heap locks the tuple and resolves the
+  // version the transaction sees.
+  Transaction *txn = exec_ctx_->GetTransaction();
+  const Schema *inner_schema = &inner_table_->schema_;
+  const AbstractExpression *predicate = plan_->Predicate();
+  Tuple inner;
+  for (const auto &[inner_rid, outer_idx] : matches) {
+    const Tuple &left = outer[outer_idx];
+    if (!inner_table_->table_->GetTuple(inner_rid, &inner, txn) ||
+        !predicate->EvaluateJoin(&left, outer_schema, &inner, inner_schema).GetAs<bool>()) {
+      continue;
+    }
+    std::vector<Value> values;
+    values.reserve(GetOutputSchema()->GetColumnCount());
+    for (const auto &column : GetOutputSchema()->GetColumns()) {
+      values.push_back(column.GetExpr()->EvaluateJoin(&left, outer_schema, &inner, inner_schema));
+    }
+    results_.emplace_back(values, GetOutputSchema());
+  }
+  return true;
+}
 
-auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (next_result_ == results_.size()) {
+    if (!JoinNextBatch()) {
+      return false;
+    }
+  }
+  *tuple = std::move(results_[next_result_++]);
+  *rid = RID();
+  return true;
+}
 
 }  // namespace bustub
@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// repartition_executor.cpp
+//
+// Identification: src/execution/repartition_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/repartition_executor.h"
+
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+RepartitionExecutor::RepartitionExecutor(ExecutorContext *exec_ctx, const RepartitionPlanNode *plan,
+                                         std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void RepartitionExecutor::Init() {
+  PipelineState *pipeline = exec_ctx_->GetPipeline();
+  state_ = pipeline == nullptr ? nullptr : pipeline->GetRepartition(plan_);
+  if (state_ == nullptr) {
+    child_executor_->Init();
+    return;
+  }
+  producer_ = 0;
+  for (size_t producer = 0; producer < state_->GetNumProducers(); producer++) {
+    state_->GetRun(producer, exec_ctx_->GetWorkerId())->Rewind();
+  }
+}
+
+auto RepartitionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (state_ == nullptr) {
+    return child_executor_->Next(tuple, rid);
+  }
+  for (; producer_ < state_->GetNumProducers(); producer_++) {
+    if (state_->GetRun(producer_, exec_ctx_->GetWorkerId())->Next(tuple)) {
+      *rid = tuple->GetRid();
+      return true;
+    }
+  }
+  return false;
+}
+
+auto RepartitionExecutor::PartitionOf(const RepartitionPlanNode *plan, const Tuple &tuple, const Schema *schema,
+                                      size_t num_partitions) -> size_t {
+  hash_t hash = 0;
+  for (const auto *key : plan->GetKeys()) {
+    Value value = key->Evaluate(&tuple, schema);
+    if (!value.IsNull()) {
+      hash = HashUtil::CombineHashes(hash, HashUtil::HashValue(&value));
+    }
+  }
+  return HashUtil::MixHash(hash) % num_partitions;
+}
+
+}  // namespace bustub
@@ -12,63 +12,54 @@
 
 #include "execution/executors/seq_scan_executor.h"
 
+#include "common/config.h"
+#include "execution/executors/gather_executor.h"
+
 namespace bustub {
 
-SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) 
-                                : AbstractExecutor(exec_ctx), plan_(plan), iterator_(nullptr,RID(),nullptr) {}
+SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan), iterator_(nullptr, RID(), nullptr) {}
 
 void SeqScanExecutor::Init() {
-    key_attrs_.clear();
-    
-    uint32_t column_idx;
-    std::string column_name;
-    uint32_t column_count=plan_->OutputSchema()->GetColumnCount();    
-    table_info_=exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
-    iterator_=table_info_->table_.get()->Begin(exec_ctx_->GetTransaction());
-  
-    for(uint32_t i=0;i<column_count;i++){
-        column_name.assign(plan_->OutputSchema()->GetColumn(i).GetName());
-        try
-        {
-           column_idx=table_info_->schema_.GetColIdx(column_name);
-        }
-        catch(const std::exception& e)
-        {
-            std::cerr << e.what() << '\n';
-            return;
-        }
-        key_attrs_.push_back(column_idx);
-    }
+  gather_.reset();
+  table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+  PipelineState *pipeline = exec_ctx_->GetPipeline();
+  morsels_ = pipeline == nullptr ? nullptr : pipeline->GetScan(plan_);
+  if (morsels_ != nullptr) {
+    // A copy of a parallel scan starts with an exhausted iterator and claims its first morsel in Next.
+    iterator_ = table_info_->table_->End();
+    return;
+  }
+  // Copies would take tuple locks on behalf of the transaction concurrently, which it does not support.
+  if (exec_ctx_->GetNumThreads() > 1 && !enable_logging &&
+      MorselSource::NumMorsels(table_info_->table_->GetFreeSpaceMap()->GetPageCount()) > 1) {
+    gather_ = std::make_unique<GatherExecutor>(exec_ctx_, plan_);
+    gather_->Init();
+    return;
+  }
+  // The predicate and the projection are both evaluated inside the iterator against a view of the page, so tuples
+  // that do not qualify are never copied out of the buffer pool.
+  iterator_ = table_info_->table_->Begin(exec_ctx_->GetTransaction(), plan_->GetPredicate(), &table_info_->schema_,
+                                         plan_->OutputSchema());
 }
 
 auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-
-    const AbstractExpression* predicate=plan_->GetPredicate();
-    Schema schema=table_info_->schema_;
-    const Schema* key_schema=plan_->OutputSchema();
-    TableIterator end =table_info_->table_.get()->End();
-
-    if(iterator_==end) {
-        return false;
-    }
-    if(predicate!=nullptr) {
-        for(;iterator_!=end;iterator_++) {
-            Tuple tp= iterator_->KeyFromTuple(table_info_->schema_,*key_schema,key_attrs_);
-            if(predicate->Evaluate(&tp,&schema).GetAs<bool>()) {
-                *tuple=tp;
-                *rid=iterator_->GetRid();
-                iterator_++;
-                return true;
-            }
-        }
-        return false;
-    } else {
-        Tuple tp=iterator_->KeyFromTuple(table_info_->schema_,*key_schema,key_attrs_);
-        *rid=iterator_->GetRid();
-        *tuple=tp;
-        iterator_++;
-        return true;
+  if (gather_ != nullptr) {
+    return gather_->Next(tuple, rid);
+  }
+  while (iterator_.IsEnd()) {
+    page_id_t first_page_id;
+    page_id_t stop_page_id;
+    if (morsels_ == nullptr || !morsels_->Next(&first_page_id, &stop_page_id)) {
+      return false;
     }
+    iterator_ = table_info_->table_->Begin(exec_ctx_->GetTransaction(), plan_->GetPredicate(), &table_info_->schema_,
+                                           plan_->OutputSchema(), first_page_id, stop_page_id);
+  }
+  *tuple = *iterator_;
+  *rid = tuple->GetRid();
+  ++iterator_;
+  return true;
 }
 
 }  // namespace bustub
@@ -0,0 +1,199 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.cpp
+//
+// Identification: src/execution/sort_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/sort_executor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "execution/sort_key.h"
+
+namespace bustub {
+
+namespace {
+
+auto RecordKeySize(const char *record) -> uint32_t {
+  uint32_t key_size;
+  memcpy(&key_size, record, sizeof(uint32_t));
+  return key_size;
+}
+
+/** @return whether record left sorts before record right */
+auto RecordLess(const char *left, const char *right) -> bool {
+  uint32_t left_size = RecordKeySize(left);
+  uint32_t right_size = RecordKeySize(right);
+  return SortKey::Compare(left + sizeof(uint32_t), left_size, right + sizeof(uint32_t), right_size) < 0;
+}
+
+/** @return the size of a whole record */
+auto RecordSize(const char *record) -> uint32_t {
+  uint32_t key_size = RecordKeySize(record);
+  uint32_t tuple_size;
+  memcpy(&tuple_size, record + sizeof(uint32_t) + key_size, sizeof(uint32_t));
+  return 2 * sizeof(uint32_t) + key_size + tuple_size;
+}
+
+/** Copy the tuple out of a record. */
+void RecordToTuple(const char *record, Tuple *tuple) {
+  tuple->DeserializeFrom(record + sizeof(uint32_t) + RecordKeySize(record));
+}
+
+}  // namespace
+
+/** A k-way merge of sorted runs, driven by a binary heap of the runs' current records. */
+class SortExecutor::RunMerger {
+ public:
+  explicit RunMerger(std::vector<std::unique_ptr<TmpTupleHeap>> runs) : runs_(std::move(runs)), heads_(runs_.size()) {
+    for (size_t i = 0; i < runs_.size(); i++) {
+      if (runs_[i]->Next(&heads_[i])) {
+        heap_.push_back(i);
+      }
+    }
+    std::make_heap(heap_.begin(), heap_.end(), Greater());
+  }
+
+  /**
+   * @param[out] record the smallest record left; its data is the raw record
+   * @return false once every run is exhausted
+   */
+  auto Next(Tuple *record) -> bool {
+    if (heap_.empty()) {
+      return false;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), Greater());
+    size_t run = heap_.back();
+    *record = std::move(heads_[run]);
+    if (runs_[run]->Next(&heads_[run])) {
+      std::push_heap(heap_.begin(), heap_.end(), Greater());
+    } else {
+      heap_.pop_back();
+    }
+    return true;
+  }
+
+ private:
+  /** Orders the heap so that the run with the smallest record is on top */
+  struct HeadGreater {
+    auto operator()(size_t left, size_t right) const -> bool {
+      return RecordLess((*heads_)[right].GetData(), (*heads_)[left].GetData());
+    }
+    const std::vector<Tuple> *heads_;
+  };
+
+  auto Greater() const -> HeadGreater { return {&heads_}; }
+
+  std::vector<std::unique_ptr<TmpTupleHeap>> runs_;
+  std::vector<Tuple> heads_;
+  std::vector<size_t> heap_;
+};
+
+SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
+                           std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+SortExecutor::~SortExecutor() = default;
+
+void SortExecutor::Init() {
+  child_executor_->Init();
+  arena_.clear();
+  records_.clear();
+  next_record_ = 0;
+  runs_.clear();
+  merger_.reset();
+
+  Tuple tuple;
+  RID rid;
+  while (child_executor_->Next(&tuple, &rid)) {
+    AddRecord(tuple);
+    if (arena_.size() + records_.size() * sizeof(size_t) > exec_ctx_->GetWorkMemory()) {
+      SpillRun();
+    }
+  }
+
+  if (runs_.empty()) {
+    SortRecords();
+    return;
+  }
+  if (!records_.empty()) {
+    SpillRun();
+  }
+  MergeRuns();
+}
+
+void SortExecutor::AddRecord(const Tuple &tuple) {
+  key_.clear();
+  SortKey::Encode(plan_->GetOrderBy(), tuple, *child_executor_->GetOutputSchema(), &key_);
+
+  auto key_size = static_cast<uint32_t>(key_.size());
+  size_t offset = arena_.size();
+  arena_.resize(offset + sizeof(uint32_t) + key_size + sizeof(uint32_t) + tuple.GetLength());
+  memcpy(arena_.data() + offset, &key_size, sizeof(uint32_t));
+  memcpy(arena_.data() + offset + sizeof(uint32_t), key_.data(), key_size);
+  tuple.SerializeTo(arena_.data() + offset + sizeof(uint32_t) + key_size);
+  records_.push_back(offset);
+}
+
+void SortExecutor::SortRecords() {
+  const char *arena = arena_.data();
+  std::sort(records_.begin(), records_.end(),
+            [arena](size_t left, size_t right) { return RecordLess(arena + left, arena + right); });
+}
+
+void SortExecutor::SpillRun() {
+  SortRecords();
+  auto run = std::make_unique<TmpTupleHeap>(exec_ctx_->GetBufferPoolManager());
+  for (size_t offset : records_) {
+    const char *record = arena_.data() + offset;
+    run->Append(record, RecordSize(record));
+  }
+  runs_.push_back(std::move(run));
+  arena_.clear();
+  records_.clear();
+}
+
+void SortExecutor::MergeRuns() {
+  while (runs_.size() > MAX_MERGE_FAN_IN) {
+    std::vector<std::unique_ptr<TmpTupleHeap>> merged;
+    for (size_t begin = 0; begin < runs_.size(); begin += MAX_MERGE_FAN_IN) {
+      size_t end = std::min(begin + MAX_MERGE_FAN_IN, runs_.size());
+      RunMerger merger({std::make_move_iterator(runs_.begin() + begin), std::make_move_iterator(runs_.begin() + end)});
+      auto run = std::make_unique<TmpTupleHeap>(exec_ctx_->GetBufferPoolManager());
+      Tuple record;
+      while (merger.Next(&record)) {
+        run->Append(record.GetData(), record.GetLength());
+      }
+      merged.push_back(std::move(run));
+    }
+    runs_ = std::move(merged);
+  }
+  merger_ = std::make_unique<RunMerger>(std::move(runs_));
+  runs_.clear();
+}
+
+auto SortExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (merger_ != nullptr) {
+    Tuple record;
+    if (!merger_->Next(&record)) {
+      return false;
+    }
+    RecordToTuple(record.GetData(), tuple);
+  } else {
+    if (next_record_ == records_.size()) {
+      return false;
+    }
+    RecordToTuple(arena_.data() + records_[next_record_++], tuple);
+  }
+  *rid = RID();
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.cpp
+//
+// Identification: src/execution/sort_key.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/sort_key.h"
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+/** Append the low `bytes` bytes of value, most significant first. */
+void AppendBigEndian(uint64_t value, size_t bytes, std::string *out) {
+  for (size_t i = bytes; i > 0; i--) {
+    out->push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xFF));
+  }
+}
+
+}  // namespace
+
+void SortKey::Encode(const std::vector<OrderBy> &order_bys, const Tuple &tuple, const Schema &schema,
+                     std::string *out) {
+  for (const auto &[type, expr] : order_bys) {
+    size_t begin = out->size();
+    EncodeValue(expr->Evaluate(&tuple, &schema), out);
+    if (type == OrderByType::Desc) {
+      for (size_t i = begin; i < out->size(); i++) {
+        (*out)[i] = static_cast<char>(~(*out)[i]);
+      }
+    }
+  }
+}
+
+void SortKey::Encode(const Tuple &tuple, const Schema &schema, std::string *out) {
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    EncodeValue(tuple.GetValue(&schema, i), out);
+  }
+}
+
+void SortKey::EncodeValue(const Value &value, std::string *out) {
+  if (value.IsNull()) {
+    out->push_back(0);
+    return;
+  }
+  out->push_back(1);
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+      out->push_back(static_cast<char>(value.GetAs<int8_t>()));
+      break;
+    case TypeId::TINYINT:
+      AppendBigEndian(static_cast<uint8_t>(value.GetAs<int8_t>()) ^ 0x80U, 1, out);
+      break;
+    case TypeId::SMALLINT:
+      AppendBigEndian(static_cast<uint16_t>(value.GetAs<int16_t>()) ^ 0x8000U, 2, out);
+      break;
+    case TypeId::INTEGER:
+      AppendBigEndian(static_cast<uint32_t>(value.GetAs<int32_t>()) ^ 0x80000000U, 4, out);
+      break;
+    case TypeId::BIGINT:
+      AppendBigEndian(static_cast<uint64_t>(value.GetAs<int64_t>()) ^ (1ULL << 63), 8, out);
+      break;
+    case TypeId::TIMESTAMP:
+      AppendBigEndian(value.GetAs<uint64_t>(), 8, out);
+      break;
+    case TypeId::DECIMAL: {
+      double decimal = value.GetAs<double>();
+      uint64_t bits;
+      memcpy(&bits, &decimal, sizeof(bits));
+      // Negative numbers order backwards in IEEE 754, so flip all of their bits; positives only need the sign bit set.
+      bits = (bits >> 63) != 0 ? ~bits : bits ^ (1ULL << 63);
+      AppendBigEndian(bits, 8, out);
+      break;
+    }
+    case TypeId::VARCHAR: {
+      // The stored length counts the terminating '\0'.
+      const char *data = value.GetData();
+      uint32_t length = value.GetLength() - 1;
+      for (uint32_t i = 0; i < length; i++) {
+        out->push_back(data[i]);
+        if (data[i] == 0) {
+          out->push_back(static_cast<char>(0xFF));
+        }
+      }
+      out->push_back(0);
+      out->push_back(0);
+      break;
+    }
+    default:
+      throw Exception(ExceptionType::MISMATCH_TYPE, "Cannot sort on this type.");
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_executor.cpp
+//
+// Identification: src/execution/topn_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/topn_executor.h"
+
+#include <algorithm>
+
+#include "execution/sort_key.h"
+
+namespace bustub {
+
+namespace {
+
+auto KeyLess(const std::string &left, const std::string &right) -> bool {
+  return SortKey::Compare(left.data(), left.size(), right.data(), right.size()) < 0;
+}
+
+}  // namespace
+
+TopNExecutor::TopNExecutor(ExecutorContext *exec_ctx, const TopNPlanNode *plan,
+                           std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx),
+      output_schema_(plan->OutputSchema()),
+      order_bys_(&plan->GetOrderBy()),
+      n_(plan->GetN()),
+      child_executor_(std::move(child_executor)) {}
+
+TopNExecutor::TopNExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *limit_plan, const SortPlanNode *sort_plan,
+                           std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx),
+      output_schema_(sort_plan->OutputSchema()),
+      order_bys_(&sort_plan->GetOrderBy()),
+      n_(limit_plan->GetLimit()),
+      child_executor_(std::move(child_executor)) {}
+
+void TopNExecutor::Init() {
+  child_executor_->Init();
+  entries_.clear();
+  next_entry_ = 0;
+  if (n_ == 0) {
+    return;
+  }
+
+  auto heap_less = [](const Entry &left, const Entry &right) { return KeyLess(left.key_, right.key_); };
+  const Schema *child_schema = child_executor_->GetOutputSchema();
+  std::string key;
+  Tuple tuple;
+  RID rid;
+  while (child_executor_->Next(&tuple, &rid)) {
+    key.clear();
+    SortKey::Encode(*order_bys_, tuple, *child_schema, &key);
+    if (entries_.size() == n_) {
+      if (!KeyLess(key, entries_.front().key_)) {
+        continue;
+      }
+      std::pop_heap(entries_.begin(), entries_.end(), heap_less);
+      entries_.pop_back();
+    }
+
+    entries_.push_back({key, tuple});
+    std::push_heap(entries_.begin(), entries_.end(), heap_less);
+  }
+  std::sort_heap(entries_.begin(), entries_.end(), heap_less);
+}
+
+auto TopNExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (next_entry_ == entries_.size()) {
+    return false;
+  }
+  *tuple = entries_[next_entry_++].tuple_;
+  *rid = RID();
+  return true;
+}
+
+}  // namespace bustub
@@ -9,6 +9,8 @@
 // Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <algorithm>
+#include <cstring>
 #include <memory>
 
 #include "execution/executors/update_executor.h"
@@ -21,25 +23,40 @@ UpdateExecutor::UpdateExecutor(ExecutorContext *exec_ctx, const UpdatePlanNode *
 
 void UpdateExecutor::Init() {
   table_info_=exec_ctx_->GetCatalog()->GetTable(plan_->TableOid());
-  index_infos_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
   txn_=exec_ctx_->GetTransaction();
-  if(child_executor_.get()==nullptr) {
+  // The new version takes the place of the old one under the same rid, so an index only changes if its entry does.
+  // One that has no column the update sets keeps its entries as they are.
+  const auto &update_attrs = plan_->GetUpdateAttr();
+  index_infos_.clear();
+  for (auto index_info : exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_)) {
+    const auto &attrs = index_info->index_->GetMetadata()->GetEntryAttrs();
+    if (std::any_of(attrs.begin(), attrs.end(), [&](uint32_t attr) { return update_attrs.count(attr) != 0; })) {
+      index_infos_.push_back(index_info);
+    }
+  }
+  if (child_executor_ == nullptr) {
     return;
-  } else {
-    assert(child_executor_.get()!=nullptr);
-    Tuple tuple;
-    Tuple update_tuple;
-    RID rid;
+  }
 
-    child_executor_->Init();
-    
-    while(child_executor_->Next(&tuple,&rid)) {
-      update_tuple=GenerateUpdatedTuple(tuple);
-      table_info_->table_->UpdateTuple(update_tuple,rid,txn_);
-      for(auto index_info: index_infos_) {
-        index_info->index_->DeleteEntry(tuple,rid,txn_);
-        index_info->index_->InsertEntry(update_tuple,rid,txn_);
+  Tuple tuple;
+  Tuple update_tuple;
+  RID rid;
+  child_executor_->Init();
+  while (child_executor_->Next(&tuple, &rid)) {
+    update_tuple = GenerateUpdatedTuple(tuple);
+    if (!table_info_->table_->UpdateTuple(update_tuple, rid, txn_)) {
+      continue;
+    }
+    for (auto index_info : index_infos_) {
+      Tuple old_entry = index_info->index_->EntryFromTuple(tuple, table_info_->schema_);
+      Tuple new_entry = index_info->index_->EntryFromTuple(update_tuple, table_info_->schema_);
+      // A counter bumped by zero, or set to the value it had, leaves the entry and the index page alone.
+      if (old_entry.GetLength() == new_entry.GetLength() &&
+          memcmp(old_entry.GetData(), new_entry.GetData(), old_entry.GetLength()) == 0) {
+        continue;
       }
+      index_info->index_->DeleteEntry(old_entry, rid, txn_);
+      index_info->index_->InsertEntry(new_entry, rid, txn_);
     }
   }
 }
@@ -48,7 +65,7 @@ auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool { ret
 
 auto UpdateExecutor::GenerateUpdatedTuple(const Tuple &src_tuple) -> Tuple {
   const auto &update_attrs = plan_->GetUpdateAttr();
-  Schema schema = table_info_->schema_;
+  const Schema &schema = table_info_->schema_;
   uint32_t col_count = schema.GetColumnCount();
   std::vector<Value> values;
   for (uint32_t idx = 0; idx < col_count; idx++) {
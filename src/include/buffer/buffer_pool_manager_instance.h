@@ -58,8 +58,6 @@ class BufferPoolManagerInstance : public BufferPoolManager {
 
   /** @return pointer to all the pages in the buffer pool */
   auto GetPages() -> Page * { return pages_; }
-  void Latch() { latch_.lock(); }
-  void UnLatch() { latch_.unlock(); }
 
  protected:
   /**
@@ -143,6 +141,9 @@ class BufferPoolManagerInstance : public BufferPoolManager {
 
   auto GetFrameID() -> frame_id_t;
 
+  /** Write a page to disk, once the log records of its changes are there */
+  void WriteBack(Page *page);
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
@@ -157,14 +158,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
   /** Page table for keeping track of buffer pool pages. */
   std::unordered_map<page_id_t, frame_id_t> page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** This latch protects the page table, the free list, the replacer and the frame metadata of every page. */
   std::mutex latch_;
   // size_t cur_pool_size_=0;
   // std::mutex replacer_latch_;
@@ -21,6 +21,7 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
 #include "storage/table/table_heap.h"
@@ -119,18 +120,22 @@ class Catalog {
    * @param txn The transaction in which the table is being created
    * @param table_name The name of the new table
    * @param schema The schema of the new table
+   * @param format The layout of the table's pages, TablePageFormat::PAX for tables that are mostly scanned and
+   * TablePageFormat::COMPRESSED for cold ones that are also rarely updated
    * @return A (non-owning) pointer to the metadata for the table
    */
-  auto CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) -> TableInfo * {
+  auto CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                   TablePageFormat format = TablePageFormat::SLOTTED) -> TableInfo * {
     if (table_names_.count(table_name) != 0) {
       return NULL_TABLE_INFO;
     }
 
     // Construct the table heap
-    auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn);
+    auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn, format, &schema);
 
-    // Fetch the table OID for the new table
+    // Fetch the table OID for the new table, its rows are locked under it
     const auto table_oid = next_table_oid_.fetch_add(1);
+    table->SetTableOid(table_oid);
 
     // Construct the table information
     auto meta = std::make_unique<TableInfo>(schema, table_name, std::move(table), table_oid);
@@ -192,19 +197,7 @@ class Catalog {
   auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
                    const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
                    HashFunction<KeyType> hash_function) -> IndexInfo * {
-    // Reject the creation request for nonexistent table
-
-    if (table_names_.find(table_name) == table_names_.end()) {
-      return NULL_INDEX_INFO;
-    }
-
-    // If the table exists, an entry for the table should already be present in index_names_
-    BUSTUB_ASSERT((index_names_.find(table_name) != index_names_.end()), "Broken Invariant");
-
-    // Determine if the requested index already exists for this table
-    auto &table_indexes = index_names_.find(table_name)->second;
-    if (table_indexes.find(index_name) != table_indexes.end()) {
-      // The requested index already exists for this table
+    if (!CanCreateIndex(index_name, table_name)) {
       return NULL_INDEX_INFO;
     }
 
@@ -217,29 +210,37 @@ class Catalog {
     // just the key, value, and comparator types
     auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
                                                                                                hash_function);
+    return AddIndex(txn, table_name, key_schema, keysize, std::move(index));
+  }
 
-    // Populate the index with all tuples in table heap
-    // [[maybe_unused]] int i=0;
-    auto *table_meta = GetTable(table_name);
-    auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
-
+  /**
+   * Create a new B+ tree index, populate existing data of the table and return its metadata.
+   *
+   * Its entries hold the include_attrs columns of each tuple after the key columns, so an index scan that only needs
+   * the key and INCLUDE columns is answered from the leaf pages without reading the table. Every tuple has an entry,
+   * the entries of equal keys are ordered by RID.
+   *
+   * @param txn The transaction in which the table is being created
+   * @param index_name The name of the new index
+   * @param table_name The name of the table
+   * @param schema The schema of the table
+   * @param key_schema The schema of the key
+   * @param key_attrs Key attributes
+   * @param keysize Size of the key, it must hold a whole entry including the INCLUDE columns
+   * @param include_attrs The table columns stored in the entries after the key columns
+   * @return A (non-owning) pointer to the metadata of the new table
+   */
+  template <class KeyType, class ValueType, class KeyComparator>
+  auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
+                   const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
+                   const std::vector<uint32_t> &include_attrs = {}) -> IndexInfo * {
+    if (!CanCreateIndex(index_name, table_name)) {
+      return NULL_INDEX_INFO;
     }
-    // std::cout<<"keysize"<<sizeof(KeyType)<<" "<<"valuesize"<<sizeof(ValueType)<<"\n";
-    // Get the next OID for the new index
-    const auto index_oid = next_index_oid_.fetch_add(1);
-
-    // Construct index information; IndexInfo takes ownership of the Index itself
-    auto index_info =
-        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
-    auto *tmp = index_info.get();
-
-    // Update internal tracking
-    indexes_.emplace(index_oid, std::move(index_info));
-    table_indexes.emplace(index_name, index_oid);
-
-    return tmp;
+    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs, include_attrs);
+    BUSTUB_ASSERT(meta->GetEntrySchema()->GetLength() <= sizeof(KeyType), "The index entry does not fit in a key");
+    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    return AddIndex(txn, table_name, key_schema, keysize, std::move(index));
   }
 
   /**
@@ -326,6 +327,47 @@ class Catalog {
   }
 
  private:
+  /** @return true if table_name exists and has no index named index_name */
+  auto CanCreateIndex(const std::string &index_name, const std::string &table_name) -> bool {
+    // Reject the creation request for nonexistent table
+    if (table_names_.find(table_name) == table_names_.end()) {
+      return false;
+    }
+
+    // If the table exists, an entry for the table should already be present in index_names_
+    BUSTUB_ASSERT((index_names_.find(table_name) != index_names_.end()), "Broken Invariant");
+
+    // Determine if the requested index already exists for this table
+    const auto &table_indexes = index_names_.find(table_name)->second;
+    return table_indexes.find(index_name) == table_indexes.end();
+  }
+
+  /** Populate a new index with the tuples of its table, register it and return its metadata */
+  auto AddIndex(Transaction *txn, const std::string &table_name, const Schema &key_schema, std::size_t keysize,
+                std::unique_ptr<Index> index) -> IndexInfo * {
+    // Populate the index with all tuples in table heap
+    auto *table_meta = GetTable(table_name);
+    auto *heap = table_meta->table_.get();
+    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
+      index->InsertEntry(index->EntryFromTuple(*tuple, table_meta->schema_), tuple->GetRid(), txn);
+    }
+
+    // Get the next OID for the new index
+    const auto index_oid = next_index_oid_.fetch_add(1);
+
+    // Construct index information; IndexInfo takes ownership of the Index itself
+    std::string index_name = index->GetName();
+    auto index_info =
+        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    auto *tmp = index_info.get();
+
+    // Update internal tracking
+    indexes_.emplace(index_oid, std::move(index_info));
+    index_names_.find(table_name)->second.emplace(index_name, index_oid);
+
+    return tmp;
+  }
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
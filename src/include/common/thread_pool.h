@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_pool.h
+//
+// Identification: src/include/common/thread_pool.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * A work-stealing thread pool.
+ *
+ * Every worker owns a deque of tasks. A task submitted from a worker goes to the back of that worker's deque and is
+ * run from there, newest first, while it is still hot in the cache; a task submitted from any other thread is dealt
+ * round-robin. A worker whose deque is empty steals the oldest task of another worker.
+ *
+ * Tasks must not block waiting for other tasks of the pool: with every worker blocked, the task they wait for would
+ * never run. Operators therefore cut long-running work into tasks that either finish or resubmit themselves.
+ */
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t num_threads);
+
+  /** Wait for the queued tasks to run, then stop the workers. */
+  ~ThreadPool();
+
+  DISALLOW_COPY_AND_MOVE(ThreadPool);
+
+  /** Queue a task to run on some worker. */
+  void Submit(std::function<void()> task);
+
+  /** @return the number of workers */
+  auto GetNumThreads() const -> size_t { return workers_.size(); }
+
+  /** @return the index of the calling worker of this pool in [0, GetNumThreads()), or GetNumThreads() elsewhere */
+  auto GetWorkerIndex() const -> size_t;
+
+ private:
+  struct Worker {
+    std::mutex latch_;
+    std::deque<std::function<void()>> tasks_;
+  };
+
+  /** Take a task for worker `self`: its own newest, or else the oldest of another worker */
+  auto Take(size_t self, std::function<void()> *task) -> bool;
+
+  void WorkerLoop(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_worker_{0};
+  /** Queued tasks that no worker has taken yet */
+  std::atomic<size_t> queued_{0};
+  std::mutex sleep_latch_;
+  std::condition_variable wakeup_;
+  bool stop_{false};
+};
+
+/**
+ * A set of tasks submitted to a ThreadPool that can be waited for together. The first exception thrown by a task is
+ * rethrown by Wait.
+ *
+ * The group queues its tasks itself and submits one pool task per task that runs the oldest one still queued. A
+ * waiting thread runs queued tasks of its group too, but never those of another group: one of those could block the
+ * waiter on work that needs it.
+ */
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool *pool) : pool_(pool) {}
+
+  /** Wait for every task, dropping their exceptions. */
+  ~TaskGroup();
+
+  DISALLOW_COPY_AND_MOVE(TaskGroup);
+
+  /** Queue a task of this group. */
+  void Submit(std::function<void()> task);
+
+  /** Run queued tasks of this group on the calling thread until at most `max_pending` of them have not finished. */
+  void WaitBelow(size_t max_pending);
+
+  /** Wait until every task of this group finished, then rethrow the first exception one of them threw. */
+  void Wait();
+
+ private:
+  /** What the group shares with its pool tasks, which outlive it when a waiting thread ran their task */
+  struct State {
+    /**
+     * Run the oldest queued task on the calling thread.
+     * @param lock holds latch_, released while the task runs
+     * @return false if no task was queued
+     */
+    auto RunQueued(std::unique_lock<std::mutex> *lock) -> bool;
+
+    std::mutex latch_;
+    /** Notified when a task is queued or finishes */
+    std::condition_variable changed_;
+    std::deque<std::function<void()>> tasks_;
+    /** Tasks that have not finished, queued or running */
+    size_t pending_{0};
+    std::exception_ptr error_;
+  };
+
+  ThreadPool *pool_;
+  std::shared_ptr<State> state_{std::make_shared<State>()};
+};
+
+}  // namespace bustub
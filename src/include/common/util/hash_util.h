@@ -13,6 +13,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <string>
@@ -30,12 +31,14 @@ class HashUtil {
 
  public:
   static inline auto HashBytes(const char *bytes, size_t length) -> hash_t {
-    // https://github.com/greenplum-db/gpos/blob/b53c1acd6285de94044ff91fbee91589543feba1/libgpos/src/utils.cpp#L126
-    hash_t hash = length;
+    // 64-bit FNV-1a. The rotate-xor hash this replaces was written for 32-bit words and sign-extended every byte, so
+    // with a 64-bit hash_t it mapped 200k consecutive integers onto about 50k distinct hashes.
+    uint64_t hash = 14695981039346656037ULL;
     for (size_t i = 0; i < length; ++i) {
-      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+      hash ^= static_cast<unsigned char>(bytes[i]);
+      hash *= 1099511628211ULL;
     }
-    return hash;
+    return static_cast<hash_t>(hash);
   }
 
   static inline auto CombineHashes(hash_t l, hash_t r) -> hash_t {
@@ -45,6 +48,20 @@ class HashUtil {
     return HashBytes(reinterpret_cast<char *>(both), sizeof(hash_t) * 2);
   }
 
+  /**
+   * Scramble every bit of a hash into every other bit (the MurmurHash3 64-bit finalizer). HashBytes leaves the low
+   * bits of small integers nearly constant, so use this before taking a hash modulo a power of two.
+   */
+  static inline auto MixHash(hash_t hash) -> hash_t {
+    uint64_t h = hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<hash_t>(h);
+  }
+
   static inline auto SumHashes(hash_t l, hash_t r) -> hash_t {
     return (l % PRIME_FACTOR + r % PRIME_FACTOR) % PRIME_FACTOR;
   }
@@ -13,15 +13,23 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>              // NOLINT
 #include <condition_variable>  // NOLINT
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <set>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "common/config.h"
+#include "common/macros.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 
@@ -29,48 +37,88 @@ namespace bustub {
 
 class TransactionManager;
 
+/** How a LockManager keeps transactions waiting for each other's locks from deadlocking */
+enum class DeadlockPolicy {
+  /** Prevent deadlocks: an older transaction aborts the younger ones in its way */
+  WOUND_WAIT,
+  /** Let transactions wait, and break the cycles in the waits-for graph every cycle_detection_interval */
+  DETECTION
+};
+
 /**
- * LockManager handles transactions asking for locks on records.
+ * LockManager handles transactions asking for locks on tables and records.
+ *
+ * Locks are hierarchical. A transaction locking a row of a table first takes an intention lock on the table
+ * (INTENTION_SHARED for a shared row lock, INTENTION_EXCLUSIVE for an exclusive one), which LockShared and
+ * LockExclusive do for it. A table locked in SHARED, SHARED_INTENTION_EXCLUSIVE or EXCLUSIVE mode covers the rows of
+ * the table in that mode, they are not locked one by one.
+ *
+ * Once a transaction holds escalation_threshold row locks on one table, its next row lock there escalates: the table
+ * is locked SHARED, or EXCLUSIVE if the transaction writes to it, and the row locks are released. A bulk statement
+ * thus holds a bounded number of locks. The rows a table lock covers are still noted in the lock sets of the
+ * transaction, which tell what it may read and write.
+ *
+ * Deadlocks are handled by the DeadlockPolicy. Under WOUND_WAIT a transaction asking for a lock aborts the younger
+ * transactions holding or waiting for a conflicting one and waits for the older ones. Under DETECTION transactions
+ * always wait, and a background thread builds the waits-for graph every cycle_detection_interval and aborts the
+ * youngest transaction of each cycle in it. Only transactions that are really deadlocked are aborted then, at the
+ * cost of waiting up to an interval for it.
+ *
+ * The lock table is split into LOCK_TABLE_PARTITIONS partitions by the hash of the RID, each with its own latch, and
+ * every request queue has a latch of its own that requests are granted and waited for under. The partition latch is
+ * only held to find or create a queue, so transactions locking different rows do not contend. What the lock manager
+ * knows about a transaction's locks is kept in the transaction, which only its own thread touches.
  */
 class LockManager {
-  enum class LockMode { SHARED, EXCLUSIVE };
-
   class LockRequest {
    public:
-    LockRequest(txn_id_t txn_id, LockMode lock_mode, bool granted=false) : txn_id_(txn_id), lock_mode_(lock_mode), granted_(granted) {}
-    LockRequest() {}
+    LockRequest(Transaction *txn, LockMode lock_mode, table_oid_t table_oid)
+        : txn_id_(txn->GetTransactionId()), txn_(txn), lock_mode_(lock_mode), table_oid_(table_oid) {}
     txn_id_t txn_id_;
+    Transaction *txn_;
     LockMode lock_mode_;
-    bool granted_;
-    void operator=(LockRequest lq){
-      txn_id_=lq.txn_id_;
-      lock_mode_=lq.lock_mode_;
-      granted_=lq.granted_;
-    }
+    /** The table of a locked row, INVALID_TABLE_OID for a row locked without its table */
+    table_oid_t table_oid_;
+    bool granted_{false};
   };
 
   class LockRequestQueue {
    public:
-    std::vector<LockRequest> request_queue_;
-    // for notifying blocked transactions on this rid
-    // std::mutex m_;
+    /** Protects the requests, blocked transactions wait on it */
+    std::mutex latch_;
+    /** Granted requests come first, then the waiting ones in the order they are granted */
+    std::list<LockRequest> request_queue_;
+    // for notifying blocked transactions on this resource
     std::condition_variable cv_;
-    // txn_id of an upgrading transaction (if any)
-    txn_id_t upgrading_ = INVALID_TXN_ID;
-    // LockRequestQueue& operator=(LockRequestQueue& q){
-    //   request_queue_=q.request_queue_;
-    //   cv_=q.cv_;
-    //   upgrading_=q.upgrading_;
-    // }
+    /** The threads using the queue, which is only erased once none is left. Protected by the partition latch. */
+    size_t users_{0};
+  };
+
+  /** A share of the lock table, the queues of the resources hashing to it */
+  template <typename K>
+  class LockTablePartition {
+   public:
+    std::mutex latch_;
+    std::unordered_map<K, LockRequestQueue> queues_;
   };
 
  public:
+  /** Row locks a transaction takes on one table before they escalate to a table lock */
+  static constexpr size_t DEFAULT_ESCALATION_THRESHOLD = 1000;
+  /** The number of partitions of the row lock table */
+  static constexpr size_t LOCK_TABLE_PARTITIONS = 64;
+
   /**
-   * Creates a new lock manager configured for the deadlock prevention policy.
+   * Creates a new lock manager, starting the cycle detection thread for DeadlockPolicy::DETECTION.
+   * @param policy how deadlocks are avoided or broken
+   * @param escalation_threshold the number of row locks on a table after which a transaction locks the table instead
    */
-  LockManager() = default;
+  explicit LockManager(DeadlockPolicy policy = DeadlockPolicy::WOUND_WAIT,
+                       size_t escalation_threshold = DEFAULT_ESCALATION_THRESHOLD);
+
+  ~LockManager();
 
-  ~LockManager() = default;
+  DISALLOW_COPY_AND_MOVE(LockManager);
 
   /*
    * [LOCK_NOTE]: For all locking functions, we:
@@ -85,26 +133,29 @@ class LockManager {
    * Acquire a lock on RID in shared mode. See [LOCK_NOTE] in header file.
    * @param txn the transaction requesting the shared lock
    * @param rid the RID to be locked in shared mode
+   * @param table_oid the table of the row, INVALID_TABLE_OID to lock the row alone
    * @return true if the lock is granted, false otherwise
    */
-  auto LockShared(Transaction *txn, const RID &rid) -> bool;
+  auto LockShared(Transaction *txn, const RID &rid, table_oid_t table_oid = INVALID_TABLE_OID) -> bool;
 
   /**
    * Acquire a lock on RID in exclusive mode. See [LOCK_NOTE] in header file.
    * @param txn the transaction requesting the exclusive lock
    * @param rid the RID to be locked in exclusive mode
+   * @param table_oid the table of the row, INVALID_TABLE_OID to lock the row alone
    * @return true if the lock is granted, false otherwise
    */
-  auto LockExclusive(Transaction *txn, const RID &rid) -> bool;
+  auto LockExclusive(Transaction *txn, const RID &rid, table_oid_t table_oid = INVALID_TABLE_OID) -> bool;
 
   /**
    * Upgrade a lock from a shared lock to an exclusive lock.
    * @param txn the transaction requesting the lock upgrade
    * @param rid the RID that should already be locked in shared mode by the
    * requesting transaction
+   * @param table_oid the table of the row, INVALID_TABLE_OID if the row was locked alone
    * @return true if the upgrade is successful, false otherwise
    */
-  auto LockUpgrade(Transaction *txn, const RID &rid) -> bool;
+  auto LockUpgrade(Transaction *txn, const RID &rid, table_oid_t table_oid = INVALID_TABLE_OID) -> bool;
 
   /**
    * Release the lock held by the transaction.
@@ -115,36 +166,157 @@ class LockManager {
    */
   auto Unlock(Transaction *txn, const RID &rid) -> bool;
 
-  inline auto ValidateTxnBeforeLock(Transaction* txn)->bool {
-      TransactionState tstate=txn->GetState();
-      if(tstate==TransactionState::ABORTED){
-        return false;
-      }
-      if(tstate==TransactionState::SHRINKING) {
-        txn->SetState(TransactionState::ABORTED);
-        throw TransactionAbortException(txn->GetTransactionId(),AbortReason::LOCK_ON_SHRINKING);
-      }
-      return true;
-  }
-  void IsItAborted(Transaction* txn,LockManager::LockRequestQueue* lq){
-    auto tid=txn->GetTransactionId();
-    if(txn->GetState()==TransactionState::ABORTED){
-      for(auto iter=lq->request_queue_.begin();iter!=lq->request_queue_.end();++iter){
-        if(iter->txn_id_==tid){
-          lq->request_queue_.erase(iter);
-        }
-      }
-      
-      throw TransactionAbortException(txn->GetTransactionId(),AbortReason::DEADLOCK); // Aborted From Wound-Wait DeadLock Preventing
-    }
-  }
+  /**
+   * Acquire a lock on a table, or upgrade the lock the transaction holds on it to cover both modes. See [LOCK_NOTE].
+   * @param txn the transaction requesting the lock
+   * @param lock_mode the mode to lock the table in
+   * @param table_oid the table to lock
+   * @return true if the lock is granted, false otherwise
+   */
+  auto LockTable(Transaction *txn, LockMode lock_mode, table_oid_t table_oid) -> bool;
+
+  /**
+   * Release the lock the transaction holds on a table, after the locks on its rows.
+   * @param txn the transaction releasing the lock
+   * @param table_oid the table locked by the transaction
+   * @return true if the unlock is successful, false otherwise
+   */
+  auto UnlockTable(Transaction *txn, table_oid_t table_oid) -> bool;
+
+  /** @return whether a lock in mode a can be held together with one in mode b by another transaction */
+  static auto AreCompatible(LockMode a, LockMode b) -> bool;
+
+  /** @return the weakest mode that covers both held and requested */
+  static auto Combine(LockMode held, LockMode requested) -> LockMode;
+
+  /*** Graph API, the waits-for graph is built and torn down by each round of cycle detection ***/
+
+  /** Adds an edge from t1 -> t2, t1 waits for t2. */
+  void AddEdge(txn_id_t t1, txn_id_t t2);
+
+  /** Removes an edge from t1 -> t2. */
+  void RemoveEdge(txn_id_t t1, txn_id_t t2);
+
+  /**
+   * Checks if the graph has a cycle, exploring from the lowest transaction id and the lowest neighbour first.
+   * @param[out] txn_id if the graph has a cycle, the youngest transaction in it
+   * @return false if the graph has no cycle, otherwise stores the youngest transaction in the cycle to txn_id
+   */
+  auto HasCycle(txn_id_t *txn_id) -> bool;
+
+  /** @return the list of all edges in the graph, used for testing only */
+  auto GetEdgeList() -> std::vector<std::pair<txn_id_t, txn_id_t>>;
+
+  /** Runs cycle detection every cycle_detection_interval until the lock manager is destroyed. */
+  void RunCycleDetection();
+
+  /** @return the number of deadlocks the cycle detection broke */
+  auto GetDeadlocksDetected() const -> size_t { return deadlocks_detected_; }
+
+  /** @return the number of transactions the lock manager aborted to keep them from deadlocking, under either policy */
+  auto GetDeadlockAborts() const -> size_t { return deadlock_aborts_; }
+
  private:
-  std::mutex latch_;
+  /** @return false if the transaction may not take locks, see [LOCK_NOTE] */
+  auto ValidateTxnBeforeLock(Transaction *txn, LockMode lock_mode) -> bool;
+
+  /** Lock a row in SHARED or EXCLUSIVE mode, see LockShared */
+  auto LockRow(Transaction *txn, LockMode lock_mode, const RID &rid, table_oid_t table_oid) -> bool;
+
+  /** Note in the lock sets of txn that it may read rid, or write it for an EXCLUSIVE lock */
+  void RecordRow(Transaction *txn, LockMode lock_mode, const RID &rid);
+
+  /** Lock a table for a transaction that may take locks, see LockTable */
+  auto AcquireTable(Transaction *txn, LockMode lock_mode, table_oid_t table_oid) -> bool;
+
+  /** @return the partition of the row lock table rid hashes to */
+  auto RowPartition(const RID &rid) -> LockTablePartition<RID> * {
+    return &row_partitions_[std::hash<RID>{}(rid) % LOCK_TABLE_PARTITIONS];
+  }
+
+  /**
+   * Find the queue of a resource and register as one of its users, so it stays put until Unpin.
+   * @param create whether to create the queue if there is none
+   * @return the queue, or nullptr if there is none and create is false
+   */
+  template <typename K>
+  auto Pin(LockTablePartition<K> *partition, const K &key, bool create) -> LockRequestQueue *;
+
+  /** Stop using the queue of a resource, it is erased if it is unused and empty */
+  template <typename K>
+  void Unpin(LockTablePartition<K> *partition, const K &key, LockRequestQueue *queue);
+
+  /**
+   * Queue a request of txn in lock_mode, or upgrade its request to lock_mode, and wait until it is granted.
+   * @param latch the held latch of the queue
+   * @return false if the transaction was aborted while waiting, its request is then gone
+   */
+  auto Acquire(Transaction *txn, LockRequestQueue *queue, LockMode lock_mode, table_oid_t table_oid,
+               std::unique_lock<std::mutex> *latch) -> bool;
+
+  /**
+   * Register txn as waiting in queue, or as not waiting for a null queue. The held latch of the queue is let go of
+   * meanwhile, waiting_latch_ comes first.
+   */
+  void SetWaiting(Transaction *txn, LockRequestQueue *queue, std::unique_lock<std::mutex> *latch);
+
+  /** Fill the waits-for graph with an edge from every waiting request to each request it waits for */
+  void BuildWaitsForGraph();
+
+  /** @return whether the DFS from txn_id meets a transaction on the path to it, storing the youngest of that cycle */
+  auto FindCycle(txn_id_t txn_id, std::vector<txn_id_t> *path, std::set<txn_id_t> *visited, txn_id_t *victim) -> bool;
+
+  /**
+   * Abort the younger transactions whose requests ahead of request conflict with it, under WOUND_WAIT, and wake them
+   * up if they are waiting.
+   * @param latch the held latch of the queue, let go of while waking up the victims waiting in other queues
+   */
+  void Wound(LockRequestQueue *queue, std::list<LockRequest>::iterator request, std::unique_lock<std::mutex> *latch);
+
+  /** @return whether request can be granted: it conflicts with no granted request and no request waits ahead of it */
+  auto IsGrantable(LockRequestQueue *queue, std::list<LockRequest>::iterator request) -> bool;
+
+  /**
+   * Remove the request of txn from the queue of a row, forgetting it in the rows of its table in txn.
+   * @return false if txn has no request for the row
+   */
+  auto ReleaseRow(Transaction *txn, const RID &rid) -> bool;
+
+  /** Drop rid from the rows of table_oid locked by the transaction, if it is there */
+  static void ForgetRow(Transaction *txn, table_oid_t table_oid, const RID &rid);
+
+  /**
+   * Release the row locks of txn on a table it now holds a covering lock on. The rows stay in the lock sets of txn, it
+   * still holds them through the table.
+   */
+  void Escalate(Transaction *txn, table_oid_t table_oid);
+
+  /** Lock table for lock requests on rows. */
+  std::array<LockTablePartition<RID>, LOCK_TABLE_PARTITIONS> row_partitions_;
+  /** Lock table for lock requests on tables, a transaction only comes here once per table. */
+  LockTablePartition<table_oid_t> table_partition_;
+
+  /** Protects waiting_, taken before any latch of a queue */
+  std::mutex waiting_latch_;
+  /** Each blocked transaction and the queue it waits in, to wake it up when it is aborted */
+  std::unordered_map<txn_id_t, std::pair<Transaction *, LockRequestQueue *>> waiting_;
+
+  DeadlockPolicy policy_;
+  size_t escalation_threshold_;
+
+  /** Protects waits_for_ */
+  std::mutex waits_for_latch_;
+  /** Waits-for graph representation, ordered for the DFS to be deterministic. */
+  std::map<txn_id_t, std::set<txn_id_t>> waits_for_;
 
-  /** Lock table for lock requests. */
-  std::unordered_map<RID, LockRequestQueue> lock_table_;
+  std::atomic<size_t> deadlocks_detected_{0};
+  std::atomic<size_t> deadlock_aborts_{0};
 
-  std::unordered_map<txn_id_t,Transaction*> txn_table_;
+  /** Wakes the cycle detection thread up to stop */
+  std::mutex cycle_detection_latch_;
+  std::condition_variable cycle_detection_cv_;
+  bool enable_cycle_detection_{false};
+  std::thread cycle_detection_thread_;
 };
 
 }  // namespace bustub
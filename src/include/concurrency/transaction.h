@@ -17,6 +17,7 @@
 #include <memory>
 #include <string>
 #include <thread>  // NOLINT
+#include <unordered_map>
 #include <unordered_set>
 
 #include "common/config.h"
@@ -44,19 +45,27 @@ namespace bustub {
 enum class TransactionState { GROWING, SHRINKING, COMMITTED, ABORTED };
 
 /**
- * Transaction isolation level.
+ * Transaction isolation level. A SNAPSHOT transaction reads the rows as the transactions committed when it began left
+ * them, from their versions (see VersionStore), and takes no locks to read.
  */
-enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED };
+enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED, SNAPSHOT };
 
 /**
  * Type of write operation.
  */
 enum class WType { INSERT = 0, DELETE, UPDATE };
 
+/**
+ * Lock modes. Rows are locked SHARED or EXCLUSIVE. Tables are locked in any mode, the intention modes announcing
+ * locks on rows of the table in the corresponding mode.
+ */
+enum class LockMode { INTENTION_SHARED, INTENTION_EXCLUSIVE, SHARED, SHARED_INTENTION_EXCLUSIVE, EXCLUSIVE };
+
 class TableHeap;
 class Catalog;
 using table_oid_t = uint32_t;
 using index_oid_t = uint32_t;
+static constexpr table_oid_t INVALID_TABLE_OID = UINT32_MAX;
 
 /**
  * WriteRecord tracks information related to a write.
@@ -113,7 +122,8 @@ enum class AbortReason {
   UNLOCK_ON_SHRINKING,
   UPGRADE_CONFLICT,
   DEADLOCK,
-  LOCKSHARED_ON_READ_UNCOMMITTED
+  LOCKSHARED_ON_READ_UNCOMMITTED,
+  TABLE_UNLOCKED_BEFORE_UNLOCKING_ROWS
 };
 
 /**
@@ -143,6 +153,9 @@ class TransactionAbortException : public std::exception {
         return "Transaction " + std::to_string(txn_id_) + " aborted on deadlock\n";
       case AbortReason::LOCKSHARED_ON_READ_UNCOMMITTED:
         return "Transaction " + std::to_string(txn_id_) + " aborted on lockshared on READ_UNCOMMITTED\n";
+      case AbortReason::TABLE_UNLOCKED_BEFORE_UNLOCKING_ROWS:
+        return "Transaction " + std::to_string(txn_id_) +
+               " aborted because it unlocked a table while still holding locks on its rows\n";
     }
     // Todo: Should fail with unreachable.
     return "";
@@ -161,7 +174,9 @@ class Transaction {
         txn_id_(txn_id),
         prev_lsn_(INVALID_LSN),
         shared_lock_set_{new std::unordered_set<RID>},
-        exclusive_lock_set_{new std::unordered_set<RID>} {
+        exclusive_lock_set_{new std::unordered_set<RID>},
+        table_lock_set_{new std::unordered_map<table_oid_t, LockMode>},
+        table_row_lock_set_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>} {
     // Initialize the sets that will be tracked.
     table_write_set_ = std::make_shared<std::deque<TableWriteRecord>>();
     index_write_set_ = std::make_shared<std::deque<IndexWriteRecord>>();
@@ -236,6 +251,16 @@ class Transaction {
     return exclusive_lock_set_->find(rid) != exclusive_lock_set_->end();
   }
 
+  /** @return the mode of the lock held on every table the transaction locked */
+  inline auto GetTableLockSet() -> std::shared_ptr<std::unordered_map<table_oid_t, LockMode>> {
+    return table_lock_set_;
+  }
+
+  /** @return the rows the transaction holds a lock of their own on, by table */
+  inline auto GetTableRowLockSet() -> std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> {
+    return table_row_lock_set_;
+  }
+
   /** @return the current state of the transaction */
   inline auto GetState() -> TransactionState { return state_; }
 
@@ -254,9 +279,18 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /** @return the commit timestamp of the last transaction a SNAPSHOT transaction sees the writes of */
+  inline auto GetReadTs() const -> timestamp_t { return read_ts_; }
+
+  /**
+   * Set the snapshot of the transaction.
+   * @param read_ts the commit timestamp of the last transaction it sees the writes of
+   */
+  inline void SetReadTs(timestamp_t read_ts) { read_ts_ = read_ts; }
+
  private:
-  /** The current transaction state. */
-  TransactionState state_;
+  /** The current transaction state, the lock manager aborts waiting transactions from other threads. */
+  std::atomic<TransactionState> state_;
   /** The isolation level of the transaction. */
   IsolationLevel isolation_level_;
   /** The thread ID, used in single-threaded transactions. */
@@ -270,6 +304,8 @@ class Transaction {
   std::shared_ptr<std::deque<IndexWriteRecord>> index_write_set_;
   /** The LSN of the last record written by the transaction. */
   lsn_t prev_lsn_;
+  /** The snapshot of a SNAPSHOT transaction, issued by TransactionManager::Begin. */
+  timestamp_t read_ts_{0};
 
   /** Concurrent index: the pages that were latched during index operation. */
   std::shared_ptr<std::deque<Page *>> page_set_;
@@ -280,6 +316,10 @@ class Transaction {
   std::shared_ptr<std::unordered_set<RID>> shared_lock_set_;
   /** LockManager: the set of exclusive-locked tuples held by this transaction. */
   std::shared_ptr<std::unordered_set<RID>> exclusive_lock_set_;
+  /** LockManager: the tables locked by this transaction, and in which mode. */
+  std::shared_ptr<std::unordered_map<table_oid_t, LockMode>> table_lock_set_;
+  /** LockManager: the row locks held by this transaction on each table, counted towards escalation. */
+  std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> table_row_lock_set_;
 };
 
 }  // namespace bustub
@@ -13,9 +13,12 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>  // NOLINT
+#include <set>
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -27,6 +30,9 @@ class LockManager;
 
 /**
  * TransactionManager keeps track of all the transactions running in the system.
+ *
+ * It also hands out the timestamps of multi-versioning: a transaction gets a commit timestamp when it commits, and a
+ * SNAPSHOT transaction reads as of the last commit before it began.
  */
 class TransactionManager {
  public:
@@ -85,6 +91,13 @@ class TransactionManager {
   void ResumeTransactions();
 
  private:
+  /** Forget the snapshot of a SNAPSHOT transaction that is done. Requires commit_latch_. */
+  void UnregisterSnapshot(Transaction *txn) {
+    if (txn->GetIsolationLevel() == IsolationLevel::SNAPSHOT) {
+      active_read_ts_.erase(active_read_ts_.find(txn->GetReadTs()));
+    }
+  }
+
   /**
    * Releases all the locks held by the given transaction.
    * @param txn the transaction whose locks should be released
@@ -100,14 +113,28 @@ class TransactionManager {
     for (auto locked_rid : lock_set) {
       lock_manager_->Unlock(txn, locked_rid);
     }
+    // The tables go last, their rows are unlocked by now.
+    std::vector<table_oid_t> tables;
+    for (const auto &[table_oid, lock_mode] : *txn->GetTableLockSet()) {
+      tables.push_back(table_oid);
+    }
+    for (table_oid_t table_oid : tables) {
+      lock_manager_->UnlockTable(txn, table_oid);
+    }
   }
 
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
 
   /** The global transaction latch is used for checkpointing. */
   ReaderWriterLatch global_txn_latch_;
+
+  /** Orders commits with the snapshots that begin */
+  std::mutex commit_latch_;
+  timestamp_t last_commit_ts_{0};
+  /** The read timestamps of the running SNAPSHOT transactions */
+  std::multiset<timestamp_t> active_read_ts_;
 };
 
 }  // namespace bustub
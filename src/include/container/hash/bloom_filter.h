@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter.h
+//
+// Identification: src/include/container/hash/bloom_filter.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * A register-blocked bloom filter over (already mixed) hashes.
+ *
+ * Each hash selects a single 64-bit block and sets BITS_PER_HASH bits inside it, so both Insert and MayContain touch
+ * exactly one word of memory. A filter without any blocks is disabled and reports every hash as possibly present.
+ */
+class BloomFilter {
+ public:
+  BloomFilter() = default;
+
+  /** Size the filter for the expected number of hashes and clear it. */
+  void Reset(size_t expected_count) {
+    size_t num_blocks = 1;
+    while (num_blocks * 64 < expected_count * BITS_PER_KEY) {
+      num_blocks <<= 1;
+    }
+    blocks_.assign(num_blocks, 0);
+    block_mask_ = num_blocks - 1;
+  }
+
+  /** Drop all blocks, disabling the filter. */
+  void Clear() {
+    blocks_.clear();
+    block_mask_ = 0;
+  }
+
+  void Insert(hash_t hash) {
+    if (!blocks_.empty()) {
+      blocks_[BlockOf(hash)] |= MaskOf(hash);
+    }
+  }
+
+  /** @return false only if hash was definitely never inserted */
+  auto MayContain(hash_t hash) const -> bool {
+    if (blocks_.empty()) {
+      return true;
+    }
+    uint64_t mask = MaskOf(hash);
+    return (blocks_[BlockOf(hash)] & mask) == mask;
+  }
+
+  /** @return the memory held by the filter, in bytes */
+  auto GetMemoryUsage() const -> size_t { return blocks_.size() * sizeof(uint64_t); }
+
+ private:
+  /** Bits of filter per expected key; 16 keeps false positives around 1% with one-word blocks */
+  static constexpr size_t BITS_PER_KEY = 16;
+  static constexpr uint32_t BITS_PER_HASH = 4;
+
+  /** The block comes from the high bits, which hash tables indexed by the low bits do not use. */
+  auto BlockOf(hash_t hash) const -> size_t { return (static_cast<uint64_t>(hash) >> 40) & block_mask_; }
+
+  static auto MaskOf(hash_t hash) -> uint64_t {
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < BITS_PER_HASH; i++) {
+      mask |= 1ULL << ((static_cast<uint64_t>(hash) >> (6 * i)) & 63);
+    }
+    return mask;
+  }
+
+  std::vector<uint64_t> blocks_;
+  size_t block_mask_{0};
+};
+
+}  // namespace bustub
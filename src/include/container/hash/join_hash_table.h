@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table.h
+//
+// Identification: src/include/container/hash/join_hash_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "container/hash/bloom_filter.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * JoinHashTable is the in-memory build side of a hash join.
+ *
+ * Rows are copied back to back into one arena as | Size (4) | Data |, and the table itself is a flat, power-of-two
+ * array of (hash, arena offset) entries probed linearly, so a probe touches one cache line of entries before it
+ * touches any row. The table is filled in two phases: Insert appends rows, then Build lays out the slots and the
+ * bloom filter once the row count is known. Rows with equal hashes are kept as separate entries; callers must compare
+ * the real keys of the rows they get back.
+ */
+class JoinHashTable {
+ public:
+  JoinHashTable() = default;
+
+  /**
+   * Append a row. Only valid before Build.
+   * @param hash the mixed hash of the row's join key
+   * @param tuple the row to copy into the arena
+   */
+  void Insert(hash_t hash, const Tuple &tuple);
+
+  /** Lay out the probe slots and the bloom filter for every inserted row. */
+  void Build();
+
+  /** Drop every row, returning the table to its insert phase. */
+  void Clear();
+
+  /** @return the number of rows */
+  auto Size() const -> size_t { return rows_.size(); }
+
+  /** @return the bytes held by the arena, the entries and the filter */
+  auto GetMemoryUsage() const -> size_t;
+
+  /**
+   * Point a tuple at a row, in insertion order. Valid until the next Insert or Clear.
+   * @param idx the row index, smaller than Size()
+   * @param[out] tuple a non-owning view of the row
+   */
+  void GetTuple(size_t idx, Tuple *tuple) const { MakeView(rows_[idx].offset_, tuple); }
+
+  /** @return false if no row with this hash was inserted; may return true spuriously. Only valid after Build. */
+  auto MayContain(hash_t hash) const -> bool { return filter_.MayContain(hash); }
+
+  /** @return the filter over every inserted hash, so it can be checked before rows reach the probe. */
+  auto GetFilter() const -> const BloomFilter & { return filter_; }
+
+  /** @return the slot a probe for hash starts from; pass it to FindNext */
+  auto ProbeStart(hash_t hash) const -> size_t { return hash & slot_mask_; }
+
+  /**
+   * Find the next row with exactly this hash.
+   * @param hash the mixed hash of the probe key
+   * @param[in,out] slot where to continue from; advanced past the row returned
+   * @param[out] tuple a non-owning view of the row
+   * @return false once the probe sequence reaches an empty slot
+   */
+  auto FindNext(hash_t hash, size_t *slot, Tuple *tuple) const -> bool;
+
+ private:
+  struct Entry {
+    hash_t hash_;
+    size_t offset_;
+  };
+
+  static constexpr size_t EMPTY_SLOT = std::numeric_limits<size_t>::max();
+
+  void MakeView(size_t offset, Tuple *tuple) const;
+
+  /** Rows as | Size (4) | Data |, back to back */
+  std::vector<char> arena_;
+  /** One entry per row, in insertion order */
+  std::vector<Entry> rows_;
+  /** Open addressing table of at least twice as many slots as rows */
+  std::vector<Entry> slots_;
+  size_t slot_mask_{0};
+  BloomFilter filter_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// row_hash_set.h
+//
+// Identification: src/include/container/hash/row_hash_set.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * RowHashSet is a set of whole rows, used to eliminate duplicates.
+ *
+ * Rows are copied back to back into one arena as | Size (4) | Data |, like JoinHashTable, and found through a
+ * power-of-two array of row indices probed linearly. Two rows are the same if their serialized bytes are equal, which
+ * for tuples of one schema means every column is equal (NULLs included). Unlike JoinHashTable the set is built
+ * incrementally: every Insert first checks whether the row is already there.
+ */
+class RowHashSet {
+ public:
+  RowHashSet() = default;
+
+  /** @return the hash of a row's bytes, mixed so that any bits of it can be used for partitioning */
+  static auto HashRow(const Tuple &tuple) -> hash_t {
+    return HashUtil::MixHash(HashUtil::HashBytes(tuple.GetData(), tuple.GetLength()));
+  }
+
+  /**
+   * Add a row unless an equal row is already in the set.
+   * @param hash HashRow of the row
+   * @param tuple the row to copy into the arena
+   * @return true if the row was new
+   */
+  auto Insert(hash_t hash, const Tuple &tuple) -> bool;
+
+  /** Drop every row. */
+  void Clear();
+
+  /** @return the number of rows */
+  auto Size() const -> size_t { return rows_.size(); }
+
+  /** @return the bytes held by the arena and the slots */
+  auto GetMemoryUsage() const -> size_t;
+
+  /** @return the hash of a row, in insertion order */
+  auto GetHash(size_t idx) const -> hash_t { return rows_[idx].hash_; }
+
+  /**
+   * Point a tuple at a row, in insertion order. Valid until the next Insert or Clear.
+   * @param idx the row index, smaller than Size()
+   * @param[out] tuple a non-owning view of the row
+   */
+  void GetTuple(size_t idx, Tuple *tuple) const;
+
+ private:
+  struct Row {
+    hash_t hash_;
+    size_t offset_;
+  };
+
+  static constexpr size_t EMPTY_SLOT = std::numeric_limits<size_t>::max();
+
+  /** Double the slot array and re-insert every row. */
+  void Grow();
+
+  /** Rows as | Size (4) | Data |, back to back */
+  std::vector<char> arena_;
+  /** One entry per row, in insertion order */
+  std::vector<Row> rows_;
+  /** Open addressing table of indices into rows_, at most half full */
+  std::vector<size_t> slots_;
+  size_t slot_mask_{0};
+};
+
+}  // namespace bustub
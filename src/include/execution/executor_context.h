@@ -12,17 +12,26 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "catalog/catalog.h"
+#include "common/thread_pool.h"
 #include "concurrency/transaction.h"
 #include "storage/page/tmp_tuple_page.h"
 
 namespace bustub {
+
+class PipelineState;
+
 /**
  * ExecutorContext stores all the context necessary to run an executor.
+ *
+ * A context owns the thread pool its parallel operators run on. A GatherExecutor gives every copy of its pipeline a
+ * child context that shares the parent's transaction and pool, splits its memory budget and runs single-threaded.
  */
 class ExecutorContext {
  public:
@@ -38,6 +47,24 @@ class ExecutorContext {
                   LockManager *lock_mgr)
       : transaction_(transaction), catalog_{catalog}, bpm_{bpm}, txn_mgr_(txn_mgr), lock_mgr_(lock_mgr) {}
 
+  /**
+   * Creates the context of one copy of a pipeline that a GatherExecutor runs in parallel.
+   * @param parent The context of the gather
+   * @param pipeline The state shared by the copies of the pipeline
+   * @param worker_id The index of this copy among them
+   */
+  ExecutorContext(ExecutorContext *parent, PipelineState *pipeline, size_t worker_id)
+      : transaction_(parent->transaction_),
+        catalog_(parent->catalog_),
+        bpm_(parent->bpm_),
+        txn_mgr_(parent->txn_mgr_),
+        lock_mgr_(parent->lock_mgr_),
+        work_memory_(parent->work_memory_),
+        num_threads_(1),
+        parent_(parent),
+        pipeline_(pipeline),
+        worker_id_(worker_id) {}
+
   ~ExecutorContext() = default;
 
   DISALLOW_COPY_AND_MOVE(ExecutorContext);
@@ -60,6 +87,41 @@ class ExecutorContext {
   /** @return the transaction manager */
   auto GetTransactionManager() -> TransactionManager * { return txn_mgr_; }
 
+  /** @return the number of bytes a memory-intensive operator may hold before it spills to temporary pages */
+  auto GetWorkMemory() const -> size_t { return work_memory_; }
+
+  /** Set the per-operator memory budget in bytes */
+  void SetWorkMemory(size_t work_memory) { work_memory_ = work_memory; }
+
+  /** @return the number of worker threads a parallel operator may use */
+  auto GetNumThreads() const -> size_t { return num_threads_; }
+
+  /**
+   * Set the number of worker threads a parallel operator may use, 1 runs everything on the calling thread. Executors
+   * hold on to the thread pool, so the number is fixed once it exists.
+   */
+  void SetNumThreads(size_t num_threads) {
+    BUSTUB_ASSERT(thread_pool_ == nullptr, "The thread pool of the context already exists.");
+    num_threads_ = std::max<size_t>(num_threads, 1);
+  }
+
+  /** @return the thread pool of the query, with GetNumThreads() workers, created on first use */
+  auto GetThreadPool() -> ThreadPool * {
+    if (parent_ != nullptr) {
+      return parent_->GetThreadPool();
+    }
+    if (thread_pool_ == nullptr) {
+      thread_pool_ = std::make_unique<ThreadPool>(num_threads_);
+    }
+    return thread_pool_.get();
+  }
+
+  /** @return the state shared with the other copies of the parallel pipeline this context runs, or nullptr */
+  auto GetPipeline() const -> PipelineState * { return pipeline_; }
+
+  /** @return the index of the copy of the parallel pipeline this context runs */
+  auto GetWorkerId() const -> size_t { return worker_id_; }
+
  private:
   /** The transaction context associated with this executor context */
   Transaction *transaction_;
@@ -71,6 +133,16 @@ class ExecutorContext {
   TransactionManager *txn_mgr_;
   /** The lock manager associated with this executor context */
   LockManager *lock_mgr_;
+  /** The memory budget of each memory-intensive operator */
+  size_t work_memory_{WORK_MEMORY_SIZE};
+  /** The degree of parallelism of each parallel operator, queries run serially unless the caller opts in */
+  size_t num_threads_{1};
+  /** The thread pool of parallel operators, owned by the top-level context */
+  std::unique_ptr<ThreadPool> thread_pool_;
+  /** For the context of a copy of a parallel pipeline: the gather's context, the shared state and the copy's index */
+  ExecutorContext *parent_{nullptr};
+  PipelineState *pipeline_{nullptr};
+  size_t worker_id_{0};
 };
 
 }  // namespace bustub
@@ -12,155 +12,124 @@
 
 #pragma once
 
+#include <limits>
 #include <memory>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "common/util/hash_util.h"
-#include "container/hash/hash_function.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/aggregation_plan.h"
+#include "storage/table/tmp_tuple_heap.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
-#include "execution/expressions/aggregate_value_expression.h"
+
 namespace bustub {
 
 /**
- * A simplified hash table that has all the necessary functionality for aggregations.
+ * A hash table that has all the necessary functionality for aggregations.
+ *
+ * Groups live in flat arrays with a fixed stride, | hash | group by values | running aggregates |, and are found
+ * through an open-addressing array of (hash, group index) slots, so a lookup never chases a node pointer. Besides
+ * folding raw input rows into a group (Accumulate), the table can fold in the running aggregates of the same group
+ * computed elsewhere (Merge), which is how thread-local and spilled partial results are combined.
  */
-class SimpleAggregationHashTable {
+class AggregationHashTable {
  public:
   /**
-   * Construct a new SimpleAggregationHashTable instance.
-   * @param agg_exprs the aggregation expressions
+   * Construct a new AggregationHashTable instance.
    * @param agg_types the types of aggregations
+   * @param num_group_bys the number of group by values of every group
    */
-  SimpleAggregationHashTable(const std::vector<const AbstractExpression *> &agg_exprs,
-                             const std::vector<AggregationType> &agg_types)
-      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {}
-
-  /** @return The initial aggregrate value for this aggregation executor */
-  auto GenerateInitialAggregateValue(RID rid) -> AggregateValue {
-    std::vector<Value> values{};
-    for (const auto &agg_type : agg_types_) {
-      switch (agg_type) {
-        case AggregationType::CountAggregate:
-          // Count starts at zero.
-          values.emplace_back(ValueFactory::GetIntegerValue(0));
-          break;
-        case AggregationType::SumAggregate:
-          // Sum starts at zero.
-          values.emplace_back(ValueFactory::GetIntegerValue(0));
-          break;
-        case AggregationType::MinAggregate:
-          // Min starts at INT_MAX.
-          values.emplace_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MAX));
-          break;
-        case AggregationType::MaxAggregate:
-          // Max starts at INT_MIN.
-          values.emplace_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_MIN));
-          break;
-      }
-    }
-    return {values,rid};
-  }
+  AggregationHashTable(const std::vector<AggregationType> *agg_types, size_t num_group_bys)
+      : agg_types_(agg_types), num_group_bys_(num_group_bys) {}
+
+  /** @return the hash of a group, with NULL group by values hashing alike */
+  static auto HashGroupBys(const std::vector<Value> &group_bys) -> hash_t;
 
   /**
-   * Combines the input into the aggregation result.
-   * @param[out] result The output aggregate value
-   * @param input The input value
+   * Fold one input row into its group, creating the group if needed.
+   * @param hash the hash of group_bys
+   * @param group_bys the group by values of the row
+   * @param inputs the values of the aggregate expressions for the row
    */
-  void CombineAggregateValues(AggregateValue *result, const AggregateValue &input) {
-    for (uint32_t i = 0; i < agg_exprs_.size(); i++) {
-      switch (agg_types_[i]) {
-        case AggregationType::CountAggregate:
-          // Count increases by one.
-          result->aggregates_[i] = result->aggregates_[i].Add(ValueFactory::GetIntegerValue(1));
-          break;
-        case AggregationType::SumAggregate:
-          // Sum increases by addition.
-          result->aggregates_[i] = result->aggregates_[i].Add(input.aggregates_[i]);
-          break;
-        case AggregationType::MinAggregate:
-          // Min is just the min.
-          result->aggregates_[i] = result->aggregates_[i].Min(input.aggregates_[i]);
-          break;
-        case AggregationType::MaxAggregate:
-          // Max is just the max.
-          result->aggregates_[i] = result->aggregates_[i].Max(input.aggregates_[i]);
-          break;
-      }
-    }
-  }
+  void Accumulate(hash_t hash, const std::vector<Value> &group_bys, const std::vector<Value> &inputs);
 
   /**
-   * Inserts a value into the hash table and then combines it with the current aggregation.
-   * @param agg_key the key to be inserted
-   * @param agg_val the value to be inserted
+   * Fold the running aggregates of a group computed elsewhere into this table.
+   * @param hash the hash of the group
+   * @param group_bys the group by values, num_group_bys of them
+   * @param aggregates the running aggregates, one per aggregation type
    */
-  void InsertCombine(const AggregateKey &agg_key, const AggregateValue &agg_val) {
-    if (ht_.count(agg_key) == 0) {
-      ht_.insert({agg_key, GenerateInitialAggregateValue(agg_val.rid)});
-    }
-    CombineAggregateValues(&ht_[agg_key], agg_val);
+  void Merge(hash_t hash, const Value *group_bys, const Value *aggregates);
+
+  /** Append a group to out as | hash (8) | for every value: type (1), value |, see MergeSerialized */
+  void SerializeGroup(size_t group, std::vector<char> *out) const;
+
+  /** Merge a group that was written by SerializeGroup. */
+  void MergeSerialized(const char *data);
+
+  /** Drop every group. */
+  void Clear();
+
+  /** @return the number of groups */
+  auto Size() const -> size_t { return hashes_.size(); }
+
+  /** @return roughly how many bytes the groups and slots take */
+  auto GetMemoryUsage() const -> size_t;
+
+  /** @return the group by values of a group */
+  auto GetGroupBys(size_t group) const -> std::vector<Value> {
+    auto begin = group_bys_.begin() + group * num_group_bys_;
+    return {begin, begin + num_group_bys_};
   }
 
-  /** An iterator over the aggregation hash table */
-  class Iterator {
-   public:
-    /** Creates an iterator for the aggregate map. */
-    explicit Iterator(std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter) : iter_{iter} {}
-
-    /** @return The key of the iterator */
-    auto Key() -> const AggregateKey & { return iter_->first; }
-
-    /** @return The value of the iterator */
-    auto Val() -> const AggregateValue & { return iter_->second; }
-
-    /** @return The iterator before it is incremented */
-    // auto operator++() -> Iterator & {
-    //   ++iter_;
-    //   return *this;
-    // }
-
-    // void operator++() {
-    //   ++iter_;
-    // }
-    void Next(){
-      ++iter_;
-    }
-    /** @return `true` if both iterators are identical */
-    auto operator==(const Iterator &other) -> bool { return this->iter_ == other.iter_; }
+  /** @return the running aggregates of a group */
+  auto GetAggregates(size_t group) const -> std::vector<Value> {
+    auto begin = aggregates_.begin() + group * agg_types_->size();
+    return {begin, begin + agg_types_->size()};
+  }
 
-    /** @return `true` if both iterators are different */
-    auto operator!=(const Iterator &other) -> bool { return this->iter_ != other.iter_; }
+  /** @return the hash of a group */
+  auto GetHash(size_t group) const -> hash_t { return hashes_[group]; }
 
-   private:
-    /** Aggregates map */
-    std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter_;
+ private:
+  struct Slot {
+    hash_t hash_;
+    size_t group_;
   };
 
-  /** @return Iterator to the start of the hash table */
-  auto Begin() -> Iterator { return Iterator{ht_.cbegin()}; }
+  static constexpr size_t EMPTY_SLOT = std::numeric_limits<size_t>::max();
 
-  /** @return Iterator to the end of the hash table */
-  auto End() -> Iterator { return Iterator{ht_.cend()}; }
+  /** @return the running aggregates of a new group */
+  auto GenerateInitialAggregateValue() const -> std::vector<Value>;
 
- private:
-  /** The hash table is just a map from aggregate keys to aggregate values */
-  std::unordered_map<AggregateKey, AggregateValue> ht_{};
-  /** The aggregate expressions that we have */
-  const std::vector<const AbstractExpression *> &agg_exprs_;
-  /** The types of aggregations that we have */
-  const std::vector<AggregationType> &agg_types_;
+  /** @return the index of the group, appending a group with initial aggregates if it does not exist */
+  auto FindOrInsert(hash_t hash, const Value *group_bys) -> size_t;
+
+  /** Double the slot array and re-insert every group. */
+  void Grow();
+
+  const std::vector<AggregationType> *agg_types_;
+  size_t num_group_bys_;
+  std::vector<Slot> slots_;
+  size_t slot_mask_{0};
+  std::vector<hash_t> hashes_;
+  std::vector<Value> group_bys_;
+  std::vector<Value> aggregates_;
 };
 
 /**
  * AggregationExecutor executes an aggregation operation (e.g. COUNT, SUM, MIN, MAX)
  * over the tuples produced by a child executor.
+ *
+ * The calling thread drains the child in morsels of MORSEL_SIZE tuples and submits them as tasks to the context's
+ * thread pool. Each pool worker pre-aggregates into its own tables, one per radix partition of the group hash. A
+ * worker whose tables outgrow its share of the work memory serializes them into per-partition TmpTupleHeaps and
+ * starts over. Finally the partitions are merged in parallel, a batch of one partition per thread at a time, so at
+ * most that batch of final groups is held in memory while it is being emitted.
  */
 class AggregationExecutor : public AbstractExecutor {
  public:
@@ -187,10 +156,37 @@ class AggregationExecutor : public AbstractExecutor {
   /** @return The output schema for the aggregation */
   auto GetOutputSchema() -> const Schema * override { return plan_->OutputSchema(); };
 
+  auto GetName() -> std::string override { return std::string("AggregationExecutor"); }
+
   /** Do not use or remove this function, otherwise you will get zero points. */
   auto GetChildExecutor() const -> const AbstractExecutor *;
 
  private:
+  /** Tuples pulled from the child per unit of work */
+  static constexpr size_t MORSEL_SIZE = 1024;
+  /** Radix partitions of the group hash, taken from its top bits */
+  static constexpr size_t NUM_PARTITIONS = 32;
+
+  /** The pre-aggregated state of one worker */
+  struct LocalAggregation {
+    std::vector<AggregationHashTable> tables_;
+    std::vector<std::unique_ptr<TmpTupleHeap>> spills_;
+  };
+
+  static auto PartitionOf(hash_t hash) -> size_t { return (hash >> 32) % NUM_PARTITIONS; }
+
+  /** Fold a morsel into a worker's tables, spilling them if they grew past budget bytes */
+  void ProcessMorsel(const std::vector<Tuple> &morsel, LocalAggregation *local, size_t budget);
+
+  /** Write every group of a worker's tables to its spill runs and clear them */
+  void Spill(LocalAggregation *local);
+
+  /** Merge partition `partition` of every worker into `result` */
+  void MergePartition(size_t partition, AggregationHashTable *result);
+
+  /** Merge the next batch of partitions in parallel; false once every partition was emitted */
+  auto LoadNextBatch() -> bool;
+
   /** @return The tuple as an AggregateKey */
   auto MakeAggregateKey(const Tuple *tuple) -> AggregateKey {
     std::vector<Value> keys;
@@ -201,26 +197,26 @@ class AggregationExecutor : public AbstractExecutor {
   }
 
   /** @return The tuple as an AggregateValue */
-  auto MakeAggregateValue(const Tuple *tuple, RID r) -> AggregateValue {
+  auto MakeAggregateValue(const Tuple *tuple) -> AggregateValue {
     std::vector<Value> vals;
     for (const auto &expr : plan_->GetAggregates()) {
       vals.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
     }
-    return {vals,r};
+    return {vals, RID()};
   }
 
- private:
   /** The aggregation plan node */
   const AggregationPlanNode *plan_;
   /** The child executor that produces tuples over which the aggregation is computed */
   std::unique_ptr<AbstractExecutor> child_;
-  /** Simple aggregation hash table */
-  // TODO(Student): Uncomment SimpleAggregationHashTable aht_;
-  /** Simple aggregation hash table iterator */
-  // TODO(Student): Uncomment SimpleAggregationHashTable::Iterator aht_iterator_;
-  SimpleAggregationHashTable agg_hash_table_;
-  SimpleAggregationHashTable::Iterator iterator_;
-  const AbstractExpression* having;
-  const Schema* key_schema_;
+  /** The pre-aggregated state of every worker */
+  std::vector<LocalAggregation> locals_;
+  /** The merged partitions being emitted */
+  std::vector<AggregationHashTable> batch_;
+  /** The first partition that has not been merged yet */
+  size_t next_partition_{0};
+  /** Position of the output within batch_ */
+  size_t batch_idx_{0};
+  size_t group_idx_{0};
 };
 }  // namespace bustub
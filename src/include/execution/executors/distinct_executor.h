@@ -13,17 +13,27 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "container/hash/row_hash_set.h"
+#include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/distinct_plan.h"
-#include "common/util/hash_util.h"
-#include "execution/expressions/column_value_expression.h"
-#include "execution/plans/seq_scan_plan.h"
+#include "storage/table/tmp_tuple_heap.h"
+
 namespace bustub {
 
 /**
  * DistinctExecutor removes duplicate rows from child ouput.
+ *
+ * Rows are compared on every column through a RowHashSet of the rows emitted so far, and a row is emitted as soon as
+ * it is found to be new, so the first rows come out without waiting for the child to finish. When the set outgrows
+ * the executor context's work memory, its largest hash partition is spilled: the partition's emitted rows are
+ * written to one TmpTupleHeap and its later input rows to another. Once the input is exhausted each spilled
+ * partition is processed the same way, starting from its emitted rows, and may itself be split again up to
+ * MAX_PARTITION_DEPTH levels.
  */
 class DistinctExecutor : public AbstractExecutor {
  public:
@@ -50,16 +60,55 @@ class DistinctExecutor : public AbstractExecutor {
   /** @return The output schema for the distinct */
   auto GetOutputSchema() -> const Schema * override { return plan_->OutputSchema(); };
 
+  auto GetName() -> std::string override { return std::string("DistinctExecutor"); }
+
  private:
+  /** Number of partitions the rows of one level are split into */
+  static constexpr uint32_t PARTITION_FANOUT = 8;
+  /** How many times a partition may be split again before it is kept in memory regardless */
+  static constexpr uint32_t MAX_PARTITION_DEPTH = 4;
+
+  /** A spilled partition: the rows already emitted for it, and the input rows that still have to be checked */
+  struct Partition {
+    std::unique_ptr<TmpTupleHeap> seen_;
+    std::unique_ptr<TmpTupleHeap> input_;
+    uint32_t depth_;
+  };
+
+  /** @return the partition of a row hash at the given depth, every depth uses an independent hash */
+  static auto PartitionOf(hash_t hash, uint32_t depth) -> uint32_t;
+
+  /**
+   * Check a row against the rows seen at the current depth, routing it to its partition's run if that was spilled.
+   * @param tuple the row
+   * @param input whether the row is input (true) or was already emitted (false)
+   * @return true if the row is new input that must be emitted
+   */
+  auto Admit(const Tuple &tuple, bool input) -> bool;
+
+  /** Move the resident partition with the most rows out of memory */
+  void SpillLargestPartition();
+
+  /** Queue every partition spilled at the current depth and start on the next queued one */
+  auto LoadNextPartition() -> bool;
+
   /** The distinct plan node to be executed */
   const DistinctPlanNode *plan_;
   /** The child executor from which tuples are obtained */
   std::unique_ptr<AbstractExecutor> child_executor_;
 
-  std::unordered_set<hash_t> encounterd_;
-  const Schema* child_schema_;
-  HashUtil hash_util_;
-  // const ColumnValueExpression* distinct_expr_;
-  // std::vector<uint32_t> key_attrs_;
+  /** The rows seen in the resident partitions */
+  RowHashSet seen_;
+  /** The number of rows of each partition in seen_ */
+  std::vector<size_t> resident_rows_;
+  /** The partitions of the current depth that were spilled, or nullptr */
+  std::vector<std::unique_ptr<Partition>> spilled_;
+  /** The depth being processed; 0 while reading the child */
+  uint32_t depth_{0};
+  /** Spilled partitions that still have to be processed */
+  std::vector<Partition> pending_;
+  /** The input of the partition being processed, nullptr while reading the child */
+  std::unique_ptr<TmpTupleHeap> input_;
+  bool child_done_{false};
 };
 }  // namespace bustub
@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// gather_executor.h
+//
+// Identification: src/include/execution/executors/gather_executor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/thread_pool.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/pipeline_state.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/gather_plan.h"
+#include "execution/tuple_exchange.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * GatherExecutor runs one copy of a pipeline per thread of the context's thread pool and merges their output.
+ *
+ * Every copy is a separate tree of executors built by the ExecutorFactory on a child ExecutorContext that shares this
+ * one's PipelineState, which is how the copies split the input at the driving leaf (see GatherPlanNode). Before the
+ * copies start, every Repartition on the driving path is run as a stage of its own: copies of its child route their
+ * tuples to one run per partition, and only once they all finished does the next stage start.
+ *
+ * A copy is driven by pool tasks that pull a batch of up to BATCH_SIZE tuples from it and push the batch into a
+ * TupleExchange, then resubmit themselves. A task that finds the exchange full parks instead and is resubmitted by Next
+ * once it has made room, so no task ever blocks a pool thread. Next drains the exchange on the calling thread.
+ */
+class GatherExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new GatherExecutor instance.
+   * @param exec_ctx The executor context
+   * @param pipeline The root of the pipeline to run in parallel
+   */
+  GatherExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *pipeline);
+
+  /** Stop the copies that are still running. */
+  ~GatherExecutor() override;
+
+  /** Initialize the gather, running every stage below the pipeline and starting its copies */
+  void Init() override;
+
+  /**
+   * Yield the next tuple produced by any copy of the pipeline.
+   * @param[out] tuple The next tuple produced by the gather
+   * @param[out] rid The RID of the next tuple
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema of the pipeline */
+  auto GetOutputSchema() -> const Schema * override { return pipeline_->OutputSchema(); }
+
+  auto GetName() -> std::string override { return std::string("GatherExecutor"); }
+
+  /**
+   * @return the leaf at which copies of `plan` split their input: a sequential scan or a Repartition, or nullptr if
+   * `plan` cannot run as several copies
+   */
+  static auto FindDrivingLeaf(const AbstractPlanNode *plan) -> const AbstractPlanNode *;
+
+ private:
+  /** Tuples a driver pulls from its copy before it hands them over */
+  static constexpr size_t BATCH_SIZE = 1024;
+
+  /** One copy of the pipeline and the task state that drives it */
+  struct Driver {
+    std::unique_ptr<ExecutorContext> ctx_;
+    std::unique_ptr<AbstractExecutor> executor_;
+    bool initialized_{false};
+    /** Set once the copy produced its last tuple */
+    bool done_{false};
+    /** Tuples pulled from the copy that the exchange did not take yet */
+    std::vector<Tuple> batch_;
+  };
+
+  /**
+   * Set up the driving leaf of a pipeline for `state`: split a scan into morsels, or run a Repartition's child to
+   * completion and keep what it routed to every partition.
+   */
+  void PrepareLeaf(PipelineState *state, const AbstractPlanNode *leaf);
+
+  /** Create the context of copy `worker_id` of a pipeline that `state` describes */
+  auto MakeWorkerContext(PipelineState *state, size_t worker_id) -> std::unique_ptr<ExecutorContext>;
+
+  /** Pull a batch from a copy unless one is pending and hand it over, then resubmit the driver or park it */
+  void RunDriver(Driver *driver);
+
+  /** Queue a task that runs one step of driver */
+  void SubmitDriver(Driver *driver);
+
+  /** Remember the first error of a copy and shut the others down */
+  void Fail(std::exception_ptr error);
+
+  /** Cancel the exchange and wait until no task of this gather runs anymore */
+  void StopDrivers();
+
+  /** The root of the pipeline to run in parallel */
+  const AbstractPlanNode *pipeline_;
+  /** The pipeline run inline, when it cannot be split */
+  std::unique_ptr<AbstractExecutor> inline_;
+
+  std::unique_ptr<PipelineState> state_;
+  std::vector<Driver> drivers_;
+  std::unique_ptr<TupleExchange> exchange_;
+  std::unique_ptr<TaskGroup> group_;
+  std::atomic<bool> stopped_{false};
+  std::mutex error_latch_;
+  std::exception_ptr error_;
+  std::vector<Tuple> batch_;
+  size_t batch_pos_{0};
+};
+
+}  // namespace bustub
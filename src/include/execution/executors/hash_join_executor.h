@@ -14,19 +14,28 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "common/util/hash_util.h"
+#include "container/hash/bloom_filter.h"
+#include "container/hash/join_hash_table.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/hash_join_plan.h"
+#include "storage/table/tmp_tuple_heap.h"
 #include "storage/table/tuple.h"
-#include "container/hash/extendible_hash_table.h"
-#include "execution/expressions/column_value_expression.h"
-#include "common/util/hash_util.h"
 
 namespace bustub {
 
 /**
- * HashJoinExecutor executes a nested-loop JOIN on two tables.
+ * HashJoinExecutor executes an equi-JOIN on two tables with a hash table built over the left input.
+ *
+ * If the left input fits in the executor context's work memory the join is a classic in-memory hash join that
+ * streams the right input through a JoinHashTable; right tuples whose key hash misses the table's bloom filter are
+ * dropped before touching any row. Otherwise it becomes a Grace hash join: both inputs are partitioned on the join key
+ * into TmpTupleHeaps, and each pair of partitions is joined in memory. Partitions that are still too large (skew) are
+ * partitioned again with a different hash, up to MAX_PARTITION_DEPTH levels. While partitioning, a bloom filter over
+ * every left key keeps right tuples that cannot match from being spilled at all.
  */
 class HashJoinExecutor : public AbstractExecutor {
  public:
@@ -54,25 +63,69 @@ class HashJoinExecutor : public AbstractExecutor {
   /** @return The output schema for the join */
   auto GetOutputSchema() -> const Schema * override { return plan_->OutputSchema(); };
 
-  auto MergeTuple(Tuple& left,Tuple& right)->Tuple;
+  auto GetName() -> std::string override { return std::string("HashJoinExecutor"); }
+
  private:
+  /** Number of partitions each spilled input is split into */
+  static constexpr uint32_t PARTITION_FANOUT = 8;
+  /** How many times a skewed partition may be split again before it is joined in memory regardless */
+  static constexpr uint32_t MAX_PARTITION_DEPTH = 4;
+
+  /** A pair of spilled partitions that still has to be joined */
+  struct Partition {
+    std::unique_ptr<TmpTupleHeap> left_;
+    std::unique_ptr<TmpTupleHeap> right_;
+    uint32_t depth_;
+  };
+
+  auto LeftKey(const Tuple &tuple) const -> Value;
+  auto RightKey(const Tuple &tuple) const -> Value;
+
+  /** @return the mixed hash of a join key */
+  static auto HashKey(const Value &key) -> hash_t { return HashUtil::MixHash(HashUtil::HashValue(&key)); }
+
+  /** @return the partition of a key hash at the given depth, every depth uses an independent hash */
+  static auto PartitionOf(hash_t hash, uint32_t depth) -> uint32_t;
+
+  /** Add a left tuple to the in-memory hash table */
+  void Build(const Tuple &tuple);
+
+  /** Spill the in-memory table and the rest of both inputs into partitions at depth 1 */
+  void PartitionInputs();
+
+  /** Split a partition that does not fit in memory into PARTITION_FANOUT partitions one level deeper */
+  void Repartition(Partition *partition);
+
+  /** Pop partitions until one fits in memory (or cannot be split), and build the hash table from its left side */
+  auto LoadNextPartition() -> bool;
+
+  /** Fetch the next probe tuple from the right child or the current right partition */
+  auto NextProbeTuple(Tuple *tuple) -> bool;
+
+  auto MergeTuple(const Tuple &left, const Tuple &right) -> Tuple;
 
   const HashJoinPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> left_executor_;
   std::unique_ptr<AbstractExecutor> right_executor_;
-  const ColumnValueExpression* left_join_column_expr_;
-  const ColumnValueExpression* right_join_column_expr_;
-  const Schema* left_schema_;
-  const Schema* right_schema_;
-  const Schema* key_schema_;
-
-
-  std::unordered_map<hash_t,std::pair<RID,Tuple>> hash_map_;
-  std::vector<std::pair<RID,Tuple>> result_;
-  // Tuple last_r_tp_;
-  HashUtil hash_util_;
-  // HashUtil::h
-  // HASH_TABLE_TYPE* hash_table_;
+  const Schema *left_schema_{nullptr};
+  const Schema *right_schema_{nullptr};
+
+  /** Left tuples of the current (or only) partition */
+  JoinHashTable hash_table_;
+
+  /** Whether the join fell back to partitioning */
+  bool spilled_{false};
+  /** Every left key hash seen while partitioning */
+  BloomFilter spill_filter_;
+  std::vector<Partition> pending_;
+  std::unique_ptr<TmpTupleHeap> probe_partition_;
+
+  /** The right tuple being probed, its key, and where we are in its probe sequence */
+  Tuple probe_tuple_;
+  Value probe_key_;
+  hash_t probe_hash_{0};
+  size_t probe_slot_{0};
+  bool probing_{false};
 };
 
 }  // namespace bustub
@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <functional>
 #include <vector>
 
+#include "catalog/catalog.h"
 #include "common/rid.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -23,9 +25,12 @@
 namespace bustub {
 
 /**
- * IndexScanExecutor executes an index scan over a table.
+ * IndexScanExecutor executes an index scan over a table, visiting its tuples in the key order of a B+ tree index.
+ *
+ * When every column the predicate and the output schema read is stored in the index entries (as a key or INCLUDE
+ * column, see Catalog::CreateIndex) the scan is index-only: rows are rebuilt from the leaf pages and the table heap is
+ * never read. Otherwise each entry's tuple is fetched from the heap by its RID.
  */
-
 class IndexScanExecutor : public AbstractExecutor {
  public:
   /**
@@ -42,7 +47,27 @@ class IndexScanExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  /**
+   * Produces the next entry of the index: its values (when entry is not nullptr) and the RID of its tuple.
+   * @return false once the index is exhausted
+   */
+  using EntryCursor = std::function<bool(std::vector<Value> *entry, RID *rid)>;
+
+  /** @return a cursor over the index, whose keys are GenericKey<KeySize> */
+  template <size_t KeySize>
+  auto MakeCursor() -> EntryCursor;
+
+  /** @return the row of the table an entry belongs to, with the columns the index does not store left empty */
+  auto RowFromEntry(const std::vector<Value> &entry) const -> Tuple;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  IndexInfo *index_info_{nullptr};
+  TableInfo *table_info_{nullptr};
+  EntryCursor cursor_;
+  /** For each table column, its position in an index entry or -1 */
+  std::vector<int> entry_positions_;
+  /** Whether the entries hold every column the scan reads */
+  bool index_only_{false};
 };
 }  // namespace bustub
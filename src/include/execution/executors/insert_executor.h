@@ -14,10 +14,12 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/insert_plan.h"
+#include "storage/table/tmp_tuple_heap.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -27,6 +29,10 @@ namespace bustub {
  *
  * Unlike UPDATE and DELETE, inserted values may either be
  * embedded in the plan itself or be pulled from a child executor.
+ *
+ * Tuples are streamed from the child and inserted BATCH_SIZE at a time: the batch goes to the table heap in one pass
+ * over its pages, then each index gets the batch's keys in sorted order. If the child reads the table being inserted
+ * into, it is drained into a TmpTupleHeap first so that it never sees the new tuples.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -56,12 +62,30 @@ class InsertExecutor : public AbstractExecutor {
   /** @return The output schema for the insert */
   auto GetOutputSchema() -> const Schema * override { return plan_->OutputSchema(); };
 
+  auto GetName() -> std::string override { return std::string("InsertExecutor"); }
+
  private:
+  /** Tuples inserted at once */
+  static constexpr size_t BATCH_SIZE = 256;
+
+  /** @return whether any scan in the plan reads the table with the given oid */
+  auto ReadsTable(const AbstractPlanNode *plan, table_oid_t oid) const -> bool;
+
+  /** Fill batch with the next tuples to insert; false once there are none */
+  auto NextBatch(std::vector<Tuple> *batch) -> bool;
+
+  /** Insert a batch into the table and every index; false if the table heap refused it */
+  auto InsertBatch(const std::vector<Tuple> &batch) -> bool;
+
   /** The insert plan node to be executed*/
-  const InsertPlanNode* plan_;
+  const InsertPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_executor_;
-  TableInfo* table_info_;
-  std::vector<IndexInfo*> index_infos_;
+  TableInfo *table_info_{nullptr};
+  std::vector<IndexInfo *> index_infos_;
+  /** The next raw values to insert */
+  size_t next_raw_{0};
+  /** The child's output, when it had to be drained before inserting */
+  std::unique_ptr<TmpTupleHeap> spool_;
 };
 
 }  // namespace bustub
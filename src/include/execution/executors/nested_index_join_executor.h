@@ -12,9 +12,9 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -22,13 +22,19 @@
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/nested_index_join_plan.h"
-#include "storage/table/tmp_tuple.h"
+#include "execution/plans/sort_plan.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
  * IndexJoinExecutor executes index join operations.
+ *
+ * Outer tuples are joined a batch of BATCH_SIZE at a time. The batch is sorted on the normalized probe key (see
+ * SortKey), so every distinct key probes the inner index once and equal keys reuse its result. On a B+ tree index the
+ * probes of a batch walk one iterator forward instead of descending the tree for every key. The matched RIDs are then
+ * sorted by position, so the inner tuples are read from the heap page by page. As in an index scan, the index finds
+ * the rows and the heap gives the version of each that the transaction sees.
  */
 class NestIndexJoinExecutor : public AbstractExecutor {
  public:
@@ -47,8 +53,40 @@ class NestIndexJoinExecutor : public AbstractExecutor {
 
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  auto GetName() -> std::string override { return std::string("NestIndexJoinExecutor"); }
+
  private:
+  /** Outer tuples joined at once */
+  static constexpr size_t BATCH_SIZE = 1024;
+  /** Entries a probe steps over to reach its key before it descends the tree instead */
+  static constexpr size_t MAX_PROBE_SKIP = 64;
+
+  /** Appends the RIDs of the index entries with a key to rids, called with keys in ascending order */
+  using KeyProbe = std::function<void(const Tuple &key, std::vector<RID> *rids)>;
+
+  /** @return a probe for one batch */
+  auto MakeProbe() -> KeyProbe;
+
+  /** @return a probe that walks a B+ tree index whose keys are GenericKey<KeySize> */
+  template <size_t KeySize>
+  auto MakeProbe() -> KeyProbe;
+
+  /** @return a probe that looks every key up in the index */
+  auto MakeScanProbe() -> KeyProbe;
+
+  /** Pull the next batch of outer tuples and join it into results_; false once the outer child is exhausted */
+  auto JoinNextBatch() -> bool;
+
   /** The nested index join plan node. */
   const NestedIndexJoinPlanNode *plan_;
+  /** The outer child */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  TableInfo *inner_table_{nullptr};
+  IndexInfo *index_{nullptr};
+  /** The side of the predicate that is evaluated on outer tuples to get the probe key, as an ORDER BY key */
+  std::vector<OrderBy> outer_key_;
+  /** The joined tuples of the current batch */
+  std::vector<Tuple> results_;
+  size_t next_result_{0};
 };
 }  // namespace bustub
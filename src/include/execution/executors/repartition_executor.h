@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// repartition_executor.h
+//
+// Identification: src/include/execution/executors/repartition_executor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/pipeline_state.h"
+#include "execution/plans/repartition_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * RepartitionExecutor yields the tuples a GatherExecutor routed to its copy of the pipeline.
+ *
+ * The routing itself is done by the gather, which runs the child as a stage of its own and appends every tuple to the
+ * run of partition PartitionOf. In a copy, the executor reads the runs of its partition that every producer of the
+ * stage wrote. Anywhere else it passes its child through.
+ */
+class RepartitionExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new RepartitionExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The repartition plan to be executed
+   * @param child_executor The child executor, only run when the repartition passes its child through
+   */
+  RepartitionExecutor(ExecutorContext *exec_ctx, const RepartitionPlanNode *plan,
+                      std::unique_ptr<AbstractExecutor> &&child_executor);
+
+  /** Initialize the repartition */
+  void Init() override;
+
+  /**
+   * Yield the next tuple of this copy's partition.
+   * @param[out] tuple The next tuple produced by the repartition
+   * @param[out] rid The next tuple RID produced by the repartition
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema for the repartition */
+  auto GetOutputSchema() -> const Schema * override { return plan_->OutputSchema(); }
+
+  auto GetName() -> std::string override { return std::string("RepartitionExecutor"); }
+
+  /**
+   * @return the partition of tuple among num_partitions, by the hash of the plan's keys with NULL keys hashing alike
+   */
+  static auto PartitionOf(const RepartitionPlanNode *plan, const Tuple &tuple, const Schema *schema,
+                          size_t num_partitions) -> size_t;
+
+ private:
+  /** The repartition plan node to be executed */
+  const RepartitionPlanNode *plan_;
+  /** The child executor from which tuples are obtained */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The runs of this copy's partition, nullptr when passing the child through */
+  RepartitionState *state_{nullptr};
+  /** The producer whose run is being read */
+  size_t producer_{0};
+};
+
+}  // namespace bustub
@@ -12,10 +12,12 @@
 
 #pragma once
 
-#include <vector>
+#include <memory>
+#include <string>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/pipeline_state.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "storage/table/tuple.h"
 
@@ -23,6 +25,14 @@ namespace bustub {
 
 /**
  * The SeqScanExecutor executor executes a sequential table scan.
+ *
+ * When the context allows more than one thread (ExecutorContext::SetNumThreads), a table of more than one morsel of
+ * MorselSource::MORSEL_PAGES pages is scanned in parallel by running the scan under a GatherExecutor, so tuples then
+ * come out in no particular order. Each copy of the scan that the gather runs
+ * claims morsels from the pipeline's MorselSource one at a time and evaluates the predicate and the projection on
+ * their pages. The predicate and projection are pushed into the TableIterator, which skips the pages whose zone maps
+ * rule out a column-to-constant comparison and on a PAX or compressed table only reads (or decompresses) the columns
+ * they use.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -48,11 +58,16 @@ class SeqScanExecutor : public AbstractExecutor {
   auto GetOutputSchema() -> const Schema * override { return plan_->OutputSchema(); }
 
   auto GetName()-> std::string override { return std::string("SeqScanExecutor");}
+
  private:
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
+  /** Iterator over the table, or over the current morsel, with the plan's predicate and projection pushed down */
   TableIterator iterator_;
-  TableInfo* table_info_;
-  std::vector<uint32_t> key_attrs_;
+  TableInfo *table_info_{nullptr};
+  /** The morsels this copy of a parallel scan claims, nullptr when scanning the whole table */
+  MorselSource *morsels_{nullptr};
+  /** The parallel scan this executor delegates to */
+  std::unique_ptr<AbstractExecutor> gather_;
 };
 }  // namespace bustub
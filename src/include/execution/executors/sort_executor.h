@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.h
+//
+// Identification: src/include/execution/executors/sort_executor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/sort_plan.h"
+#include "storage/table/tmp_tuple_heap.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SortExecutor orders the tuples of its child by the plan's ORDER BY keys.
+ *
+ * Every child tuple is stored in an arena as a record
+ * | key size (4) | normalized key | tuple size (4) | tuple |, see SortKey, so sorting only memcmps keys. Once the arena
+ * outgrows the executor context's work memory the records are sorted and written out as a run of a TmpTupleHeap.
+ * If any run was spilled, the runs are merged in passes of at most MAX_MERGE_FAN_IN runs until a single k-way merge
+ * can produce the output.
+ */
+class SortExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new SortExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The sort plan to be executed
+   * @param child_executor The child executor from which tuples are pulled
+   */
+  SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child_executor);
+
+  ~SortExecutor() override;
+
+  /** Initialize the sort, consuming the whole child */
+  void Init() override;
+
+  /**
+   * Yield the next tuple from the sort.
+   * @param[out] tuple The next tuple produced by the sort
+   * @param[out] rid The next tuple RID produced by the sort, always invalid
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema for the sort */
+  auto GetOutputSchema() -> const Schema * override { return plan_->OutputSchema(); };
+
+  auto GetName() -> std::string override { return std::string("SortExecutor"); }
+
+ private:
+  /** Most runs merged at once; every run being read keeps one page pinned */
+  static constexpr size_t MAX_MERGE_FAN_IN = 16;
+
+  class RunMerger;
+
+  /** Append the record of a child tuple to the arena */
+  void AddRecord(const Tuple &tuple);
+
+  /** Sort the arena's records by key */
+  void SortRecords();
+
+  /** Sort the arena's records into a new run and clear the arena */
+  void SpillRun();
+
+  /** Merge runs_ in passes until at most MAX_MERGE_FAN_IN are left, then start the final merge */
+  void MergeRuns();
+
+  /** The sort plan node to be executed */
+  const SortPlanNode *plan_;
+  /** The child executor from which tuples are obtained */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+
+  /** Records of the current run, back to back */
+  std::vector<char> arena_;
+  /** Arena offsets of the records, in sorted order after SortRecords */
+  std::vector<size_t> records_;
+  /** The next record to emit when nothing was spilled */
+  size_t next_record_{0};
+  /** Sorted runs that were spilled */
+  std::vector<std::unique_ptr<TmpTupleHeap>> runs_;
+  /** The final merge, if anything was spilled */
+  std::unique_ptr<RunMerger> merger_;
+  /** Scratch space for one normalized key */
+  std::string key_;
+};
+
+}  // namespace bustub
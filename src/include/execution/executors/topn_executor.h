@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_executor.h
+//
+// Identification: src/include/execution/executors/topn_executor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TopNExecutor produces the first N tuples of its child in ORDER BY order.
+ *
+ * It keeps a max-heap of the N smallest normalized keys seen so far (see SortKey), so memory stays bounded by N and
+ * a child tuple that does not beat the current N-th key is dropped without being copied.
+ */
+class TopNExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new TopNExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The top-n plan to be executed
+   * @param child_executor The child executor from which tuples are pulled
+   */
+  TopNExecutor(ExecutorContext *exec_ctx, const TopNPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child_executor);
+
+  /**
+   * Construct a TopNExecutor for a LIMIT directly over a sort, which it replaces.
+   * @param exec_ctx The executor context
+   * @param limit_plan The limit plan
+   * @param sort_plan The sort plan below the limit
+   * @param child_executor The executor of the sort's child
+   */
+  TopNExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *limit_plan, const SortPlanNode *sort_plan,
+               std::unique_ptr<AbstractExecutor> &&child_executor);
+
+  /** Initialize the top-n, consuming the whole child */
+  void Init() override;
+
+  /**
+   * Yield the next tuple from the top-n.
+   * @param[out] tuple The next tuple produced by the top-n
+   * @param[out] rid The next tuple RID produced by the top-n, always invalid
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema for the top-n */
+  auto GetOutputSchema() -> const Schema * override { return output_schema_; };
+
+  auto GetName() -> std::string override { return std::string("TopNExecutor"); }
+
+ private:
+  struct Entry {
+    std::string key_;
+    Tuple tuple_;
+  };
+
+  /** The output schema, the same as the child's */
+  const Schema *output_schema_;
+  /** The ORDER BY keys */
+  const std::vector<OrderBy> *order_bys_;
+  /** The number of tuples to produce */
+  size_t n_;
+  /** The child executor from which tuples are obtained */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** A max-heap on key while consuming the child, then sorted ascending */
+  std::vector<Entry> entries_;
+  /** The next entry to emit */
+  size_t next_entry_{0};
+};
+
+}  // namespace bustub
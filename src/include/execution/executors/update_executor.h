@@ -74,6 +74,7 @@ class UpdateExecutor : public AbstractExecutor {
   std::unique_ptr<AbstractExecutor> child_executor_;
 
   Transaction* txn_;
+  /** The indexes of the table whose entries include a column the update sets, the others are never touched */
   std::vector<IndexInfo*> index_infos_;
 };
 }  // namespace bustub
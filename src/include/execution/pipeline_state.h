@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pipeline_state.h
+//
+// Identification: src/include/execution/pipeline_state.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "execution/plans/abstract_plan.h"
+#include "storage/table/tmp_tuple_heap.h"
+
+namespace bustub {
+
+/** The pages of a table, handed out MORSEL_PAGES at a time to the copies of a parallel scan. */
+class MorselSource {
+ public:
+  /** Pages per unit of work of a parallel scan */
+  static constexpr size_t MORSEL_PAGES = 16;
+
+  explicit MorselSource(std::vector<page_id_t> page_ids) : page_ids_(std::move(page_ids)) {}
+
+  /** @return the number of morsels a table of num_pages pages is cut into */
+  static auto NumMorsels(size_t num_pages) -> size_t { return (num_pages + MORSEL_PAGES - 1) / MORSEL_PAGES; }
+
+  /**
+   * Claim the next morsel. A morsel ends where the next one starts in the page list, so pages appended to the table
+   * after the page ids were taken belong to the last morsel.
+   * @param[out] first_page_id the first page of the morsel
+   * @param[out] stop_page_id the first page after the morsel, INVALID_PAGE_ID for the last one
+   * @return false once every morsel was claimed
+   */
+  auto Next(page_id_t *first_page_id, page_id_t *stop_page_id) -> bool {
+    size_t first = next_++ * MORSEL_PAGES;
+    if (first >= page_ids_.size()) {
+      return false;
+    }
+    size_t stop = first + MORSEL_PAGES;
+    *first_page_id = page_ids_[first];
+    *stop_page_id = stop < page_ids_.size() ? page_ids_[stop] : INVALID_PAGE_ID;
+    return true;
+  }
+
+ private:
+  std::vector<page_id_t> page_ids_;
+  std::atomic<size_t> next_{0};
+};
+
+/** The tuples a Repartition routed, one run per producing copy and partition. */
+class RepartitionState {
+ public:
+  RepartitionState(BufferPoolManager *bpm, size_t num_producers, size_t num_partitions) : runs_(num_producers) {
+    for (auto &runs : runs_) {
+      for (size_t i = 0; i < num_partitions; i++) {
+        runs.push_back(std::make_unique<TmpTupleHeap>(bpm));
+      }
+    }
+  }
+
+  auto GetNumProducers() const -> size_t { return runs_.size(); }
+
+  /** @return the run that producer writes the tuples of partition to */
+  auto GetRun(size_t producer, size_t partition) -> TmpTupleHeap * { return runs_[producer][partition].get(); }
+
+ private:
+  std::vector<std::vector<std::unique_ptr<TmpTupleHeap>>> runs_;
+};
+
+/**
+ * State shared by the copies of a pipeline that a GatherExecutor runs on several workers: how the driving scans are
+ * split, and what every Repartition produced. The Gather fills it in between stages, while no copy is running, so the
+ * copies only ever read the maps.
+ */
+class PipelineState {
+ public:
+  explicit PipelineState(size_t num_workers) : num_workers_(num_workers) {}
+
+  /** @return the number of copies of the pipeline */
+  auto GetNumWorkers() const -> size_t { return num_workers_; }
+
+  /** Split the scan `plan` into morsels of the given pages */
+  void AddScan(const AbstractPlanNode *plan, std::vector<page_id_t> page_ids) {
+    scans_[plan] = std::make_unique<MorselSource>(std::move(page_ids));
+  }
+
+  /** @return the morsels of scan `plan`, or nullptr if every copy reads it in full */
+  auto GetScan(const AbstractPlanNode *plan) const -> MorselSource * {
+    auto it = scans_.find(plan);
+    return it == scans_.end() ? nullptr : it->second.get();
+  }
+
+  auto AddRepartition(const AbstractPlanNode *plan, BufferPoolManager *bpm, size_t num_producers)
+      -> RepartitionState * {
+    auto &state = repartitions_[plan];
+    state = std::make_unique<RepartitionState>(bpm, num_producers, num_workers_);
+    return state.get();
+  }
+
+  /** @return what Repartition `plan` produced, or nullptr if it passes its child through */
+  auto GetRepartition(const AbstractPlanNode *plan) const -> RepartitionState * {
+    auto it = repartitions_.find(plan);
+    return it == repartitions_.end() ? nullptr : it->second.get();
+  }
+
+ private:
+  size_t num_workers_;
+  std::unordered_map<const AbstractPlanNode *, std::unique_ptr<MorselSource>> scans_;
+  std::unordered_map<const AbstractPlanNode *, std::unique_ptr<RepartitionState>> repartitions_;
+};
+
+}  // namespace bustub
@@ -31,7 +31,11 @@ enum class PlanType {
   Distinct,
   NestedLoopJoin,
   NestedIndexJoin,
-  HashJoin
+  HashJoin,
+  Sort,
+  TopN,
+  Gather,
+  Repartition
 };
 
 /**
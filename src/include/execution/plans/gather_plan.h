@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// gather_plan.h
+//
+// Identification: src/include/execution/plans/gather_plan.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * Gather runs copies of its child pipeline on the worker threads and merges their output into one stream, in no
+ * particular order.
+ *
+ * The input is split at the pipeline's driving leaf, reached from the child through the probe side of hash joins,
+ * the outer side of nested-loop and nested-index joins and through aggregations and distincts that sit above a
+ * Repartition. A sequential scan there is split into morsels of pages, a Repartition into its partitions. Every other
+ * input, such as the build side of a hash join, is read in full by each copy. A pipeline without a driving leaf runs
+ * as a single copy on the calling thread.
+ */
+class GatherPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Construct a new GatherPlanNode instance.
+   * @param output_schema The output schema of the gather, which must be the child's
+   * @param child The pipeline to run in parallel
+   */
+  GatherPlanNode(const Schema *output_schema, const AbstractPlanNode *child)
+      : AbstractPlanNode(output_schema, {child}) {}
+
+  /** @return The type of the plan node */
+  auto GetType() const -> PlanType override { return PlanType::Gather; }
+
+  /** @return The child plan node */
+  auto GetChildPlan() const -> const AbstractPlanNode * {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Gather should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+};
+
+}  // namespace bustub
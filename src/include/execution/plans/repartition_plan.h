@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// repartition_plan.h
+//
+// Identification: src/include/execution/plans/repartition_plan.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * Repartition redistributes the tuples of its child among the copies of the pipeline a Gather runs, by the hash of
+ * the partition keys, so that every copy sees all tuples with the same keys. An aggregation or distinct above it may
+ * then run in every copy, as long as it groups by (a superset of) the partition keys.
+ *
+ * The child is run to completion by its own set of copies before the pipeline above starts. Outside a Gather, or off
+ * the driving path of one, Repartition passes its child through.
+ */
+class RepartitionPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Construct a new RepartitionPlanNode instance.
+   * @param output_schema The output schema of the repartition, which must be the child's
+   * @param child The child plan from which tuples are obtained
+   * @param keys The partition keys, evaluated against the child's output schema
+   */
+  RepartitionPlanNode(const Schema *output_schema, const AbstractPlanNode *child,
+                      std::vector<const AbstractExpression *> keys)
+      : AbstractPlanNode(output_schema, {child}), keys_(std::move(keys)) {}
+
+  /** @return The type of the plan node */
+  auto GetType() const -> PlanType override { return PlanType::Repartition; }
+
+  /** @return The partition keys */
+  auto GetKeys() const -> const std::vector<const AbstractExpression *> & { return keys_; }
+
+  /** @return The child plan node */
+  auto GetChildPlan() const -> const AbstractPlanNode * {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Repartition should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+ private:
+  /** The partition keys */
+  std::vector<const AbstractExpression *> keys_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_plan.h
+//
+// Identification: src/include/execution/plans/sort_plan.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** OrderByType is the direction of one ORDER BY key. Default is ascending. */
+enum class OrderByType { Default, Asc, Desc };
+
+/** One ORDER BY key: its direction and the expression evaluated against the child's output */
+using OrderBy = std::pair<OrderByType, const AbstractExpression *>;
+
+/**
+ * Sort orders the tuples of its child by a list of ORDER BY keys.
+ * NULLs compare smaller than every other value.
+ */
+class SortPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Construct a new SortPlanNode instance.
+   * @param output_schema The output schema of the sort, which must be the child's
+   * @param child The child plan from which tuples are obtained
+   * @param order_bys The ORDER BY keys, most significant first
+   */
+  SortPlanNode(const Schema *output_schema, const AbstractPlanNode *child, std::vector<OrderBy> order_bys)
+      : AbstractPlanNode(output_schema, {child}), order_bys_(std::move(order_bys)) {}
+
+  /** @return The type of the plan node */
+  auto GetType() const -> PlanType override { return PlanType::Sort; }
+
+  /** @return The ORDER BY keys */
+  auto GetOrderBy() const -> const std::vector<OrderBy> & { return order_bys_; }
+
+  /** @return The child plan node */
+  auto GetChildPlan() const -> const AbstractPlanNode * {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Sort should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+ private:
+  /** The ORDER BY keys */
+  std::vector<OrderBy> order_bys_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.h
+//
+// Identification: src/include/execution/sort_key.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "execution/plans/sort_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SortKey encodes the ORDER BY values of a tuple into a normalized key: a byte string whose memcmp order is the
+ * ORDER BY order, so sorting and merging never have to deserialize or dispatch on Value types.
+ *
+ * Every key is | null flag (1) | value |. Integers are stored big-endian with the sign bit flipped, decimals as their
+ * IEEE bits made order-preserving, and varchars with 0x00 escaped as 0x00 0xFF and terminated by 0x00 0x00. All bytes
+ * of a descending key are inverted.
+ */
+class SortKey {
+ public:
+  /**
+   * Append the normalized key of a tuple to out.
+   * @param order_bys the ORDER BY keys
+   * @param tuple the tuple to encode
+   * @param schema the schema of tuple
+   * @param[out] out where the key is appended
+   */
+  static void Encode(const std::vector<OrderBy> &order_bys, const Tuple &tuple, const Schema &schema,
+                     std::string *out);
+
+  /**
+   * Append the normalized key of every column of a tuple, all ascending, to out.
+   * @param tuple the tuple to encode
+   * @param schema the schema of tuple
+   * @param[out] out where the key is appended
+   */
+  static void Encode(const Tuple &tuple, const Schema &schema, std::string *out);
+
+  /** @return memcmp order of two normalized keys, where a proper prefix sorts first */
+  static auto Compare(const char *left, uint32_t left_size, const char *right, uint32_t right_size) -> int {
+    int cmp = memcmp(left, right, std::min(left_size, right_size));
+    if (cmp != 0) {
+      return cmp;
+    }
+    return left_size < right_size ? -1 : (left_size > right_size ? 1 : 0);
+  }
+
+ private:
+  static void EncodeValue(const Value &value, std::string *out);
+};
+
+}  // namespace bustub
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_exchange.h
+//
+// Identification: src/include/execution/tuple_exchange.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TupleExchange hands batches of tuples from producers to a consumer thread through a bounded queue.
+ *
+ * Producers are tasks of a ThreadPool and must not block, so a push into a full queue fails instead of waiting: the
+ * producer passes a `resume` callback that the exchange keeps and calls once the consumer has made room, and the
+ * producer stops until then. A fast producer therefore never gets more than `capacity` batches ahead. The exchange is
+ * finished once every producer has called Finish, and the consumer then drains what is left. Cancel wakes the consumer
+ * up, drops the parked producers and makes Push and Pop fail, which is how a consumer that stops early shuts its
+ * producers down.
+ */
+class TupleExchange {
+ public:
+  /**
+   * @param capacity the number of batches the queue holds before pushes fail
+   * @param num_producers the number of producers that will call Finish
+   */
+  TupleExchange(size_t capacity, size_t num_producers) : capacity_(capacity), num_producers_(num_producers) {}
+
+  DISALLOW_COPY_AND_MOVE(TupleExchange);
+
+  /**
+   * Enqueue batch if there is room.
+   * @param batch the tuples to hand over, moved from only if the push succeeds
+   * @param resume called once there is room again if the queue is full; nullptr to enqueue past the capacity
+   * @return false if the exchange was cancelled or the batch was not enqueued because the queue is full
+   */
+  auto Push(std::vector<Tuple> &&batch, std::function<void()> resume) -> bool {
+    std::scoped_lock lock(latch_);
+    if (cancelled_) {
+      return false;
+    }
+    if (batches_.size() >= capacity_ && resume != nullptr) {
+      parked_.push_back(std::move(resume));
+      return false;
+    }
+    batches_.push_back(std::move(batch));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /** Block until a batch is available; false once every producer finished and the queue is drained, or cancelled. */
+  auto Pop(std::vector<Tuple> *batch) -> bool {
+    std::vector<std::function<void()>> resumed;
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      not_empty_.wait(lock, [&] { return !batches_.empty() || num_producers_ == 0 || cancelled_; });
+      if (batches_.empty() || cancelled_) {
+        return false;
+      }
+      *batch = std::move(batches_.front());
+      batches_.pop_front();
+      if (batches_.size() < capacity_) {
+        resumed.swap(parked_);
+      }
+    }
+    // A resumed producer may push right away, so call them without holding the latch.
+    for (auto &resume : resumed) {
+      resume();
+    }
+    return true;
+  }
+
+  /** A producer will not push anymore. */
+  void Finish() {
+    std::scoped_lock lock(latch_);
+    BUSTUB_ASSERT(num_producers_ > 0, "More producers finished than were registered.");
+    if (--num_producers_ == 0) {
+      not_empty_.notify_all();
+    }
+  }
+
+  /** Drop every queued batch and parked producer, and fail all current and future pushes and pops. */
+  void Cancel() {
+    std::scoped_lock lock(latch_);
+    cancelled_ = true;
+    batches_.clear();
+    parked_.clear();
+    not_empty_.notify_all();
+  }
+
+ private:
+  size_t capacity_;
+  size_t num_producers_;
+  std::mutex latch_;
+  std::condition_variable not_empty_;
+  std::deque<std::vector<Tuple>> batches_;
+  /** The resume callbacks of producers that found the queue full */
+  std::vector<std::function<void()>> parked_;
+  bool cancelled_{false};
+};
+
+}  // namespace bustub
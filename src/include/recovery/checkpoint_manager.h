@@ -20,6 +20,10 @@ namespace bustub {
 
 /**
  * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ *
+ * The checkpoint waits for the running transactions to end and writes every page out, then logs a CHECKPOINT record
+ * and points the master record at it. Recovery reads the log from there: no transaction was active and no page was
+ * dirty at the checkpoint, so its record carries no transaction or dirty page table.
  */
 class CheckpointManager {
  public:
@@ -35,9 +39,9 @@ class CheckpointManager {
   void EndCheckpoint();
 
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
 };
 
 }  // namespace bustub
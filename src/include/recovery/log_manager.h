@@ -16,7 +16,9 @@
 #include <condition_variable>  // NOLINT
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 
+#include "common/macros.h"
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
 
@@ -25,50 +27,102 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * The log is double buffered: records are appended to log_buffer_ while the flush thread writes out flush_buffer_,
+ * the two are swapped when a flush begins. A committing transaction waits in Flush() until its COMMIT record is on
+ * disk, and every transaction that committed while a flush was under way is made durable by the next one: they share
+ * a write (group commit).
+ *
+ * Appending takes no latch. A record reserves its LSN and its space in log_buffer_ together, with a compare-and-swap
+ * on reserved_, and is serialized there concurrently with the others; filled_ counts the bytes written. A flush seals
+ * the buffer against new reservations and waits until everything reserved in it is filled in before swapping.
+ *
+ * Without the flush thread, a thread that needs the log on disk or room in the buffer writes the buffer out itself.
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+  explicit LogManager(DiskManager *disk_manager) : persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
     flush_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogManager() {
+    if (flush_thread_ != nullptr) {
+      StopFlushThread();
+    }
     delete[] log_buffer_;
     delete[] flush_buffer_;
     log_buffer_ = nullptr;
     flush_buffer_ = nullptr;
   }
 
+  DISALLOW_COPY_AND_MOVE(LogManager);
+
   void RunFlushThread();
   void StopFlushThread();
 
   auto AppendLogRecord(LogRecord *log_record) -> lsn_t;
 
-  inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
+  /**
+   * Block until the log records up to and including lsn are on disk, writing the log buffer out if they are not.
+   * Records not appended yet are not waited for.
+   */
+  void Flush(lsn_t lsn);
+
+  inline auto GetNextLSN() -> lsn_t { return static_cast<lsn_t>(reserved_.load() >> 32); }
   inline auto GetPersistentLSN() -> lsn_t { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
   inline auto GetLogBuffer() -> char * { return log_buffer_; }
 
+  /**
+   * Append a CHECKPOINT record and point the master record of the disk manager at it once it is on disk, together
+   * with the log before it. No other record may be appended meanwhile.
+   * @return the LSN of the record
+   */
+  auto AppendCheckpointRecord() -> lsn_t;
+
+  /** Continue the LSNs of the log on disk after a restart, before any record is appended. */
+  void SetNextLSN(lsn_t next_lsn);
+
+  /** Write a log record, its size_ bytes, in the format described by LogRecord */
+  static void SerializeLogRecord(const LogRecord &log_record, char *data);
+
  private:
-  // TODO(students): you may add your own member variables
+  /** Have the log buffer written out and wait for it, or for the next flush to complete. Requires latch_. */
+  void ForceFlush(std::unique_lock<std::mutex> *lock);
+
+  /** Swap the buffers and write out what was appended. Requires flush_latch_, and latch_ through lock. */
+  void SwapAndFlush(std::unique_lock<std::mutex> *lock);
+
+  /** The offset of reserved_ while a flush swaps the buffers, no record is appended then */
+  static constexpr uint32_t SEALED = UINT32_MAX;
 
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** The next log sequence number in the high 32 bits, the bytes reserved in log_buffer_ in the low ones. */
+  std::atomic<uint64_t> reserved_{0};
+  /** The bytes of log_buffer_ filled in by the records that reserved them */
+  std::atomic<size_t> filled_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
   char *log_buffer_;
   char *flush_buffer_;
 
+  /** Protects the state of the flush thread and the flush requests */
   std::mutex latch_;
+  /** Held while flush_buffer_ is written out, by one flush at a time */
+  std::mutex flush_latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
+  bool stop_flush_thread_{false};
+  /** Set when a thread is waiting for the next flush, which then starts right away */
+  bool flush_requested_{false};
 
+  /** Wakes up the flush thread */
   std::condition_variable cv_;
+  /** Signalled when a flush completed, for the threads waiting on persistent_lsn_ or for room in the buffer */
+  std::condition_variable flushed_cv_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
@@ -32,6 +32,10 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** A checkpoint, no transaction runs and every page is on disk. */
+  CHECKPOINT,
+  /** A compensation log record, the action that undid a record of a transaction in recovery. */
+  CLR,
 };
 
 /**
@@ -54,9 +58,14 @@ enum class LogRecordType {
  * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
  *-----------------------------------------------------------------------------------
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *------------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *------------------------------------
+ * For compensation log record, where the action is laid out as the record of its type without the HEADER
+ *-------------------------------------------------
+ * | HEADER | undo_next_lsn | action_type | action |
+ *-------------------------------------------------
+ * Checkpoint type log record is the HEADER only.
  */
 class LogRecord {
   friend class LogManager;
@@ -110,6 +119,14 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for CLR type, the action undoing a record of the transaction whose prev_lsn_ is undo_next_lsn
+  LogRecord(lsn_t undo_next_lsn, const LogRecord &action) : LogRecord(action) {
+    size_ = action.size_ + sizeof(lsn_t) + sizeof(LogRecordType);
+    log_record_type_ = LogRecordType::CLR;
+    action_type_ = action.log_record_type_;
+    undo_next_lsn_ = undo_next_lsn;
+  }
+
   ~LogRecord() = default;
 
   inline auto GetDeleteTuple() -> Tuple & { return delete_tuple_; }
@@ -128,6 +145,10 @@ class LogRecord {
 
   inline auto GetNewPageRecord() -> page_id_t { return prev_page_id_; }
 
+  inline auto GetUndoNextLSN() -> lsn_t { return undo_next_lsn_; }
+
+  inline auto GetActionType() -> LogRecordType { return action_type_; }
+
   inline auto GetSize() -> int32_t { return size_; }
 
   inline auto GetLSN() -> lsn_t { return lsn_; }
@@ -176,6 +197,10 @@ class LogRecord {
   // case4: for new page operation
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
+
+  // case5: for compensation, the type of the action, whose fields are those of a record of that type
+  LogRecordType action_type_{LogRecordType::INVALID};
+  lsn_t undo_next_lsn_{INVALID_LSN};
   static const int HEADER_SIZE = 20;
 };  // namespace bustub
 
@@ -13,22 +13,51 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
+#include "storage/page/table_page.h"
 
 namespace bustub {
 
 /**
- * Read log file from disk, redo and undo.
+ * Read log file from disk, redo and undo, ARIES style.
+ *
+ * Redo reads the log from the last checkpoint, the offset of the master record, to the end. The checkpoint is sharp,
+ * so the analysis of the log needs no pass of its own: it is done while reading, keeping the transactions that did
+ * not end and the offsets of their records. The records that change a page are handed to redo workers partitioned by
+ * page id, each applying the records of its pages in LSN order wherever the page LSN shows they are not on disk yet.
+ * Pages are independent, so redo scales with the workers while the reader only parses record headers.
+ *
+ * Undo rolls the transactions that did not end back, record by record in descending LSN order across them, following
+ * their prev_lsn_ chains. With a log manager, every undone record is compensated by a CLR whose undo_next_lsn_ is the
+ * record's prev_lsn_, and an ABORT record ends each transaction, so a crash during recovery redoes the undo done so
+ * far and goes on from there. The log manager then continues after the LSNs of the log.
+ *
+ * Recovery runs before logging is enabled.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
+  /**
+   * @param log_manager the log manager to write the compensation log records to, nullptr not to log the undo
+   * @param num_workers the number of redo workers, at most one per frame of the buffer pool as each pins a page
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager = nullptr,
+              size_t num_workers = std::max(1U, std::thread::hardware_concurrency()))
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        num_workers_(std::clamp<size_t>(num_workers, 1, buffer_pool_manager->GetPoolSize())),
+        offset_(0) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
@@ -37,20 +66,61 @@ class LogRecovery {
     log_buffer_ = nullptr;
   }
 
+  DISALLOW_COPY_AND_MOVE(LogRecovery);
+
   void Redo();
   void Undo();
-  auto DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool;
+
+  /**
+   * @param size the bytes available at data
+   * @return false if data does not begin with a complete log record
+   */
+  auto DeserializeLogRecord(const char *data, int size, LogRecord *log_record) -> bool;
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** The records of the pages of a redo worker, in LSN order */
+  struct RedoPartition {
+    std::mutex latch_;
+    /** Signalled when a batch is queued or taken, or the log is read to the end */
+    std::condition_variable cv_;
+    /** Serialized records, as read from the log */
+    std::deque<std::vector<char>> batches_;
+    bool done_{false};
+  };
+
+  /** The batches a reader queues for a worker before it waits for the worker to catch up */
+  static constexpr size_t MAX_QUEUED_BATCHES = 8;
+
+  /** Note the transaction of a record read at the offset, and queue it for the workers of the pages it changes. */
+  void Analyze(const char *data, int offset, std::vector<std::vector<char>> *batches);
+
+  /** Apply the records of a partition until the log is read to the end. */
+  void RunRedoWorker(size_t partition);
+
+  /** Apply the part of a record that changes the pages of a partition, if not on the pages already. */
+  void RedoRecord(LogRecord *log_record, size_t partition);
+
+  /** Reverse a record, and log the compensation. */
+  void UndoRecord(LogRecord *log_record);
+
+  /** Fetch a page for recovery, which needs at most one page per thread. */
+  auto FetchTablePage(page_id_t page_id) -> TablePage *;
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  size_t num_workers_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
-  /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  /** Mapping the log sequence number to log file offset for undos, for the records of the active transactions. */
+  std::unordered_map<txn_id_t, std::unordered_map<lsn_t, int>> lsn_mapping_;
+  /** The LSN of the last record of the log */
+  lsn_t last_lsn_{INVALID_LSN};
+
+  std::vector<std::unique_ptr<RedoPartition>> partitions_;
 
-  int offset_ __attribute__((__unused__));
+  int offset_;
   char *log_buffer_;
 };
 
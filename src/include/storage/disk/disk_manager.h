@@ -71,6 +71,19 @@ class DiskManager {
    */
   auto ReadLog(char *log_data, int size, int offset) -> bool;
 
+  /** @return the size of the log file */
+  auto GetLogFileSize() -> int;
+
+  /**
+   * Point the master record at the log record recovery starts from, the last checkpoint. The master record is a file
+   * next to the log, written once per checkpoint.
+   * @param offset offset of the record in the log file
+   */
+  void WriteMasterRecord(int offset);
+
+  /** @return the offset the master record points at, 0 if there is none */
+  auto ReadMasterRecord() -> int;
+
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
 
@@ -94,6 +107,7 @@ class DiskManager {
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
+  std::string master_name_;
   // stream to write db file
   std::fstream db_io_;
   std::string file_name_;
@@ -14,6 +14,7 @@
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -28,19 +29,29 @@ namespace bustub {
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) A key can have several values, its entries are ordered by value and each
+ * key & value pair is stored once
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Writers hold the tree latch exclusively for the whole operation and readers share it, so a split or merge is never
+ * observed half done. The root page id is recorded in the header page under the index name.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  friend class IndexIterator<KeyType, ValueType, KeyComparator>;
 
  public:
+  /**
+   * @param header_page_id the header page that records the root page id, trees that share a buffer pool with other
+   * data keep their own
+   */
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     page_id_t header_page_id = HEADER_PAGE_ID);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
@@ -48,10 +59,13 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
-  // Remove a key and its value from this B+ tree.
+  // Remove a key and its value from this B+ tree, the first value when the key has several.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove a key & value pair from this B+ tree.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // return the values associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
   // index iterator
@@ -76,6 +90,22 @@ class BPlusTree {
  private:
   void StartNewTree(const KeyType &key, const ValueType &value);
 
+  /** Allocate a page for a new node, throws if the buffer pool is full */
+  auto NewNodePage(page_id_t *page_id) -> Page *;
+
+  /** Find the leaf page of the key & value pair, or of the first entry of key when value is nullptr */
+  auto FindEntryLeafPage(const KeyType &key, const ValueType *value) -> Page *;
+
+  /**
+   * Copy the entries of the first leaf that has any from key on into entries. Used by IndexIterator.
+   * @param key where to start, nullptr for the first entry of the tree
+   * @param after the value of the last entry copied before, whose pair with key is skipped; nullptr to start at the
+   * first entry of key
+   */
+  void ReadLeaf(const KeyType *key, const ValueType *after, std::vector<MappingType> *entries);
+
+  void RemoveEntry(const KeyType &key, const ValueType *value, Transaction *transaction);
+
   auto InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
@@ -110,6 +140,8 @@ class BPlusTree {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  page_id_t header_page_id_;
+  ReaderWriterLatch latch_;
 };
 
 }  // namespace bustub
@@ -23,6 +23,10 @@ namespace bustub {
 
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
+/**
+ * BPlusTreeIndex stores the entries of an index (see IndexMetadata) in a B+ tree. Entries are compared on their key
+ * columns only, the tree orders the entries of equal keys by RID and keeps one per tuple.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
@@ -41,8 +45,13 @@ class BPlusTreeIndex : public Index {
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
  protected:
+  /** Allocate and initialize the header page the tree records its root page id in */
+  static auto NewHeaderPage(BufferPoolManager *buffer_pool_manager) -> page_id_t;
+
   // comparator for key
   KeyComparator comparator_;
+  // the page id of page 0 belongs to whoever allocated it first, so the tree has a header page of its own
+  page_id_t header_page_id_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
 };
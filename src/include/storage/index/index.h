@@ -32,6 +32,9 @@ class Transaction;
  * index, since the external callers does not know the actual structure of
  * the index key, so it is the index's responsibility to maintain such a
  * mapping relation and does the conversion between tuple key and index key
+ *
+ * A covering index also stores INCLUDE columns in its entries. They follow the key columns, take no part in
+ * comparisons and let an index scan answer queries that only need the key and INCLUDE columns without the table.
  */
 class IndexMetadata {
  public:
@@ -43,14 +46,23 @@ class IndexMetadata {
    * @param table_name The name of the table on which the index is created
    * @param tuple_schema The schema of the indexed key
    * @param key_attrs The mapping from indexed columns to base table columns
+   * @param include_attrs The base table columns stored in the entries after the key columns
    */
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                std::vector<uint32_t> key_attrs, const std::vector<uint32_t> &include_attrs = {})
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(std::move(key_attrs)),
+        entry_attrs_(key_attrs_) {
+    entry_attrs_.insert(entry_attrs_.end(), include_attrs.begin(), include_attrs.end());
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
+    entry_schema_ = Schema::CopySchema(tuple_schema, entry_attrs_);
   }
 
-  ~IndexMetadata() { delete key_schema_; }
+  ~IndexMetadata() {
+    delete key_schema_;
+    delete entry_schema_;
+  }
 
   /** @return The name of the index */
   inline auto GetName() const -> const std::string & { return name_; }
@@ -72,6 +84,12 @@ class IndexMetadata {
   /** @return The mapping relation between indexed columns and base table columns */
   inline auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return key_attrs_; }
 
+  /** @return A schema object pointer that represents an index entry, the key columns followed by INCLUDE columns */
+  inline auto GetEntrySchema() const -> Schema * { return entry_schema_; }
+
+  /** @return The base table columns of an index entry, the key attributes followed by the INCLUDE attributes */
+  inline auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return entry_attrs_; }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -94,6 +112,10 @@ class IndexMetadata {
   const std::vector<uint32_t> key_attrs_;
   /** The schema of the indexed key */
   Schema *key_schema_;
+  /** The key attributes followed by the INCLUDE attributes */
+  std::vector<uint32_t> entry_attrs_;
+  /** The schema of an entry, its key columns are laid out as in key_schema_ */
+  Schema *entry_schema_;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -139,6 +161,16 @@ class Index {
   /** @return The index key attributes */
   auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetKeyAttrs(); }
 
+  /**
+   * Build the entry that indexes a table tuple. Without INCLUDE columns this is just its key.
+   * @param tuple the table tuple
+   * @param schema the schema of the table
+   * @return the key columns of tuple followed by its INCLUDE columns
+   */
+  auto EntryFromTuple(const Tuple &tuple, const Schema &schema) const -> Tuple {
+    return tuple.KeyFromTuple(schema, *metadata_->GetEntrySchema(), metadata_->GetEntryAttrs());
+  }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
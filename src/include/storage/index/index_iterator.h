@@ -13,17 +13,36 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <vector>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree;
+
+/**
+ * IndexIterator walks the entries of a B+ tree in key order.
+ *
+ * The iterator holds no page pins or latches between calls: it copies the remaining entries of one leaf at a time
+ * under the tree latch, and when those run out it asks the tree for the entries after the last one it returned. A
+ * concurrent split or merge therefore never leaves it on a page that has been recycled.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
  public:
-  // you may define your own constructor based on your member variables
+  /** An iterator that is already at the end */
   IndexIterator();
+
+  /**
+   * @param tree the tree to walk
+   * @param key where to start, at its first entry; nullptr to start at the first entry of the tree
+   */
+  IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree, const KeyType *key);
+
   ~IndexIterator();  // NOLINT
 
   auto IsEnd() -> bool;
@@ -32,12 +51,15 @@ class IndexIterator {
 
   auto operator++() -> IndexIterator &;
 
-  auto operator==(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator==(const IndexIterator &itr) const -> bool;
 
-  auto operator!=(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_{nullptr};
+  /** The entries of the current leaf from where the iterator is, and the position within them */
+  std::vector<MappingType> entries_;
+  size_t pos_{0};
 };
 
 }  // namespace bustub
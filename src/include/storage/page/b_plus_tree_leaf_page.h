@@ -24,7 +24,8 @@ namespace bustub {
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
+ * page. A key can have several values, the entries of a key are ordered by value
+ * and each pair is stored once.
  *
  * Leaf page format (keys are stored in order):
  *  ----------------------------------------------------------------------
@@ -50,12 +51,14 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
   auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+  auto EntryIndex(const KeyType &key, const ValueType *value, const KeyComparator &comparator) const -> int;
+  auto CompareAt(int index, const KeyType &key, const ValueType *value, const KeyComparator &comparator) const -> int;
   auto GetItem(int index) -> const MappingType &;
 
   // insert and delete methods
   auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> int;
   auto Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const -> bool;
-  auto RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) -> int;
+  auto RemoveAndDeleteRecord(const KeyType &key, const ValueType *value, const KeyComparator &comparator) -> int;
 
   // Split and Merge utility methods
   void MoveHalfTo(BPlusTreeLeafPage *recipient);
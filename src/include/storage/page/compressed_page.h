@@ -0,0 +1,268 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page.h
+//
+// Identification: src/include/storage/page/compressed_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/page/table_page.h"
+#include "type/limits.h"
+#include "type/type.h"
+
+namespace bustub {
+
+/**
+ * Compressed page format:
+ *  -------------------------------------------------------------------------------------
+ *  | HEADER | COLUMNS | SEGMENT 0 | SEGMENT 1 | ... | SEGMENT k | ... FREE SPACE ...  |
+ *  -------------------------------------------------------------------------------------
+ *                                                               ^
+ *                                                               free space pointer
+ *
+ *  Header format (size in bytes), the first 32 bytes are the TablePage header:
+ *  -------------------------------------------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) | TupleCount (4) | FsmPageId (4) |
+ *  -------------------------------------------------------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------
+ *  | Format (4) | ColumnCount (2) | RowLength (2) | Type (2) | RowOffset (2) | ... |
+ *  ---------------------------------------------------------------------------------
+ *
+ *  Rows are stored in segments, one per batch of tuples inserted together, and numbered across segments in the order
+ *  the segments were written; TupleCount is the number of rows in all of them. Unlike the other formats, the free
+ *  space pointer is the end of the last segment.
+ *
+ *  Segment format:
+ *  -----------------------------------------------------------------------------------------------------
+ *  | SegmentSize (2) | RowCount (2) | ColumnOffset (2) ... | SlotState (1) ... | COLUMN 0 | ... | COLUMN n-1 |
+ *  -----------------------------------------------------------------------------------------------------
+ *
+ *  Every column of a segment is encoded on its own, with whichever of these takes the fewest bytes for its values:
+ *  - PLAIN: the fixed-length values as they are.
+ *  - RLE: | RunCount (4) | Value | RunEnd (4) | ... |, one value per run of equal values.
+ *  - FOR (frame of reference): | Base (8) | Bits (1) | ... |, every integer stored as its bit-packed distance to the
+ *    smallest one of the segment, so a monotone column of close values takes a few bits per row.
+ *  - DICTIONARY: | EntryCount (4) | Bits (1) | CodesOffset (4) | EntryOffset (4) ... | ENTRIES | CODES |, every
+ *    distinct VARCHAR stored once and every row a bit-packed code into the entries. VARCHARs always use it.
+ *
+ *  A segment is never changed in place: a delete only changes a slot state, and an update re-encodes the segment and
+ *  moves the segments behind it. Scans decode the columns they need a segment at a time, see ReadRows.
+ */
+class CompressedPage : public TablePage {
+ public:
+  /**
+   * Initialize an empty page for a table with the given schema.
+   * @param page_id the page ID of this table page
+   * @param prev_page_id the previous table page ID
+   * @param log_manager the log manager in use
+   * @param txn the transaction that this page is created in
+   * @param schema the schema of the table
+   */
+  void Init(page_id_t page_id, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn,
+            const Schema &schema);
+
+  /** Initialize an empty page for the same table as `layout`, see Init above for the other parameters. */
+  void Init(page_id_t page_id, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn,
+            CompressedPage *layout);
+
+  /**
+   * A tuple whose size is no larger than this always fits into a segment of its own.
+   * @return the bytes left behind the last segment, less what a segment of one row takes beyond the tuple's bytes
+   */
+  auto GetFreeSpaceRemaining() -> uint32_t;
+
+  /** @return the length of the fixed-length part of a row-format tuple of the table */
+  auto GetRowLength() -> uint16_t { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_ROW_LENGTH); }
+
+  /**
+   * Insert as many of the tuples as fit into one new segment.
+   * @param tuples the tuples to insert
+   * @param count the number of tuples
+   * @param[out] rids the rids of the inserted tuples
+   * @param txn the transaction performing the insert
+   * @param lock_manager the lock manager
+   * @param table_oid the table of the page, its rows are locked under it
+   * @param log_manager the log manager
+   * @return the number of tuples inserted, the first ones of tuples
+   */
+  auto InsertTuples(const Tuple *tuples, size_t count, RID *rids, Transaction *txn, LockManager *lock_manager,
+                    table_oid_t table_oid, LogManager *log_manager) -> size_t;
+
+  /** The tuple operations of TablePage, taking and returning row-format tuples. */
+  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                   LogManager *log_manager) -> bool;
+  auto MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                  LogManager *log_manager) -> bool;
+  auto UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
+                   LockManager *lock_manager, table_oid_t table_oid, LogManager *log_manager) -> bool;
+  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+  void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager,
+                table_oid_t table_oid) -> bool;
+  auto GetTupleView(const RID &rid, Tuple *tuple) -> bool;
+  auto GetFirstTupleRid(RID *first_rid) -> bool;
+  auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool;
+
+  /**
+   * Decode the live rows from first_slot on, a segment and within it a column at a time. Columns that are not read
+   * are left zeroed (VARCHARs as NULL) in the row-format tuples.
+   * @param first_slot the first slot to decode
+   * @param columns which columns to read, empty to read all of them
+   * @param[out] rows the decoded rows, with their rids set
+   */
+  void ReadRows(uint32_t first_slot, const std::vector<bool> &columns, std::vector<Tuple> *rows);
+
+ private:
+  static constexpr size_t OFFSET_COLUMN_COUNT = SIZE_TABLE_PAGE_HEADER;
+  static constexpr size_t OFFSET_ROW_LENGTH = OFFSET_COLUMN_COUNT + 2;
+  static constexpr size_t OFFSET_COLUMNS = OFFSET_ROW_LENGTH + 2;
+  static constexpr size_t SIZE_COLUMN = 4;
+  static constexpr size_t SIZE_SEGMENT_HEADER = 4;
+  /** | Encoding (1) | Base (8) | Bits (1) | */
+  static constexpr size_t SIZE_FOR_HEADER = 10;
+  /** | Encoding (1) | EntryCount (4) | Bits (1) | CodesOffset (4) | */
+  static constexpr size_t SIZE_DICTIONARY_HEADER = 10;
+  /** Bit-packed values are read 8 bytes at a time, so that many bytes minus one follow the last one */
+  static constexpr size_t SIZE_PACKING_PAD = 7;
+  /** The widest frame of reference that can be read with one 8-byte load at any bit offset */
+  static constexpr uint32_t MAX_FOR_BITS = 56;
+
+  enum class SlotState : uint8_t { EMPTY = 0, LIVE = 1, DELETED = 2 };
+  enum class Encoding : uint8_t { PLAIN = 0, RLE = 1, FOR = 2, DICTIONARY = 3 };
+
+  auto GetColumnCount() -> uint16_t { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_COLUMN_COUNT); }
+
+  auto GetColumnType(uint32_t column) -> TypeId {
+    return static_cast<TypeId>(*reinterpret_cast<uint16_t *>(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * column));
+  }
+
+  auto GetRowOffset(uint32_t column) -> uint16_t {
+    return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * column + 2);
+  }
+
+  /** @return where the first segment starts */
+  auto GetSegmentsOffset() -> uint32_t { return OFFSET_COLUMNS + SIZE_COLUMN * GetColumnCount(); }
+
+  /** Segments start wherever the previous one ended, so their fields are copied out rather than dereferenced */
+  static auto GetSegmentSize(const char *segment) -> uint16_t {
+    uint16_t size;
+    memcpy(&size, segment, sizeof(uint16_t));
+    return size;
+  }
+
+  static auto GetSegmentRowCount(const char *segment) -> uint16_t {
+    uint16_t row_count;
+    memcpy(&row_count, segment + 2, sizeof(uint16_t));
+    return row_count;
+  }
+
+  auto GetColumnBlock(char *segment, uint32_t column) -> char * {
+    uint16_t block_offset;
+    memcpy(&block_offset, segment + SIZE_SEGMENT_HEADER + 2 * column, sizeof(uint16_t));
+    return segment + block_offset;
+  }
+
+  auto GetSlotStatePtr(char *segment, uint32_t row) -> char * {
+    return segment + SIZE_SEGMENT_HEADER + 2 * GetColumnCount() + row;
+  }
+
+  /** @return the bytes a segment of one row takes beyond the row-format tuple, whatever the row holds */
+  auto GetSegmentOverhead() -> uint32_t;
+
+  /**
+   * Find the segment that holds slot.
+   * @param slot the slot to find
+   * @param[out] row where the slot is in its segment
+   * @return the segment, nullptr if the page has no such slot
+   */
+  auto FindSegment(uint32_t slot, uint32_t *row) -> char *;
+
+  /** @return the state of slot, EMPTY if the page has no such slot */
+  auto GetSlotState(uint32_t slot) -> SlotState;
+
+  /** @return the first live slot from slot on, GetTupleCount() if there is none */
+  auto FindLiveSlot(uint32_t slot) -> uint32_t;
+
+  /**
+   * Encode rows into a segment.
+   * @param rows the row-format tuples
+   * @param count the number of rows
+   * @param states the state of every row, nullptr for all live
+   * @param[out] segment the encoded segment
+   */
+  void EncodeSegment(const Tuple *rows, size_t count, const SlotState *states, std::vector<char> *segment);
+
+  /** Append the encoding of one fixed-length column to block, with whichever encoding takes the fewest bytes */
+  void EncodeFixed(uint32_t column, const Tuple *rows, size_t count, std::vector<char> *block);
+
+  /** Append the DICTIONARY encoding of one VARCHAR column to block */
+  void EncodeVarchar(uint32_t column, const Tuple *rows, size_t count, std::vector<char> *block);
+
+  /**
+   * Decode rows of a segment into row-format tuples, one column at a time.
+   * @param segment the segment
+   * @param first_slot the slot number of the first row of the segment
+   * @param local_rows the rows to decode, in ascending order
+   * @param count the number of rows
+   * @param columns which columns to read, empty to read all of them
+   * @param[out] out count tuples that receive the rows
+   */
+  void Decode(char *segment, uint32_t first_slot, const uint32_t *local_rows, size_t count,
+              const std::vector<bool> &columns, Tuple *out);
+
+  /** @return the | length | bytes | of row in a DICTIONARY block */
+  static auto GetDictionaryEntry(const char *block, uint32_t row) -> const char *;
+
+  /** Decode the single row `row` of segment */
+  void DecodeRow(char *segment, uint32_t first_slot, uint32_t row, Tuple *tuple) {
+    Decode(segment, first_slot, &row, 1, {}, tuple);
+  }
+
+  /** @return the bytes a | length | bytes | VARCHAR value at data takes */
+  static auto GetVarlenValueSize(const char *data) -> uint32_t {
+    uint32_t length = *reinterpret_cast<const uint32_t *>(data);
+    return sizeof(uint32_t) + (length == BUSTUB_VALUE_NULL ? 0 : length);
+  }
+
+  /** @return true if FOR applies to values of type */
+  static auto IsInteger(TypeId type) -> bool {
+    return type == TypeId::BOOLEAN || type == TypeId::TINYINT || type == TypeId::SMALLINT ||
+           type == TypeId::INTEGER || type == TypeId::BIGINT || type == TypeId::TIMESTAMP;
+  }
+
+  /** @return the integer of width bytes at data, sign-extended */
+  static auto ReadInteger(const char *data, uint32_t width) -> int64_t;
+
+  /** Store the low width bytes of value at data */
+  static void WriteInteger(char *data, uint32_t width, int64_t value);
+
+  /** @return the bytes count bits-bit values take packed, with the padding that follows them */
+  static auto GetPackedSize(size_t count, uint32_t bits) -> size_t { return (count * bits + 7) / 8 + SIZE_PACKING_PAD; }
+
+  /** @return the value at index of a bit-packed array of bits-bit values */
+  static auto Unpack(const char *packed, size_t index, uint32_t bits) -> uint64_t;
+
+  /** Store value at index of a zeroed bit-packed array of bits-bit values */
+  static void Pack(char *packed, size_t index, uint32_t bits, uint64_t value);
+
+  /** @return the bits needed for values up to max_value */
+  static auto BitsFor(uint64_t max_value) -> uint32_t;
+
+  /** Append a log record of a write to this page and stamp the page with its LSN. */
+  void AppendLogRecord(LogRecord *log_record, Transaction *txn, LogManager *log_manager);
+
+  /** @return true if the transaction holds or got an exclusive lock on rid, upgrading a shared one */
+  static auto LockForWrite(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid) -> bool;
+};
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * One page of a table heap's free-space map. Every entry records a heap page and its free-space category, a byte
+ * that says how many CATEGORY_UNITs of free space the page had when it was last touched. Pages of the map are chained
+ * and list the heap pages in the order they were added to the heap.
+ *
+ * Page format (size in bytes):
+ *  ---------------------------------------------------------------------------------------------
+ *  | PageId (4) | LSN (4) | HeapPageId (4) | NextPageId (4) | EntryCount (4) | HeapPageId_1 (4) |
+ *  ---------------------------------------------------------------------------------------------
+ *  --------------------------------------------------------------------------
+ *  | ... | HeapPageId_CAPACITY (4) | Category_1 (1) | ... | Category_CAPACITY (1) |
+ *  --------------------------------------------------------------------------
+ *
+ * HeapPageId is the first page of the table heap the map belongs to, so a stale root pointer is detected on open.
+ */
+class FreeSpaceMapPage : public Page {
+ public:
+  /** Free-space categories, the category of a page is its free space / CATEGORY_UNIT */
+  static constexpr uint32_t NUM_CATEGORIES = 256;
+  static constexpr uint32_t CATEGORY_UNIT = (PAGE_SIZE + NUM_CATEGORIES - 1) / NUM_CATEGORIES;
+
+  void Init(page_id_t page_id, page_id_t heap_page_id) {
+    memcpy(GetData(), &page_id, sizeof(page_id_t));
+    memcpy(GetData() + OFFSET_HEAP_PAGE_ID, &heap_page_id, sizeof(page_id_t));
+    SetNextPageId(INVALID_PAGE_ID);
+    SetEntryCount(0);
+  }
+
+  auto GetFsmPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** @return the first page of the table heap this map belongs to */
+  auto GetHeapPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_HEAP_PAGE_ID); }
+
+  auto GetNextPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  auto GetEntryCount() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_ENTRY_COUNT); }
+
+  auto IsFull() -> bool { return GetEntryCount() == CAPACITY; }
+
+  /** @return the heap page of entry slot */
+  auto GetPageId(uint32_t slot) -> page_id_t {
+    return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PAGE_IDS + slot * sizeof(page_id_t));
+  }
+
+  /** @return the free-space category of entry slot */
+  auto GetCategory(uint32_t slot) -> uint8_t {
+    return *reinterpret_cast<uint8_t *>(GetData() + OFFSET_CATEGORIES + slot);
+  }
+
+  void SetCategory(uint32_t slot, uint8_t category) { GetData()[OFFSET_CATEGORIES + slot] = category; }
+
+  /**
+   * Add an entry for a heap page, the page must not be full.
+   * @return the slot of the new entry
+   */
+  auto Append(page_id_t page_id, uint8_t category) -> uint32_t {
+    uint32_t slot = GetEntryCount();
+    memcpy(GetData() + OFFSET_PAGE_IDS + slot * sizeof(page_id_t), &page_id, sizeof(page_id_t));
+    SetCategory(slot, category);
+    SetEntryCount(slot + 1);
+    return slot;
+  }
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+
+  static constexpr size_t OFFSET_HEAP_PAGE_ID = 8;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
+  static constexpr size_t OFFSET_ENTRY_COUNT = 16;
+  static constexpr size_t OFFSET_PAGE_IDS = 20;
+  static constexpr uint32_t CAPACITY = (PAGE_SIZE - OFFSET_PAGE_IDS) / (sizeof(page_id_t) + 1);
+  static constexpr size_t OFFSET_CATEGORIES = OFFSET_PAGE_IDS + CAPACITY * sizeof(page_id_t);
+
+  void SetEntryCount(uint32_t entry_count) {
+    memcpy(GetData() + OFFSET_ENTRY_COUNT, &entry_count, sizeof(uint32_t));
+  }
+};
+
+}  // namespace bustub
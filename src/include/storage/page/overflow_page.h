@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_page.h
+//
+// Identification: src/include/storage/page/overflow_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * An OverflowPage holds part of a value too large to be stored in its tuple, see TableHeap. A value is spread over a
+ * chain of them, linked in order; the tuple keeps the first page id and the value's length.
+ *
+ * Format (size in byte):
+ *  ----------------------------------------------------
+ * | NextPageId (4) | DataSize (4) | Data (DataSize) ... |
+ *  ----------------------------------------------------
+ *
+ * A chain is written once, before the tuple pointing to it is visible, and freed once no version of the tuple points
+ * to it any more, so its pages are never latched.
+ */
+class OverflowPage : public Page {
+ public:
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 0;
+  static constexpr size_t OFFSET_DATA_SIZE = 4;
+  static constexpr size_t SIZE_HEADER = 8;
+  /** The most bytes of a value one page holds */
+  static constexpr uint32_t CAPACITY = PAGE_SIZE - SIZE_HEADER;
+
+  /**
+   * Write a value to a new chain of overflow pages.
+   * @param bpm the buffer pool the pages are allocated from
+   * @param data the bytes of the value
+   * @param size the length of the value
+   * @return the id of the first page of the chain, INVALID_PAGE_ID if out of frames (nothing is left allocated)
+   */
+  static auto WriteChain(BufferPoolManager *bpm, const char *data, uint32_t size) -> page_id_t;
+
+  /**
+   * Read a value back from its chain.
+   * @param bpm the buffer pool the chain is in
+   * @param first_page_id the first page of the chain
+   * @param size the length of the value
+   * @param[out] data where the value is copied to, size bytes
+   */
+  static void ReadChain(BufferPoolManager *bpm, page_id_t first_page_id, uint32_t size, char *data);
+
+  /** Delete every page of the chain starting at first_page_id */
+  static void FreeChain(BufferPoolManager *bpm, page_id_t first_page_id);
+
+ private:
+  void Init(page_id_t next_page_id, const char *data, uint32_t size);
+
+  auto GetNextPageId() -> page_id_t;
+
+  auto GetDataSize() -> uint32_t;
+};
+
+}  // namespace bustub
@@ -0,0 +1,205 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.h
+//
+// Identification: src/include/storage/page/pax_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/page/table_page.h"
+#include "type/limits.h"
+#include "type/type.h"
+
+namespace bustub {
+
+/**
+ * PAX (Partition Attributes Across) page format:
+ *  -----------------------------------------------------------------------------------------------------
+ *  | HEADER | COLUMNS | SLOT STATES | MINIPAGE 0 | ... | MINIPAGE n-1 | ... FREE SPACE ... | VARLEN HEAP |
+ *  -----------------------------------------------------------------------------------------------------
+ *                                                                                        ^
+ *                                                                                        free space pointer
+ *
+ *  Header format (size in bytes), the first 32 bytes are the TablePage header:
+ *  -------------------------------------------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) | TupleCount (4) | FsmPageId (4) |
+ *  -------------------------------------------------------------------------------------------------------------
+ *  -----------------------------------------------------------------
+ *  | Format (4) | Capacity (4) | ColumnCount (2) | RowLength (2) |
+ *  -----------------------------------------------------------------
+ *
+ *  Every column is described by | Type (2) | MinipageOffset (2) | RowOffset (2) |. The page holds up to Capacity
+ *  rows, chosen when the page is initialized, and every column gets a minipage of Capacity fixed-width values. A
+ *  VARCHAR minipage holds the page offset of each value, whose | length | bytes | live in the varlen heap at the end of
+ *  the page. A slot state per row tells empty, live and marked-deleted rows apart; TupleCount is one past the last
+ *  slot in use.
+ *
+ *  A scan that needs a few columns of a wide table only reads their minipages. Tuples go in and come out in the row
+ *  format the schema describes (RowOffset and RowLength), so the page can stand in for a slotted one everywhere:
+ *  TablePage forwards its tuple operations here when the page's Format is PAX.
+ */
+class PaxPage : public TablePage {
+ public:
+  /** The VARCHAR bytes per VARCHAR column to size the first page of a table for, before any row is known */
+  static constexpr uint32_t VARLEN_GUESS = 16;
+
+  /**
+   * Initialize the page for a table with the given schema.
+   * @param page_id the page ID of this table page
+   * @param prev_page_id the previous table page ID
+   * @param log_manager the log manager in use
+   * @param txn the transaction that this page is created in
+   * @param schema the schema of the table
+   * @param varlen_hint the VARCHAR bytes a row is expected to need, which decides how many rows the page holds
+   */
+  void Init(page_id_t page_id, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn,
+            const Schema &schema, uint32_t varlen_hint);
+
+  /** Initialize the page for the same table as `layout`, see Init above for the other parameters. */
+  void Init(page_id_t page_id, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn, PaxPage *layout,
+            uint32_t varlen_hint);
+
+  /**
+   * @param tuple a row-format tuple of the table
+   * @param row_length the fixed-length part of the table's rows, see GetRowLength
+   * @return the free space that inserting tuple claims, see GetFreeSpaceRemaining
+   */
+  static auto GetInsertSize(const Tuple &tuple, uint32_t row_length) -> uint32_t {
+    return tuple.GetLength() - row_length + 1;
+  }
+
+  /**
+   * A free slot counts as one byte, so a page without one has no room however large its varlen heap is.
+   * @return the varlen heap bytes left plus one if a slot is free, 0 otherwise
+   */
+  auto GetFreeSpaceRemaining() -> uint32_t;
+
+  /** @return the number of rows the page has room for */
+  auto GetCapacity() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_CAPACITY); }
+
+  /** @return the number of columns of the table */
+  auto GetColumnCount() -> uint16_t { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_COLUMN_COUNT); }
+
+  /** @return the length of the fixed-length part of a row-format tuple of the table */
+  auto GetRowLength() -> uint16_t { return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_ROW_LENGTH); }
+
+  /** The tuple operations of TablePage, taking and returning row-format tuples. */
+  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                   LogManager *log_manager) -> bool;
+  auto MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                  LogManager *log_manager) -> bool;
+  auto UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
+                   LockManager *lock_manager, table_oid_t table_oid, LogManager *log_manager) -> bool;
+  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+  void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager,
+                table_oid_t table_oid) -> bool;
+  auto GetTupleView(const RID &rid, Tuple *tuple) -> bool;
+  auto GetFirstTupleRid(RID *first_rid) -> bool;
+  auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool;
+
+  /**
+   * Decode the live rows from first_slot on, one column at a time, so every minipage is read front to back once.
+   * Columns that are not read are left zeroed (VARCHARs as NULL) in the row-format tuples.
+   * @param first_slot the first slot to decode
+   * @param columns which columns to read, empty to read all of them
+   * @param[out] rows the decoded rows, with their rids set
+   */
+  void ReadRows(uint32_t first_slot, const std::vector<bool> &columns, std::vector<Tuple> *rows);
+
+ private:
+  static constexpr size_t OFFSET_CAPACITY = SIZE_TABLE_PAGE_HEADER;
+  static constexpr size_t OFFSET_COLUMN_COUNT = OFFSET_CAPACITY + 4;
+  static constexpr size_t OFFSET_ROW_LENGTH = OFFSET_COLUMN_COUNT + 2;
+  static constexpr size_t OFFSET_COLUMNS = OFFSET_ROW_LENGTH + 2;
+  static constexpr size_t SIZE_COLUMN = 6;
+  /** The bytes a VARCHAR value takes in its minipage: the page offset of its | length | bytes | */
+  static constexpr uint32_t SIZE_VARLEN_REF = sizeof(uint32_t);
+
+  enum class SlotState : uint8_t { EMPTY = 0, LIVE = 1, DELETED = 2 };
+
+  auto GetColumnType(uint32_t column) -> TypeId {
+    return static_cast<TypeId>(*reinterpret_cast<uint16_t *>(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * column));
+  }
+
+  auto GetMinipageOffset(uint32_t column) -> uint16_t {
+    return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * column + 2);
+  }
+
+  auto GetRowOffset(uint32_t column) -> uint16_t {
+    return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * column + 4);
+  }
+
+  /** @return the bytes a value of the column takes in its minipage */
+  static auto GetMinipageWidth(TypeId type) -> uint32_t {
+    return type == TypeId::VARCHAR ? SIZE_VARLEN_REF : static_cast<uint32_t>(Type::GetTypeSize(type));
+  }
+
+  /** @return where the value of column in slot starts in its minipage */
+  auto GetValuePtr(uint32_t column, uint32_t slot) -> char * {
+    return GetData() + GetMinipageOffset(column) + slot * GetMinipageWidth(GetColumnType(column));
+  }
+
+  auto GetSlotState(uint32_t slot) -> SlotState {
+    return static_cast<SlotState>(GetData()[GetSlotStatesOffset() + slot]);
+  }
+
+  void SetSlotState(uint32_t slot, SlotState state) {
+    GetData()[GetSlotStatesOffset() + slot] = static_cast<char>(state);
+  }
+
+  auto GetSlotStatesOffset() -> uint32_t { return OFFSET_COLUMNS + SIZE_COLUMN * GetColumnCount(); }
+
+  /** @return the bytes between the end of the last minipage and the varlen heap */
+  auto GetHeapFreeSpace() -> uint32_t;
+
+  /** Lay the minipages out for columns described at OFFSET_COLUMNS and rows of varlen_hint VARCHAR bytes */
+  void InitLayout(uint32_t varlen_hint);
+
+  /** @return the slot an insert would use, GetCapacity() if the page is full */
+  auto FindFreeSlot() -> uint32_t;
+
+  /** @return the varlen heap bytes the VARCHAR values of a row-format tuple need */
+  auto GetVarlenSize(const Tuple &tuple) -> uint32_t;
+
+  /** Store the values of a row-format tuple in slot, whose VARCHAR values must have been freed */
+  void WriteRow(uint32_t slot, const Tuple &tuple);
+
+  /**
+   * Decode count slots into row-format tuples, one column at a time.
+   * @param slots the slots to decode
+   * @param count the number of slots
+   * @param columns which columns to read, empty to read all of them
+   * @param[out] rows count tuples that receive the rows
+   */
+  void Decode(const uint32_t *slots, size_t count, const std::vector<bool> &columns, Tuple *rows);
+
+  /** @return the varlen heap bytes the VARCHAR values of slot take */
+  auto GetVarlenSize(uint32_t slot) -> uint32_t;
+
+  /** Release the varlen heap values of slot */
+  void FreeVarlen(uint32_t slot);
+
+  /** @return the bytes a | length | bytes | VARCHAR value at data takes */
+  static auto GetVarlenValueSize(const char *data) -> uint32_t {
+    uint32_t length = *reinterpret_cast<const uint32_t *>(data);
+    return sizeof(uint32_t) + (length == BUSTUB_VALUE_NULL ? 0 : length);
+  }
+
+  /** Append a log record of a write to this page and stamp the page with its LSN. */
+  void AppendLogRecord(LogRecord *log_record, Transaction *txn, LogManager *log_manager);
+
+  /** @return true if the transaction holds or got an exclusive lock on rid, upgrading a shared one */
+  static auto LockForWrite(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid) -> bool;
+};
+
+}  // namespace bustub
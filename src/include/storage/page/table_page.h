@@ -24,6 +24,19 @@ static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
 
 namespace bustub {
 
+class PaxPage;
+class CompressedPage;
+
+/** How a table page lays out its tuples */
+enum class TablePageFormat : uint32_t {
+  /** Whole tuples in a slotted page */
+  SLOTTED = 0,
+  /** One minipage per column, see PaxPage */
+  PAX = 1,
+  /** Columns encoded a batch of rows at a time, see CompressedPage */
+  COMPRESSED = 2,
+};
+
 /**
  * Slotted page format:
  *  ---------------------------------------------------------
@@ -36,10 +49,15 @@ namespace bustub {
  *  ----------------------------------------------------------------------------
  *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
  *  ----------------------------------------------------------------------------
- *  ----------------------------------------------------------------
- *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
- *  ----------------------------------------------------------------
+ *  --------------------------------------------------------------------------------------------------
+ *  | TupleCount (4) | FsmPageId (4) | Format (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
+ *  --------------------------------------------------------------------------------------------------
+ *
+ *  FsmPageId is only set on the first page of a table heap, where it points to the root of its FreeSpaceMap.
  *
+ *  Format tells the slotted layout above apart from a PaxPage or a CompressedPage, which share the header up to and
+ *  including Format. The tuple operations of those pages are forwarded to them, so callers that only deal in
+ *  row-format tuples do not need to know how a page stores them.
  */
 class TablePage : public Page {
  public:
@@ -72,27 +90,45 @@ class TablePage : public Page {
     memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
   }
 
+  /** @return the root page ID of the table's free-space map, only meaningful on the first page of the table */
+  auto GetFsmPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_FSM_PAGE_ID); }
+
+  /** Set the root page id of the table's free-space map. */
+  void SetFsmPageId(page_id_t fsm_page_id) { memcpy(GetData() + OFFSET_FSM_PAGE_ID, &fsm_page_id, sizeof(page_id_t)); }
+
+  /** @return the layout of this page */
+  auto GetFormat() -> TablePageFormat { return *reinterpret_cast<TablePageFormat *>(GetData() + OFFSET_FORMAT); }
+
+  /** @return the number of bytes that can still be claimed for a tuple and its slot */
+  auto GetFreeSpaceRemaining() -> uint32_t;
+
+  /** @return the free space that inserting tuple into a page without an empty slot claims */
+  static auto GetInsertSize(const Tuple &tuple) -> uint32_t { return tuple.size_ + SIZE_TUPLE; }
+
   /**
    * Insert a tuple into the table.
    * @param tuple tuple to insert
    * @param[out] rid rid of the inserted tuple
    * @param txn transaction performing the insert
    * @param lock_manager the lock manager
+   * @param table_oid the table of the page, its rows are locked under it
    * @param log_manager the log manager
    * @return true if the insert is successful (i.e. there is enough space)
    */
-  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager)
-      -> bool;
+  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                   LogManager *log_manager) -> bool;
 
   /**
    * Mark a tuple as deleted. This does not actually delete the tuple.
    * @param rid rid of the tuple to mark as deleted
    * @param txn transaction performing the delete
    * @param lock_manager the lock manager
+   * @param table_oid the table of the page, its rows are locked under it
    * @param log_manager the log manager
    * @return true if marking the tuple as deleted is successful (i.e the tuple exists)
    */
-  auto MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager) -> bool;
+  auto MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                  LogManager *log_manager) -> bool;
 
   /**
    * Update a tuple.
@@ -101,27 +137,50 @@ class TablePage : public Page {
    * @param rid rid of the tuple
    * @param txn transaction performing the update
    * @param lock_manager the lock manager
+   * @param table_oid the table of the page, its rows are locked under it
    * @param log_manager the log manager
    * @return true if updating the tuple succeeded
    */
   auto UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
-                   LockManager *lock_manager, LogManager *log_manager) -> bool;
+                   LockManager *lock_manager, table_oid_t table_oid, LogManager *log_manager) -> bool;
 
-  /** To be called on commit or abort. Actually perform the delete or rollback an insert. */
-  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+  /**
+   * To be called on commit or abort. Actually perform the delete or rollback an insert.
+   * @param[out] delete_tuple if not nullptr, receives the removed tuple of a slotted page
+   */
+  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager, Tuple *delete_tuple = nullptr);
 
   /** To be called on abort. Rollback a delete, i.e. this reverses a MarkDelete. */
   void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
 
+  /**
+   * To be called in recovery, without logging. Put a tuple into the slot it was inserted into or removed from, i.e.
+   * redo an insert or reverse an ApplyDelete.
+   * @return true if the slot was empty and the tuple fits
+   */
+  auto RestoreTuple(const Tuple &tuple, const RID &rid) -> bool;
+
   /**
    * Read a tuple from a table.
    * @param rid rid of the tuple to read
    * @param[out] tuple the tuple that was read
    * @param txn transaction performing the read
    * @param lock_manager the lock manager
+   * @param table_oid the table of the page, its rows are locked under it
    * @return true if the read is successful (i.e. the tuple exists)
    */
-  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) -> bool;
+  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager,
+                table_oid_t table_oid) -> bool;
+
+  /**
+   * Point a tuple at the bytes of a live slot without copying or locking. The view is only valid while the caller
+   * holds this page's latch and pin; copy it (or evaluate against it) before releasing either. A PAX page has no
+   * row-format bytes to point at and decodes a copy instead.
+   * @param rid rid of the tuple to view
+   * @param[out] tuple a non-owning tuple that references the page data
+   * @return true if the slot exists and is not deleted
+   */
+  auto GetTupleView(const RID &rid, Tuple *tuple) -> bool;
 
   /** @return the rid of the first tuple in this page */
 
@@ -138,17 +197,35 @@ class TablePage : public Page {
    */
   auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool;
 
- private:
+  /**
+   * Give back the empty slots at the end of the slot array. Tuples are kept packed by ApplyDelete, so this is all
+   * there is left to compact on a slotted page.
+   * @return the number of slots given back
+   */
+  auto ReclaimSlots() -> uint32_t;
+
+ protected:
   static_assert(sizeof(page_id_t) == 4);
 
-  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 32;
   static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
-  static constexpr size_t OFFSET_TUPLE_OFFSET = 24;  // Naming things is hard.
-  static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  static constexpr size_t OFFSET_FSM_PAGE_ID = 24;
+  static constexpr size_t OFFSET_FORMAT = 28;
+  static constexpr size_t OFFSET_TUPLE_OFFSET = 32;  // Naming things is hard.
+  static constexpr size_t OFFSET_TUPLE_SIZE = 36;
+
+  /** Set the layout of this page. */
+  void SetFormat(TablePageFormat format) { memcpy(GetData() + OFFSET_FORMAT, &format, sizeof(TablePageFormat)); }
+
+  /** @return this page as the PaxPage it is, see GetFormat */
+  auto AsPax() -> PaxPage *;
+
+  /** @return this page as the CompressedPage it is, see GetFormat */
+  auto AsCompressed() -> CompressedPage *;
 
   /** @return pointer to the end of the current free space, see header comment */
   auto GetFreeSpacePointer() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
@@ -167,10 +244,6 @@ class TablePage : public Page {
   /** Set the number of tuples in this page. */
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  auto GetFreeSpaceRemaining() -> uint32_t {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   /** @return tuple offset at slot slot_num */
   auto GetTupleOffsetAtSlot(uint32_t slot_num) -> uint32_t {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
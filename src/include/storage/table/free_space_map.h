@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "storage/page/free_space_map_page.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap tracks how much room every page of a table heap has left, so an insert finds a page that fits its
+ * tuple without walking the heap.
+ *
+ * The map is persisted in a chain of FreeSpaceMapPages and mirrored in memory as one bucket of heap pages per
+ * free-space category. FindPage scans at most NUM_CATEGORIES buckets and moving a page between buckets is a swap, so
+ * both are constant time however large the heap grows. Categories round down, so a page is never promised more room
+ * than it had when it was recorded; the owner reports the real free space back after every insert, which also corrects
+ * entries that went stale. The persisted map is a hint: the TableHeap re-registers heap pages it is missing on open.
+ * The map also serves as a directory of the heap's pages, which is how a parallel scan splits the heap.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * Create an empty map. Its first page is allocated when the first heap page is recorded.
+   * @param buffer_pool_manager the buffer pool manager
+   * @param heap_page_id the first page of the table heap the map belongs to
+   */
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t heap_page_id)
+      : buffer_pool_manager_(buffer_pool_manager), heap_page_id_(heap_page_id) {}
+
+  DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+  /**
+   * Read a persisted map into this empty one.
+   * @param root_page_id the first page of the map
+   * @return false if root_page_id does not hold a map of this heap, the map is left empty then
+   */
+  auto Load(page_id_t root_page_id) -> bool;
+
+  /**
+   * @param size the free space a tuple needs, see TablePage::GetInsertSize
+   * @return a heap page that had at least size bytes free when it was last recorded, or INVALID_PAGE_ID
+   */
+  auto FindPage(uint32_t size) -> page_id_t;
+
+  /**
+   * Record the free space of a heap page, adding the page to the map if it is new.
+   * @param page_id the heap page
+   * @param free_space the bytes the page has left, see TablePage::GetFreeSpaceRemaining
+   */
+  void Update(page_id_t page_id, uint32_t free_space);
+
+  /** @return the heap page added last, the tail of the heap, or INVALID_PAGE_ID if the map is empty */
+  auto GetLastPageId() -> page_id_t;
+
+  /** @return the first page of the map, or INVALID_PAGE_ID if nothing was recorded yet */
+  auto GetRootPageId() -> page_id_t;
+
+  /** @return the number of heap pages in the map */
+  auto GetPageCount() -> size_t;
+
+  /** @return every heap page in the map, in the order they were added, which is their order in the page list */
+  auto GetPageIds() -> std::vector<page_id_t>;
+
+ private:
+  /** Where a heap page is recorded, on disk and in memory */
+  struct Entry {
+    size_t fsm_page_idx_;
+    uint32_t slot_;
+    uint8_t category_;
+    size_t bucket_pos_;
+  };
+
+  static auto CategoryOf(uint32_t free_space) -> uint8_t {
+    return static_cast<uint8_t>(free_space / FreeSpaceMapPage::CATEGORY_UNIT);
+  }
+
+  /** Put a heap page into the bucket of category */
+  void AddToBucket(page_id_t page_id, Entry *entry, uint8_t category);
+
+  /** Take a heap page out of its bucket */
+  void RemoveFromBucket(const Entry &entry);
+
+  /** Persist a new entry at the end of the chain, returns false if the buffer pool is out of frames */
+  auto AppendEntry(page_id_t page_id, uint8_t category, Entry *entry) -> bool;
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t heap_page_id_;
+  std::mutex latch_;
+  std::vector<page_id_t> fsm_page_ids_;
+  std::unordered_map<page_id_t, Entry> entries_;
+  std::vector<page_id_t> page_ids_;
+  std::array<std::vector<page_id_t>, FreeSpaceMapPage::NUM_CATEGORIES> buckets_;
+};
+
+}  // namespace bustub
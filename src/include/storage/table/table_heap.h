@@ -12,22 +12,56 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/page/compressed_page.h"
+#include "storage/page/overflow_page.h"
+#include "storage/page/pax_page.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "storage/table/version_store.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages, plus a FreeSpaceMap that inserts consult to pick a page with room for
+ * their tuple instead of walking the list. The map's root page is recorded in the header of the first page.
+ *
+ * All pages of a heap share one TablePageFormat, chosen when the table is created. A PAX heap lays every page out for
+ * the table's schema, see PaxPage. A COMPRESSED heap, meant for cold tables that are mostly loaded and scanned, stores
+ * every batch of inserted tuples as one compressed segment, see CompressedPage.
+ *
+ * A heap created with its schema also keeps a ZoneMap of the values on every page, which scans with a predicate use
+ * to step over pages without fetching them.
+ *
+ * A SLOTTED heap created with its schema stores tuples larger than TOAST_THRESHOLD by moving their largest VARCHAR
+ * values to chains of OverflowPages, leaving a pointer in the tuple, until the tuple is short enough. Tuples read from
+ * the heap fetch such a value only when its column is asked for, so a scan that does not project it never reads it.
+ * A chain is freed with the last version of the tuple pointing to it: when the delete of the tuple is applied, when
+ * an update replacing it commits, or right away when the version pointing to it is rolled back.
+ *
+ * With logging, every write records the version of the row it replaces in the heap's VersionStore, and SNAPSHOT
+ * transactions read the versions of their snapshot from there instead of locking. A SNAPSHOT transaction writing a row
+ * takes its exclusive lock first, and is aborted if the row changed since its snapshot began.
+ *
+ * Vacuum compacts a SLOTTED heap while it is in use, a page latch at a time. It never moves a tuple, so the rids held
+ * by readers, indexes and write sets stay valid.
  */
 class TableHeap {
   friend class TableIterator;
 
  public:
+  /** Tuples longer than this have VARCHAR values moved to overflow pages */
+  static constexpr uint32_t TOAST_THRESHOLD = PAGE_SIZE / 4;
+
   ~TableHeap() = default;
 
   /**
@@ -46,12 +80,15 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param format the layout of the table's pages
+   * @param schema the schema of the table, required for PAX and COMPRESSED pages and to keep a ZoneMap
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, TablePageFormat format = TablePageFormat::SLOTTED, const Schema *schema = nullptr);
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table. If the tuple is too large (>= page_size) after moving its VARCHAR values to
+   * overflow pages, return false.
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
@@ -59,6 +96,16 @@ class TableHeap {
    */
   auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
 
+  /**
+   * Insert a batch of tuples, filling each page as far as it goes before moving on, so every page is fetched and
+   * latched once per batch rather than once per tuple.
+   * @param tuples tuples to insert
+   * @param[out] rids the rids of the inserted tuples, in order
+   * @param txn the transaction performing the insert
+   * @return true iff every tuple was inserted
+   */
+  auto InsertTuples(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn) -> bool;
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param rid resource id of the tuple of delete
@@ -76,6 +123,14 @@ class TableHeap {
    */
   auto UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) -> bool;
 
+  /**
+   * Put back the version of a tuple an update replaced, when the updating transaction aborts.
+   * @param old_tuple the version replaced, as the write set of txn holds it
+   * @param rid rid of the tuple
+   * @param txn transaction rolling back the update
+   */
+  void RollbackUpdate(const Tuple &old_tuple, const RID &rid, Transaction *txn);
+
   /**
    * Called on Commit/Abort to actually delete a tuple or rollback an insert.
    * @param rid rid of the tuple to delete
@@ -83,6 +138,12 @@ class TableHeap {
    */
   void ApplyDelete(const RID &rid, Transaction *txn);
 
+  /**
+   * Free the overflow pages of a tuple version no longer stored in the heap, the old version of a committed update.
+   * @param tuple the tuple version as it was stored
+   */
+  void FreeOverflow(const Tuple &tuple);
+
   /**
    * Called on abort to rollback a delete.
    * @param rid rid of the deleted tuple.
@@ -99,20 +160,134 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool;
 
+  /**
+   * Compact the heap: give back the empty slots at the end of every page and update the free-space map. Pages are not
+   * merged or freed, the log has no record to redo that with.
+   * @return the number of slots given back
+   */
+  auto Vacuum() -> size_t;
+
   /** @return the begin iterator of this table */
   auto Begin(Transaction *txn) -> TableIterator;
 
+  /**
+   * @param txn the transaction performing the scan
+   * @param predicate filter pushed into the iterator, evaluated against schema (nullptr for none)
+   * @param schema the schema of the tuples stored in this table
+   * @param out_schema projection applied to qualifying tuples (nullptr to return stored tuples)
+   * @return a begin iterator that only stops on qualifying tuples
+   */
+  auto Begin(Transaction *txn, const AbstractExpression *predicate, const Schema *schema, const Schema *out_schema)
+      -> TableIterator;
+
+  /**
+   * Scan a contiguous run of pages, see Begin above for the other parameters.
+   * @param first_page_id the first page to scan
+   * @param stop_page_id the page following the last page to scan, INVALID_PAGE_ID to scan to the end of the table
+   * @return a begin iterator that only stops on qualifying tuples in [first_page_id, stop_page_id)
+   */
+  auto Begin(Transaction *txn, const AbstractExpression *predicate, const Schema *schema, const Schema *out_schema,
+             page_id_t first_page_id, page_id_t stop_page_id) -> TableIterator;
+
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
 
+  /** @return the catalog's id of this table, the lock manager locks its rows under it */
+  inline auto GetTableOid() const -> table_oid_t { return table_oid_; }
+
+  /** Set the catalog's id of this table */
+  inline void SetTableOid(table_oid_t table_oid) { table_oid_ = table_oid; }
+
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the free-space map of this table, read or rebuilt on first use for an opened table */
+  auto GetFreeSpaceMap() -> FreeSpaceMap *;
+
+  /** @return the zone map of this table, nullptr if the heap was opened without its schema */
+  auto GetZoneMap() -> ZoneMap * { return zone_map_.get(); }
+
+  /** @return the older versions of the rows of this table */
+  auto GetVersionStore() -> VersionStore * { return &version_store_; }
+
+  /** @return the pages of this table in page list order, starting with the first page */
+  auto GetPageIds() -> std::vector<page_id_t> { return GetFreeSpaceMap()->GetPageIds(); }
+
  private:
+  /** Insert count tuples, writing their rids to rids[0..count) */
+  auto InsertTuples(const Tuple *tuples, size_t count, RID *rids, Transaction *txn) -> bool;
+
+  /**
+   * @param txn the transaction growing the heap
+   * @param tuple the tuple that did not fit anywhere, a new PAX page leaves room for its VARCHAR values
+   * @return a new, WLatched page linked after the last page of the heap, or nullptr if out of frames
+   */
+  auto AppendPage(Transaction *txn, const Tuple &tuple) -> TablePage *;
+
+  /** @return the free space inserting tuple claims on a page of this heap */
+  auto GetInsertSize(const Tuple &tuple) -> uint32_t {
+    switch (format_) {
+      case TablePageFormat::PAX:
+        return PaxPage::GetInsertSize(tuple, row_length_);
+      case TablePageFormat::COMPRESSED:
+        // A compressed page only promises room for a segment of one tuple, see CompressedPage::GetFreeSpaceRemaining.
+        return tuple.GetLength();
+      default:
+        return TablePage::GetInsertSize(tuple);
+    }
+  }
+
+  /**
+   * Move the largest VARCHAR values of tuple to overflow pages until it is no longer than TOAST_THRESHOLD.
+   * @param tuple a tuple longer than TOAST_THRESHOLD
+   * @param[out] stored the tuple to store, pointing to the overflow pages of the moved values; left empty when tuple
+   * already points to overflow pages and is stored as it is
+   * @return false if out of frames for the overflow pages
+   */
+  auto MoveToOverflow(const Tuple &tuple, Tuple *stored) -> bool;
+
+  /** @return whether tuples of this heap may have VARCHAR values moved to overflow pages */
+  auto CanOverflow() const -> bool { return format_ == TablePageFormat::SLOTTED && !varlen_offsets_.empty(); }
+
+  /**
+   * Update a tuple, or roll an update back. The state of txn cannot tell a rollback apart, wound-wait marks other
+   * transactions aborted while they are still running.
+   */
+  auto ReplaceTuple(const Tuple &tuple, const RID &rid, Transaction *txn, bool rollback) -> bool;
+
+  /** @return a copy of a stored tuple owning its data, with the values moved to overflow pages read back inline */
+  auto CopyVersion(const Tuple &stored) -> Tuple;
+
+  /** @return whether txn reads the versions of its snapshot */
+  static auto ReadsSnapshot(Transaction *txn) -> bool {
+    return enable_logging && txn->GetIsolationLevel() == IsolationLevel::SNAPSHOT;
+  }
+
+  /**
+   * Lock a row a SNAPSHOT transaction is about to write, first-committer-wins.
+   * @return false if the transaction is aborted, the row changed since its snapshot began or the lock failed
+   */
+  auto LockForSnapshotWrite(const RID &rid, Transaction *txn) -> bool;
+
+  /** Load the free-space map of an opened table, recording any heap pages it is missing */
+  void OpenFreeSpaceMap();
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  table_oid_t table_oid_{INVALID_TABLE_OID};
+  std::unique_ptr<FreeSpaceMap> free_space_map_;
+  std::once_flag free_space_map_opened_;
+  std::unique_ptr<ZoneMap> zone_map_;
+  VersionStore version_store_;
+  /** The layout of the heap's pages and, for PAX pages, the length of a row's fixed part; read with the map */
+  TablePageFormat format_{TablePageFormat::SLOTTED};
+  uint32_t row_length_{0};
+  /** Where the VARCHAR columns keep the offset of their payload, known for a heap created with its schema */
+  std::vector<uint32_t> varlen_offsets_;
+  /** Serializes growing the heap, so two appends do not both link after the same last page */
+  std::mutex append_latch_;
 };
 
 }  // namespace bustub
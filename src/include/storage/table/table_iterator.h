@@ -13,10 +13,14 @@
 #pragma once
 
 #include <cassert>
+#include <utility>
+#include <vector>
 
 #include "common/rid.h"
 #include "concurrency/transaction.h"
+#include "execution/expressions/abstract_expression.h"
 #include "storage/table/tuple.h"
+#include "storage/table/version_store.h"
 
 namespace bustub {
 
@@ -24,15 +28,49 @@ class TableHeap;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
+ *
+ * A scan may optionally push a predicate and a projection down into the iterator. The predicate is then evaluated
+ * against a zero-copy view of each slot while the page is latched, and only qualifying tuples are locked and
+ * materialized (projected onto out_schema if one is given). Pages the heap's ZoneMap rules out for the predicate are
+ * stepped over without being fetched.
+ *
+ * Without logging there are no tuple locks to take, and a PAX or compressed page (see PaxPage and CompressedPage) is
+ * decoded a page at a time instead: only the columns the predicate and out_schema use are read (or decompressed), the
+ * rows are kept in the iterator and filtered and projected after the page is released.
  */
 class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  /**
+   * @param table_heap the heap being scanned
+   * @param rid the first rid to visit, or an invalid rid for End()
+   * @param txn the transaction performing the scan
+   * @param predicate filter evaluated against schema, nullptr to accept every tuple
+   * @param schema the schema of the stored tuples, required when predicate or out_schema is given
+   * @param out_schema the projection to materialize, nullptr to return the stored tuple unchanged
+   * @param stop_page_id the page at which the scan ends without visiting it, INVALID_PAGE_ID to scan to the end
+   */
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, const AbstractExpression *predicate = nullptr,
+                const Schema *schema = nullptr, const Schema *out_schema = nullptr,
+                page_id_t stop_page_id = INVALID_PAGE_ID);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        predicate_(other.predicate_),
+        schema_(other.schema_),
+        out_schema_(other.out_schema_),
+        stop_page_id_(other.stop_page_id_),
+        pax_columns_(other.pax_columns_),
+        pax_rows_(other.pax_rows_),
+        pax_pos_(other.pax_pos_),
+        pax_page_id_(other.pax_page_id_),
+        pax_next_page_id_(other.pax_next_page_id_),
+        versions_(other.versions_),
+        versions_page_id_(other.versions_page_id_),
+        versions_records_(other.versions_records_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -42,6 +80,9 @@ class TableIterator {
 
   inline auto operator!=(const TableIterator &itr) const -> bool { return !(*this == itr); }
 
+  /** @return true if the iterator has run past the last qualifying tuple */
+  inline auto IsEnd() const -> bool { return tuple_->rid_.GetPageId() == INVALID_PAGE_ID; }
+
   auto operator*() -> const Tuple &;
 
   auto operator->() -> Tuple *;
@@ -50,17 +91,63 @@ class TableIterator {
 
   auto operator++(int) -> TableIterator;
 
+  /** Mark the columns of the scanned schema that expr reads, other scans use it to find the columns they need */
+  static void CollectColumns(const AbstractExpression *expr, std::vector<bool> *columns);
+
   auto operator=(const TableIterator &other) -> TableIterator & {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    predicate_ = other.predicate_;
+    schema_ = other.schema_;
+    out_schema_ = other.out_schema_;
+    stop_page_id_ = other.stop_page_id_;
+    pax_columns_ = other.pax_columns_;
+    pax_rows_ = other.pax_rows_;
+    pax_pos_ = other.pax_pos_;
+    pax_page_id_ = other.pax_page_id_;
+    pax_next_page_id_ = other.pax_next_page_id_;
+    versions_ = other.versions_;
+    versions_page_id_ = other.versions_page_id_;
+    versions_records_ = other.versions_records_;
     return *this;
   }
 
  private:
+  /**
+   * Move to the first qualifying tuple at or after `rid`, or to End() if there is none.
+   * @param rid where to start looking
+   * @param inclusive whether `rid` itself is a candidate
+   */
+  void Seek(RID rid, bool inclusive);
+
+  /** Lock and copy (or project) the viewed tuple into tuple_. The page of the view must still be latched. */
+  auto Materialize(const Tuple &view) -> bool;
+
+  /** Move to the next qualifying row of the decoded page, @return false if there is none left */
+  auto NextPaxRow() -> bool;
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  const AbstractExpression *predicate_;
+  const Schema *schema_;
+  const Schema *out_schema_;
+  page_id_t stop_page_id_;
+  /** The columns of schema_ a PAX or compressed page is decoded with, empty for all of them */
+  std::vector<bool> pax_columns_;
+  /** The decoded rows of page pax_page_id_ from where the scan was, and the next one to look at */
+  std::vector<Tuple> pax_rows_;
+  size_t pax_pos_{0};
+  page_id_t pax_page_id_{INVALID_PAGE_ID};
+  page_id_t pax_next_page_id_{INVALID_PAGE_ID};
+  /**
+   * For a SNAPSHOT scan, the rows with versions of page versions_page_id_ as VersionStore::ReadPage gave them, when
+   * the store's record count for the page was versions_records_
+   */
+  std::vector<VersionStore::VersionedSlot> versions_;
+  page_id_t versions_page_id_{INVALID_PAGE_ID};
+  uint64_t versions_records_{0};
 };
 
 }  // namespace bustub
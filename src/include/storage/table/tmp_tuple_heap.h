@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tmp_tuple_heap.h
+//
+// Identification: src/include/storage/table/tmp_tuple_heap.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "storage/page/tmp_tuple_page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TmpTupleHeap is an append-only run of tuples that an operator spills when its input does not fit in memory.
+ *
+ * Tuples are packed into a private page-sized buffer and copied into a fresh TmpTuplePage of the buffer pool once it
+ * fills up, so appending never keeps a frame pinned. Reading walks the run in insertion order and pins one page at a
+ * time. All pages are deleted from the buffer pool when the heap is destroyed.
+ */
+class TmpTupleHeap {
+ public:
+  explicit TmpTupleHeap(BufferPoolManager *buffer_pool_manager);
+
+  ~TmpTupleHeap();
+
+  DISALLOW_COPY_AND_MOVE(TmpTupleHeap);
+
+  /** Append a copy of tuple to the run. Must not be called once reading has started. */
+  void Append(const Tuple &tuple);
+
+  /** Append raw bytes as a tuple; they come back from Next as the tuple's data. */
+  void Append(const char *data, uint32_t size);
+
+  /**
+   * Read the next tuple of the run.
+   * @param[out] tuple a deep copy of the next tuple
+   * @return false once every tuple has been returned
+   */
+  auto Next(Tuple *tuple) -> bool;
+
+  /** Restart reading from the first tuple. */
+  void Rewind();
+
+  /** @return the number of tuples appended */
+  auto GetTupleCount() const -> size_t { return tuple_count_; }
+
+  /** @return the number of tuple bytes appended, excluding page overhead */
+  auto GetByteSize() const -> size_t { return byte_size_; }
+
+ private:
+  /** Copy the write buffer into a new buffer pool page. */
+  void FlushBuffer();
+
+  /** Pin the page at read_page_idx_ and collect the offsets of its tuples in insertion order. */
+  auto LoadReadPage() -> bool;
+
+  /** Unpin the page currently being read, if any. */
+  void ReleaseReadPage();
+
+  BufferPoolManager *buffer_pool_manager_;
+  std::vector<page_id_t> page_ids_;
+  std::unique_ptr<TmpTuplePage> write_buffer_;
+  size_t tuple_count_{0};
+  size_t byte_size_{0};
+
+  size_t read_page_idx_{0};
+  TmpTuplePage *read_page_{nullptr};
+  std::vector<uint32_t> read_offsets_;
+  size_t read_pos_{0};
+};
+
+}  // namespace bustub
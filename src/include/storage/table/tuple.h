@@ -21,18 +21,34 @@
 
 namespace bustub {
 
+class BufferPoolManager;
+
 /**
  * Tuple format:
  * ---------------------------------------------------------------------
  * | FIXED-SIZE or VARIED-SIZED OFFSET | PAYLOAD OF VARIED-SIZED FIELD |
  * ---------------------------------------------------------------------
+ *
+ * A VARIED-SIZED payload is its length followed by its bytes. A tuple stored in a table heap may have large payloads
+ * moved to overflow pages instead (see TableHeap), the payload is then the length with OVERFLOW_FLAG set followed by
+ * the first page id of the chain, and the value is read from the chain when its column is asked for.
  */
 class Tuple {
   friend class TablePage;
+  friend class PaxPage;
+  friend class CompressedPage;
   friend class TableHeap;
   friend class TableIterator;
+  friend class TmpTupleHeap;
+  friend class JoinHashTable;
+  friend class RowHashSet;
 
  public:
+  /** Set in the length of a payload moved to overflow pages */
+  static constexpr uint32_t OVERFLOW_FLAG = 1U << 31;
+  /** The size of a payload moved to overflow pages: the flagged length and the first page id of its chain */
+  static constexpr uint32_t OVERFLOW_PAYLOAD_SIZE = 2 * sizeof(uint32_t);
+
   // Default constructor (to create a dummy tuple)
   Tuple() = default;
 
@@ -48,6 +64,12 @@ class Tuple {
   // assign operator, deep copy
   auto operator=(const Tuple &other) -> Tuple &;
 
+  // move constructor, steals the buffer of other
+  Tuple(Tuple &&other) noexcept;
+
+  // move assign operator, steals the buffer of other
+  auto operator=(Tuple &&other) noexcept -> Tuple &;
+
   ~Tuple() {
     if (allocated_) {
       delete[] data_;
@@ -64,6 +86,9 @@ class Tuple {
   // return RID of current tuple
   inline auto GetRid() const -> RID { return rid_; }
 
+  // set RID of current tuple, for operators that carry it along with the tuple
+  inline void SetRid(const RID &rid) { rid_ = rid; }
+
   // Get the address of this tuple in the table's backing store
   inline auto GetData() const -> char * { return data_; }
 
@@ -75,7 +100,8 @@ class Tuple {
   auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
 
   // Generates a key tuple given schemas and attributes
-  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) -> Tuple;
+  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const
+      -> Tuple;
 
   // Is the column value null ?
   inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
@@ -94,6 +120,8 @@ class Tuple {
   RID rid_{};              // if pointing to the table heap, the rid is valid
   uint32_t size_{0};
   char *data_{nullptr};
+  // the buffer pool holding the overflow pages of a tuple read from a table heap
+  BufferPoolManager *overflow_bpm_{nullptr};
 };
 
 }  // namespace bustub
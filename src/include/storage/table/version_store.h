@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.h
+//
+// Identification: src/include/storage/table/version_store.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rid.h"
+#include "concurrency/transaction.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** What a SNAPSHOT transaction sees of a row */
+enum class VersionVisibility {
+  /** The row as the heap stores it now, if the heap still has it */
+  CURRENT,
+  /** An older version of the row, kept in the VersionStore */
+  OLDER,
+  /** Nothing, the row did not exist for the transaction */
+  NONE
+};
+
+/**
+ * VersionStore keeps the older versions of the rows of a table heap for SNAPSHOT transactions, an undo store next to
+ * the heap, which only ever holds the newest version of a row.
+ *
+ * Every write to a row (with logging, like the locks) first records the version it replaces: the row before the
+ * writing transaction touched it, or that there was none for an insert. A row's versions form a chain, newest first,
+ * each valid from the commit timestamp of the transaction that wrote it (its begin timestamp) until the next one
+ * begins. The heap's version begins when its writer commits. A transaction reading at read_ts sees the newest version
+ * beginning at or before read_ts, and its own writes.
+ *
+ * A row with no chain is visible to everyone as the heap stores it. A chain is pruned when its writer commits, down
+ * to the versions a running SNAPSHOT transaction may still read, and dropped altogether once the heap's version is
+ * visible to all of them, so the store only holds the rows written since the oldest running snapshot began.
+ *
+ * Writers record a version while they hold the page latch of the row, and readers look a row up while they hold it,
+ * so a reader never sees the heap's new version without its chain.
+ */
+class VersionStore {
+ public:
+  /** The number of partitions of the store, by page */
+  static constexpr size_t PARTITIONS = 16;
+
+  VersionStore() = default;
+
+  DISALLOW_COPY_AND_MOVE(VersionStore);
+
+  /**
+   * Record the version of a row a transaction is about to replace, once per transaction and row.
+   * @param rid the row
+   * @param txn the writing transaction, which holds an exclusive lock on the row
+   * @param old_tuple the row as it was, inlined and owning its data; nullptr if it did not exist
+   */
+  void Record(const RID &rid, Transaction *txn, const Tuple *old_tuple);
+
+  /**
+   * @return whether the row was changed by a transaction that committed after the snapshot of txn began, which a
+   * SNAPSHOT transaction must not overwrite
+   */
+  auto IsWriteConflict(const RID &rid, Transaction *txn) -> bool;
+
+  /**
+   * Mark the version txn wrote as committed and prune the chain. The chains of its partition kept for older snapshots
+   * are pruned too when the watermark moved on since.
+   * @param commit_ts the commit timestamp of txn
+   * @param watermark the read timestamp of the oldest running SNAPSHOT transaction, commit_ts if there is none
+   */
+  void Commit(const RID &rid, Transaction *txn, timestamp_t commit_ts, timestamp_t watermark);
+
+  /** Drop the version txn recorded for a row, its writes to the row are rolled back */
+  void Rollback(const RID &rid, Transaction *txn);
+
+  /**
+   * Find what txn sees of a row.
+   * @param[out] tuple the version, for OLDER
+   */
+  auto Read(const RID &rid, Transaction *txn, Tuple *tuple) -> VersionVisibility;
+
+  /** What a SNAPSHOT transaction sees of a row of a page with versions */
+  struct VersionedSlot {
+    uint32_t slot_;
+    VersionVisibility visibility_;
+    /** The version, for OLDER */
+    Tuple tuple_;
+  };
+
+  /**
+   * Find what txn sees of every row of a page with versions.
+   * @param[out] slots the rows with versions, by slot
+   */
+  void ReadPage(page_id_t page_id, Transaction *txn, std::vector<VersionedSlot> *slots);
+
+  /**
+   * @return how often a version was recorded in the partition of a page. Versions are recorded under the page's latch,
+   * so a reader of the page can keep the slots ReadPage gave it for as long as the count stays the same.
+   */
+  auto GetRecordCount(page_id_t page_id) -> uint64_t { return GetPartition(page_id)->records_; }
+
+  /** @return whether any row of the page has versions */
+  auto HasVersions(page_id_t page_id) -> bool;
+
+ private:
+  /** A version of a row older than the heap's */
+  struct Version {
+    /** The commit timestamp of the writer of the version, 0 for a version everyone sees */
+    timestamp_t begin_ts_;
+    /** Whether the row existed */
+    bool present_;
+    Tuple tuple_;
+  };
+
+  struct VersionChain {
+    /** The transaction that wrote the heap's version and did not commit yet, INVALID_TXN_ID if it committed */
+    txn_id_t writer_{INVALID_TXN_ID};
+    /** The begin timestamp of the heap's version once its writer committed */
+    timestamp_t head_ts_{0};
+    /** Newest first */
+    std::deque<Version> versions_;
+  };
+
+  struct Partition {
+    std::mutex latch_;
+    /** The chains of every page, by slot */
+    std::unordered_map<page_id_t, std::map<uint32_t, VersionChain>> pages_;
+    /** The rows whose committed chains a running snapshot may still read */
+    std::unordered_set<RID> retained_;
+    /** The watermark the retained chains were last pruned to */
+    timestamp_t watermark_{0};
+    /** Counts the calls to Record, see GetRecordCount */
+    std::atomic<uint64_t> records_{0};
+  };
+
+  auto GetPartition(page_id_t page_id) -> Partition * { return &partitions_[page_id % PARTITIONS]; }
+
+  /** @return whether the chain is no longer needed, after dropping the versions no snapshot at watermark reads */
+  static auto Prune(VersionChain *chain, timestamp_t watermark) -> bool;
+
+  /** @return what txn sees of the row with the chain, copying an OLDER version to tuple */
+  static auto Resolve(const VersionChain &chain, Transaction *txn, Tuple *tuple) -> VersionVisibility;
+
+  std::array<Partition, PARTITIONS> partitions_;
+};
+
+}  // namespace bustub
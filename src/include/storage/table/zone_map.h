@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.h
+//
+// Identification: src/include/storage/table/zone_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * ZoneMap summarizes the values every page of a table heap holds, so a scan can rule out pages by their predicate
+ * without fetching them.
+ *
+ * For every fixed-length column of every page the map keeps the smallest and largest value and the number of NULLs
+ * ever written to the page. Deletes do not shrink a zone and updates only widen it, so a zone may promise values a page
+ * no longer holds but never misses one it does. A page is only ruled out by comparisons of a column with a constant,
+ * and only while the column has no NULLs on the page, since comparing NULL does not yield false.
+ *
+ * The map lives in memory next to the FreeSpaceMap and, like its directory of pages, follows the order of the page
+ * list, which is how a scan steps over a page it did not fetch. A heap opened without its schema has no zone map.
+ */
+class ZoneMap {
+ public:
+  /** @param schema the schema of the heap's tuples */
+  explicit ZoneMap(const Schema &schema) : schema_(schema) {}
+
+  DISALLOW_COPY_AND_MOVE(ZoneMap);
+
+  /** Add a page appended to the heap, with empty zones. */
+  void AddPage(page_id_t page_id);
+
+  /**
+   * Widen the zones of a page by tuples written to it.
+   * @param page_id the page the tuples went to, which must have been added
+   * @param tuples the tuples
+   * @param count the number of tuples
+   */
+  void Record(page_id_t page_id, const Tuple *tuples, size_t count);
+
+  /**
+   * Step over the pages predicate rules out.
+   * @param page_id the page to start at
+   * @param stop_page_id the page at which to stop without looking at it, INVALID_PAGE_ID for the end of the heap
+   * @param predicate the predicate of the scan, evaluated against the heap's schema
+   * @return the first page from page_id on that may hold a qualifying tuple, stop_page_id if there is none
+   */
+  auto Skip(page_id_t page_id, page_id_t stop_page_id, const AbstractExpression *predicate) -> page_id_t;
+
+ private:
+  /** The values of one column written to a page */
+  struct ColumnZone {
+    /** Only meaningful once has_values_ is set */
+    Value min_;
+    Value max_;
+    bool has_values_{false};
+    uint32_t null_count_{0};
+  };
+
+  /** The zones of a page, one per column of which only the fixed-length ones are kept, and its place in the list */
+  struct PageZone {
+    std::vector<ColumnZone> columns_;
+    size_t position_;
+  };
+
+  /** @return false if no tuple of the page satisfies predicate */
+  auto MayMatch(const PageZone &zone, const AbstractExpression *predicate) -> bool;
+
+  Schema schema_;
+  std::mutex latch_;
+  std::vector<page_id_t> page_ids_;
+  std::unordered_map<page_id_t, PageZone> zones_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,9 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+#include <utility>
+
 namespace bustub {
 /*
  * set enable_logging = true
@@ -23,34 +26,187 @@ namespace bustub {
  * This thread runs forever until system shutdown/StopFlushThread
  */
 void LogManager::RunFlushThread() {
-    enable_logging=true;
+  std::scoped_lock latch(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  stop_flush_thread_ = false;
+  flush_thread_ = new std::thread([this] {
+    bool stop = false;
+    while (!stop) {
+      std::unique_lock<std::mutex> lock(latch_);
+      cv_.wait_for(lock, log_timeout, [this] { return flush_requested_ || stop_flush_thread_; });
+      stop = stop_flush_thread_;
+      lock.unlock();
+      // The last round writes out what was appended before the thread was stopped.
+      std::scoped_lock flush_latch(flush_latch_);
+      lock.lock();
+      SwapAndFlush(&lock);
+    }
+  });
 }
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::scoped_lock latch(latch_);
+    if (flush_thread_ == nullptr) {
+      return;
+    }
+    stop_flush_thread_ = true;
+    flush_thread = flush_thread_;
+  }
+  cv_.notify_one();
+  flush_thread->join();
+  delete flush_thread;
+  {
+    std::scoped_lock latch(latch_);
+    flush_thread_ = nullptr;
+  }
+  enable_logging = false;
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t { return INVALID_LSN; }
+auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t {
+  BUSTUB_ASSERT(log_record->size_ <= LOG_BUFFER_SIZE, "A log record must fit the log buffer.");
+  auto size = static_cast<uint32_t>(log_record->size_);
+  uint64_t reserved = reserved_.load();
+  uint32_t offset;
+  while (true) {
+    offset = static_cast<uint32_t>(reserved);
+    if (offset != SEALED && offset + size <= LOG_BUFFER_SIZE) {
+      if (reserved_.compare_exchange_weak(reserved, reserved + (uint64_t{1} << 32) + size)) {
+        break;
+      }
+      continue;
+    }
+    // The buffer is full or being swapped. A swap completes under latch_, after which a full buffer is flushed.
+    std::unique_lock<std::mutex> lock(latch_);
+    reserved = reserved_.load();
+    if (static_cast<uint32_t>(reserved) + size > LOG_BUFFER_SIZE) {
+      ForceFlush(&lock);
+      reserved = reserved_.load();
+    }
+  }
+  // The buffer is not swapped before the space reserved in it is filled in.
+  log_record->lsn_ = static_cast<lsn_t>(reserved >> 32);
+  SerializeLogRecord(*log_record, log_buffer_ + offset);
+  filled_.fetch_add(size);
+  return log_record->lsn_;
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  lsn = std::min(lsn, GetNextLSN() - 1);
+  while (persistent_lsn_ < lsn) {
+    ForceFlush(&lock);
+  }
+}
+
+auto LogManager::AppendCheckpointRecord() -> lsn_t {
+  Flush(GetNextLSN() - 1);
+  // Nothing is appended meanwhile, the record begins where the log file ends.
+  int offset = disk_manager_->GetLogFileSize();
+  LogRecord log_record(INVALID_TXN_ID, INVALID_LSN, LogRecordType::CHECKPOINT);
+  lsn_t lsn = AppendLogRecord(&log_record);
+  Flush(lsn);
+  disk_manager_->WriteMasterRecord(offset);
+  return lsn;
+}
+
+void LogManager::SetNextLSN(lsn_t next_lsn) {
+  std::scoped_lock latch(latch_);
+  BUSTUB_ASSERT(static_cast<uint32_t>(reserved_.load()) == 0, "No record may be buffered.");
+  reserved_.store(static_cast<uint64_t>(next_lsn) << 32);
+  persistent_lsn_ = next_lsn - 1;
+}
+
+void LogManager::SerializeLogRecord(const LogRecord &log_record, char *data) {
+  // The header fields come first in LogRecord, in the order they are written.
+  memcpy(data, &log_record, LogRecord::HEADER_SIZE);
+  char *pos = data + LogRecord::HEADER_SIZE;
+  LogRecordType type = log_record.log_record_type_;
+  if (type == LogRecordType::CLR) {
+    memcpy(pos, &log_record.undo_next_lsn_, sizeof(lsn_t));
+    memcpy(pos + sizeof(lsn_t), &log_record.action_type_, sizeof(LogRecordType));
+    pos += sizeof(lsn_t) + sizeof(LogRecordType);
+    type = log_record.action_type_;
+  }
+  switch (type) {
+    case LogRecordType::INSERT:
+      memcpy(pos, &log_record.insert_rid_, sizeof(RID));
+      log_record.insert_tuple_.SerializeTo(pos + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(pos, &log_record.delete_rid_, sizeof(RID));
+      log_record.delete_tuple_.SerializeTo(pos + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(pos, &log_record.update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record.old_tuple_.SerializeTo(pos);
+      pos += sizeof(int32_t) + log_record.old_tuple_.GetLength();
+      log_record.new_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(pos, &log_record.prev_page_id_, sizeof(page_id_t));
+      memcpy(pos + sizeof(page_id_t), &log_record.page_id_, sizeof(page_id_t));
+      break;
+    default:
+      break;
+  }
+}
+
+void LogManager::ForceFlush(std::unique_lock<std::mutex> *lock) {
+  if (flush_thread_ != nullptr) {
+    // Every thread waiting now is served by the next flush.
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(*lock);
+    return;
+  }
+  lock->unlock();
+  std::scoped_lock flush_latch(flush_latch_);
+  lock->lock();
+  SwapAndFlush(lock);
+}
+
+void LogManager::SwapAndFlush(std::unique_lock<std::mutex> *lock) {
+  flush_requested_ = false;
+  // Seal the buffer. Only a flush seals it, and one flush runs at a time.
+  uint64_t reserved = reserved_.load();
+  while (!reserved_.compare_exchange_weak(reserved, reserved | SEALED)) {
+  }
+  auto size = static_cast<uint32_t>(reserved);
+  auto next_lsn = static_cast<lsn_t>(reserved >> 32);
+  if (size == 0) {
+    reserved_.store(reserved);
+    flushed_cv_.notify_all();
+    return;
+  }
+  // The records that reserved their space are being serialized, which does not take long.
+  while (filled_.load() != size) {
+    std::this_thread::yield();
+  }
+  std::swap(log_buffer_, flush_buffer_);
+  filled_.store(0);
+  reserved_.store(static_cast<uint64_t>(next_lsn) << 32);
+  // Appending goes on into the other buffer while this one is written.
+  lock->unlock();
+  disk_manager_->WriteLog(flush_buffer_, static_cast<int>(size));
+  lock->lock();
+  persistent_lsn_ = next_lsn - 1;
+  flushed_cv_.notify_all();
+}
 
 }  // namespace bustub
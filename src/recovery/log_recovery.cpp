@@ -12,6 +12,10 @@
 
 #include "recovery/log_recovery.h"
 
+#include <cstring>
+#include <queue>
+#include <utility>
+
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -20,21 +24,378 @@ namespace bustub {
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool { return false; }
+auto LogRecovery::DeserializeLogRecord(const char *data, int size, LogRecord *log_record) -> bool {
+  if (size < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  int32_t record_size;
+  memcpy(&record_size, data, sizeof(int32_t));
+  if (record_size < LogRecord::HEADER_SIZE || record_size > size) {
+    return false;
+  }
+  // The header fields, in the order LogManager::SerializeLogRecord writes them.
+  log_record->size_ = record_size;
+  memcpy(&log_record->lsn_, data + 4, sizeof(lsn_t));
+  memcpy(&log_record->txn_id_, data + 8, sizeof(txn_id_t));
+  memcpy(&log_record->prev_lsn_, data + 12, sizeof(lsn_t));
+  memcpy(&log_record->log_record_type_, data + 16, sizeof(LogRecordType));
+  const char *pos = data + LogRecord::HEADER_SIZE;
+  LogRecordType type = log_record->log_record_type_;
+  if (type == LogRecordType::CLR) {
+    memcpy(&log_record->undo_next_lsn_, pos, sizeof(lsn_t));
+    memcpy(&log_record->action_type_, pos + sizeof(lsn_t), sizeof(LogRecordType));
+    pos += sizeof(lsn_t) + sizeof(LogRecordType);
+    type = log_record->action_type_;
+  }
+  switch (type) {
+    case LogRecordType::INSERT:
+      memcpy(&log_record->insert_rid_, pos, sizeof(RID));
+      log_record->insert_tuple_.DeserializeFrom(pos + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(&log_record->delete_rid_, pos, sizeof(RID));
+      log_record->delete_tuple_.DeserializeFrom(pos + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(&log_record->update_rid_, pos, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.DeserializeFrom(pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.DeserializeFrom(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(&log_record->prev_page_id_, pos, sizeof(page_id_t));
+      memcpy(&log_record->page_id_, pos + sizeof(page_id_t), sizeof(page_id_t));
+      break;
+    default:
+      break;
+  }
+  return true;
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
- *read log file from the beginning to end (you must prefetch log records into
- *log buffer to reduce unnecessary I/O operations), remember to compare page's
- *LSN with log_record's sequence number, and also build active_txn_ table &
- *lsn_mapping_ table
+ *read log file from the last checkpoint to the end, build active_txn_ table & lsn_mapping_ table on the way and
+ *hand the records to the redo workers of their pages, which compare page's LSN with log_record's sequence number
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  BUSTUB_ASSERT(!enable_logging, "Recovery runs before logging is enabled.");
+  active_txn_.clear();
+  lsn_mapping_.clear();
+  last_lsn_ = INVALID_LSN;
+
+  // Start at the last checkpoint, or at the beginning of a log without one.
+  offset_ = disk_manager_->ReadMasterRecord();
+  LogRecord checkpoint;
+  if (offset_ != 0 && (!disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_) ||
+                       !DeserializeLogRecord(log_buffer_, LOG_BUFFER_SIZE, &checkpoint) ||
+                       checkpoint.GetLogRecordType() != LogRecordType::CHECKPOINT)) {
+    offset_ = 0;
+  }
+
+  partitions_.clear();
+  std::vector<std::thread> workers;
+  for (size_t partition = 0; partition < num_workers_; partition++) {
+    partitions_.push_back(std::make_unique<RedoPartition>());
+    workers.emplace_back(&LogRecovery::RunRedoWorker, this, partition);
+  }
+
+  std::vector<std::vector<char>> batches(num_workers_);
+  while (disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_)) {
+    int pos = 0;
+    while (pos + LogRecord::HEADER_SIZE <= LOG_BUFFER_SIZE) {
+      int32_t size;
+      memcpy(&size, log_buffer_ + pos, sizeof(int32_t));
+      // A record that does not fit is read again at the beginning of the buffer.
+      if (size < LogRecord::HEADER_SIZE || pos + size > LOG_BUFFER_SIZE) {
+        break;
+      }
+      Analyze(log_buffer_ + pos, offset_ + pos, &batches);
+      pos += size;
+    }
+    for (size_t partition = 0; partition < num_workers_; partition++) {
+      if (batches[partition].empty()) {
+        continue;
+      }
+      RedoPartition *queue = partitions_[partition].get();
+      std::unique_lock<std::mutex> lock(queue->latch_);
+      queue->cv_.wait(lock, [queue] { return queue->batches_.size() < MAX_QUEUED_BATCHES; });
+      queue->batches_.push_back(std::move(batches[partition]));
+      batches[partition].clear();
+      queue->cv_.notify_all();
+    }
+    // The rest of the log file is not a complete record, what a crash during a write leaves behind.
+    if (pos == 0) {
+      break;
+    }
+    offset_ += pos;
+  }
+
+  for (auto &queue : partitions_) {
+    std::scoped_lock latch(queue->latch_);
+    queue->done_ = true;
+    queue->cv_.notify_all();
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  partitions_.clear();
+
+  if (log_manager_ != nullptr) {
+    log_manager_->SetNextLSN(last_lsn_ + 1);
+  }
+}
+
+void LogRecovery::Analyze(const char *data, int offset, std::vector<std::vector<char>> *batches) {
+  int32_t size;
+  lsn_t lsn;
+  txn_id_t txn_id;
+  LogRecordType type;
+  memcpy(&size, data, sizeof(int32_t));
+  memcpy(&lsn, data + 4, sizeof(lsn_t));
+  memcpy(&txn_id, data + 8, sizeof(txn_id_t));
+  memcpy(&type, data + 16, sizeof(LogRecordType));
+  last_lsn_ = lsn;
+
+  const char *pos = data + LogRecord::HEADER_SIZE;
+  switch (type) {
+    case LogRecordType::BEGIN:
+      // Transaction ids start over after a restart.
+      active_txn_[txn_id] = lsn;
+      lsn_mapping_[txn_id].clear();
+      return;
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+      active_txn_.erase(txn_id);
+      lsn_mapping_.erase(txn_id);
+      return;
+    case LogRecordType::CLR:
+      memcpy(&type, pos + sizeof(lsn_t), sizeof(LogRecordType));
+      pos += sizeof(lsn_t) + sizeof(LogRecordType);
+      break;
+    case LogRecordType::INSERT:
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+    case LogRecordType::UPDATE:
+    case LogRecordType::NEWPAGE:
+      break;
+    default:
+      return;
+  }
+  active_txn_[txn_id] = lsn;
+  lsn_mapping_[txn_id][lsn] = offset;
+
+  // The pages the record changes: the page of its RID, which begins with the page id, or a new page and the page it
+  // is linked after.
+  page_id_t page_id;
+  page_id_t linked_page_id = INVALID_PAGE_ID;
+  if (type == LogRecordType::NEWPAGE) {
+    memcpy(&linked_page_id, pos, sizeof(page_id_t));
+    memcpy(&page_id, pos + sizeof(page_id_t), sizeof(page_id_t));
+  } else {
+    memcpy(&page_id, pos, sizeof(page_id_t));
+  }
+  size_t partition = page_id % num_workers_;
+  (*batches)[partition].insert((*batches)[partition].end(), data, data + size);
+  if (linked_page_id != INVALID_PAGE_ID && linked_page_id % num_workers_ != partition) {
+    auto &linked_batch = (*batches)[linked_page_id % num_workers_];
+    linked_batch.insert(linked_batch.end(), data, data + size);
+  }
+}
+
+void LogRecovery::RunRedoWorker(size_t partition) {
+  RedoPartition *queue = partitions_[partition].get();
+  while (true) {
+    std::vector<char> batch;
+    {
+      std::unique_lock<std::mutex> lock(queue->latch_);
+      queue->cv_.wait(lock, [queue] { return !queue->batches_.empty() || queue->done_; });
+      if (queue->batches_.empty()) {
+        return;
+      }
+      batch = std::move(queue->batches_.front());
+      queue->batches_.pop_front();
+      queue->cv_.notify_all();
+    }
+    for (size_t pos = 0; pos < batch.size();) {
+      LogRecord log_record;
+      bool complete = DeserializeLogRecord(batch.data() + pos, static_cast<int>(batch.size() - pos), &log_record);
+      BUSTUB_ASSERT(complete, "Batches hold complete records.");
+      RedoRecord(&log_record, partition);
+      pos += log_record.GetSize();
+    }
+  }
+}
+
+void LogRecovery::RedoRecord(LogRecord *log_record, size_t partition) {
+  LogRecordType type = log_record->log_record_type_;
+  if (type == LogRecordType::CLR) {
+    type = log_record->action_type_;
+  }
+  lsn_t lsn = log_record->lsn_;
+
+  if (type == LogRecordType::NEWPAGE) {
+    if (static_cast<size_t>(log_record->page_id_) % num_workers_ == partition) {
+      TablePage *page = FetchTablePage(log_record->page_id_);
+      page->WLatch();
+      bool redo = page->GetLSN() < lsn;
+      if (redo) {
+        page->Init(log_record->page_id_, PAGE_SIZE, log_record->prev_page_id_, nullptr, nullptr);
+        page->SetLSN(lsn);
+      }
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(log_record->page_id_, redo);
+    }
+    page_id_t prev_page_id = log_record->prev_page_id_;
+    if (prev_page_id != INVALID_PAGE_ID && static_cast<size_t>(prev_page_id) % num_workers_ == partition) {
+      // The link is not logged on the previous page, which has it unless it was written out before.
+      TablePage *page = FetchTablePage(prev_page_id);
+      page->WLatch();
+      bool link = page->GetNextPageId() == INVALID_PAGE_ID;
+      if (link) {
+        page->SetNextPageId(log_record->page_id_);
+      }
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(prev_page_id, link);
+    }
+    return;
+  }
+
+  RID rid = type == LogRecordType::INSERT   ? log_record->insert_rid_
+            : type == LogRecordType::UPDATE ? log_record->update_rid_
+                                            : log_record->delete_rid_;
+  TablePage *page = FetchTablePage(rid.GetPageId());
+  page->WLatch();
+  bool redo = page->GetLSN() < lsn;
+  if (redo) {
+    switch (type) {
+      case LogRecordType::INSERT:
+        page->RestoreTuple(log_record->insert_tuple_, rid);
+        break;
+      case LogRecordType::MARKDELETE:
+        page->MarkDelete(rid, nullptr, nullptr, 0, nullptr);
+        break;
+      case LogRecordType::APPLYDELETE:
+        page->ApplyDelete(rid, nullptr, nullptr);
+        break;
+      case LogRecordType::ROLLBACKDELETE:
+        page->RollbackDelete(rid, nullptr, nullptr);
+        break;
+      case LogRecordType::UPDATE: {
+        Tuple old_tuple;
+        page->UpdateTuple(log_record->new_tuple_, &old_tuple, rid, nullptr, nullptr, 0, nullptr);
+        break;
+      }
+      default:
+        break;
+    }
+    page->SetLSN(lsn);
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(rid.GetPageId(), redo);
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
- *iterate through active txn map and undo each operation
+ *undo the records of the active txns, the latest first, following their prev_lsn_ chains
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  BUSTUB_ASSERT(!enable_logging, "Recovery runs before logging is enabled.");
+  // The next record to undo of every active transaction, the latest of them is undone first.
+  std::priority_queue<std::pair<lsn_t, txn_id_t>> undo_next;
+  for (const auto &[txn_id, lsn] : active_txn_) {
+    undo_next.emplace(lsn, txn_id);
+  }
+  while (!undo_next.empty()) {
+    auto [lsn, txn_id] = undo_next.top();
+    undo_next.pop();
+    auto &offsets = lsn_mapping_[txn_id];
+    auto offset = offsets.find(lsn);
+    if (offset == offsets.end()) {
+      // Back at its BEGIN record, the transaction is rolled back.
+      if (log_manager_ != nullptr) {
+        LogRecord log_record(txn_id, active_txn_[txn_id], LogRecordType::ABORT);
+        log_manager_->AppendLogRecord(&log_record);
+      }
+      continue;
+    }
+    LogRecord log_record;
+    bool read = disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset->second) &&
+                DeserializeLogRecord(log_buffer_, LOG_BUFFER_SIZE, &log_record);
+    BUSTUB_ASSERT(read, "The records of the active transactions were read before.");
+    if (log_record.GetLogRecordType() == LogRecordType::CLR) {
+      // The records after undo_next_lsn_ were undone before a crash during recovery.
+      undo_next.emplace(log_record.GetUndoNextLSN(), txn_id);
+      continue;
+    }
+    UndoRecord(&log_record);
+    undo_next.emplace(log_record.GetPrevLSN(), txn_id);
+  }
+  if (log_manager_ != nullptr) {
+    log_manager_->Flush(log_manager_->GetNextLSN() - 1);
+  }
+  active_txn_.clear();
+  lsn_mapping_.clear();
+}
+
+void LogRecovery::UndoRecord(LogRecord *log_record) {
+  LogRecordType type = log_record->log_record_type_;
+  if (type == LogRecordType::NEWPAGE) {
+    // The page stays in the table, empty.
+    return;
+  }
+  txn_id_t txn_id = log_record->txn_id_;
+  lsn_t prev_lsn = active_txn_[txn_id];
+  RID rid = type == LogRecordType::INSERT   ? log_record->insert_rid_
+            : type == LogRecordType::UPDATE ? log_record->update_rid_
+                                            : log_record->delete_rid_;
+  TablePage *page = FetchTablePage(rid.GetPageId());
+  page->WLatch();
+  LogRecord compensation;
+  switch (type) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(rid, nullptr, nullptr);
+      compensation = LogRecord(txn_id, prev_lsn, LogRecordType::APPLYDELETE, rid, log_record->insert_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(rid, nullptr, nullptr);
+      compensation = LogRecord(txn_id, prev_lsn, LogRecordType::ROLLBACKDELETE, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(rid, nullptr, nullptr, 0, nullptr);
+      compensation = LogRecord(txn_id, prev_lsn, LogRecordType::MARKDELETE, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->RestoreTuple(log_record->delete_tuple_, rid);
+      compensation = LogRecord(txn_id, prev_lsn, LogRecordType::INSERT, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple new_tuple;
+      page->UpdateTuple(log_record->old_tuple_, &new_tuple, rid, nullptr, nullptr, 0, nullptr);
+      compensation =
+          LogRecord(txn_id, prev_lsn, LogRecordType::UPDATE, rid, log_record->new_tuple_, log_record->old_tuple_);
+      break;
+    }
+    default:
+      break;
+  }
+  if (log_manager_ != nullptr) {
+    LogRecord clr(log_record->prev_lsn_, compensation);
+    lsn_t lsn = log_manager_->AppendLogRecord(&clr);
+    page->SetLSN(lsn);
+    active_txn_[txn_id] = lsn;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
+}
+
+auto LogRecovery::FetchTablePage(page_id_t page_id) -> TablePage * {
+  auto *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  BUSTUB_ASSERT(page != nullptr, "Recovery pins a page per thread, there are frames enough.");
+  return page;
+}
 
 }  // namespace bustub
@@ -12,7 +12,9 @@
 
 #include <sys/stat.h>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <string>
@@ -38,6 +40,7 @@ DiskManager::DiskManager(const std::string &db_file)
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  master_name_ = file_name_.substr(0, n) + ".master";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -46,6 +49,8 @@ DiskManager::DiskManager(const std::string &db_file)
     // create a new file
     log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
     log_io_.close();
+    // A master record left behind points into a log that is gone.
+    std::remove(master_name_.c_str());
     // reopen with original mode
     log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
     if (!log_io_.is_open()) {
@@ -191,6 +196,36 @@ auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
   return true;
 }
 
+/**
+ * Returns the size of the log file
+ */
+auto DiskManager::GetLogFileSize() -> int { return GetFileSize(log_name_); }
+
+/**
+ * Write the master record to a new file renamed over the old one, so a crash leaves one or the other
+ */
+void DiskManager::WriteMasterRecord(int offset) {
+  std::string tmp_name = master_name_ + ".tmp";
+  std::ofstream master_io(tmp_name, std::ios::binary | std::ios::trunc | std::ios::out);
+  master_io.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+  master_io.close();
+  if (master_io.fail() || std::rename(tmp_name.c_str(), master_name_.c_str()) != 0) {
+    LOG_DEBUG("I/O error while writing master record");
+  }
+}
+
+/**
+ * Read the master record, 0 means recovery reads the whole log
+ */
+auto DiskManager::ReadMasterRecord() -> int {
+  std::ifstream master_io(master_name_, std::ios::binary | std::ios::in);
+  int offset = 0;
+  if (!master_io.is_open() || !master_io.read(reinterpret_cast<char *>(&offset), sizeof(offset))) {
+    return 0;
+  }
+  return offset;
+}
+
 /**
  * Returns number of flushes made so far
  */
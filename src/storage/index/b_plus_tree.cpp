@@ -9,7 +9,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <string>
+#include <type_traits>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -20,30 +22,53 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, page_id_t header_page_id)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      // An internal page holds one child more than its max size until it is split.
+      internal_max_size_(std::min<int>(internal_max_size, INTERNAL_PAGE_SIZE - 1)),
+      header_page_id_(header_page_id) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_PAGE_ID; }
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 /*
- * Return the only value that associated with input key
+ * Return the values that associated with input key, in order
  * This method is used for point query
  * @return : true means key exists
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  return false;
+  latch_.RLock();
+  size_t size = result->size();
+  if (!IsEmpty()) {
+    auto *leaf = reinterpret_cast<LeafPage *>(FindEntryLeafPage(key, nullptr)->GetData());
+    int index = leaf->KeyIndex(key, comparator_);
+    // The entries of the key can go on in the next leaves.
+    while (true) {
+      for (; index < leaf->GetSize() && comparator_(leaf->KeyAt(index), key) == 0; index++) {
+        result->push_back(leaf->GetItem(index).second);
+      }
+      if (index < leaf->GetSize() || leaf->GetNextPageId() == INVALID_PAGE_ID) {
+        break;
+      }
+      page_id_t next_page_id = leaf->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+      leaf = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(next_page_id)->GetData());
+      index = 0;
+    }
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+  }
+  latch_.RUnlock();
+  return result->size() > size;
 }
 
 /*****************************************************************************
@@ -53,12 +78,25 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: a key can have several values but each pair is stored once, if
+ * user try to insert a duplicate pair return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  latch_.WLock();
+  bool inserted = true;
+  try {
+    if (IsEmpty()) {
+      StartNewTree(key, value);
+    } else {
+      inserted = InsertIntoLeaf(key, value, transaction);
+    }
+  } catch (...) {
+    latch_.WUnlock();
+    throw;
+  }
+  latch_.WUnlock();
+  return inserted;
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -67,19 +105,52 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  auto *root = reinterpret_cast<LeafPage *>(NewNodePage(&page_id)->GetData());
+  root->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::NewNodePage(page_id_t *page_id) -> Page * {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  return page;
+}
 
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
- * through leaf page to see whether insert key exist or not. If exist, return
+ * through leaf page to see whether insert pair exist or not. If exist, return
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: if user try to insert a duplicate pair return false, otherwise
+ * return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  Page *page = FindEntryLeafPage(key, &value);
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int size = leaf->GetSize();
+  int new_size = leaf->Insert(key, value, comparator_);
+  if (new_size == size) {
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+    return false;
+  }
+  if (new_size >= leaf->GetMaxSize()) {
+    LeafPage *sibling = Split(leaf);
+    sibling->SetNextPageId(leaf->GetNextPageId());
+    leaf->SetNextPageId(sibling->GetPageId());
+    InsertIntoParent(leaf, sibling->KeyAt(0), sibling, transaction);
+    buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+  return true;
 }
 
 /*
@@ -92,7 +163,15 @@ auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::Split(N *node) -> N * {
-  return nullptr;
+  page_id_t page_id;
+  auto *sibling = reinterpret_cast<N *>(NewNodePage(&page_id)->GetData());
+  sibling->Init(page_id, node->GetParentPageId(), node->GetMaxSize());
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    node->MoveHalfTo(sibling);
+  } else {
+    node->MoveHalfTo(sibling, buffer_pool_manager_);
+  }
+  return sibling;
 }
 
 /*
@@ -106,7 +185,30 @@ auto BPLUSTREE_TYPE::Split(N *node) -> N * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    page_id_t root_page_id;
+    auto *root = reinterpret_cast<InternalPage *>(NewNodePage(&root_page_id)->GetData());
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId(0);
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    return;
+  }
+
+  page_id_t parent_page_id = old_node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_page_id)->GetData());
+  new_node->SetParentPageId(parent_page_id);
+  if (parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId()) > parent->GetMaxSize()) {
+    InternalPage *sibling = Split(parent);
+    InsertIntoParent(parent, sibling->KeyAt(0), sibling, transaction);
+    buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -119,7 +221,33 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) { RemoveEntry(key, nullptr, transaction); }
+
+/*
+ * Delete the key & value pair, the other values of key stay
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  RemoveEntry(key, &value, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveEntry(const KeyType &key, const ValueType *value, Transaction *transaction) {
+  latch_.WLock();
+  if (!IsEmpty()) {
+    Page *page = FindEntryLeafPage(key, value);
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    page_id_t leaf_page_id = leaf->GetPageId();
+    int size = leaf->GetSize();
+    bool deleted =
+        leaf->RemoveAndDeleteRecord(key, value, comparator_) < size && CoalesceOrRedistribute(leaf, transaction);
+    buffer_pool_manager_->UnpinPage(leaf_page_id, true);
+    if (deleted) {
+      buffer_pool_manager_->DeletePage(leaf_page_id);
+    }
+  }
+  latch_.WUnlock();
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
@@ -131,7 +259,40 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -> bool {
-  return false;
+  if (node->IsRootPage()) {
+    return AdjustRoot(node);
+  }
+  if (node->GetSize() >= node->GetMinSize()) {
+    return false;
+  }
+
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_page_id)->GetData());
+  int index = parent->ValueIndex(node->GetPageId());
+  page_id_t neighbor_page_id = parent->ValueAt(index == 0 ? 1 : index - 1);
+  auto *neighbor = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(neighbor_page_id)->GetData());
+
+  // A leaf splits as soon as it is full, so two leaves only merge into one that is not.
+  int merged_size = neighbor->GetSize() + node->GetSize();
+  bool fits = node->IsLeafPage() ? merged_size < node->GetMaxSize() : merged_size <= node->GetMaxSize();
+  if (!fits) {
+    Redistribute(neighbor, node, index);
+    buffer_pool_manager_->UnpinPage(neighbor_page_id, true);
+    buffer_pool_manager_->UnpinPage(parent_page_id, true);
+    return false;
+  }
+
+  // The right one of the two pages is merged into the left one. When node is leftmost that is the neighbor.
+  bool delete_parent = Coalesce(&neighbor, &node, &parent, index, transaction);
+  buffer_pool_manager_->UnpinPage(neighbor_page_id, true);
+  if (index == 0) {
+    buffer_pool_manager_->DeletePage(neighbor_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+  if (delete_parent) {
+    buffer_pool_manager_->DeletePage(parent_page_id);
+  }
+  return index != 0;
 }
 
 /*
@@ -151,7 +312,19 @@ template <typename N>
 auto BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
                               Transaction *transaction) -> bool {
-  return false;
+  int remove_index = index;
+  if (index == 0) {
+    std::swap(*neighbor_node, *node);
+    remove_index = 1;
+  }
+  // *node is now the right page and *neighbor_node the left one
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    (*node)->MoveAllTo(*neighbor_node);
+  } else {
+    (*node)->MoveAllTo(*neighbor_node, (*parent)->KeyAt(remove_index), buffer_pool_manager_);
+  }
+  (*parent)->Remove(remove_index);
+  return CoalesceOrRedistribute(*parent, transaction);
 }
 
 /*
@@ -165,7 +338,26 @@ auto BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_page_id)->GetData());
+  if (index == 0) {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveFirstToEndOf(node);
+    } else {
+      neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1), buffer_pool_manager_);
+    }
+    parent->SetKeyAt(1, neighbor_node->KeyAt(0));
+  } else {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveLastToFrontOf(node);
+    } else {
+      neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(index), buffer_pool_manager_);
+    }
+    parent->SetKeyAt(index, node->KeyAt(0));
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -177,7 +369,25 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return false; }
+auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool {
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0) {
+      return false;
+    }
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId(0);
+    return true;
+  }
+  if (old_root_node->GetSize() > 1) {
+    return false;
+  }
+  root_page_id_ = reinterpret_cast<InternalPage *>(old_root_node)->RemoveAndReturnOnlyChild();
+  auto *root = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
+  root->SetParentPageId(INVALID_PAGE_ID);
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  UpdateRootPageId(0);
+  return true;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -188,7 +398,7 @@ auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return f
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(this, nullptr); }
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -196,7 +406,7 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE()
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(this, &key); }
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -215,7 +425,67 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE();
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> Page * {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    page_id_t child_page_id = leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_);
+    buffer_pool_manager_->UnpinPage(internal->GetPageId(), false);
+    page = buffer_pool_manager_->FetchPage(child_page_id);
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+/*
+ * Find the leaf page the key & value pair is in or belongs in, with a nullptr value the one of the first entry of
+ * key. The entries of a key are ordered by value and can span leaves, so from the leftmost leaf that can hold key
+ * move right while the next leaf starts at or before the pair.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindEntryLeafPage(const KeyType &key, const ValueType *value) -> Page * {
+  Page *page = FindLeafPage(key);
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  while (leaf->GetNextPageId() != INVALID_PAGE_ID && leaf->EntryIndex(key, value, comparator_) == leaf->GetSize()) {
+    Page *next_page = buffer_pool_manager_->FetchPage(leaf->GetNextPageId());
+    auto *next = reinterpret_cast<LeafPage *>(next_page->GetData());
+    if (next->CompareAt(0, key, value, comparator_) > 0) {
+      buffer_pool_manager_->UnpinPage(next->GetPageId(), false);
+      break;
+    }
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+    page = next_page;
+    leaf = next;
+  }
+  return page;
+}
+
+/*
+ * Copy the entries from key on, or after the pair of key and after, of the leaf they are in, or of the first leaf
+ * after it that has any
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReadLeaf(const KeyType *key, const ValueType *after, std::vector<MappingType> *entries) {
+  latch_.RLock();
+  if (!IsEmpty()) {
+    Page *page = key == nullptr ? FindLeafPage(KeyType{}, true) : FindEntryLeafPage(*key, after);
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    int index = key == nullptr ? 0 : leaf->EntryIndex(*key, after, comparator_);
+    if (after != nullptr && index < leaf->GetSize() && leaf->CompareAt(index, *key, after, comparator_) == 0) {
+      index++;
+    }
+    while (index == leaf->GetSize() && leaf->GetNextPageId() != INVALID_PAGE_ID) {
+      page_id_t next_page_id = leaf->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+      leaf = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(next_page_id)->GetData());
+      index = 0;
+    }
+    for (; index < leaf->GetSize(); index++) {
+      entries->push_back(leaf->GetItem(index));
+    }
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+  }
+  latch_.RUnlock();
 }
 
 /*
@@ -228,15 +498,13 @@ auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> Page * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id_));
+  // A tree that became empty and is started again already has its record.
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
 }
 
 /*
@@ -11,6 +11,9 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include "common/exception.h"
+#include "storage/page/header_page.h"
+
 namespace bustub {
 /*
  * Constructor
@@ -19,7 +22,21 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      header_page_id_(NewHeaderPage(buffer_pool_manager)),
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE,
+                 header_page_id_) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::NewHeaderPage(BufferPoolManager *buffer_pool_manager) -> page_id_t {
+  page_id_t page_id;
+  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager->NewPage(&page_id));
+  if (header_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  header_page->Init();
+  buffer_pool_manager->UnpinPage(page_id, true);
+  return page_id;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
@@ -36,7 +53,7 @@ void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *t
   KeyType index_key;
   index_key.SetFromKey(key);
 
-  container_.Remove(index_key, transaction);
+  container_.Remove(index_key, rid, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -44,7 +61,6 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   // construct scan index key
   KeyType index_key;
   index_key.SetFromKey(key);
-  std::cout<<"scan key : "<<index_key<<"\n";
   container_.GetValue(index_key, result, transaction);
 }
 
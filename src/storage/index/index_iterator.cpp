@@ -3,28 +3,54 @@
  */
 #include <cassert>
 
+#include "storage/index/b_plus_tree.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree, const KeyType *key)
+    : tree_(tree) {
+  tree_->ReadLeaf(key, nullptr, &entries_);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::IsEnd() -> bool { return pos_ == entries_.size(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
+  assert(!IsEnd());
+  return entries_[pos_];
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  assert(!IsEnd());
+  if (++pos_ == entries_.size()) {
+    MappingType last = entries_.back();
+    entries_.clear();
+    pos_ = 0;
+    tree_->ReadLeaf(&last.first, &last.second, &entries_);
+  }
+  return *this;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::operator==(const IndexIterator &itr) const -> bool {
+  bool is_end = pos_ == entries_.size();
+  bool other_is_end = itr.pos_ == itr.entries_.size();
+  if (is_end || other_is_end) {
+    return is_end == other_is_end;
+  }
+  return tree_ == itr.tree_ && tree_->comparator_(entries_[pos_].first, itr.entries_[itr.pos_].first) == 0 &&
+         entries_[pos_].second == itr.entries_[itr.pos_].second;
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
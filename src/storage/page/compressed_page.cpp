@@ -0,0 +1,666 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page.cpp
+//
+// Identification: src/storage/page/compressed_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/compressed_page.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace bustub {
+
+void CompressedPage::Init(page_id_t page_id, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn,
+                          const Schema &schema) {
+  TablePage::Init(page_id, PAGE_SIZE, prev_page_id, log_manager, txn);
+  SetFormat(TablePageFormat::COMPRESSED);
+  auto column_count = static_cast<uint16_t>(schema.GetColumnCount());
+  auto row_length = static_cast<uint16_t>(schema.GetLength());
+  memcpy(GetData() + OFFSET_COLUMN_COUNT, &column_count, sizeof(uint16_t));
+  memcpy(GetData() + OFFSET_ROW_LENGTH, &row_length, sizeof(uint16_t));
+  for (uint32_t i = 0; i < column_count; i++) {
+    const Column &column = schema.GetColumn(i);
+    auto type = static_cast<uint16_t>(column.GetType());
+    auto row_offset = static_cast<uint16_t>(column.GetOffset());
+    memcpy(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * i, &type, sizeof(uint16_t));
+    memcpy(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * i + 2, &row_offset, sizeof(uint16_t));
+  }
+  SetFreeSpacePointer(GetSegmentsOffset());
+}
+
+void CompressedPage::Init(page_id_t page_id, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn,
+                          CompressedPage *layout) {
+  TablePage::Init(page_id, PAGE_SIZE, prev_page_id, log_manager, txn);
+  SetFormat(TablePageFormat::COMPRESSED);
+  memcpy(GetData() + OFFSET_COLUMN_COUNT, layout->GetData() + OFFSET_COLUMN_COUNT,
+         OFFSET_COLUMNS - OFFSET_COLUMN_COUNT + SIZE_COLUMN * layout->GetColumnCount());
+  SetFreeSpacePointer(GetSegmentsOffset());
+}
+
+auto CompressedPage::GetSegmentOverhead() -> uint32_t {
+  // The segment header and a slot state, then per column the encoding byte in front of its PLAIN value or, for a
+  // VARCHAR, the dictionary header and the padding of its codes (the one entry offset takes the place of the tuple's
+  // value offset, and a single code takes no bits).
+  uint32_t overhead = SIZE_SEGMENT_HEADER + 2 * GetColumnCount() + sizeof(SlotState);
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    overhead += GetColumnType(column) == TypeId::VARCHAR ? SIZE_DICTIONARY_HEADER + SIZE_PACKING_PAD : sizeof(Encoding);
+  }
+  return overhead;
+}
+
+auto CompressedPage::GetFreeSpaceRemaining() -> uint32_t {
+  uint32_t used = GetFreeSpacePointer() + GetSegmentOverhead();
+  return used >= PAGE_SIZE ? 0 : PAGE_SIZE - used;
+}
+
+auto CompressedPage::FindSegment(uint32_t slot, uint32_t *row) -> char * {
+  uint32_t first_slot = 0;
+  for (uint32_t offset = GetSegmentsOffset(); offset < GetFreeSpacePointer();) {
+    char *segment = GetData() + offset;
+    if (slot < first_slot + GetSegmentRowCount(segment)) {
+      *row = slot - first_slot;
+      return segment;
+    }
+    first_slot += GetSegmentRowCount(segment);
+    offset += GetSegmentSize(segment);
+  }
+  return nullptr;
+}
+
+auto CompressedPage::GetSlotState(uint32_t slot) -> SlotState {
+  uint32_t row;
+  char *segment = FindSegment(slot, &row);
+  return segment == nullptr ? SlotState::EMPTY : static_cast<SlotState>(*GetSlotStatePtr(segment, row));
+}
+
+auto CompressedPage::FindLiveSlot(uint32_t slot) -> uint32_t {
+  uint32_t first_slot = 0;
+  for (uint32_t offset = GetSegmentsOffset(); offset < GetFreeSpacePointer();) {
+    char *segment = GetData() + offset;
+    uint32_t row_count = GetSegmentRowCount(segment);
+    for (uint32_t row = slot > first_slot ? slot - first_slot : 0; row < row_count; row++) {
+      if (static_cast<SlotState>(*GetSlotStatePtr(segment, row)) == SlotState::LIVE) {
+        return first_slot + row;
+      }
+    }
+    first_slot += row_count;
+    offset += GetSegmentSize(segment);
+  }
+  return GetTupleCount();
+}
+
+auto CompressedPage::ReadInteger(const char *data, uint32_t width) -> int64_t {
+  switch (width) {
+    case 1:
+      return *reinterpret_cast<const int8_t *>(data);
+    case 2: {
+      int16_t value;
+      memcpy(&value, data, sizeof(int16_t));
+      return value;
+    }
+    case 4: {
+      int32_t value;
+      memcpy(&value, data, sizeof(int32_t));
+      return value;
+    }
+    default: {
+      int64_t value;
+      memcpy(&value, data, sizeof(int64_t));
+      return value;
+    }
+  }
+}
+
+void CompressedPage::WriteInteger(char *data, uint32_t width, int64_t value) {
+  switch (width) {
+    case 1:
+      *reinterpret_cast<int8_t *>(data) = static_cast<int8_t>(value);
+      break;
+    case 2: {
+      auto narrow = static_cast<int16_t>(value);
+      memcpy(data, &narrow, sizeof(int16_t));
+      break;
+    }
+    case 4: {
+      auto narrow = static_cast<int32_t>(value);
+      memcpy(data, &narrow, sizeof(int32_t));
+      break;
+    }
+    default:
+      memcpy(data, &value, sizeof(int64_t));
+      break;
+  }
+}
+
+auto CompressedPage::Unpack(const char *packed, size_t index, uint32_t bits) -> uint64_t {
+  if (bits == 0) {
+    return 0;
+  }
+  size_t bit = index * bits;
+  uint64_t window;
+  memcpy(&window, packed + bit / 8, sizeof(uint64_t));
+  return (window >> (bit % 8)) & ((uint64_t{1} << bits) - 1);
+}
+
+void CompressedPage::Pack(char *packed, size_t index, uint32_t bits, uint64_t value) {
+  if (bits == 0) {
+    return;
+  }
+  size_t bit = index * bits;
+  uint64_t window;
+  memcpy(&window, packed + bit / 8, sizeof(uint64_t));
+  window |= value << (bit % 8);
+  memcpy(packed + bit / 8, &window, sizeof(uint64_t));
+}
+
+auto CompressedPage::BitsFor(uint64_t max_value) -> uint32_t {
+  uint32_t bits = 0;
+  while (max_value != 0) {
+    bits++;
+    max_value >>= 1;
+  }
+  return bits;
+}
+
+void CompressedPage::EncodeSegment(const Tuple *rows, size_t count, const SlotState *states,
+                                   std::vector<char> *segment) {
+  uint32_t column_count = GetColumnCount();
+  uint32_t states_offset = SIZE_SEGMENT_HEADER + 2 * column_count;
+  segment->assign(states_offset + count, 0);
+  for (size_t i = 0; i < count; i++) {
+    (*segment)[states_offset + i] = static_cast<char>(states == nullptr ? SlotState::LIVE : states[i]);
+  }
+  for (uint32_t column = 0; column < column_count; column++) {
+    auto block_offset = static_cast<uint16_t>(segment->size());
+    memcpy(segment->data() + SIZE_SEGMENT_HEADER + 2 * column, &block_offset, sizeof(uint16_t));
+    if (GetColumnType(column) == TypeId::VARCHAR) {
+      EncodeVarchar(column, rows, count, segment);
+    } else {
+      EncodeFixed(column, rows, count, segment);
+    }
+  }
+  // A segment too large for the page is only ever measured, never stored, so its sizes may be cut short.
+  auto size = static_cast<uint16_t>(segment->size());
+  auto row_count = static_cast<uint16_t>(count);
+  memcpy(segment->data(), &size, sizeof(uint16_t));
+  memcpy(segment->data() + 2, &row_count, sizeof(uint16_t));
+}
+
+void CompressedPage::EncodeFixed(uint32_t column, const Tuple *rows, size_t count, std::vector<char> *block) {
+  TypeId type = GetColumnType(column);
+  auto width = static_cast<uint32_t>(Type::GetTypeSize(type));
+  uint32_t row_offset = GetRowOffset(column);
+  auto value_at = [&](size_t i) { return rows[i].data_ + row_offset; };
+
+  // Size every encoding that applies and keep the smallest.
+  size_t plain_size = sizeof(Encoding) + count * width;
+  uint32_t runs = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (i == 0 || memcmp(value_at(i), value_at(i - 1), width) != 0) {
+      runs++;
+    }
+  }
+  size_t rle_size = sizeof(Encoding) + sizeof(uint32_t) + runs * (width + sizeof(uint32_t));
+  int64_t base = 0;
+  uint32_t bits = 0;
+  size_t for_size = SIZE_MAX;
+  if (IsInteger(type) && count > 0) {
+    int64_t min = ReadInteger(value_at(0), width);
+    int64_t max = min;
+    for (size_t i = 1; i < count; i++) {
+      int64_t value = ReadInteger(value_at(i), width);
+      min = std::min(min, value);
+      max = std::max(max, value);
+    }
+    base = min;
+    bits = BitsFor(static_cast<uint64_t>(max) - static_cast<uint64_t>(min));
+    if (bits <= MAX_FOR_BITS) {
+      for_size = SIZE_FOR_HEADER + GetPackedSize(count, bits);
+    }
+  }
+
+  size_t start = block->size();
+  if (for_size < plain_size && for_size <= rle_size) {
+    block->resize(start + for_size, 0);
+    char *data = block->data() + start;
+    data[0] = static_cast<char>(Encoding::FOR);
+    memcpy(data + 1, &base, sizeof(int64_t));
+    data[9] = static_cast<char>(bits);
+    for (size_t i = 0; i < count; i++) {
+      auto delta = static_cast<uint64_t>(ReadInteger(value_at(i), width)) - static_cast<uint64_t>(base);
+      Pack(data + SIZE_FOR_HEADER, i, bits, delta);
+    }
+  } else if (rle_size < plain_size) {
+    block->resize(start + rle_size);
+    char *data = block->data() + start;
+    data[0] = static_cast<char>(Encoding::RLE);
+    memcpy(data + 1, &runs, sizeof(uint32_t));
+    char *run = nullptr;
+    for (size_t i = 0; i < count; i++) {
+      if (i == 0 || memcmp(value_at(i), value_at(i - 1), width) != 0) {
+        run = run == nullptr ? data + 1 + sizeof(uint32_t) : run + width + sizeof(uint32_t);
+        memcpy(run, value_at(i), width);
+      }
+      auto end = static_cast<uint32_t>(i + 1);
+      memcpy(run + width, &end, sizeof(uint32_t));
+    }
+  } else {
+    block->resize(start + plain_size);
+    char *data = block->data() + start;
+    data[0] = static_cast<char>(Encoding::PLAIN);
+    for (size_t i = 0; i < count; i++) {
+      memcpy(data + 1 + i * width, value_at(i), width);
+    }
+  }
+}
+
+void CompressedPage::EncodeVarchar(uint32_t column, const Tuple *rows, size_t count, std::vector<char> *block) {
+  uint32_t row_offset = GetRowOffset(column);
+  // Number the distinct | length | bytes | values in the order they first appear, NULL being one of them.
+  std::unordered_map<std::string, uint32_t> codes;
+  std::vector<const std::string *> entries;
+  std::vector<uint32_t> row_codes(count);
+  uint32_t entries_size = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t value_offset;
+    memcpy(&value_offset, rows[i].data_ + row_offset, sizeof(uint32_t));
+    const char *value = rows[i].data_ + value_offset;
+    auto [it, inserted] = codes.emplace(std::string(value, GetVarlenValueSize(value)), entries.size());
+    if (inserted) {
+      entries.push_back(&it->first);
+      entries_size += it->first.size();
+    }
+    row_codes[i] = it->second;
+  }
+
+  auto entry_count = static_cast<uint32_t>(entries.size());
+  uint32_t bits = BitsFor(entry_count > 0 ? entry_count - 1 : 0);
+  uint32_t entries_offset = SIZE_DICTIONARY_HEADER + sizeof(uint32_t) * entry_count;
+  uint32_t codes_offset = entries_offset + entries_size;
+  size_t start = block->size();
+  block->resize(start + codes_offset + GetPackedSize(count, bits), 0);
+  char *data = block->data() + start;
+  data[0] = static_cast<char>(Encoding::DICTIONARY);
+  memcpy(data + 1, &entry_count, sizeof(uint32_t));
+  data[5] = static_cast<char>(bits);
+  memcpy(data + 6, &codes_offset, sizeof(uint32_t));
+  uint32_t entry_offset = entries_offset;
+  for (uint32_t code = 0; code < entry_count; code++) {
+    memcpy(data + SIZE_DICTIONARY_HEADER + sizeof(uint32_t) * code, &entry_offset, sizeof(uint32_t));
+    memcpy(data + entry_offset, entries[code]->data(), entries[code]->size());
+    entry_offset += entries[code]->size();
+  }
+  for (size_t i = 0; i < count; i++) {
+    Pack(data + codes_offset, i, bits, row_codes[i]);
+  }
+}
+
+auto CompressedPage::GetDictionaryEntry(const char *block, uint32_t row) -> const char * {
+  auto bits = static_cast<uint32_t>(static_cast<uint8_t>(block[5]));
+  uint32_t codes_offset;
+  memcpy(&codes_offset, block + 6, sizeof(uint32_t));
+  uint64_t code = Unpack(block + codes_offset, row, bits);
+  uint32_t entry_offset;
+  memcpy(&entry_offset, block + SIZE_DICTIONARY_HEADER + sizeof(uint32_t) * code, sizeof(uint32_t));
+  return block + entry_offset;
+}
+
+void CompressedPage::Decode(char *segment, uint32_t first_slot, const uint32_t *local_rows, size_t count,
+                            const std::vector<bool> &columns, Tuple *out) {
+  auto is_read = [&columns](uint32_t column) { return columns.empty() || columns[column]; };
+  uint32_t row_length = GetRowLength();
+
+  // Size every row first: the fixed-length part, then a | length | bytes | per VARCHAR, a NULL one if it is not read.
+  std::vector<uint32_t> sizes(count, row_length);
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    if (GetColumnType(column) != TypeId::VARCHAR) {
+      continue;
+    }
+    const char *block = GetColumnBlock(segment, column);
+    for (size_t i = 0; i < count; i++) {
+      sizes[i] += is_read(column) ? GetVarlenValueSize(GetDictionaryEntry(block, local_rows[i])) : sizeof(uint32_t);
+    }
+  }
+  for (size_t i = 0; i < count; i++) {
+    Tuple &row = out[i];
+    if (row.allocated_) {
+      delete[] row.data_;
+    }
+    row.data_ = new char[sizes[i]];
+    row.size_ = sizes[i];
+    row.allocated_ = true;
+    row.rid_ = RID(GetTablePageId(), first_slot + local_rows[i]);
+    memset(row.data_, 0, row_length);
+    sizes[i] = row_length;  // From here on, where the next VARCHAR of the row goes.
+  }
+
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    TypeId type = GetColumnType(column);
+    uint32_t row_offset = GetRowOffset(column);
+    const char *block = GetColumnBlock(segment, column);
+    if (type == TypeId::VARCHAR) {
+      for (size_t i = 0; i < count; i++) {
+        char *data = out[i].data_;
+        memcpy(data + row_offset, &sizes[i], sizeof(uint32_t));
+        if (is_read(column)) {
+          const char *value = GetDictionaryEntry(block, local_rows[i]);
+          uint32_t size = GetVarlenValueSize(value);
+          memcpy(data + sizes[i], value, size);
+          sizes[i] += size;
+        } else {
+          uint32_t null_length = BUSTUB_VALUE_NULL;
+          memcpy(data + sizes[i], &null_length, sizeof(uint32_t));
+          sizes[i] += sizeof(uint32_t);
+        }
+      }
+      continue;
+    }
+    if (!is_read(column)) {
+      continue;
+    }
+
+    auto width = static_cast<uint32_t>(Type::GetTypeSize(type));
+    switch (static_cast<Encoding>(block[0])) {
+      case Encoding::PLAIN:
+        for (size_t i = 0; i < count; i++) {
+          memcpy(out[i].data_ + row_offset, block + 1 + local_rows[i] * width, width);
+        }
+        break;
+      case Encoding::RLE: {
+        // The rows are in ascending order, so the runs are walked once.
+        const char *run = block + 1 + sizeof(uint32_t);
+        for (size_t i = 0; i < count; i++) {
+          uint32_t end;
+          memcpy(&end, run + width, sizeof(uint32_t));
+          while (end <= local_rows[i]) {
+            run += width + sizeof(uint32_t);
+            memcpy(&end, run + width, sizeof(uint32_t));
+          }
+          memcpy(out[i].data_ + row_offset, run, width);
+        }
+        break;
+      }
+      case Encoding::FOR: {
+        int64_t base;
+        memcpy(&base, block + 1, sizeof(int64_t));
+        auto bits = static_cast<uint32_t>(static_cast<uint8_t>(block[9]));
+        for (size_t i = 0; i < count; i++) {
+          uint64_t value = static_cast<uint64_t>(base) + Unpack(block + SIZE_FOR_HEADER, local_rows[i], bits);
+          WriteInteger(out[i].data_ + row_offset, width, static_cast<int64_t>(value));
+        }
+        break;
+      }
+      default:
+        UNREACHABLE("Fixed-length columns are never dictionary encoded.");
+    }
+  }
+}
+
+void CompressedPage::ReadRows(uint32_t first_slot, const std::vector<bool> &columns, std::vector<Tuple> *rows) {
+  std::vector<uint32_t> local_rows;
+  uint32_t segment_slot = 0;
+  for (uint32_t offset = GetSegmentsOffset(); offset < GetFreeSpacePointer();) {
+    char *segment = GetData() + offset;
+    uint32_t row_count = GetSegmentRowCount(segment);
+    local_rows.clear();
+    for (uint32_t row = first_slot > segment_slot ? first_slot - segment_slot : 0; row < row_count; row++) {
+      if (static_cast<SlotState>(*GetSlotStatePtr(segment, row)) == SlotState::LIVE) {
+        local_rows.push_back(row);
+      }
+    }
+    if (!local_rows.empty()) {
+      size_t begin = rows->size();
+      rows->resize(begin + local_rows.size());
+      Decode(segment, segment_slot, local_rows.data(), local_rows.size(), columns, rows->data() + begin);
+    }
+    segment_slot += row_count;
+    offset += GetSegmentSize(segment);
+  }
+}
+
+void CompressedPage::AppendLogRecord(LogRecord *log_record, Transaction *txn, LogManager *log_manager) {
+  lsn_t lsn = log_manager->AppendLogRecord(log_record);
+  SetLSN(lsn);
+  txn->SetPrevLSN(lsn);
+}
+
+auto CompressedPage::LockForWrite(const RID &rid, Transaction *txn, LockManager *lock_manager,
+                                  table_oid_t table_oid) -> bool {
+  if (txn->IsSharedLocked(rid)) {
+    return lock_manager->LockUpgrade(txn, rid, table_oid);
+  }
+  return txn->IsExclusiveLocked(rid) || lock_manager->LockExclusive(txn, rid, table_oid);
+}
+
+auto CompressedPage::InsertTuples(const Tuple *tuples, size_t count, RID *rids, Transaction *txn,
+                                  LockManager *lock_manager, table_oid_t table_oid, LogManager *log_manager) -> size_t {
+  // A segment only grows with its rows, so search for the most rows that fit behind the last segment.
+  uint32_t available = PAGE_SIZE - GetFreeSpacePointer();
+  size_t fitting = 0;
+  size_t too_many = std::min(count, static_cast<size_t>(available)) + 1;
+  std::vector<char> segment;
+  std::vector<char> candidate;
+  while (fitting + 1 < too_many) {
+    size_t rows = fitting + (too_many - fitting) / 2;
+    EncodeSegment(tuples, rows, nullptr, &candidate);
+    if (candidate.size() <= available) {
+      fitting = rows;
+      segment.swap(candidate);
+    } else {
+      too_many = rows;
+    }
+  }
+  if (fitting == 0) {
+    return 0;
+  }
+
+  memcpy(GetData() + GetFreeSpacePointer(), segment.data(), segment.size());
+  SetFreeSpacePointer(GetFreeSpacePointer() + segment.size());
+  uint32_t first_slot = GetTupleCount();
+  SetTupleCount(first_slot + fitting);
+  for (size_t i = 0; i < fitting; i++) {
+    rids[i].Set(GetTablePageId(), first_slot + i);
+    if (enable_logging) {
+      BUSTUB_ASSERT(!txn->IsSharedLocked(rids[i]) && !txn->IsExclusiveLocked(rids[i]),
+                    "A new tuple should not be locked.");
+      bool locked = lock_manager->LockExclusive(txn, rids[i], table_oid);
+      BUSTUB_ASSERT(locked, "Locking a new tuple should always work.");
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INSERT, rids[i], tuples[i]);
+      AppendLogRecord(&log_record, txn, log_manager);
+    }
+  }
+  return fitting;
+}
+
+auto CompressedPage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager,
+                                 table_oid_t table_oid, LogManager *log_manager) -> bool {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  return InsertTuples(&tuple, 1, rid, txn, lock_manager, table_oid, log_manager) == 1;
+}
+
+auto CompressedPage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                                LogManager *log_manager) -> bool {
+  uint32_t row;
+  char *segment = FindSegment(rid.GetSlotNum(), &row);
+  // If the slot does not hold a live tuple, abort the transaction.
+  if (segment == nullptr || static_cast<SlotState>(*GetSlotStatePtr(segment, row)) != SlotState::LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+
+  if (enable_logging) {
+    if (!LockForWrite(rid, txn, lock_manager, table_oid)) {
+      return false;
+    }
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, dummy_tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+  *GetSlotStatePtr(segment, row) = static_cast<char>(SlotState::DELETED);
+  return true;
+}
+
+auto CompressedPage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
+                                 LockManager *lock_manager, table_oid_t table_oid, LogManager *log_manager) -> bool {
+  BUSTUB_ASSERT(new_tuple.size_ > 0, "Cannot have empty tuples.");
+  uint32_t row;
+  char *segment = FindSegment(rid.GetSlotNum(), &row);
+  if (segment == nullptr || static_cast<SlotState>(*GetSlotStatePtr(segment, row)) != SlotState::LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+
+  // Re-encode the whole segment with the row replaced, its encodings may no longer suit the new value.
+  uint32_t row_count = GetSegmentRowCount(segment);
+  uint32_t first_slot = rid.GetSlotNum() - row;
+  std::vector<uint32_t> local_rows(row_count);
+  std::vector<SlotState> states(row_count);
+  for (uint32_t i = 0; i < row_count; i++) {
+    local_rows[i] = i;
+    states[i] = static_cast<SlotState>(*GetSlotStatePtr(segment, i));
+  }
+  std::vector<Tuple> rows(row_count);
+  Decode(segment, first_slot, local_rows.data(), row_count, {}, rows.data());
+  Tuple replaced = std::move(rows[row]);
+  rows[row] = new_tuple;
+  std::vector<char> encoded;
+  EncodeSegment(rows.data(), row_count, states.data(), &encoded);
+  // If the segment outgrows the page, the caller deletes and reinserts.
+  uint32_t old_size = GetSegmentSize(segment);
+  if (encoded.size() > old_size && encoded.size() - old_size > PAGE_SIZE - GetFreeSpacePointer()) {
+    return false;
+  }
+
+  *old_tuple = std::move(replaced);
+  if (enable_logging) {
+    if (!LockForWrite(rid, txn, lock_manager, table_oid)) {
+      return false;
+    }
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple, new_tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+  // Move the segments behind this one to where the re-encoded segment ends.
+  uint32_t segment_offset = segment - GetData();
+  uint32_t free_space_pointer = GetFreeSpacePointer();
+  memmove(segment + encoded.size(), segment + old_size, free_space_pointer - segment_offset - old_size);
+  memcpy(segment, encoded.data(), encoded.size());
+  SetFreeSpacePointer(free_space_pointer - old_size + encoded.size());
+  return true;
+}
+
+void CompressedPage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  uint32_t row;
+  char *segment = FindSegment(rid.GetSlotNum(), &row);
+  BUSTUB_ASSERT(segment != nullptr, "Cannot have more slots than tuples.");
+
+  if (enable_logging) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
+    // Log the deleted tuple for undo purposes.
+    Tuple delete_tuple;
+    DecodeRow(segment, rid.GetSlotNum() - row, row, &delete_tuple);
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, delete_tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+  *GetSlotStatePtr(segment, row) = static_cast<char>(SlotState::EMPTY);
+
+  // The bytes of a row stay in its segment. Only trailing segments without any row left are given back, which is
+  // what rolling back an insert leaves behind.
+  std::vector<uint32_t> offsets;
+  for (uint32_t offset = GetSegmentsOffset(); offset < GetFreeSpacePointer();
+       offset += GetSegmentSize(GetData() + offset)) {
+    offsets.push_back(offset);
+  }
+  while (!offsets.empty()) {
+    char *last = GetData() + offsets.back();
+    uint32_t row_count = GetSegmentRowCount(last);
+    for (uint32_t i = 0; i < row_count; i++) {
+      if (static_cast<SlotState>(*GetSlotStatePtr(last, i)) != SlotState::EMPTY) {
+        return;
+      }
+    }
+    SetFreeSpacePointer(offsets.back());
+    SetTupleCount(GetTupleCount() - row_count);
+    offsets.pop_back();
+  }
+}
+
+void CompressedPage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  if (enable_logging) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own an exclusive lock on the RID.");
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ROLLBACKDELETE, rid, dummy_tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+
+  uint32_t row;
+  char *segment = FindSegment(rid.GetSlotNum(), &row);
+  BUSTUB_ASSERT(segment != nullptr, "We can't have more slots than tuples.");
+  if (static_cast<SlotState>(*GetSlotStatePtr(segment, row)) == SlotState::DELETED) {
+    *GetSlotStatePtr(segment, row) = static_cast<char>(SlotState::LIVE);
+  }
+}
+
+auto CompressedPage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager,
+                              table_oid_t table_oid) -> bool {
+  uint32_t row;
+  char *segment = FindSegment(rid.GetSlotNum(), &row);
+  if (segment == nullptr || static_cast<SlotState>(*GetSlotStatePtr(segment, row)) != SlotState::LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+  if (enable_logging) {
+    if (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !lock_manager->LockShared(txn, rid, table_oid)) {
+      return false;
+    }
+  }
+  DecodeRow(segment, rid.GetSlotNum() - row, row, tuple);
+  return true;
+}
+
+auto CompressedPage::GetTupleView(const RID &rid, Tuple *tuple) -> bool {
+  uint32_t row;
+  char *segment = FindSegment(rid.GetSlotNum(), &row);
+  if (segment == nullptr || static_cast<SlotState>(*GetSlotStatePtr(segment, row)) != SlotState::LIVE) {
+    return false;
+  }
+  DecodeRow(segment, rid.GetSlotNum() - row, row, tuple);
+  return true;
+}
+
+auto CompressedPage::GetFirstTupleRid(RID *first_rid) -> bool {
+  uint32_t slot = FindLiveSlot(0);
+  if (slot < GetTupleCount()) {
+    first_rid->Set(GetTablePageId(), slot);
+    return true;
+  }
+  first_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+auto CompressedPage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool {
+  BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
+  uint32_t slot = FindLiveSlot(cur_rid.GetSlotNum() + 1);
+  if (slot < GetTupleCount()) {
+    next_rid->Set(GetTablePageId(), slot);
+    return true;
+  }
+  next_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+}  // namespace bustub
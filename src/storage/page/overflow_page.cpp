@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_page.cpp
+//
+// Identification: src/storage/page/overflow_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/overflow_page.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+auto OverflowPage::WriteChain(BufferPoolManager *bpm, const char *data, uint32_t size) -> page_id_t {
+  // Write the chain back to front, so every page is written once and already knows the page that follows it.
+  uint32_t page_count = std::max<uint32_t>(1, (size + CAPACITY - 1) / CAPACITY);
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  for (uint32_t i = page_count; i > 0; i--) {
+    uint32_t begin = (i - 1) * CAPACITY;
+    page_id_t page_id;
+    auto page = static_cast<OverflowPage *>(bpm->NewPage(&page_id));
+    if (page == nullptr) {
+      FreeChain(bpm, next_page_id);
+      return INVALID_PAGE_ID;
+    }
+    page->Init(next_page_id, data + begin, std::min(CAPACITY, size - begin));
+    bpm->UnpinPage(page_id, true);
+    next_page_id = page_id;
+  }
+  return next_page_id;
+}
+
+void OverflowPage::ReadChain(BufferPoolManager *bpm, page_id_t first_page_id, uint32_t size, char *data) {
+  page_id_t page_id = first_page_id;
+  uint32_t read = 0;
+  while (read < size) {
+    BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "An overflow chain is shorter than its value.");
+    auto page = static_cast<OverflowPage *>(bpm->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch an overflow page.");
+    uint32_t data_size = std::min(page->GetDataSize(), size - read);
+    memcpy(data + read, page->GetData() + SIZE_HEADER, data_size);
+    read += data_size;
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+void OverflowPage::FreeChain(BufferPoolManager *bpm, page_id_t first_page_id) {
+  page_id_t page_id = first_page_id;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<OverflowPage *>(bpm->FetchPage(page_id));
+    if (page == nullptr) {
+      return;
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    bpm->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+void OverflowPage::Init(page_id_t next_page_id, const char *data, uint32_t size) {
+  memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  memcpy(GetData() + OFFSET_DATA_SIZE, &size, sizeof(uint32_t));
+  memcpy(GetData() + SIZE_HEADER, data, size);
+}
+
+auto OverflowPage::GetNextPageId() -> page_id_t {
+  return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID);
+}
+
+auto OverflowPage::GetDataSize() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_DATA_SIZE); }
+
+}  // namespace bustub
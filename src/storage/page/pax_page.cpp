@@ -0,0 +1,421 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.cpp
+//
+// Identification: src/storage/page/pax_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/pax_page.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+void PaxPage::Init(page_id_t page_id, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn,
+                   const Schema &schema, uint32_t varlen_hint) {
+  TablePage::Init(page_id, PAGE_SIZE, prev_page_id, log_manager, txn);
+  SetFormat(TablePageFormat::PAX);
+  auto column_count = static_cast<uint16_t>(schema.GetColumnCount());
+  auto row_length = static_cast<uint16_t>(schema.GetLength());
+  memcpy(GetData() + OFFSET_COLUMN_COUNT, &column_count, sizeof(uint16_t));
+  memcpy(GetData() + OFFSET_ROW_LENGTH, &row_length, sizeof(uint16_t));
+  for (uint32_t i = 0; i < column_count; i++) {
+    const Column &column = schema.GetColumn(i);
+    auto type = static_cast<uint16_t>(column.GetType());
+    auto row_offset = static_cast<uint16_t>(column.GetOffset());
+    memcpy(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * i, &type, sizeof(uint16_t));
+    memcpy(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * i + 4, &row_offset, sizeof(uint16_t));
+  }
+  InitLayout(varlen_hint);
+}
+
+void PaxPage::Init(page_id_t page_id, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn,
+                   PaxPage *layout, uint32_t varlen_hint) {
+  TablePage::Init(page_id, PAGE_SIZE, prev_page_id, log_manager, txn);
+  SetFormat(TablePageFormat::PAX);
+  memcpy(GetData() + OFFSET_COLUMN_COUNT, layout->GetData() + OFFSET_COLUMN_COUNT,
+         OFFSET_COLUMNS - OFFSET_COLUMN_COUNT + SIZE_COLUMN * layout->GetColumnCount());
+  // Size the rows for what the rows of the table needed so far, unless the tuple at hand needs more.
+  uint32_t rows = 0;
+  for (uint32_t slot = 0; slot < layout->GetTupleCount(); slot++) {
+    rows += layout->GetSlotState(slot) == SlotState::EMPTY ? 0 : 1;
+  }
+  if (rows > 0) {
+    varlen_hint = std::max(varlen_hint, (PAGE_SIZE - layout->GetFreeSpacePointer()) / rows);
+  }
+  InitLayout(varlen_hint);
+}
+
+void PaxPage::InitLayout(uint32_t varlen_hint) {
+  uint32_t row_width = sizeof(SlotState);
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    row_width += GetMinipageWidth(GetColumnType(column));
+  }
+  uint32_t capacity = std::max(1U, (PAGE_SIZE - GetSlotStatesOffset()) / (row_width + varlen_hint));
+  memcpy(GetData() + OFFSET_CAPACITY, &capacity, sizeof(uint32_t));
+  memset(GetData() + GetSlotStatesOffset(), 0, capacity);
+
+  uint32_t offset = GetSlotStatesOffset() + capacity;
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    auto minipage_offset = static_cast<uint16_t>(offset);
+    memcpy(GetData() + OFFSET_COLUMNS + SIZE_COLUMN * column + 2, &minipage_offset, sizeof(uint16_t));
+    offset += capacity * GetMinipageWidth(GetColumnType(column));
+  }
+  BUSTUB_ASSERT(offset <= PAGE_SIZE, "The minipages of one row must fit in a page.");
+}
+
+auto PaxPage::GetHeapFreeSpace() -> uint32_t {
+  uint32_t end = GetSlotStatesOffset() + GetCapacity();
+  if (GetColumnCount() > 0) {
+    uint32_t last = GetColumnCount() - 1;
+    end = GetMinipageOffset(last) + GetCapacity() * GetMinipageWidth(GetColumnType(last));
+  }
+  return GetFreeSpacePointer() - end;
+}
+
+auto PaxPage::GetFreeSpaceRemaining() -> uint32_t {
+  return FindFreeSlot() < GetCapacity() ? GetHeapFreeSpace() + 1 : 0;
+}
+
+auto PaxPage::FindFreeSlot() -> uint32_t {
+  for (uint32_t slot = 0; slot < GetTupleCount(); slot++) {
+    if (GetSlotState(slot) == SlotState::EMPTY) {
+      return slot;
+    }
+  }
+  return GetTupleCount();
+}
+
+auto PaxPage::GetVarlenSize(const Tuple &tuple) -> uint32_t {
+  uint32_t size = 0;
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    if (GetColumnType(column) == TypeId::VARCHAR) {
+      uint32_t value_offset;
+      memcpy(&value_offset, tuple.data_ + GetRowOffset(column), sizeof(uint32_t));
+      size += GetVarlenValueSize(tuple.data_ + value_offset);
+    }
+  }
+  return size;
+}
+
+auto PaxPage::GetVarlenSize(uint32_t slot) -> uint32_t {
+  uint32_t size = 0;
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    if (GetColumnType(column) == TypeId::VARCHAR) {
+      uint32_t value_offset;
+      memcpy(&value_offset, GetValuePtr(column, slot), sizeof(uint32_t));
+      size += GetVarlenValueSize(GetData() + value_offset);
+    }
+  }
+  return size;
+}
+
+void PaxPage::WriteRow(uint32_t slot, const Tuple &tuple) {
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    TypeId type = GetColumnType(column);
+    const char *src = tuple.data_ + GetRowOffset(column);
+    if (type != TypeId::VARCHAR) {
+      memcpy(GetValuePtr(column, slot), src, GetMinipageWidth(type));
+      continue;
+    }
+    // Move the | length | bytes | to the varlen heap and keep where it went in the minipage.
+    uint32_t value_offset;
+    memcpy(&value_offset, src, sizeof(uint32_t));
+    uint32_t size = GetVarlenValueSize(tuple.data_ + value_offset);
+    SetFreeSpacePointer(GetFreeSpacePointer() - size);
+    memcpy(GetData() + GetFreeSpacePointer(), tuple.data_ + value_offset, size);
+    uint32_t page_offset = GetFreeSpacePointer();
+    memcpy(GetValuePtr(column, slot), &page_offset, sizeof(uint32_t));
+  }
+}
+
+void PaxPage::FreeVarlen(uint32_t slot) {
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    if (GetColumnType(column) != TypeId::VARCHAR) {
+      continue;
+    }
+    uint32_t value_offset;
+    memcpy(&value_offset, GetValuePtr(column, slot), sizeof(uint32_t));
+    uint32_t size = GetVarlenValueSize(GetData() + value_offset);
+    uint32_t free_space_pointer = GetFreeSpacePointer();
+    BUSTUB_ASSERT(value_offset >= free_space_pointer, "Free space appears before varlen values.");
+
+    // Close the gap the value leaves and shift every value that was below it.
+    memmove(GetData() + free_space_pointer + size, GetData() + free_space_pointer, value_offset - free_space_pointer);
+    SetFreeSpacePointer(free_space_pointer + size);
+    for (uint32_t other_column = 0; other_column < GetColumnCount(); other_column++) {
+      if (GetColumnType(other_column) != TypeId::VARCHAR) {
+        continue;
+      }
+      for (uint32_t other_slot = 0; other_slot < GetTupleCount(); other_slot++) {
+        if (GetSlotState(other_slot) == SlotState::EMPTY) {
+          continue;
+        }
+        uint32_t other_offset;
+        memcpy(&other_offset, GetValuePtr(other_column, other_slot), sizeof(uint32_t));
+        if (other_offset < value_offset) {
+          other_offset += size;
+          memcpy(GetValuePtr(other_column, other_slot), &other_offset, sizeof(uint32_t));
+        }
+      }
+    }
+  }
+}
+
+void PaxPage::Decode(const uint32_t *slots, size_t count, const std::vector<bool> &columns, Tuple *rows) {
+  auto is_read = [&columns](uint32_t column) { return columns.empty() || columns[column]; };
+  uint32_t row_length = GetRowLength();
+
+  // Size every row first: the fixed-length part, then a | length | bytes | per VARCHAR, a NULL one if it is not read.
+  std::vector<uint32_t> sizes(count, row_length);
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    if (GetColumnType(column) != TypeId::VARCHAR) {
+      continue;
+    }
+    for (size_t i = 0; i < count; i++) {
+      uint32_t value_offset;
+      memcpy(&value_offset, GetValuePtr(column, slots[i]), sizeof(uint32_t));
+      sizes[i] += is_read(column) ? GetVarlenValueSize(GetData() + value_offset) : sizeof(uint32_t);
+    }
+  }
+  for (size_t i = 0; i < count; i++) {
+    Tuple &row = rows[i];
+    if (row.allocated_) {
+      delete[] row.data_;
+    }
+    row.data_ = new char[sizes[i]];
+    row.size_ = sizes[i];
+    row.allocated_ = true;
+    row.rid_ = RID(GetTablePageId(), slots[i]);
+    memset(row.data_, 0, row_length);
+    sizes[i] = row_length;  // From here on, where the next VARCHAR of the row goes.
+  }
+
+  for (uint32_t column = 0; column < GetColumnCount(); column++) {
+    TypeId type = GetColumnType(column);
+    uint32_t width = GetMinipageWidth(type);
+    uint32_t row_offset = GetRowOffset(column);
+    const char *minipage = GetData() + GetMinipageOffset(column);
+    if (type != TypeId::VARCHAR) {
+      if (is_read(column)) {
+        for (size_t i = 0; i < count; i++) {
+          memcpy(rows[i].data_ + row_offset, minipage + slots[i] * width, width);
+        }
+      }
+      continue;
+    }
+    for (size_t i = 0; i < count; i++) {
+      char *data = rows[i].data_;
+      memcpy(data + row_offset, &sizes[i], sizeof(uint32_t));
+      if (is_read(column)) {
+        uint32_t value_offset;
+        memcpy(&value_offset, minipage + slots[i] * width, sizeof(uint32_t));
+        uint32_t size = GetVarlenValueSize(GetData() + value_offset);
+        memcpy(data + sizes[i], GetData() + value_offset, size);
+        sizes[i] += size;
+      } else {
+        uint32_t null_length = BUSTUB_VALUE_NULL;
+        memcpy(data + sizes[i], &null_length, sizeof(uint32_t));
+        sizes[i] += sizeof(uint32_t);
+      }
+    }
+  }
+}
+
+void PaxPage::ReadRows(uint32_t first_slot, const std::vector<bool> &columns, std::vector<Tuple> *rows) {
+  std::vector<uint32_t> slots;
+  slots.reserve(GetTupleCount());
+  for (uint32_t slot = first_slot; slot < GetTupleCount(); slot++) {
+    if (GetSlotState(slot) == SlotState::LIVE) {
+      slots.push_back(slot);
+    }
+  }
+  size_t begin = rows->size();
+  rows->resize(begin + slots.size());
+  Decode(slots.data(), slots.size(), columns, rows->data() + begin);
+}
+
+void PaxPage::AppendLogRecord(LogRecord *log_record, Transaction *txn, LogManager *log_manager) {
+  lsn_t lsn = log_manager->AppendLogRecord(log_record);
+  SetLSN(lsn);
+  txn->SetPrevLSN(lsn);
+}
+
+auto PaxPage::LockForWrite(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid) -> bool {
+  if (txn->IsSharedLocked(rid)) {
+    return lock_manager->LockUpgrade(txn, rid, table_oid);
+  }
+  return txn->IsExclusiveLocked(rid) || lock_manager->LockExclusive(txn, rid, table_oid);
+}
+
+auto PaxPage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager,
+                          table_oid_t table_oid, LogManager *log_manager) -> bool {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  uint32_t slot = FindFreeSlot();
+  if (slot == GetCapacity() || GetHeapFreeSpace() < GetVarlenSize(tuple)) {
+    return false;
+  }
+
+  WriteRow(slot, tuple);
+  SetSlotState(slot, SlotState::LIVE);
+  rid->Set(GetTablePageId(), slot);
+  if (slot == GetTupleCount()) {
+    SetTupleCount(slot + 1);
+  }
+
+  if (enable_logging) {
+    BUSTUB_ASSERT(!txn->IsSharedLocked(*rid) && !txn->IsExclusiveLocked(*rid), "A new tuple should not be locked.");
+    bool locked = lock_manager->LockExclusive(txn, *rid, table_oid);
+    BUSTUB_ASSERT(locked, "Locking a new tuple should always work.");
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INSERT, *rid, tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+  return true;
+}
+
+auto PaxPage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                         LogManager *log_manager) -> bool {
+  uint32_t slot = rid.GetSlotNum();
+  // If the slot does not hold a live tuple, abort the transaction.
+  if (slot >= GetTupleCount() || GetSlotState(slot) != SlotState::LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+
+  if (enable_logging) {
+    if (!LockForWrite(rid, txn, lock_manager, table_oid)) {
+      return false;
+    }
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, dummy_tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+  SetSlotState(slot, SlotState::DELETED);
+  return true;
+}
+
+auto PaxPage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
+                          LockManager *lock_manager, table_oid_t table_oid, LogManager *log_manager) -> bool {
+  BUSTUB_ASSERT(new_tuple.size_ > 0, "Cannot have empty tuples.");
+  uint32_t slot = rid.GetSlotNum();
+  if (slot >= GetTupleCount() || GetSlotState(slot) != SlotState::LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+  // Only the VARCHAR values can grow, the caller deletes and reinserts if they do not fit.
+  if (GetHeapFreeSpace() + GetVarlenSize(slot) < GetVarlenSize(new_tuple)) {
+    return false;
+  }
+
+  Decode(&slot, 1, {}, old_tuple);
+  if (enable_logging) {
+    if (!LockForWrite(rid, txn, lock_manager, table_oid)) {
+      return false;
+    }
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple, new_tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+  FreeVarlen(slot);
+  WriteRow(slot, new_tuple);
+  return true;
+}
+
+void PaxPage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  uint32_t slot = rid.GetSlotNum();
+  BUSTUB_ASSERT(slot < GetTupleCount(), "Cannot have more slots than tuples.");
+
+  if (enable_logging) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
+    // Log the deleted tuple for undo purposes.
+    Tuple delete_tuple;
+    Decode(&slot, 1, {}, &delete_tuple);
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, delete_tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+
+  FreeVarlen(slot);
+  SetSlotState(slot, SlotState::EMPTY);
+  // Give trailing empty slots back, so scans stop at the last row.
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetSlotState(tuple_count - 1) == SlotState::EMPTY) {
+    tuple_count--;
+  }
+  SetTupleCount(tuple_count);
+}
+
+void PaxPage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  if (enable_logging) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own an exclusive lock on the RID.");
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ROLLBACKDELETE, rid, dummy_tuple);
+    AppendLogRecord(&log_record, txn, log_manager);
+  }
+
+  uint32_t slot = rid.GetSlotNum();
+  BUSTUB_ASSERT(slot < GetTupleCount(), "We can't have more slots than tuples.");
+  if (GetSlotState(slot) == SlotState::DELETED) {
+    SetSlotState(slot, SlotState::LIVE);
+  }
+}
+
+auto PaxPage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager,
+                       table_oid_t table_oid) -> bool {
+  uint32_t slot = rid.GetSlotNum();
+  if (slot >= GetTupleCount() || GetSlotState(slot) != SlotState::LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+  if (enable_logging) {
+    if (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !lock_manager->LockShared(txn, rid, table_oid)) {
+      return false;
+    }
+  }
+  Decode(&slot, 1, {}, tuple);
+  return true;
+}
+
+auto PaxPage::GetTupleView(const RID &rid, Tuple *tuple) -> bool {
+  uint32_t slot = rid.GetSlotNum();
+  if (slot >= GetTupleCount() || GetSlotState(slot) != SlotState::LIVE) {
+    return false;
+  }
+  Decode(&slot, 1, {}, tuple);
+  return true;
+}
+
+auto PaxPage::GetFirstTupleRid(RID *first_rid) -> bool {
+  for (uint32_t slot = 0; slot < GetTupleCount(); slot++) {
+    if (GetSlotState(slot) == SlotState::LIVE) {
+      first_rid->Set(GetTablePageId(), slot);
+      return true;
+    }
+  }
+  first_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+auto PaxPage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool {
+  BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
+  for (uint32_t slot = cur_rid.GetSlotNum() + 1; slot < GetTupleCount(); slot++) {
+    if (GetSlotState(slot) == SlotState::LIVE) {
+      next_rid->Set(GetTablePageId(), slot);
+      return true;
+    }
+  }
+  next_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+}  // namespace bustub
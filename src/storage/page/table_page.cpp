@@ -14,6 +14,9 @@
 
 #include <cassert>
 
+#include "storage/page/compressed_page.h"
+#include "storage/page/pax_page.h"
+
 namespace bustub {
 
 void TablePage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_id, LogManager *log_manager,
@@ -33,10 +36,32 @@ void TablePage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_
   SetNextPageId(INVALID_PAGE_ID);
   SetFreeSpacePointer(page_size);
   SetTupleCount(0);
+  SetFsmPageId(INVALID_PAGE_ID);
+  SetFormat(TablePageFormat::SLOTTED);
+}
+
+auto TablePage::AsPax() -> PaxPage * { return static_cast<PaxPage *>(this); }
+
+auto TablePage::AsCompressed() -> CompressedPage * { return static_cast<CompressedPage *>(this); }
+
+auto TablePage::GetFreeSpaceRemaining() -> uint32_t {
+  if (GetFormat() == TablePageFormat::PAX) {
+    return AsPax()->GetFreeSpaceRemaining();
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    return AsCompressed()->GetFreeSpaceRemaining();
+  }
+  return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
 }
 
 auto TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager,
-                            LogManager *log_manager) -> bool {
+                            table_oid_t table_oid, LogManager *log_manager) -> bool {
+  if (GetFormat() == TablePageFormat::PAX) {
+    return AsPax()->InsertTuple(tuple, rid, txn, lock_manager, table_oid, log_manager);
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    return AsCompressed()->InsertTuple(tuple, rid, txn, lock_manager, table_oid, log_manager);
+  }
   BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
   // If there is not enough space, then return false.
   if (GetFreeSpaceRemaining() < tuple.size_ + SIZE_TUPLE) {
@@ -75,7 +100,7 @@ auto TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, Lock
   if (enable_logging) {
     BUSTUB_ASSERT(!txn->IsSharedLocked(*rid) && !txn->IsExclusiveLocked(*rid), "A new tuple should not be locked.");
     // Acquire an exclusive lock on the new tuple.
-    bool locked = lock_manager->LockExclusive(txn, *rid);
+    bool locked = lock_manager->LockExclusive(txn, *rid, table_oid);
     BUSTUB_ASSERT(locked, "Locking a new tuple should always work.");
     LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INSERT, *rid, tuple);
     lsn_t lsn = log_manager->AppendLogRecord(&log_record);
@@ -85,8 +110,14 @@ auto TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, Lock
   return true;
 }
 
-auto TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager)
-    -> bool {
+auto TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, table_oid_t table_oid,
+                           LogManager *log_manager) -> bool {
+  if (GetFormat() == TablePageFormat::PAX) {
+    return AsPax()->MarkDelete(rid, txn, lock_manager, table_oid, log_manager);
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    return AsCompressed()->MarkDelete(rid, txn, lock_manager, table_oid, log_manager);
+  }
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort the transaction.
   if (slot_num >= GetTupleCount()) {
@@ -108,10 +139,10 @@ auto TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_m
   if (enable_logging) {
     // Acquire an exclusive lock, upgrading from a shared lock if necessary.
     if (txn->IsSharedLocked(rid)) {
-      if (!lock_manager->LockUpgrade(txn, rid)) {
+      if (!lock_manager->LockUpgrade(txn, rid, table_oid)) {
         return false;
       }
-    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid, table_oid)) {
       return false;
     }
     Tuple dummy_tuple;
@@ -129,7 +160,13 @@ auto TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_m
 }
 
 auto TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
-                            LockManager *lock_manager, LogManager *log_manager) -> bool {
+                            LockManager *lock_manager, table_oid_t table_oid, LogManager *log_manager) -> bool {
+  if (GetFormat() == TablePageFormat::PAX) {
+    return AsPax()->UpdateTuple(new_tuple, old_tuple, rid, txn, lock_manager, table_oid, log_manager);
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    return AsCompressed()->UpdateTuple(new_tuple, old_tuple, rid, txn, lock_manager, table_oid, log_manager);
+  }
   BUSTUB_ASSERT(new_tuple.size_ > 0, "Cannot have empty tuples.");
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort the transaction.
@@ -146,12 +183,10 @@ auto TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
     if (enable_logging) {
       txn->SetState(TransactionState::ABORTED);
     }
-    std::cout<<"1\n";
     return false;
   }
   // If there is not enuogh space to update, we need to update via delete followed by an insert (not enough space).
   if (GetFreeSpaceRemaining() + tuple_size < new_tuple.size_) {
-      std::cout<<"2\n";
     return false;
   }
 
@@ -169,12 +204,10 @@ auto TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
   if (enable_logging) {
     // Acquire an exclusive lock, upgrading from shared if necessary.
     if (txn->IsSharedLocked(rid)) {
-      if (!lock_manager->LockUpgrade(txn, rid)) {
-        std::cout<<"3\n";
+      if (!lock_manager->LockUpgrade(txn, rid, table_oid)) {
         return false;
       }
-    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
-      std::cout<<"4\n";
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid, table_oid)) {
       return false;
     }
     LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple, new_tuple);
@@ -183,6 +216,12 @@ auto TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
     txn->SetPrevLSN(lsn);
   }
 
+  // A version of the same size, a counter bumped or a flag flipped, overwrites the old one where it is.
+  if (new_tuple.size_ == tuple_size) {
+    memcpy(GetData() + tuple_offset, new_tuple.data_, tuple_size);
+    return true;
+  }
+
   // Perform the update.
   uint32_t free_space_pointer = GetFreeSpacePointer();
   BUSTUB_ASSERT(tuple_offset >= free_space_pointer, "Offset should appear after current free space position.");
@@ -203,7 +242,15 @@ auto TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
   return true;
 }
 
-void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager, Tuple *delete_tuple) {
+  if (GetFormat() == TablePageFormat::PAX) {
+    AsPax()->ApplyDelete(rid, txn, log_manager);
+    return;
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    AsCompressed()->ApplyDelete(rid, txn, log_manager);
+    return;
+  }
   uint32_t slot_num = rid.GetSlotNum();
   BUSTUB_ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
 
@@ -216,17 +263,21 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
   // Otherwise we are rolling back an insert.
 
   // We need to copy out the deleted tuple for undo purposes.
-  Tuple delete_tuple;
-  delete_tuple.size_ = tuple_size;
-  delete_tuple.data_ = new char[delete_tuple.size_];
-  memcpy(delete_tuple.data_, GetData() + tuple_offset, delete_tuple.size_);
-  delete_tuple.rid_ = rid;
-  delete_tuple.allocated_ = true;
+  Tuple removed_tuple;
+  Tuple &removed = delete_tuple != nullptr ? *delete_tuple : removed_tuple;
+  if (removed.allocated_) {
+    delete[] removed.data_;
+  }
+  removed.size_ = tuple_size;
+  removed.data_ = new char[removed.size_];
+  memcpy(removed.data_, GetData() + tuple_offset, removed.size_);
+  removed.rid_ = rid;
+  removed.allocated_ = true;
 
   if (enable_logging) {
     BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
 
-    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, delete_tuple);
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, removed);
     lsn_t lsn = log_manager->AppendLogRecord(&log_record);
     SetLSN(lsn);
     txn->SetPrevLSN(lsn);
@@ -251,6 +302,14 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
 }
 
 void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  if (GetFormat() == TablePageFormat::PAX) {
+    AsPax()->RollbackDelete(rid, txn, log_manager);
+    return;
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    AsCompressed()->RollbackDelete(rid, txn, log_manager);
+    return;
+  }
   // Log the rollback.
   if (enable_logging) {
     BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own an exclusive lock on the RID.");
@@ -271,7 +330,40 @@ void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log
   }
 }
 
-auto TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) -> bool {
+auto TablePage::RestoreTuple(const Tuple &tuple, const RID &rid) -> bool {
+  if (GetFormat() != TablePageFormat::SLOTTED) {
+    // Replaying the page's history, the other formats insert into the slot the tuple was in.
+    RID placed;
+    return InsertTuple(tuple, &placed, nullptr, nullptr, 0, nullptr) && placed == rid;
+  }
+  BUSTUB_ASSERT(!enable_logging, "Restoring a tuple is not logged.");
+  uint32_t slot_num = rid.GetSlotNum();
+  // The slot must be empty, or the next one.
+  if (slot_num > GetTupleCount() || (slot_num < GetTupleCount() && GetTupleSize(slot_num) != 0)) {
+    return false;
+  }
+  if (GetFreeSpaceRemaining() < tuple.size_ + (slot_num == GetTupleCount() ? SIZE_TUPLE : 0)) {
+    return false;
+  }
+
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size_);
+  memcpy(GetData() + GetFreeSpacePointer(), tuple.data_, tuple.size_);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, tuple.size_);
+  if (slot_num == GetTupleCount()) {
+    SetTupleCount(GetTupleCount() + 1);
+  }
+  return true;
+}
+
+auto TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager,
+                         table_oid_t table_oid) -> bool {
+  if (GetFormat() == TablePageFormat::PAX) {
+    return AsPax()->GetTuple(rid, tuple, txn, lock_manager, table_oid);
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    return AsCompressed()->GetTuple(rid, tuple, txn, lock_manager, table_oid);
+  }
   // Get the current slot number.
   uint32_t slot_num = rid.GetSlotNum();
   // If somehow we have more slots than tuples, abort the transaction.
@@ -293,7 +385,7 @@ auto TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
 
   // Otherwise we have a valid tuple, try to acquire at least a shared lock.
   if (enable_logging) {
-    if (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !lock_manager->LockShared(txn, rid)) {
+    if (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !lock_manager->LockShared(txn, rid, table_oid)) {
       return false;
     }
   }
@@ -311,7 +403,49 @@ auto TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
   return true;
 }
 
+auto TablePage::GetTupleView(const RID &rid, Tuple *tuple) -> bool {
+  if (GetFormat() == TablePageFormat::PAX) {
+    return AsPax()->GetTupleView(rid, tuple);
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    return AsCompressed()->GetTupleView(rid, tuple);
+  }
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount()) {
+    return false;
+  }
+  uint32_t tuple_size = GetTupleSize(slot_num);
+  if (IsDeleted(tuple_size)) {
+    return false;
+  }
+  if (tuple->allocated_) {
+    delete[] tuple->data_;
+  }
+  tuple->data_ = GetData() + GetTupleOffsetAtSlot(slot_num);
+  tuple->size_ = tuple_size;
+  tuple->rid_ = rid;
+  tuple->allocated_ = false;
+  return true;
+}
+
+auto TablePage::ReclaimSlots() -> uint32_t {
+  uint32_t tuple_count = GetTupleCount();
+  uint32_t reclaimed = 0;
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+    reclaimed++;
+  }
+  SetTupleCount(tuple_count);
+  return reclaimed;
+}
+
 auto TablePage::GetFirstTupleRid(RID *first_rid) -> bool {
+  if (GetFormat() == TablePageFormat::PAX) {
+    return AsPax()->GetFirstTupleRid(first_rid);
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    return AsCompressed()->GetFirstTupleRid(first_rid);
+  }
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); ++i) {
     if (!IsDeleted(GetTupleSize(i))) {
@@ -324,6 +458,12 @@ auto TablePage::GetFirstTupleRid(RID *first_rid) -> bool {
 }
 
 auto TablePage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool {
+  if (GetFormat() == TablePageFormat::PAX) {
+    return AsPax()->GetNextTupleRid(cur_rid, next_rid);
+  }
+  if (GetFormat() == TablePageFormat::COMPRESSED) {
+    return AsCompressed()->GetNextTupleRid(cur_rid, next_rid);
+  }
   BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
   // Find and return the first valid tuple after our current slot number.
   for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); ++i) {
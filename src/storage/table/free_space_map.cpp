@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include <limits>
+
+namespace bustub {
+
+namespace {
+/** fsm_page_idx_ of an entry that only lives in memory because the buffer pool was out of frames */
+constexpr size_t NOT_PERSISTED = std::numeric_limits<size_t>::max();
+}  // namespace
+
+auto FreeSpaceMap::Load(page_id_t root_page_id) -> bool {
+  std::scoped_lock lock(latch_);
+  BUSTUB_ASSERT(fsm_page_ids_.empty() && entries_.empty(), "Can only load into an empty map.");
+  for (page_id_t fsm_page_id = root_page_id; fsm_page_id != INVALID_PAGE_ID;) {
+    auto page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_id));
+    if (page == nullptr) {
+      break;
+    }
+    page->RLatch();
+    if (page->GetFsmPageId() != fsm_page_id || page->GetHeapPageId() != heap_page_id_) {
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(fsm_page_id, false);
+      break;
+    }
+    fsm_page_ids_.push_back(fsm_page_id);
+    for (uint32_t slot = 0; slot < page->GetEntryCount(); slot++) {
+      page_id_t page_id = page->GetPageId(slot);
+      Entry &entry = entries_[page_id];
+      entry.fsm_page_idx_ = fsm_page_ids_.size() - 1;
+      entry.slot_ = slot;
+      AddToBucket(page_id, &entry, page->GetCategory(slot));
+      page_ids_.push_back(page_id);
+    }
+    fsm_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetFsmPageId(), false);
+  }
+  return !fsm_page_ids_.empty();
+}
+
+auto FreeSpaceMap::FindPage(uint32_t size) -> page_id_t {
+  std::scoped_lock lock(latch_);
+  // Round up: every page in bucket c had at least c * CATEGORY_UNIT bytes free.
+  for (uint32_t category = (size + FreeSpaceMapPage::CATEGORY_UNIT - 1) / FreeSpaceMapPage::CATEGORY_UNIT;
+       category < FreeSpaceMapPage::NUM_CATEGORIES; category++) {
+    if (!buckets_[category].empty()) {
+      // The most recently recorded page is the most likely to still be in the buffer pool.
+      return buckets_[category].back();
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, uint32_t free_space) {
+  std::scoped_lock lock(latch_);
+  uint8_t category = CategoryOf(free_space);
+  auto it = entries_.find(page_id);
+  if (it == entries_.end()) {
+    Entry &entry = entries_[page_id];
+    if (!AppendEntry(page_id, category, &entry)) {
+      entry.fsm_page_idx_ = NOT_PERSISTED;
+    }
+    AddToBucket(page_id, &entry, category);
+    page_ids_.push_back(page_id);
+    return;
+  }
+
+  Entry &entry = it->second;
+  if (entry.category_ == category) {
+    return;
+  }
+  RemoveFromBucket(entry);
+  AddToBucket(page_id, &entry, category);
+  if (entry.fsm_page_idx_ == NOT_PERSISTED) {
+    return;
+  }
+  page_id_t fsm_page_id = fsm_page_ids_[entry.fsm_page_idx_];
+  auto page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_id));
+  // The persisted category is only a hint, losing this write just leaves it stale.
+  if (page != nullptr) {
+    page->WLatch();
+    page->SetCategory(entry.slot_, category);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(fsm_page_id, true);
+  }
+}
+
+auto FreeSpaceMap::GetLastPageId() -> page_id_t {
+  std::scoped_lock lock(latch_);
+  return page_ids_.empty() ? INVALID_PAGE_ID : page_ids_.back();
+}
+
+auto FreeSpaceMap::GetRootPageId() -> page_id_t {
+  std::scoped_lock lock(latch_);
+  return fsm_page_ids_.empty() ? INVALID_PAGE_ID : fsm_page_ids_.front();
+}
+
+auto FreeSpaceMap::GetPageCount() -> size_t {
+  std::scoped_lock lock(latch_);
+  return page_ids_.size();
+}
+
+auto FreeSpaceMap::GetPageIds() -> std::vector<page_id_t> {
+  std::scoped_lock lock(latch_);
+  return page_ids_;
+}
+
+void FreeSpaceMap::AddToBucket(page_id_t page_id, Entry *entry, uint8_t category) {
+  entry->category_ = category;
+  entry->bucket_pos_ = buckets_[category].size();
+  buckets_[category].push_back(page_id);
+}
+
+void FreeSpaceMap::RemoveFromBucket(const Entry &entry) {
+  auto &bucket = buckets_[entry.category_];
+  page_id_t moved = bucket.back();
+  bucket[entry.bucket_pos_] = moved;
+  entries_[moved].bucket_pos_ = entry.bucket_pos_;
+  bucket.pop_back();
+}
+
+auto FreeSpaceMap::AppendEntry(page_id_t page_id, uint8_t category, Entry *entry) -> bool {
+  FreeSpaceMapPage *page = nullptr;
+  if (!fsm_page_ids_.empty()) {
+    page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_ids_.back()));
+    if (page == nullptr) {
+      return false;
+    }
+    page->WLatch();
+  }
+
+  if (page == nullptr || page->IsFull()) {
+    // Chain a new page of the map after the last one.
+    page_id_t new_page_id;
+    auto new_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->NewPage(&new_page_id));
+    if (new_page == nullptr) {
+      if (page != nullptr) {
+        page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(page->GetFsmPageId(), false);
+      }
+      return false;
+    }
+    new_page->WLatch();
+    new_page->Init(new_page_id, heap_page_id_);
+    if (page != nullptr) {
+      page->SetNextPageId(new_page_id);
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetFsmPageId(), true);
+    }
+    fsm_page_ids_.push_back(new_page_id);
+    page = new_page;
+  }
+
+  entry->fsm_page_idx_ = fsm_page_ids_.size() - 1;
+  entry->slot_ = page->Append(page_id, category);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetFsmPageId(), true);
+  return true;
+}
+
+}  // namespace bustub
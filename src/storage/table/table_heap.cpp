@@ -10,7 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <numeric>
+#include <vector>
 
 #include "common/logger.h"
 #include "storage/table/table_heap.h"
@@ -25,71 +31,403 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
       first_page_id_(first_page_id) {}
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     Transaction *txn)
-    : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
+                     Transaction *txn, TablePageFormat format, const Schema *schema)
+    : buffer_pool_manager_(buffer_pool_manager),
+      lock_manager_(lock_manager),
+      log_manager_(log_manager),
+      format_(format),
+      row_length_(schema == nullptr ? 0 : schema->GetLength()) {
   // Initialize the first table page.
   auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
   BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
   first_page->WLatch();
-  first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  if (format_ == TablePageFormat::PAX) {
+    BUSTUB_ASSERT(schema != nullptr, "A PAX table heap needs the schema of its rows.");
+    // Nothing is known about the rows yet, guess a short string per VARCHAR.
+    uint32_t varlen_hint = schema->GetUnlinedColumns().size() * PaxPage::VARLEN_GUESS;
+    static_cast<PaxPage *>(first_page)->Init(first_page_id_, INVALID_LSN, log_manager_, txn, *schema, varlen_hint);
+  } else if (format_ == TablePageFormat::COMPRESSED) {
+    BUSTUB_ASSERT(schema != nullptr, "A compressed table heap needs the schema of its rows.");
+    static_cast<CompressedPage *>(first_page)->Init(first_page_id_, INVALID_LSN, log_manager_, txn, *schema);
+  } else {
+    first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  }
+  if (schema != nullptr) {
+    zone_map_ = std::make_unique<ZoneMap>(*schema);
+    zone_map_->AddPage(first_page_id_);
+    for (uint32_t column : schema->GetUnlinedColumns()) {
+      varlen_offsets_.push_back(schema->GetColumn(column).GetOffset());
+    }
+  }
+  // Start the free-space map with the first page and remember where it lives.
+  free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_, first_page_id_);
+  free_space_map_->Update(first_page_id_, first_page->GetFreeSpaceRemaining());
+  first_page->SetFsmPageId(free_space_map_->GetRootPageId());
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
-auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool {
-  if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
-    txn->SetState(TransactionState::ABORTED);
-    return false;
+auto TableHeap::GetFreeSpaceMap() -> FreeSpaceMap * {
+  std::call_once(free_space_map_opened_, [this] {
+    if (free_space_map_ == nullptr) {
+      OpenFreeSpaceMap();
+    }
+  });
+  return free_space_map_.get();
+}
+
+void TableHeap::OpenFreeSpaceMap() {
+  free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_, first_page_id_);
+  auto first_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  BUSTUB_ASSERT(first_page != nullptr, "Couldn't find the first page of the table heap.");
+  first_page->RLatch();
+  page_id_t root_page_id = first_page->GetFsmPageId();
+  format_ = first_page->GetFormat();
+  if (format_ == TablePageFormat::PAX) {
+    row_length_ = static_cast<PaxPage *>(first_page)->GetRowLength();
+  } else if (format_ == TablePageFormat::COMPRESSED) {
+    row_length_ = static_cast<CompressedPage *>(first_page)->GetRowLength();
   }
+  first_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(first_page_id_, false);
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+  // The persisted map may be missing (a heap written before maps existed) or lag the heap when pages were appended
+  // and the map page was not flushed. Walk whatever part of the list it does not cover and record those pages.
+  bool loaded = free_space_map_->Load(root_page_id);
+  page_id_t page_id = first_page_id_;
+  page_id_t last_page_id = free_space_map_->GetLastPageId();
+  if (last_page_id != INVALID_PAGE_ID) {
+    auto last_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id));
+    BUSTUB_ASSERT(last_page != nullptr, "Couldn't find the last page of the table heap.");
+    last_page->RLatch();
+    page_id = last_page->GetNextPageId();
+    last_page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+  }
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't find a page of the table heap.");
+    page->RLatch();
+    free_space_map_->Update(page_id, page->GetFreeSpaceRemaining());
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+
+  if (!loaded) {
+    first_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+    first_page->WLatch();
+    first_page->SetFsmPageId(free_space_map_->GetRootPageId());
+    first_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  }
+}
+
+auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool {
+  return InsertTuples(&tuple, 1, rid, txn);
+}
+
+auto TableHeap::InsertTuples(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn) -> bool {
+  rids->resize(tuples.size());
+  return InsertTuples(tuples.data(), tuples.size(), rids->data(), txn);
+}
+
+auto TableHeap::InsertTuples(const Tuple *tuples, size_t count, RID *rids, Transaction *txn) -> bool {
+  // Long tuples are stored with their large values moved out of line. Should the insert fail, the chains of the
+  // tuples that did not make it are freed here, those of the inserted ones when the insert is rolled back.
+  std::vector<Tuple> stored;
+  std::vector<bool> moved;
+  size_t inserted = 0;
+  auto abort = [&] {
+    for (size_t i = inserted; i < moved.size(); i++) {
+      if (moved[i]) {
+        FreeOverflow(stored[i]);
+      }
+    }
     txn->SetState(TransactionState::ABORTED);
     return false;
+  };
+  if (CanOverflow()) {
+    for (size_t i = 0; i < count; i++) {
+      if (tuples[i].size_ <= TOAST_THRESHOLD) {
+        continue;
+      }
+      if (stored.empty()) {
+        stored.assign(tuples, tuples + count);
+        moved.assign(count, false);
+      }
+      Tuple overflowed;
+      if (!MoveToOverflow(tuples[i], &overflowed)) {
+        return abort();
+      }
+      if (overflowed.size_ != 0) {
+        stored[i] = std::move(overflowed);
+        moved[i] = true;
+      }
+    }
+    if (!stored.empty()) {
+      tuples = stored.data();
+    }
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (tuples[i].size_ + 40 > PAGE_SIZE) {  // larger than one page size
+      return abort();
+    }
   }
 
-  cur_page->WLatch();
-  // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
-  while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
-    auto next_page_id = cur_page->GetNextPageId();
-    // If the next page is a valid page,
-    if (next_page_id != INVALID_PAGE_ID) {
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
+  FreeSpaceMap *free_space_map = GetFreeSpaceMap();
+  while (inserted < count) {
+    // Ask the free-space map for a page the next tuple fits in. If there is none, grow the heap by one page.
+    TablePage *cur_page;
+    page_id_t page_id = free_space_map->FindPage(GetInsertSize(tuples[inserted]));
+    bool appended = page_id == INVALID_PAGE_ID;
+    if (appended) {
+      cur_page = AppendPage(txn, tuples[inserted]);
     } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
-      // If we could not create a new page,
-      if (new_page == nullptr) {
-        // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-        txn->SetState(TransactionState::ABORTED);
-        return false;
+      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+      if (cur_page != nullptr) {
+        cur_page->WLatch();
       }
-      // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
+    }
+    // If we could not get a page, then life sucks and we abort the transaction.
+    if (cur_page == nullptr) {
+      return abort();
+    }
+
+    // Fill the page as far as it goes, every tuple that does not fit continues on the next page we are given.
+    // A compressed page takes the tuples that fit as one segment, so they are encoded together.
+    bool dirty = false;
+    size_t first = inserted;
+    if (format_ == TablePageFormat::COMPRESSED) {
+      inserted += static_cast<CompressedPage *>(cur_page)->InsertTuples(tuples + first, count - first, rids + first,
+                                                                        txn, lock_manager_, table_oid_, log_manager_);
+      for (size_t i = first; i < inserted; i++) {
+        txn->GetWriteSet()->emplace_back(rids[i], WType::INSERT, Tuple{}, this);
+        if (enable_logging) {
+          version_store_.Record(rids[i], txn, nullptr);
+        }
+      }
+      dirty = inserted > first;
+    }
+    while (format_ != TablePageFormat::COMPRESSED && inserted < count &&
+           cur_page->InsertTuple(tuples[inserted], &rids[inserted], txn, lock_manager_, table_oid_, log_manager_)) {
+      // Update the transaction's write set. Snapshots from before the insert do not see the tuple.
+      txn->GetWriteSet()->emplace_back(rids[inserted], WType::INSERT, Tuple{}, this);
+      if (enable_logging) {
+        version_store_.Record(rids[inserted], txn, nullptr);
+      }
+      dirty = true;
+      inserted++;
+    }
+    // Widen the page's zones before it is released, a scan must not step over the page once it sees the tuples.
+    if (zone_map_ != nullptr && dirty) {
+      zone_map_->Record(cur_page->GetTablePageId(), tuples + first, inserted - first);
+    }
+    // A tuple that does not fit an empty page (the columns of a wide PAX or compressed row take more than the tuple
+    // itself) never will, give up instead of appending pages forever.
+    if (appended && !dirty) {
+      free_space_map->Update(cur_page->GetTablePageId(), cur_page->GetFreeSpaceRemaining());
       cur_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-      cur_page = new_page;
+      return abort();
     }
+    // Record what the page has left. This also corrects an entry that promised more room than the page had, so the
+    // map does not hand out the same page for this tuple again.
+    free_space_map->Update(cur_page->GetTablePageId(), cur_page->GetFreeSpaceRemaining());
+    cur_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), dirty);
   }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-  // Update the transaction's write set.
-  txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
   return true;
 }
 
+auto TableHeap::MoveToOverflow(const Tuple &tuple, Tuple *stored) -> bool {
+  // The payload of every VARCHAR column, where it is and how long it is stored inline. A tuple already pointing to
+  // overflow pages is a stored version being put back (a rollback), it goes back as it was.
+  size_t varlen_count = varlen_offsets_.size();
+  std::vector<uint32_t> offsets(varlen_count);
+  std::vector<uint32_t> sizes(varlen_count);
+  std::vector<bool> movable(varlen_count);
+  for (size_t i = 0; i < varlen_count; i++) {
+    offsets[i] = *reinterpret_cast<const uint32_t *>(tuple.data_ + varlen_offsets_[i]);
+    uint32_t length = *reinterpret_cast<const uint32_t *>(tuple.data_ + offsets[i]);
+    if (length == BUSTUB_VALUE_NULL) {
+      sizes[i] = sizeof(uint32_t);
+    } else if ((length & Tuple::OVERFLOW_FLAG) != 0) {
+      return true;
+    } else {
+      sizes[i] = sizeof(uint32_t) + length;
+      movable[i] = sizes[i] > Tuple::OVERFLOW_PAYLOAD_SIZE;
+    }
+  }
+
+  // Move the largest values first, the fewest chains bring the tuple under the threshold.
+  std::vector<size_t> order(varlen_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+  std::vector<page_id_t> chains(varlen_count, INVALID_PAGE_ID);
+  uint32_t size = tuple.size_;
+  for (size_t i : order) {
+    if (size <= TOAST_THRESHOLD) {
+      break;
+    }
+    if (!movable[i]) {
+      continue;
+    }
+    chains[i] = OverflowPage::WriteChain(buffer_pool_manager_, tuple.data_ + offsets[i] + sizeof(uint32_t),
+                                         sizes[i] - sizeof(uint32_t));
+    if (chains[i] == INVALID_PAGE_ID) {
+      for (page_id_t chain : chains) {
+        if (chain != INVALID_PAGE_ID) {
+          OverflowPage::FreeChain(buffer_pool_manager_, chain);
+        }
+      }
+      return false;
+    }
+    size -= sizes[i] - Tuple::OVERFLOW_PAYLOAD_SIZE;
+  }
+
+  // Rebuild the tuple: the fixed part, then the payloads in column order, moved ones replaced by their pointer.
+  char *data = new char[size];
+  memcpy(data, tuple.data_, row_length_);
+  uint32_t offset = row_length_;
+  for (size_t i = 0; i < varlen_count; i++) {
+    *reinterpret_cast<uint32_t *>(data + varlen_offsets_[i]) = offset;
+    if (chains[i] == INVALID_PAGE_ID) {
+      memcpy(data + offset, tuple.data_ + offsets[i], sizes[i]);
+      offset += sizes[i];
+      continue;
+    }
+    uint32_t length = (sizes[i] - sizeof(uint32_t)) | Tuple::OVERFLOW_FLAG;
+    memcpy(data + offset, &length, sizeof(uint32_t));
+    memcpy(data + offset + sizeof(uint32_t), &chains[i], sizeof(page_id_t));
+    offset += Tuple::OVERFLOW_PAYLOAD_SIZE;
+  }
+  BUSTUB_ASSERT(offset == size, "A tuple must be its fixed part followed by its payloads.");
+  if (stored->allocated_) {
+    delete[] stored->data_;
+  }
+  stored->data_ = data;
+  stored->size_ = size;
+  stored->rid_ = tuple.rid_;
+  stored->allocated_ = true;
+  return true;
+}
+
+void TableHeap::FreeOverflow(const Tuple &tuple) {
+  if (!CanOverflow() || tuple.size_ == 0) {
+    return;
+  }
+  for (uint32_t varlen_offset : varlen_offsets_) {
+    uint32_t offset = *reinterpret_cast<const uint32_t *>(tuple.data_ + varlen_offset);
+    uint32_t length = *reinterpret_cast<const uint32_t *>(tuple.data_ + offset);
+    if (length != BUSTUB_VALUE_NULL && (length & Tuple::OVERFLOW_FLAG) != 0) {
+      page_id_t first_page_id = *reinterpret_cast<const page_id_t *>(tuple.data_ + offset + sizeof(uint32_t));
+      OverflowPage::FreeChain(buffer_pool_manager_, first_page_id);
+    }
+  }
+}
+
+auto TableHeap::CopyVersion(const Tuple &stored) -> Tuple {
+  Tuple copy;
+  copy.rid_ = stored.rid_;
+  copy.allocated_ = true;
+  // The size of the tuple with every payload moved to overflow pages read back.
+  uint32_t size = stored.size_;
+  if (CanOverflow()) {
+    for (uint32_t varlen_offset : varlen_offsets_) {
+      uint32_t offset = *reinterpret_cast<const uint32_t *>(stored.data_ + varlen_offset);
+      uint32_t length = *reinterpret_cast<const uint32_t *>(stored.data_ + offset);
+      if (length != BUSTUB_VALUE_NULL && (length & Tuple::OVERFLOW_FLAG) != 0) {
+        size += sizeof(uint32_t) + (length & ~Tuple::OVERFLOW_FLAG) - Tuple::OVERFLOW_PAYLOAD_SIZE;
+      }
+    }
+  }
+  copy.size_ = size;
+  copy.data_ = new char[size];
+  if (size == stored.size_) {
+    memcpy(copy.data_, stored.data_, size);
+    return copy;
+  }
+
+  // Rebuild the tuple, the inverse of MoveToOverflow: the fixed part, then the payloads in column order.
+  memcpy(copy.data_, stored.data_, row_length_);
+  uint32_t offset = row_length_;
+  for (uint32_t varlen_offset : varlen_offsets_) {
+    uint32_t stored_offset = *reinterpret_cast<const uint32_t *>(stored.data_ + varlen_offset);
+    uint32_t length = *reinterpret_cast<const uint32_t *>(stored.data_ + stored_offset);
+    *reinterpret_cast<uint32_t *>(copy.data_ + varlen_offset) = offset;
+    if (length == BUSTUB_VALUE_NULL || (length & Tuple::OVERFLOW_FLAG) == 0) {
+      uint32_t payload_size = sizeof(uint32_t) + (length == BUSTUB_VALUE_NULL ? 0 : length);
+      memcpy(copy.data_ + offset, stored.data_ + stored_offset, payload_size);
+      offset += payload_size;
+      continue;
+    }
+    length &= ~Tuple::OVERFLOW_FLAG;
+    page_id_t first_page_id = *reinterpret_cast<const page_id_t *>(stored.data_ + stored_offset + sizeof(uint32_t));
+    memcpy(copy.data_ + offset, &length, sizeof(uint32_t));
+    OverflowPage::ReadChain(buffer_pool_manager_, first_page_id, length, copy.data_ + offset + sizeof(uint32_t));
+    offset += sizeof(uint32_t) + length;
+  }
+  return copy;
+}
+
+auto TableHeap::LockForSnapshotWrite(const RID &rid, Transaction *txn) -> bool {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (!txn->IsExclusiveLocked(rid)) {
+    bool locked = txn->IsSharedLocked(rid) ? lock_manager_->LockUpgrade(txn, rid, table_oid_)
+                                           : lock_manager_->LockExclusive(txn, rid, table_oid_);
+    if (!locked) {
+      return false;
+    }
+  }
+  // With the lock held no other transaction writes the row until we are done. One that committed a write after our
+  // snapshot began wins, ours would overwrite a version we never saw.
+  if (version_store_.IsWriteConflict(rid, txn)) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  return true;
+}
+
+auto TableHeap::AppendPage(Transaction *txn, const Tuple &tuple) -> TablePage * {
+  std::scoped_lock lock(append_latch_);
+  page_id_t last_page_id = GetFreeSpaceMap()->GetLastPageId();
+  auto last_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id));
+  if (last_page == nullptr) {
+    return nullptr;
+  }
+  page_id_t new_page_id;
+  auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&new_page_id));
+  if (new_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+    return nullptr;
+  }
+  // Initialize the new page and link it after the last one.
+  new_page->WLatch();
+  last_page->WLatch();
+  last_page->SetNextPageId(new_page_id);
+  if (format_ == TablePageFormat::PAX) {
+    uint32_t varlen_hint = tuple.size_ - row_length_;
+    static_cast<PaxPage *>(new_page)->Init(new_page_id, last_page_id, log_manager_, txn,
+                                           static_cast<PaxPage *>(last_page), varlen_hint);
+  } else if (format_ == TablePageFormat::COMPRESSED) {
+    static_cast<CompressedPage *>(new_page)->Init(new_page_id, last_page_id, log_manager_, txn,
+                                                  static_cast<CompressedPage *>(last_page));
+  } else {
+    new_page->Init(new_page_id, PAGE_SIZE, last_page_id, log_manager_, txn);
+  }
+  last_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(last_page_id, true);
+  free_space_map_->Update(new_page_id, new_page->GetFreeSpaceRemaining());
+  if (zone_map_ != nullptr) {
+    zone_map_->AddPage(new_page_id);
+  }
+  return new_page;
+}
+
 auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
   // TODO(Amadou): remove empty page
   // Find the page which contains the tuple.
@@ -99,9 +437,19 @@ auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  // Otherwise, mark the tuple as deleted.
+  if (ReadsSnapshot(txn) && !LockForSnapshotWrite(rid, txn)) {
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+    return false;
+  }
+  // Otherwise, mark the tuple as deleted. Snapshots from before the delete still see the tuple as it was.
   page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  Tuple view;
+  bool versioned = enable_logging && page->GetTupleView(rid, &view);
+  if (page->MarkDelete(rid, txn, lock_manager_, table_oid_, log_manager_) && versioned) {
+    view.overflow_bpm_ = buffer_pool_manager_;
+    Tuple old_tuple = CopyVersion(view);
+    version_store_.Record(rid, txn, &old_tuple);
+  }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
   // Update the transaction's write set.
@@ -110,6 +458,14 @@ auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
 }
 
 auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) -> bool {
+  return ReplaceTuple(tuple, rid, txn, false);
+}
+
+void TableHeap::RollbackUpdate(const Tuple &old_tuple, const RID &rid, Transaction *txn) {
+  ReplaceTuple(old_tuple, rid, txn, true);
+}
+
+auto TableHeap::ReplaceTuple(const Tuple &tuple, const RID &rid, Transaction *txn, bool rollback) -> bool {
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
@@ -117,17 +473,45 @@ auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  // A transaction rolling back its update has the lock already.
+  if (!rollback && ReadsSnapshot(txn) && !LockForSnapshotWrite(rid, txn)) {
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+    return false;
+  }
+  // A long new version is stored with its large values moved out of line, like an insert.
+  Tuple overflowed;
+  if (CanOverflow() && tuple.size_ > TOAST_THRESHOLD && !MoveToOverflow(tuple, &overflowed)) {
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  const Tuple &new_tuple = overflowed.size_ != 0 ? overflowed : tuple;
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
+  FreeSpaceMap *free_space_map = GetFreeSpaceMap();
   page->WLatch();
-  bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
-  if(!is_updated) {
-    // std::cout<<"TableHeap::UpdateTuple not updated\n";
+  bool is_updated = page->UpdateTuple(new_tuple, &old_tuple, rid, txn, lock_manager_, table_oid_, log_manager_);
+  if (is_updated) {
+    free_space_map->Update(rid.GetPageId(), page->GetFreeSpaceRemaining());
+    if (zone_map_ != nullptr) {
+      zone_map_->Record(rid.GetPageId(), &tuple, 1);
+    }
+    // A rollback puts back the version the transaction recorded, which is dropped from the store when it is done.
+    if (enable_logging && !rollback) {
+      old_tuple.overflow_bpm_ = buffer_pool_manager_;
+      Tuple old_version = CopyVersion(old_tuple);
+      version_store_.Record(rid, txn, &old_version);
+    }
   }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
-  // Update the transaction's write set.
-  if (is_updated && txn->GetState() != TransactionState::ABORTED) {
+  if (!is_updated) {
+    FreeOverflow(overflowed);
+  } else if (rollback) {
+    // Rolling back, the version replaced was the transaction's own and nothing points to its chains any more.
+    FreeOverflow(old_tuple);
+  } else {
+    // Update the transaction's write set.
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
   }
   return is_updated;
@@ -137,12 +521,18 @@ void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  // Open the free-space map before latching, opening it may have to read this page.
+  FreeSpaceMap *free_space_map = GetFreeSpaceMap();
   // Delete the tuple from the page.
+  Tuple delete_tuple;
   page->WLatch();
-  page->ApplyDelete(rid, txn, log_manager_);
+  page->ApplyDelete(rid, txn, log_manager_, &delete_tuple);
   lock_manager_->Unlock(txn, rid);
+  // The tuple's space can be reused right away.
+  free_space_map->Update(rid.GetPageId(), page->GetFreeSpaceRemaining());
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  FreeOverflow(delete_tuple);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
@@ -166,32 +556,64 @@ auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  // Read the tuple from the page.
+  // Read the tuple from the page. A SNAPSHOT transaction reads the version of its snapshot without locking it.
   page->RLatch();
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
+  bool res;
+  if (ReadsSnapshot(txn)) {
+    VersionVisibility visibility = version_store_.Read(rid, txn, tuple);
+    Tuple view;
+    res = visibility == VersionVisibility::OLDER ||
+          (visibility == VersionVisibility::CURRENT && page->GetTupleView(rid, &view));
+    if (visibility == VersionVisibility::CURRENT && res) {
+      // The overflow pages of the version may be freed once a writer replaces it, read them now.
+      view.overflow_bpm_ = buffer_pool_manager_;
+      *tuple = CopyVersion(view);
+    }
+  } else {
+    res = page->GetTuple(rid, tuple, txn, lock_manager_, table_oid_);
+    tuple->overflow_bpm_ = buffer_pool_manager_;
+  }
   page->RUnlatch();
   buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
   return res;
 }
 
-auto TableHeap::Begin(Transaction *txn) -> TableIterator {
-  // Start an iterator from the first page.
-  // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
-  RID rid;
-  auto page_id = first_page_id_;
+auto TableHeap::Vacuum() -> size_t {
+  // Opening the free-space map reads the format of an opened heap. PAX and compressed pages are not compacted.
+  FreeSpaceMap *free_space_map = GetFreeSpaceMap();
+  if (format_ != TablePageFormat::SLOTTED) {
+    return 0;
+  }
+  size_t reclaimed = 0;
+  page_id_t page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
     auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-    page->RLatch();
-    // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
-    auto found_tuple = page->GetFirstTupleRid(&rid);
-    page->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page_id, false);
-    if (found_tuple) {
+    if (page == nullptr) {
       break;
     }
-    page_id = page->GetNextPageId();
+    page->WLatch();
+    uint32_t page_reclaimed = page->ReclaimSlots();
+    free_space_map->Update(page_id, page->GetFreeSpaceRemaining());
+    page_id_t next_page_id = page->GetNextPageId();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, page_reclaimed > 0);
+    reclaimed += page_reclaimed;
+    page_id = next_page_id;
   }
-  return TableIterator(this, rid, txn);
+  return reclaimed;
+}
+
+auto TableHeap::Begin(Transaction *txn) -> TableIterator { return Begin(txn, nullptr, nullptr, nullptr); }
+
+auto TableHeap::Begin(Transaction *txn, const AbstractExpression *predicate, const Schema *schema,
+                      const Schema *out_schema) -> TableIterator {
+  // Start from the first slot of the first page; the iterator skips deleted slots and empty pages itself.
+  return TableIterator(this, RID(first_page_id_, 0), txn, predicate, schema, out_schema);
+}
+
+auto TableHeap::Begin(Transaction *txn, const AbstractExpression *predicate, const Schema *schema,
+                      const Schema *out_schema, page_id_t first_page_id, page_id_t stop_page_id) -> TableIterator {
+  return TableIterator(this, RID(first_page_id, 0), txn, predicate, schema, out_schema, stop_page_id);
 }
 
 auto TableHeap::End() -> TableIterator { return TableIterator(this, RID(INVALID_PAGE_ID, 0), nullptr); }
@@ -10,16 +10,41 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
 
+#include "execution/expressions/column_value_expression.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, const AbstractExpression *predicate,
+                             const Schema *schema, const Schema *out_schema, page_id_t stop_page_id)
+    : table_heap_(table_heap),
+      tuple_(new Tuple(rid)),
+      txn_(txn),
+      predicate_(predicate),
+      schema_(schema),
+      out_schema_(out_schema),
+      stop_page_id_(stop_page_id) {
+  assert((predicate_ == nullptr && out_schema_ == nullptr) || schema_ != nullptr);
+  // Without a projection the whole stored tuple is returned, which needs every column.
+  if (out_schema_ != nullptr) {
+    pax_columns_.assign(schema_->GetColumnCount(), false);
+    CollectColumns(predicate_, &pax_columns_);
+    for (const auto &column : out_schema_->GetColumns()) {
+      if (column.GetExpr() != nullptr) {
+        CollectColumns(column.GetExpr(), &pax_columns_);
+      } else {
+        pax_columns_[schema_->GetColIdx(column.GetName())] = true;
+      }
+    }
+  }
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    Seek(rid, true);
   }
 }
 
@@ -34,34 +59,213 @@ auto TableIterator::operator->() -> Tuple * {
 }
 
 auto TableIterator::operator++() -> TableIterator & {
+  Seek(tuple_->rid_, false);
+  return *this;
+}
+
+void TableIterator::Seek(RID rid, bool inclusive) {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
-
-  RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
+  ZoneMap *zone_map = table_heap_->GetZoneMap();
+  page_id_t page_id = rid.GetPageId();
+  Tuple view;
+  view.overflow_bpm_ = buffer_pool_manager;
+  while (page_id != INVALID_PAGE_ID && page_id != stop_page_id_) {
+    if (page_id == pax_page_id_) {
+      if (NextPaxRow()) {
+        return;
+      }
+      page_id = pax_next_page_id_;
+      pax_page_id_ = INVALID_PAGE_ID;
+      pax_rows_.clear();
+      continue;
+    }
+
+    // A page whose zones rule the predicate out holds no qualifying tuple and is not fetched at all. The page the scan
+    // is on passed this check when the scan got there.
+    if (predicate_ != nullptr && zone_map != nullptr && (inclusive || page_id != rid.GetPageId())) {
+      page_id = zone_map->Skip(page_id, stop_page_id_, predicate_);
+      if (page_id == INVALID_PAGE_ID || page_id == stop_page_id_) {
         break;
       }
     }
+
+    auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id));
+    assert(cur_page != nullptr);  // all pages are pinned
+    cur_page->RLatch();
+
+    if (!enable_logging && cur_page->GetFormat() != TablePageFormat::SLOTTED) {
+      uint32_t first_slot = 0;
+      if (rid.GetPageId() == page_id) {
+        first_slot = inclusive ? rid.GetSlotNum() : rid.GetSlotNum() + 1;
+      }
+      pax_rows_.clear();
+      if (cur_page->GetFormat() == TablePageFormat::PAX) {
+        static_cast<PaxPage *>(cur_page)->ReadRows(first_slot, pax_columns_, &pax_rows_);
+      } else {
+        static_cast<CompressedPage *>(cur_page)->ReadRows(first_slot, pax_columns_, &pax_rows_);
+      }
+      pax_pos_ = 0;
+      pax_page_id_ = page_id;
+      pax_next_page_id_ = cur_page->GetNextPageId();
+      cur_page->RUnlatch();
+      buffer_pool_manager->UnpinPage(page_id, false);
+      continue;
+    }
+
+    // A SNAPSHOT transaction sees the rows of the page with versions as of its snapshot, including the ones the heap no
+    // longer has. They are read when the scan gets to the page, and again only if a writer recorded versions since.
+    std::vector<VersionStore::VersionedSlot> no_versions;
+    std::vector<VersionStore::VersionedSlot> &versions = TableHeap::ReadsSnapshot(txn_) ? versions_ : no_versions;
+    if (TableHeap::ReadsSnapshot(txn_)) {
+      uint64_t records = table_heap_->version_store_.GetRecordCount(page_id);
+      if (page_id != versions_page_id_ || records != versions_records_) {
+        table_heap_->version_store_.ReadPage(page_id, txn_, &versions_);
+        versions_page_id_ = page_id;
+        versions_records_ = records;
+      }
+    }
+    uint32_t first_slot = rid.GetPageId() != page_id ? 0 : rid.GetSlotNum() + (inclusive ? 0 : 1);
+    auto version = std::find_if(versions.begin(), versions.end(),
+                                [first_slot](const VersionStore::VersionedSlot &v) { return v.slot_ >= first_slot; });
+
+    bool found;
+    if (rid.GetPageId() != page_id) {
+      found = cur_page->GetFirstTupleRid(&rid);
+    } else if (inclusive) {
+      found = true;
+    } else {
+      found = cur_page->GetNextTupleRid(rid, &rid);
+    }
+
+    // Walk the heap's rows and the rows with versions together, by slot.
+    while (found || version != versions.end()) {
+      const Tuple *row = &view;
+      if (version != versions.end() && (!found || version->slot_ <= rid.GetSlotNum())) {
+        RID version_rid(page_id, version->slot_);
+        if (found && version->slot_ == rid.GetSlotNum()) {
+          found = cur_page->GetNextTupleRid(rid, &rid);
+        }
+        bool visible =
+            version->visibility_ == VersionVisibility::OLDER ||
+            (version->visibility_ == VersionVisibility::CURRENT && cur_page->GetTupleView(version_rid, &view));
+        if (version->visibility_ == VersionVisibility::OLDER) {
+          version->tuple_.rid_ = version_rid;
+          row = &version->tuple_;
+        }
+        ++version;
+        if (!visible) {
+          continue;
+        }
+      } else {
+        bool visible = cur_page->GetTupleView(rid, &view);
+        found = cur_page->GetNextTupleRid(rid, &rid);
+        if (!visible) {
+          continue;
+        }
+      }
+      if (predicate_ != nullptr && !predicate_->Evaluate(row, schema_).GetAs<bool>()) {
+        continue;
+      }
+      bool materialized;
+      try {
+        materialized = Materialize(*row);
+      } catch (...) {
+        cur_page->RUnlatch();
+        buffer_pool_manager->UnpinPage(page_id, false);
+        throw;
+      }
+      if (materialized) {
+        // release until copy the tuple
+        cur_page->RUnlatch();
+        buffer_pool_manager->UnpinPage(page_id, false);
+        return;
+      }
+      // We could not lock the tuple, the transaction is aborted and the scan is over.
+      cur_page->RUnlatch();
+      buffer_pool_manager->UnpinPage(page_id, false);
+      tuple_->rid_ = RID(INVALID_PAGE_ID, 0);
+      return;
+    }
+
+    page_id_t next_page_id = cur_page->GetNextPageId();
+    cur_page->RUnlatch();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  tuple_->rid_ = RID(INVALID_PAGE_ID, 0);
+}
+
+auto TableIterator::Materialize(const Tuple &view) -> bool {
+  const RID &rid = view.rid_;
+  bool snapshot = TableHeap::ReadsSnapshot(txn_);
+  if (enable_logging && !snapshot) {
+    LockManager *lock_manager = table_heap_->lock_manager_;
+    if (!txn_->IsSharedLocked(rid) && !txn_->IsExclusiveLocked(rid) &&
+        !lock_manager->LockShared(txn_, rid, table_heap_->table_oid_)) {
+      return false;
+    }
   }
-  tuple_->rid_ = next_tuple_rid;
 
-  if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+  if (out_schema_ == nullptr && snapshot) {
+    // The overflow pages of the row may be freed once a writer replaces it, they are read now.
+    *tuple_ = table_heap_->CopyVersion(view);
+    tuple_->overflow_bpm_ = view.overflow_bpm_;
+    return true;
+  }
+  if (out_schema_ == nullptr) {
+    if (tuple_->allocated_) {
+      delete[] tuple_->data_;
+    }
+    tuple_->data_ = new char[view.size_];
+    memcpy(tuple_->data_, view.data_, view.size_);
+    tuple_->size_ = view.size_;
+    tuple_->allocated_ = true;
+    tuple_->rid_ = rid;
+    tuple_->overflow_bpm_ = view.overflow_bpm_;
+    return true;
+  }
+
+  std::vector<Value> values;
+  values.reserve(out_schema_->GetColumnCount());
+  for (const auto &column : out_schema_->GetColumns()) {
+    if (column.GetExpr() != nullptr) {
+      values.push_back(column.GetExpr()->Evaluate(&view, schema_));
+    } else {
+      values.push_back(view.GetValue(schema_, schema_->GetColIdx(column.GetName())));
+    }
+  }
+  *tuple_ = Tuple(std::move(values), out_schema_);
+  tuple_->rid_ = rid;
+  return true;
+}
+
+auto TableIterator::NextPaxRow() -> bool {
+  while (pax_pos_ < pax_rows_.size()) {
+    Tuple &row = pax_rows_[pax_pos_++];
+    if (predicate_ != nullptr && !predicate_->Evaluate(&row, schema_).GetAs<bool>()) {
+      continue;
+    }
+    if (out_schema_ == nullptr) {
+      *tuple_ = std::move(row);
+    } else {
+      Materialize(row);
+    }
+    return true;
+  }
+  return false;
+}
+
+void TableIterator::CollectColumns(const AbstractExpression *expr, std::vector<bool> *columns) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr);
+      column != nullptr && column->GetColIdx() < columns->size()) {
+    (*columns)[column->GetColIdx()] = true;
+  }
+  for (const auto *child : expr->GetChildren()) {
+    CollectColumns(child, columns);
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-  return *this;
 }
 
 auto TableIterator::operator++(int) -> TableIterator {
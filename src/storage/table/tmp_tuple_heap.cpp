@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tmp_tuple_heap.cpp
+//
+// Identification: src/storage/table/tmp_tuple_heap.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/tmp_tuple_heap.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+TmpTupleHeap::TmpTupleHeap(BufferPoolManager *buffer_pool_manager)
+    : buffer_pool_manager_(buffer_pool_manager), write_buffer_(std::make_unique<TmpTuplePage>()) {
+  write_buffer_->Init(INVALID_PAGE_ID, PAGE_SIZE);
+}
+
+TmpTupleHeap::~TmpTupleHeap() {
+  ReleaseReadPage();
+  for (auto page_id : page_ids_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+}
+
+void TmpTupleHeap::Append(const Tuple &tuple) {
+  BUSTUB_ASSERT(read_page_ == nullptr && read_page_idx_ == 0, "Cannot append to a run that is being read.");
+  TmpTuple out(INVALID_PAGE_ID, 0);
+  if (!write_buffer_->Insert(tuple, &out)) {
+    FlushBuffer();
+    if (!write_buffer_->Insert(tuple, &out)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "Tuple is too large for a temporary page.");
+    }
+  }
+  tuple_count_++;
+  byte_size_ += tuple.GetLength();
+}
+
+void TmpTupleHeap::Append(const char *data, uint32_t size) {
+  Tuple view;
+  view.data_ = const_cast<char *>(data);
+  view.size_ = size;
+  Append(view);
+}
+
+void TmpTupleHeap::FlushBuffer() {
+  if (write_buffer_->GetFreeSpacePointer() == PAGE_SIZE) {
+    return;
+  }
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Out of buffer pool frames while spilling tuples.");
+  }
+  memcpy(page->GetData(), write_buffer_->GetData(), PAGE_SIZE);
+  memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  page_ids_.push_back(page_id);
+  write_buffer_->Init(INVALID_PAGE_ID, PAGE_SIZE);
+}
+
+auto TmpTupleHeap::Next(Tuple *tuple) -> bool {
+  // The tail of the run still sits in the write buffer the first time we read.
+  FlushBuffer();
+  while (read_page_ == nullptr || read_pos_ == read_offsets_.size()) {
+    ReleaseReadPage();
+    if (read_page_idx_ == page_ids_.size() || !LoadReadPage()) {
+      return false;
+    }
+  }
+  read_page_->Get(TmpTuple(read_page_->GetTablePageId(), read_offsets_[read_pos_++]), tuple);
+  tuple->rid_ = RID();
+  return true;
+}
+
+void TmpTupleHeap::Rewind() {
+  ReleaseReadPage();
+  read_page_idx_ = 0;
+}
+
+auto TmpTupleHeap::LoadReadPage() -> bool {
+  auto page = buffer_pool_manager_->FetchPage(page_ids_[read_page_idx_++]);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Out of buffer pool frames while reading spilled tuples.");
+  }
+  read_page_ = reinterpret_cast<TmpTuplePage *>(page);
+  read_offsets_.clear();
+  read_pos_ = 0;
+  // Tuples grow down from the end of the page, so walking up from the free space pointer visits the newest first.
+  for (uint32_t offset = read_page_->GetFreeSpacePointer(); offset < PAGE_SIZE;
+       offset = read_page_->GetNextOffset(offset)) {
+    read_offsets_.push_back(offset);
+  }
+  std::reverse(read_offsets_.begin(), read_offsets_.end());
+  return true;
+}
+
+void TmpTupleHeap::ReleaseReadPage() {
+  if (read_page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(read_page_->GetPageId(), false);
+    read_page_ = nullptr;
+  }
+}
+
+}  // namespace bustub
@@ -16,6 +16,7 @@
 #include <string>
 #include <vector>
 
+#include "storage/page/overflow_page.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -59,7 +60,8 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
   }
 }
 
-Tuple::Tuple(const Tuple &other) : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_) {
+Tuple::Tuple(const Tuple &other)
+    : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_), overflow_bpm_(other.overflow_bpm_) {
   if (allocated_) {
     delete[] data_;
   }
@@ -80,6 +82,7 @@ auto Tuple::operator=(const Tuple &other) -> Tuple & {
   allocated_ = other.allocated_;
   rid_ = other.rid_;
   size_ = other.size_;
+  overflow_bpm_ = other.overflow_bpm_;
 
   if (allocated_) {
     // Deep copy.
@@ -93,16 +96,57 @@ auto Tuple::operator=(const Tuple &other) -> Tuple & {
   return *this;
 }
 
+Tuple::Tuple(Tuple &&other) noexcept
+    : allocated_(other.allocated_),
+      rid_(other.rid_),
+      size_(other.size_),
+      data_(other.data_),
+      overflow_bpm_(other.overflow_bpm_) {
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
+}
+
+auto Tuple::operator=(Tuple &&other) noexcept -> Tuple & {
+  if (this == &other) {
+    return *this;
+  }
+  if (allocated_) {
+    delete[] data_;
+  }
+  allocated_ = other.allocated_;
+  rid_ = other.rid_;
+  size_ = other.size_;
+  data_ = other.data_;
+  overflow_bpm_ = other.overflow_bpm_;
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
+  return *this;
+}
+
 auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
   assert(schema);
   assert(data_);
   const TypeId column_type = schema->GetColumn(column_idx).GetType();
   const char *data_ptr = GetDataPtr(schema, column_idx);
+  if (column_type == TypeId::VARCHAR) {
+    uint32_t length = *reinterpret_cast<const uint32_t *>(data_ptr);
+    if (length != BUSTUB_VALUE_NULL && (length & OVERFLOW_FLAG) != 0) {
+      // The value was moved to overflow pages, it is only read now that the column is asked for.
+      BUSTUB_ASSERT(overflow_bpm_ != nullptr, "A tuple with overflow values must come from its table heap.");
+      length &= ~OVERFLOW_FLAG;
+      page_id_t first_page_id = *reinterpret_cast<const page_id_t *>(data_ptr + sizeof(uint32_t));
+      std::vector<char> data(length);
+      OverflowPage::ReadChain(overflow_bpm_, first_page_id, length, data.data());
+      return Value(TypeId::VARCHAR, data.data(), length, true);
+    }
+  }
   // the third parameter "is_inlined" is unused
   return Value::DeserializeFrom(data_ptr, column_type);
 }
 
-auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs)
+auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const
     -> Tuple {
   std::vector<Value> values;
   values.reserve(key_attrs.size());
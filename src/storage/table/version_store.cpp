@@ -0,0 +1,192 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.cpp
+//
+// Identification: src/storage/table/version_store.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/version_store.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bustub {
+
+void VersionStore::Record(const RID &rid, Transaction *txn, const Tuple *old_tuple) {
+  Partition *partition = GetPartition(rid.GetPageId());
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  partition->records_++;
+  VersionChain &chain = partition->pages_[rid.GetPageId()][rid.GetSlotNum()];
+  if (chain.writer_ == txn->GetTransactionId()) {
+    // The version before the transaction's first write is recorded already.
+    return;
+  }
+  // A row without a chain is visible to everyone, as is the version it had.
+  chain.versions_.push_front(
+      Version{chain.head_ts_, old_tuple != nullptr, old_tuple != nullptr ? *old_tuple : Tuple{}});
+  chain.writer_ = txn->GetTransactionId();
+}
+
+auto VersionStore::IsWriteConflict(const RID &rid, Transaction *txn) -> bool {
+  Partition *partition = GetPartition(rid.GetPageId());
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  auto page = partition->pages_.find(rid.GetPageId());
+  if (page == partition->pages_.end()) {
+    return false;
+  }
+  auto chain = page->second.find(rid.GetSlotNum());
+  return chain != page->second.end() && chain->second.writer_ == INVALID_TXN_ID &&
+         chain->second.head_ts_ > txn->GetReadTs();
+}
+
+void VersionStore::Commit(const RID &rid, Transaction *txn, timestamp_t commit_ts, timestamp_t watermark) {
+  Partition *partition = GetPartition(rid.GetPageId());
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  auto page = partition->pages_.find(rid.GetPageId());
+  if (page == partition->pages_.end()) {
+    return;
+  }
+  auto chain = page->second.find(rid.GetSlotNum());
+  if (chain == page->second.end() || chain->second.writer_ != txn->GetTransactionId()) {
+    return;
+  }
+  chain->second.writer_ = INVALID_TXN_ID;
+  chain->second.head_ts_ = commit_ts;
+  if (!Prune(&chain->second, watermark)) {
+    partition->retained_.insert(rid);
+  } else {
+    page->second.erase(chain);
+    if (page->second.empty()) {
+      partition->pages_.erase(page);
+    }
+  }
+  if (watermark <= partition->watermark_) {
+    return;
+  }
+
+  // The oldest snapshot moved on, the chains kept for it are pruned along.
+  partition->watermark_ = watermark;
+  for (auto retained = partition->retained_.begin(); retained != partition->retained_.end();) {
+    auto retained_page = partition->pages_.find(retained->GetPageId());
+    if (retained_page == partition->pages_.end()) {
+      retained = partition->retained_.erase(retained);
+      continue;
+    }
+    auto retained_chain = retained_page->second.find(retained->GetSlotNum());
+    if (retained_chain == retained_page->second.end() || retained_chain->second.writer_ != INVALID_TXN_ID) {
+      // Gone, or written again and retained once more if need be when its writer commits.
+      retained = partition->retained_.erase(retained);
+      continue;
+    }
+    if (!Prune(&retained_chain->second, watermark)) {
+      ++retained;
+      continue;
+    }
+    retained_page->second.erase(retained_chain);
+    if (retained_page->second.empty()) {
+      partition->pages_.erase(retained_page);
+    }
+    retained = partition->retained_.erase(retained);
+  }
+}
+
+void VersionStore::Rollback(const RID &rid, Transaction *txn) {
+  Partition *partition = GetPartition(rid.GetPageId());
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  auto page = partition->pages_.find(rid.GetPageId());
+  if (page == partition->pages_.end()) {
+    return;
+  }
+  auto chain = page->second.find(rid.GetSlotNum());
+  if (chain == page->second.end() || chain->second.writer_ != txn->GetTransactionId()) {
+    return;
+  }
+  // The heap is back to the version recorded, which begins where it did.
+  chain->second.writer_ = INVALID_TXN_ID;
+  chain->second.head_ts_ = chain->second.versions_.front().begin_ts_;
+  chain->second.versions_.pop_front();
+  if (chain->second.versions_.empty()) {
+    page->second.erase(chain);
+    if (page->second.empty()) {
+      partition->pages_.erase(page);
+    }
+  } else {
+    partition->retained_.insert(rid);
+  }
+}
+
+auto VersionStore::Prune(VersionChain *chain, timestamp_t watermark) -> bool {
+  if (chain->writer_ != INVALID_TXN_ID) {
+    return false;
+  }
+  // Every running snapshot reads at watermark or later. Once the heap's version is visible to all of them the chain
+  // is no longer needed, otherwise the oldest of them needs the newest version beginning at or before watermark.
+  if (chain->head_ts_ <= watermark) {
+    return true;
+  }
+  auto oldest_needed = std::find_if(chain->versions_.begin(), chain->versions_.end(),
+                                    [watermark](const Version &version) { return version.begin_ts_ <= watermark; });
+  if (oldest_needed != chain->versions_.end()) {
+    chain->versions_.erase(oldest_needed + 1, chain->versions_.end());
+  }
+  return false;
+}
+
+auto VersionStore::Resolve(const VersionChain &chain, Transaction *txn, Tuple *tuple) -> VersionVisibility {
+  if (chain.writer_ == txn->GetTransactionId() ||
+      (chain.writer_ == INVALID_TXN_ID && chain.head_ts_ <= txn->GetReadTs())) {
+    return VersionVisibility::CURRENT;
+  }
+  for (const Version &version : chain.versions_) {
+    if (version.begin_ts_ <= txn->GetReadTs()) {
+      if (!version.present_) {
+        return VersionVisibility::NONE;
+      }
+      *tuple = version.tuple_;
+      return VersionVisibility::OLDER;
+    }
+  }
+  return VersionVisibility::NONE;
+}
+
+auto VersionStore::Read(const RID &rid, Transaction *txn, Tuple *tuple) -> VersionVisibility {
+  Partition *partition = GetPartition(rid.GetPageId());
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  auto page = partition->pages_.find(rid.GetPageId());
+  if (page == partition->pages_.end()) {
+    return VersionVisibility::CURRENT;
+  }
+  auto chain = page->second.find(rid.GetSlotNum());
+  if (chain == page->second.end()) {
+    return VersionVisibility::CURRENT;
+  }
+  return Resolve(chain->second, txn, tuple);
+}
+
+void VersionStore::ReadPage(page_id_t page_id, Transaction *txn, std::vector<VersionedSlot> *slots) {
+  slots->clear();
+  Partition *partition = GetPartition(page_id);
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  auto page = partition->pages_.find(page_id);
+  if (page == partition->pages_.end()) {
+    return;
+  }
+  for (const auto &[slot, chain] : page->second) {
+    Tuple tuple;
+    VersionVisibility visibility = Resolve(chain, txn, &tuple);
+    slots->push_back(VersionedSlot{slot, visibility, std::move(tuple)});
+  }
+}
+
+auto VersionStore::HasVersions(page_id_t page_id) -> bool {
+  Partition *partition = GetPartition(page_id);
+  std::lock_guard<std::mutex> latch(partition->latch_);
+  return partition->pages_.count(page_id) != 0;
+}
+
+}  // namespace bustub
@@ -0,0 +1,137 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.cpp
+//
+// Identification: src/storage/table/zone_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/zone_map.h"
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+
+namespace bustub {
+
+void ZoneMap::AddPage(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  PageZone &zone = zones_[page_id];
+  zone.columns_.resize(schema_.GetColumnCount());
+  zone.position_ = page_ids_.size();
+  page_ids_.push_back(page_id);
+}
+
+void ZoneMap::Record(page_id_t page_id, const Tuple *tuples, size_t count) {
+  std::scoped_lock lock(latch_);
+  auto it = zones_.find(page_id);
+  BUSTUB_ASSERT(it != zones_.end(), "The page must have been added to the zone map.");
+  std::vector<ColumnZone> &columns = it->second.columns_;
+  for (uint32_t column = 0; column < schema_.GetColumnCount(); column++) {
+    if (!schema_.GetColumn(column).IsInlined()) {
+      continue;
+    }
+    ColumnZone &zone = columns[column];
+    for (size_t i = 0; i < count; i++) {
+      Value value = tuples[i].GetValue(&schema_, column);
+      if (value.IsNull()) {
+        zone.null_count_++;
+      } else if (!zone.has_values_) {
+        zone.min_ = value;
+        zone.max_ = value;
+        zone.has_values_ = true;
+      } else if (value.CompareLessThan(zone.min_) == CmpBool::CmpTrue) {
+        zone.min_ = value;
+      } else if (value.CompareGreaterThan(zone.max_) == CmpBool::CmpTrue) {
+        zone.max_ = value;
+      }
+    }
+  }
+}
+
+auto ZoneMap::Skip(page_id_t page_id, page_id_t stop_page_id, const AbstractExpression *predicate) -> page_id_t {
+  std::scoped_lock lock(latch_);
+  while (page_id != INVALID_PAGE_ID && page_id != stop_page_id) {
+    auto it = zones_.find(page_id);
+    // A page the map does not know yet was just appended, it has to be read.
+    if (it == zones_.end() || MayMatch(it->second, predicate)) {
+      return page_id;
+    }
+    size_t next = it->second.position_ + 1;
+    page_id = next < page_ids_.size() ? page_ids_[next] : INVALID_PAGE_ID;
+  }
+  return stop_page_id;
+}
+
+auto ZoneMap::MayMatch(const PageZone &zone, const AbstractExpression *predicate) -> bool {
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return true;
+  }
+  // Bring the comparison into the form `column <type> constant`.
+  ComparisonType type = comparison->GetComparisonType();
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  if (column == nullptr || constant == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    if (column == nullptr || constant == nullptr) {
+      return true;
+    }
+    switch (type) {
+      case ComparisonType::LessThan:
+        type = ComparisonType::GreaterThan;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        type = ComparisonType::GreaterThanOrEqual;
+        break;
+      case ComparisonType::GreaterThan:
+        type = ComparisonType::LessThan;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        type = ComparisonType::LessThanOrEqual;
+        break;
+      default:
+        break;
+    }
+  }
+
+  uint32_t column_idx = column->GetColIdx();
+  if (column_idx >= zone.columns_.size() || !schema_.GetColumn(column_idx).IsInlined()) {
+    return true;
+  }
+  const ColumnZone &column_zone = zone.columns_[column_idx];
+  Value value = constant->Evaluate(nullptr, nullptr);
+  if (column_zone.null_count_ > 0 || value.IsNull()) {
+    return true;
+  }
+  // Nothing was ever written to the page.
+  if (!column_zone.has_values_) {
+    return false;
+  }
+  const Value &min = column_zone.min_;
+  const Value &max = column_zone.max_;
+  switch (type) {
+    case ComparisonType::Equal:
+      return min.CompareLessThanEquals(value) == CmpBool::CmpTrue &&
+             max.CompareGreaterThanEquals(value) == CmpBool::CmpTrue;
+    case ComparisonType::NotEqual:
+      return min.CompareNotEquals(value) == CmpBool::CmpTrue || max.CompareNotEquals(value) == CmpBool::CmpTrue;
+    case ComparisonType::LessThan:
+      return min.CompareLessThan(value) == CmpBool::CmpTrue;
+    case ComparisonType::LessThanOrEqual:
+      return min.CompareLessThanEquals(value) == CmpBool::CmpTrue;
+    case ComparisonType::GreaterThan:
+      return max.CompareGreaterThan(value) == CmpBool::CmpTrue;
+    case ComparisonType::GreaterThanOrEqual:
+      return max.CompareGreaterThanEquals(value) == CmpBool::CmpTrue;
+    default:
+      return true;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// thread_pool_test.cpp
+//
+// Identification: test/common/thread_pool_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <functional>
+#include <future>  // NOLINT
+#include <stdexcept>
+
+#include "common/thread_pool.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ThreadPoolTest, TaskGroupTest) {
+  ThreadPool pool(4);
+  std::atomic<int> sum{0};
+  {
+    TaskGroup group(&pool);
+    for (int i = 1; i <= 1000; i++) {
+      group.Submit([&sum, i] { sum += i; });
+    }
+    group.Wait();
+    EXPECT_EQ(sum, 500500);
+  }
+
+  // Tasks may submit more tasks of their group, as the drivers of a gather do, and Wait helps running them.
+  std::atomic<int> steps{0};
+  TaskGroup group(&pool);
+  std::function<void(int)> step = [&](int remaining) {
+    steps++;
+    if (remaining > 0) {
+      group.Submit([&step, remaining] { step(remaining - 1); });
+    }
+  };
+  for (int i = 0; i < 8; i++) {
+    group.Submit([&step] { step(99); });
+  }
+  group.Wait();
+  EXPECT_EQ(steps, 800);
+  EXPECT_EQ(pool.GetWorkerIndex(), pool.GetNumThreads());
+}
+
+// NOLINTNEXTLINE
+TEST(ThreadPoolTest, WaitRunsOwnGroupTest) {
+  ThreadPool pool(1);
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> blocked;
+  pool.Submit([&blocked, released] {
+    blocked.set_value();
+    released.wait();
+  });
+  blocked.get_future().wait();
+
+  // The only worker is busy, so waiting for a group runs its tasks here, and those of no other group.
+  std::atomic<bool> other_ran{false};
+  TaskGroup other(&pool);
+  other.Submit([&other_ran] { other_ran = true; });
+  std::atomic<int> ran{0};
+  TaskGroup group(&pool);
+  for (int i = 0; i < 10; i++) {
+    group.Submit([&ran] { ran++; });
+  }
+  group.Wait();
+  EXPECT_EQ(ran, 10);
+  EXPECT_FALSE(other_ran);
+
+  release.set_value();
+  other.Wait();
+  EXPECT_TRUE(other_ran);
+}
+
+// NOLINTNEXTLINE
+TEST(ThreadPoolTest, ErrorTest) {
+  ThreadPool pool(2);
+  TaskGroup group(&pool);
+  std::atomic<int> ran{0};
+  for (int i = 0; i < 100; i++) {
+    group.Submit([&ran, i] {
+      ran++;
+      if (i == 50) {
+        throw std::runtime_error("task failed");
+      }
+    });
+  }
+  EXPECT_THROW(group.Wait(), std::runtime_error);
+  EXPECT_EQ(ran, 100);
+
+  // The error is reported once, the group can be reused.
+  group.Submit([&ran] { ran++; });
+  group.Wait();
+  EXPECT_EQ(ran, 101);
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <atomic>
 #include <cstdio>
 #include <memory>
@@ -33,6 +34,7 @@
 #include "execution/plans/nested_index_join_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "test_util.h"  // NOLINT
 #include "type/value_factory.h"
 
@@ -254,4 +256,92 @@ TEST_F(TransactionTest, DirtyReadsTest) {
   delete txn2;
 }
 
+// NOLINTNEXTLINE
+TEST_F(TransactionTest, SnapshotIndexJoinTest) {
+  // txn1 (SNAPSHOT): begin
+  // txn2: UPDATE inner SET b = b + 100; INSERT INTO inner VALUES (10, 110); commit
+  // txn1: SELECT outer.a, inner.b FROM outer JOIN inner ON outer.a = inner.a
+  // Versions are only kept with logging, like the locks, so the tables get a log manager of their own.
+  DiskManager disk_manager("snapshot_test.db");
+  BufferPoolManagerInstance bpm(64, &disk_manager);
+  LogManager log_manager(&disk_manager);
+  TransactionManager txn_mgr(GetLockManager(), &log_manager);
+  Catalog catalog(&bpm, GetLockManager(), &log_manager);
+  ExecutionEngine execution_engine(&bpm, &txn_mgr, &catalog);
+  Transaction *loader = txn_mgr.Begin();
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::INTEGER)});
+  auto make_row = [&schema](int32_t a, int32_t b) {
+    return Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetIntegerValue(b)}, &schema);
+  };
+  auto *outer_info = catalog.CreateTable(loader, "outer", schema);
+  auto *inner_info = catalog.CreateTable(loader, "inner", schema);
+  RID rid;
+  for (int32_t i = 0; i < 20; i++) {
+    ASSERT_TRUE(outer_info->table_->InsertTuple(make_row(i, 0), &rid, loader));
+  }
+  std::vector<RID> rids(10);
+  for (int32_t i = 0; i < 10; i++) {
+    ASSERT_TRUE(inner_info->table_->InsertTuple(make_row(i, i), &rids[i], loader));
+  }
+  Schema key_schema({Column("a", TypeId::INTEGER)});
+  auto *index_info = catalog.CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(loader, "snapshot_index", "inner",
+                                                                                   schema, key_schema, {0}, 8);
+  txn_mgr.Commit(loader);
+  delete loader;
+
+  LoggingGuard logging;
+  auto txn1 = txn_mgr.Begin(nullptr, IsolationLevel::SNAPSHOT);
+  auto txn2 = txn_mgr.Begin();
+  for (int32_t i = 0; i < 10; i++) {
+    ASSERT_TRUE(inner_info->table_->UpdateTuple(make_row(i, i + 100), rids[i], txn2));
+  }
+  Tuple row = make_row(10, 110);
+  ASSERT_TRUE(inner_info->table_->InsertTuple(row, &rid, txn2));
+  index_info->index_->InsertEntry(index_info->index_->EntryFromTuple(row, schema), rid, txn2);
+  txn_mgr.Commit(txn2);
+  delete txn2;
+
+  auto outer_a = MakeColumnValueExpression(schema, 0, "a");
+  auto outer_schema = MakeOutputSchema({{"a", outer_a}});
+  SeqScanPlanNode scan_plan{outer_schema, nullptr, outer_info->oid_};
+  auto join_outer_a = MakeColumnValueExpression(*outer_schema, 0, "a");
+  auto inner_a = MakeColumnValueExpression(schema, 1, "a");
+  auto inner_b = MakeColumnValueExpression(schema, 1, "b");
+  auto predicate = MakeComparisonExpression(join_outer_a, inner_a, ComparisonType::Equal);
+  auto out_schema = MakeOutputSchema({{"outer_a", join_outer_a}, {"inner_b", inner_b}});
+  NestedIndexJoinPlanNode join_plan{out_schema, {&scan_plan}, predicate, inner_info->oid_, "snapshot_index",
+                                    outer_schema, &schema};
+  auto join = [&](Transaction *txn) {
+    ExecutorContext exec_ctx(txn, &catalog, &bpm, &txn_mgr, GetLockManager());
+    std::vector<Tuple> result_set;
+    execution_engine.Execute(&join_plan, &result_set, txn, &exec_ctx);
+    std::vector<std::pair<int32_t, int32_t>> rows;
+    for (const auto &tuple : result_set) {
+      rows.emplace_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>(), tuple.GetValue(out_schema, 1).GetAs<int32_t>());
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  };
+
+  // txn1 sees the rows as they were when it began, a transaction begun after the commit sees the new ones.
+  std::vector<std::pair<int32_t, int32_t>> old_rows;
+  std::vector<std::pair<int32_t, int32_t>> new_rows;
+  for (int32_t i = 0; i <= 10; i++) {
+    if (i < 10) {
+      old_rows.emplace_back(i, i);
+    }
+    new_rows.emplace_back(i, i + 100);
+  }
+  ASSERT_EQ(join(txn1), old_rows);
+  txn_mgr.Commit(txn1);
+  delete txn1;
+  auto txn3 = txn_mgr.Begin();
+  ASSERT_EQ(join(txn3), new_rows);
+  txn_mgr.Commit(txn3);
+  delete txn3;
+  disk_manager.ShutDown();
+  remove("snapshot_test.db");
+  remove("snapshot_test.log");
+}
+
 }  // namespace bustub
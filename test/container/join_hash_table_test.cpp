@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_hash_table_test.cpp
+//
+// Identification: test/container/join_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "container/hash/join_hash_table.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto IntTuple(int32_t value, const Schema *schema) -> Tuple {
+  return Tuple({ValueFactory::GetIntegerValue(value)}, schema);
+}
+
+auto IntHash(int32_t value) -> hash_t {
+  auto key = ValueFactory::GetIntegerValue(value);
+  return HashUtil::MixHash(HashUtil::HashValue(&key));
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(JoinHashTableTest, DuplicatesAndCollisions) {
+  Schema schema({Column("a", TypeId::INTEGER)});
+  JoinHashTable table;
+
+  // Every key appears three times, and keys 0..99 are also inserted under one shared hash to force collisions.
+  const int32_t num_keys = 1000;
+  const hash_t shared_hash = 42;
+  for (int copy = 0; copy < 3; copy++) {
+    for (int32_t i = 0; i < num_keys; i++) {
+      table.Insert(IntHash(i), IntTuple(i, &schema));
+    }
+  }
+  for (int32_t i = 0; i < 100; i++) {
+    table.Insert(shared_hash, IntTuple(i, &schema));
+  }
+  table.Build();
+  ASSERT_EQ(table.Size(), 3 * num_keys + 100);
+
+  for (int32_t i = 0; i < num_keys; i++) {
+    hash_t hash = IntHash(i);
+    ASSERT_TRUE(table.MayContain(hash));
+    size_t slot = table.ProbeStart(hash);
+    Tuple row;
+    int matches = 0;
+    while (table.FindNext(hash, &slot, &row)) {
+      if (row.GetValue(&schema, 0).GetAs<int32_t>() == i) {
+        matches++;
+      }
+    }
+    ASSERT_EQ(matches, 3);
+  }
+
+  size_t slot = table.ProbeStart(shared_hash);
+  Tuple row;
+  int matches = 0;
+  while (table.FindNext(shared_hash, &slot, &row)) {
+    matches++;
+  }
+  ASSERT_EQ(matches, 100);
+
+  // Rows are also reachable in insertion order, which is how the join spills them.
+  table.GetTuple(num_keys + 7, &row);
+  ASSERT_EQ(row.GetValue(&schema, 0).GetAs<int32_t>(), 7);
+
+  table.Clear();
+  table.Build();
+  slot = table.ProbeStart(IntHash(1));
+  ASSERT_FALSE(table.FindNext(IntHash(1), &slot, &row));
+}
+
+// NOLINTNEXTLINE
+TEST(JoinHashTableTest, BloomFilterFalsePositiveRate) {
+  const size_t num_keys = 100000;
+  BloomFilter filter;
+  filter.Reset(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    filter.Insert(IntHash(static_cast<int32_t>(i)));
+  }
+  size_t false_positives = 0;
+  for (size_t i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(filter.MayContain(IntHash(static_cast<int32_t>(i))));
+    false_positives += filter.MayContain(IntHash(static_cast<int32_t>(num_keys + i))) ? 1 : 0;
+  }
+  ASSERT_LT(false_positives, num_keys / 20);
+}
+
+// Microbenchmark: build on 1M rows, probe with 100M keys of which about 1% match.
+// Run with --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+// NOLINTNEXTLINE
+TEST(JoinHashTableTest, DISABLED_ProbeBenchmark) {
+  const int32_t build_rows = 1000000;
+  const int64_t probe_rows = 100000000;
+  Schema schema({Column("a", TypeId::INTEGER)});
+
+  auto start = std::chrono::steady_clock::now();
+  JoinHashTable table;
+  for (int32_t i = 0; i < build_rows; i++) {
+    table.Insert(IntHash(i), IntTuple(i, &schema));
+  }
+  table.Build();
+  auto built = std::chrono::steady_clock::now();
+
+  std::mt19937 generator(15445);
+  std::uniform_int_distribution<int32_t> distribution(0, build_rows * 100 - 1);
+  int64_t filtered = 0;
+  int64_t matches = 0;
+  Tuple row;
+  for (int64_t i = 0; i < probe_rows; i++) {
+    int32_t key = distribution(generator);
+    hash_t hash = IntHash(key);
+    if (!table.MayContain(hash)) {
+      filtered++;
+      continue;
+    }
+    size_t slot = table.ProbeStart(hash);
+    while (table.FindNext(hash, &slot, &row)) {
+      matches += row.GetValue(&schema, 0).GetAs<int32_t>() == key ? 1 : 0;
+    }
+  }
+  auto probed = std::chrono::steady_clock::now();
+
+  auto build_ms = std::chrono::duration_cast<std::chrono::milliseconds>(built - start).count();
+  auto probe_ms = std::chrono::duration_cast<std::chrono::milliseconds>(probed - built).count();
+  printf("build %d rows: %ld ms (%zu bytes), probe %ld rows: %ld ms, %ld filtered, %ld matches\n", build_rows,
+         static_cast<long>(build_ms), table.GetMemoryUsage(), static_cast<long>(probe_rows),  // NOLINT
+         static_cast<long>(probe_ms), static_cast<long>(filtered), static_cast<long>(matches));  // NOLINT
+  ASSERT_GT(matches, 0);
+}
+
+}  // namespace bustub
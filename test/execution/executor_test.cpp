@@ -10,9 +10,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <memory>
 #include <numeric>
+#include <random>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -30,9 +35,15 @@
 #include "execution/expressions/constant_value_expression.h"
 #include "execution/plans/delete_plan.h"
 #include "execution/plans/distinct_plan.h"
+#include "execution/plans/gather_plan.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
 #include "execution/plans/limit_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
+#include "execution/plans/repartition_plan.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
 #include "execution/plans/update_plan.h"
 #include "executor_test_util.h"  // NOLINT
 #include "gtest/gtest.h"
@@ -110,6 +121,347 @@ TEST_F(ExecutorTest, SimpleSeqScanTest) {
   }
 }
 
+// SELECT colA FROM scan_test WHERE colB < 5, scanned by several workers
+TEST_F(ExecutorTest, ParallelSeqScanTest) {
+  Schema table_schema({Column("colA", TypeId::INTEGER), Column("colB", TypeId::INTEGER)});
+  auto table_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "scan_test", table_schema);
+  const int32_t num_rows = 20000;
+  std::vector<Tuple> rows;
+  for (int32_t i = 0; i < num_rows; i++) {
+    rows.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i % 10)},
+                      &table_schema);
+  }
+  std::vector<RID> rids;
+  ASSERT_TRUE(table_info->table_->InsertTuples(rows, &rids, GetTxn()));
+
+  auto *col_a = MakeColumnValueExpression(table_schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(table_schema, 0, "colB");
+  auto *const5 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(5));
+  auto *predicate = MakeComparisonExpression(col_b, const5, ComparisonType::LessThan);
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}});
+  SeqScanPlanNode scan_plan{out_schema, predicate, table_info->oid_};
+  LimitPlanNode limit_plan{out_schema, &scan_plan, 10};
+
+  // Queries run on the calling thread unless the caller asks for more.
+  ASSERT_EQ(GetExecutorContext()->GetNumThreads(), 1);
+  for (size_t num_threads : {1, 4}) {
+    auto exec_ctx = MakeExecutorContext(num_threads);
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&scan_plan, &result_set, GetTxn(), exec_ctx.get());
+    ASSERT_EQ(result_set.size(), num_rows / 2);
+    std::unordered_set<int32_t> encountered{};
+    for (const auto &tuple : result_set) {
+      auto a = tuple.GetValue(out_schema, 0).GetAs<int32_t>();
+      ASSERT_LT(a % 10, 5);
+      ASSERT_TRUE(encountered.insert(a).second);
+    }
+
+    // Stopping early shuts the workers down.
+    result_set.clear();
+    GetExecutionEngine()->Execute(&limit_plan, &result_set, GetTxn(), exec_ctx.get());
+    ASSERT_EQ(result_set.size(), 10);
+  }
+}
+
+// Microbenchmark: full scan of 1M rows at 1, 4, 16 and 64 threads.
+// Run with --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST_F(ExecutorTest, DISABLED_ParallelSeqScanBenchmark) {
+  Schema table_schema({Column("colA", TypeId::INTEGER), Column("colB", TypeId::INTEGER)});
+  auto table_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "scan_bench", table_schema);
+  const int32_t num_rows = 1000000;
+  std::vector<Tuple> rows;
+  std::vector<RID> rids;
+  for (int32_t i = 0; i < num_rows; i++) {
+    rows.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i % 100)},
+                      &table_schema);
+    if (rows.size() == 4096 || i == num_rows - 1) {
+      ASSERT_TRUE(table_info->table_->InsertTuples(rows, &rids, GetTxn()));
+      rows.clear();
+    }
+  }
+
+  auto *col_a = MakeColumnValueExpression(table_schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(table_schema, 0, "colB");
+  auto *const1 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(1));
+  auto *predicate = MakeComparisonExpression(col_b, const1, ComparisonType::LessThan);
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}});
+  SeqScanPlanNode scan_plan{out_schema, predicate, table_info->oid_};
+
+  for (size_t num_threads : {1, 4, 16, 64}) {
+    auto exec_ctx = MakeExecutorContext(num_threads);
+    std::vector<Tuple> result_set{};
+    auto start = std::chrono::steady_clock::now();
+    GetExecutionEngine()->Execute(&scan_plan, &result_set, GetTxn(), exec_ctx.get());
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%zu threads: %d rows in %ld ms\n", num_threads, num_rows, static_cast<long>(ms));  // NOLINT
+    ASSERT_EQ(result_set.size(), num_rows / 100);
+  }
+}
+
+// SELECT colA, colD FROM pax_test WHERE colC < 10 on a PAX table, which must return what the same scan of a row
+// table returns
+TEST_F(ExecutorTest, PaxSeqScanTest) {
+  Schema table_schema({Column("colA", TypeId::INTEGER), Column("colB", TypeId::VARCHAR, 64),
+                       Column("colC", TypeId::INTEGER), Column("colD", TypeId::VARCHAR, 64)});
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto row_info = catalog->CreateTable(GetTxn(), "row_test", table_schema);
+  auto pax_info = catalog->CreateTable(GetTxn(), "pax_test", table_schema, TablePageFormat::PAX);
+  auto compressed_info = catalog->CreateTable(GetTxn(), "compressed_test", table_schema, TablePageFormat::COMPRESSED);
+  const int32_t num_rows = 5000;
+  std::vector<Tuple> rows;
+  for (int32_t i = 0; i < num_rows; i++) {
+    rows.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i),
+                                         ValueFactory::GetVarcharValue(std::string(i % 40, 'b')),
+                                         ValueFactory::GetIntegerValue(i % 100),
+                                         ValueFactory::GetVarcharValue("d" + std::to_string(i))},
+                      &table_schema);
+  }
+  std::vector<RID> rids;
+  ASSERT_TRUE(row_info->table_->InsertTuples(rows, &rids, GetTxn()));
+  ASSERT_TRUE(pax_info->table_->InsertTuples(rows, &rids, GetTxn()));
+  ASSERT_TRUE(compressed_info->table_->InsertTuples(rows, &rids, GetTxn()));
+
+  auto *col_a = MakeColumnValueExpression(table_schema, 0, "colA");
+  auto *col_c = MakeColumnValueExpression(table_schema, 0, "colC");
+  auto *col_d = MakeColumnValueExpression(table_schema, 0, "colD");
+  auto *const10 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(10));
+  auto *predicate = MakeComparisonExpression(col_c, const10, ComparisonType::LessThan);
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colD", col_d}});
+
+  std::unique_ptr<ExecutorContext> exec_ctx;
+  auto run = [&](const TableInfo *table_info, const AbstractExpression *filter, const Schema *schema) {
+    SeqScanPlanNode plan{schema, filter, table_info->oid_};
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), exec_ctx.get());
+    std::vector<std::string> result;
+    for (const auto &tuple : result_set) {
+      std::string row;
+      for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+        row += tuple.GetValue(schema, i).ToString() + "|";
+      }
+      result.push_back(row);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+
+  for (size_t num_threads : {1, 4}) {
+    exec_ctx = MakeExecutorContext(num_threads);
+    auto expected = run(row_info, predicate, out_schema);
+    ASSERT_EQ(expected.size(), num_rows / 10);
+    ASSERT_EQ(run(pax_info, predicate, out_schema), expected);
+    ASSERT_EQ(run(compressed_info, predicate, out_schema), expected);
+    // Without a projection every column is read.
+    auto all_rows = run(row_info, nullptr, &table_schema);
+    ASSERT_EQ(run(pax_info, nullptr, &table_schema), all_rows);
+    ASSERT_EQ(run(compressed_info, nullptr, &table_schema), all_rows);
+  }
+}
+
+// Microbenchmark: SELECT col0 FROM a 16-column table WHERE col1 < 1, stored as rows, as PAX and as compressed pages.
+// Run with --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST_F(ExecutorTest, DISABLED_PaxSeqScanBenchmark) {
+  std::vector<Column> columns;
+  for (int i = 0; i < 16; i++) {
+    columns.emplace_back("col" + std::to_string(i), TypeId::INTEGER);
+  }
+  Schema table_schema(columns);
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  const int32_t num_rows = 200000;
+  auto *col_0 = MakeColumnValueExpression(table_schema, 0, "col0");
+  auto *col_1 = MakeColumnValueExpression(table_schema, 0, "col1");
+  auto *const1 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(1));
+  auto *predicate = MakeComparisonExpression(col_1, const1, ComparisonType::LessThan);
+  auto *out_schema = MakeOutputSchema({{"col0", col_0}});
+
+  for (auto format : {TablePageFormat::SLOTTED, TablePageFormat::PAX, TablePageFormat::COMPRESSED}) {
+    const char *name = format == TablePageFormat::PAX          ? "pax"
+                       : format == TablePageFormat::COMPRESSED ? "compressed"
+                                                               : "rows";
+    auto table_info = catalog->CreateTable(GetTxn(), std::string("pax_bench_") + name, table_schema, format);
+    std::vector<Tuple> rows;
+    std::vector<RID> rids;
+    for (int32_t i = 0; i < num_rows; i++) {
+      std::vector<Value> values;
+      for (int c = 0; c < 16; c++) {
+        values.push_back(ValueFactory::GetIntegerValue(c == 1 ? i % 100 : i));
+      }
+      rows.emplace_back(values, &table_schema);
+      if (rows.size() == 4096 || i == num_rows - 1) {
+        ASSERT_TRUE(table_info->table_->InsertTuples(rows, &rids, GetTxn()));
+        rows.clear();
+      }
+    }
+
+    SeqScanPlanNode scan_plan{out_schema, predicate, table_info->oid_};
+    std::vector<Tuple> result_set{};
+    auto start = std::chrono::steady_clock::now();
+    GetExecutionEngine()->Execute(&scan_plan, &result_set, GetTxn(), GetExecutorContext());
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%s: %zu pages, %d rows in %ld ms\n", name,  // NOLINT
+           table_info->table_->GetPageIds().size(), num_rows, static_cast<long>(ms));  // NOLINT
+    ASSERT_EQ(result_set.size(), num_rows / 100);
+  }
+}
+
+// SELECT colA, colB FROM t WHERE colC < 3 through an index on colA that INCLUDEs colB and colC
+TEST_F(ExecutorTest, IndexOnlyScanTest) {
+  Schema table_schema({Column("colA", TypeId::INTEGER), Column("colB", TypeId::VARCHAR, 16),
+                       Column("colC", TypeId::INTEGER), Column("colD", TypeId::VARCHAR, 128)});
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto *table_info = catalog->CreateTable(GetTxn(), "covered_test", table_schema);
+  const int32_t num_rows = 2000;
+  std::vector<int32_t> keys(num_rows);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(445));
+  auto make_row = [](int32_t key) {
+    return std::vector<Value>{ValueFactory::GetIntegerValue(key),
+                              ValueFactory::GetVarcharValue("b" + std::to_string(key)),
+                              ValueFactory::GetIntegerValue(key % 7),
+                              ValueFactory::GetVarcharValue(std::string(100, 'd'))};
+  };
+
+  // The first half is in the table when the index is built, the second half is inserted through it.
+  std::vector<Tuple> rows;
+  for (int32_t i = 0; i < num_rows / 2; i++) {
+    rows.emplace_back(make_row(keys[i]), &table_schema);
+  }
+  std::vector<RID> rids;
+  ASSERT_TRUE(table_info->table_->InsertTuples(rows, &rids, GetTxn()));
+  Schema key_schema({Column("colA", TypeId::INTEGER)});
+  auto *index_info = catalog->CreateIndex<GenericKey<32>, RID, GenericComparator<32>>(
+      GetTxn(), "covered_index", "covered_test", table_schema, key_schema, {0}, 32, {1, 2});
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+  std::vector<std::vector<Value>> raw_values;
+  for (int32_t i = num_rows / 2; i < num_rows; i++) {
+    raw_values.push_back(make_row(keys[i]));
+  }
+  InsertPlanNode insert_plan{std::move(raw_values), table_info->oid_};
+  GetExecutionEngine()->Execute(&insert_plan, nullptr, GetTxn(), GetExecutorContext());
+
+  auto *col_a = MakeColumnValueExpression(table_schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(table_schema, 0, "colB");
+  auto *col_c = MakeColumnValueExpression(table_schema, 0, "colC");
+  auto *col_d = MakeColumnValueExpression(table_schema, 0, "colD");
+  auto *const3 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(3));
+  auto *predicate = MakeComparisonExpression(col_c, const3, ComparisonType::LessThan);
+  auto *covered_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto *uncovered_schema = MakeOutputSchema({{"colA", col_a}, {"colD", col_d}});
+
+  auto run = [&](const Schema *out_schema) {
+    IndexScanPlanNode plan{out_schema, predicate, index_info->index_oid_};
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+    return result_set;
+  };
+
+  // Both scans return the qualifying rows in key order.
+  std::vector<int32_t> expected_keys;
+  for (int32_t key = 0; key < num_rows; key++) {
+    if (key % 7 < 3) {
+      expected_keys.push_back(key);
+    }
+  }
+  auto covered = run(covered_schema);
+  auto uncovered = run(uncovered_schema);
+  ASSERT_EQ(covered.size(), expected_keys.size());
+  ASSERT_EQ(uncovered.size(), expected_keys.size());
+  for (size_t i = 0; i < expected_keys.size(); i++) {
+    ASSERT_EQ(covered[i].GetValue(covered_schema, 0).GetAs<int32_t>(), expected_keys[i]);
+    ASSERT_EQ(covered[i].GetValue(covered_schema, 1).ToString(), "b" + std::to_string(expected_keys[i]));
+    ASSERT_EQ(uncovered[i].GetValue(uncovered_schema, 0).GetAs<int32_t>(), expected_keys[i]);
+    ASSERT_EQ(uncovered[i].GetValue(uncovered_schema, 1).ToString(), std::string(100, 'd'));
+  }
+
+  // Remove key 0 from the heap only: the index-only scan never reads the heap and still finds it.
+  std::vector<RID> key0_rids;
+  index_info->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(0)}, &key_schema), &key0_rids, GetTxn());
+  ASSERT_EQ(key0_rids.size(), 1);
+  table_info->table_->ApplyDelete(key0_rids[0], GetTxn());
+  ASSERT_EQ(run(covered_schema).size(), expected_keys.size());
+  ASSERT_EQ(run(uncovered_schema).size(), expected_keys.size() - 1);
+}
+
+// Microbenchmark: SELECT col0, col1 FROM a 16-column table WHERE col1 < 1 through an index on col0, with and without
+// col1 INCLUDEd. Rows are stored in random key order, so the plain index reads a random heap page per entry.
+// Run with --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST_F(ExecutorTest, DISABLED_IndexOnlyScanBenchmark) {
+  std::vector<Column> columns;
+  for (int i = 0; i < 16; i++) {
+    columns.emplace_back("col" + std::to_string(i), TypeId::INTEGER);
+  }
+  Schema table_schema(columns);
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto *table_info = catalog->CreateTable(GetTxn(), "index_bench", table_schema);
+  const int32_t num_rows = 200000;
+  std::vector<int32_t> keys(num_rows);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(445));
+  std::vector<Tuple> rows;
+  std::vector<RID> rids;
+  for (int32_t i = 0; i < num_rows; i++) {
+    std::vector<Value> values;
+    for (int c = 0; c < 16; c++) {
+      values.push_back(ValueFactory::GetIntegerValue(c == 1 ? keys[i] % 100 : keys[i]));
+    }
+    rows.emplace_back(values, &table_schema);
+    if (rows.size() == 4096 || i == num_rows - 1) {
+      ASSERT_TRUE(table_info->table_->InsertTuples(rows, &rids, GetTxn()));
+      rows.clear();
+    }
+  }
+
+  Schema key_schema({Column("col0", TypeId::INTEGER)});
+  auto *plain_index = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      GetTxn(), "plain_index", "index_bench", table_schema, key_schema, {0}, 8);
+  auto *covering_index = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      GetTxn(), "covering_index", "index_bench", table_schema, key_schema, {0}, 8, {1});
+  auto *col_0 = MakeColumnValueExpression(table_schema, 0, "col0");
+  auto *col_1 = MakeColumnValueExpression(table_schema, 0, "col1");
+  auto *const1 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(1));
+  auto *predicate = MakeComparisonExpression(col_1, const1, ComparisonType::LessThan);
+  auto *out_schema = MakeOutputSchema({{"col0", col_0}, {"col1", col_1}});
+
+  for (const auto *index_info : {plain_index, covering_index}) {
+    IndexScanPlanNode scan_plan{out_schema, predicate, index_info->index_oid_};
+    std::vector<Tuple> result_set{};
+    auto start = std::chrono::steady_clock::now();
+    GetExecutionEngine()->Execute(&scan_plan, &result_set, GetTxn(), GetExecutorContext());
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%s: %d rows in %ld ms\n", index_info->name_.c_str(), num_rows, static_cast<long>(ms));  // NOLINT
+    ASSERT_EQ(result_set.size(), num_rows / 100);
+  }
+}
+
+// INSERT INTO test_3 SELECT colA, colB FROM test_3, with an index on colA: every row is copied exactly once
+TEST_F(ExecutorTest, SelfInsertTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a bigint");
+  auto *index_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index1", "test_3", schema, *key_schema, {0}, 8, HashFunctionType{});
+
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto scan_plan = std::make_unique<SeqScanPlanNode>(out_schema, nullptr, table_info->oid_);
+  auto insert_plan = std::make_unique<InsertPlanNode>(scan_plan.get(), table_info->oid_);
+  GetExecutionEngine()->Execute(insert_plan.get(), nullptr, GetTxn(), GetExecutorContext());
+
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(scan_plan.get(), &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), 2 * TEST3_SIZE);
+
+  // Both copies of every row are in the index.
+  std::vector<RID> rids{};
+  for (int32_t a = 0; a < static_cast<int32_t>(TEST3_SIZE); a++) {
+    rids.clear();
+    Tuple key({ValueFactory::GetIntegerValue(a)}, &index_info->key_schema_);
+    index_info->index_->ScanKey(key, &rids, GetTxn());
+    ASSERT_EQ(rids.size(), 2);
+  }
+}
+
 // INSERT INTO empty_table2 VALUES (100, 10), (101, 11), (102, 12)
 TEST_F(ExecutorTest, SimpleRawInsertTest) {
   // Create Values to insert
@@ -329,6 +681,100 @@ TEST_F(ExecutorTest, SimpleUpdateTest) {
   }
 }
 
+// UPDATE test_3 SET colB = colB + 1, then SET colA = colA + 0, with an index on colA and one on colA INCLUDE colB
+TEST_F(ExecutorTest, UpdateSkipsUnchangedIndexTest) {
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto *table_info = catalog->GetTable("test_3");
+  auto &schema = table_info->schema_;
+  Schema key_schema({Column("colA", TypeId::INTEGER)});
+  auto *key_index = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      GetTxn(), "key_index", "test_3", schema, key_schema, {0}, 8);
+  auto *covering_index = catalog->CreateIndex<GenericKey<16>, RID, GenericComparator<16>>(
+      GetTxn(), "covering_index", "test_3", schema, key_schema, {0}, 16, {1});
+  auto scan_key = [&](int32_t key) {
+    std::vector<RID> rids;
+    key_index->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(key)}, &key_schema), &rids, GetTxn());
+    return rids.size();
+  };
+
+  // Take key 5 out of the plain index behind the executors' back: an update that maintained the index would put it
+  // back.
+  std::vector<RID> rids;
+  key_index->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(5)}, &key_schema), &rids, GetTxn());
+  ASSERT_EQ(rids.size(), 1);
+  key_index->index_->DeleteEntry(Tuple({ValueFactory::GetIntegerValue(5)}, &key_schema), rids[0], GetTxn());
+
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  SeqScanPlanNode scan_plan{out_schema, nullptr, table_info->oid_};
+  auto update = [&](uint32_t column) {
+    std::unordered_map<uint32_t, UpdateInfo> update_attrs{};
+    update_attrs.emplace(column, UpdateInfo{UpdateType::Add, column == 0 ? 0 : 1});
+    UpdatePlanNode update_plan{&scan_plan, table_info->oid_, update_attrs};
+    GetExecutionEngine()->Execute(&update_plan, nullptr, GetTxn(), GetExecutorContext());
+  };
+
+  // colB is not in the plain index, and colA + 0 leaves its entries as they were: the index is never touched.
+  update(1);
+  update(0);
+  ASSERT_EQ(scan_key(5), 0);
+  ASSERT_EQ(scan_key(6), 1);
+
+  // The covering index holds colB, its entries were updated.
+  IndexScanPlanNode index_scan_plan{out_schema, nullptr, covering_index->index_oid_};
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&index_scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), TEST3_SIZE);
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(result_set[i].GetValue(out_schema, 0).GetAs<int32_t>(), static_cast<int32_t>(i));
+    ASSERT_EQ(result_set[i].GetValue(out_schema, 1).GetAs<int32_t>(), static_cast<int32_t>(i + 1));
+  }
+}
+
+// Microbenchmark: UPDATE t SET hits = hits + 1 on a table with four indexes none of which holds hits, against
+// UPDATE t SET id = id + 0, which has to look at the entries of every index. Neither changes an index page.
+// Run with --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST_F(ExecutorTest, DISABLED_CounterUpdateBenchmark) {
+  Schema table_schema({Column("id", TypeId::INTEGER), Column("a", TypeId::INTEGER), Column("b", TypeId::INTEGER),
+                       Column("c", TypeId::INTEGER), Column("hits", TypeId::INTEGER)});
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto *table_info = catalog->CreateTable(GetTxn(), "counter_bench", table_schema);
+  const int32_t num_rows = 100000;
+  std::vector<Tuple> rows;
+  std::vector<RID> rids;
+  for (int32_t i = 0; i < num_rows; i++) {
+    rows.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(num_rows - i),
+                                         ValueFactory::GetIntegerValue(2 * i), ValueFactory::GetIntegerValue(3 * i),
+                                         ValueFactory::GetIntegerValue(0)},
+                      &table_schema);
+  }
+  ASSERT_TRUE(table_info->table_->InsertTuples(rows, &rids, GetTxn()));
+  for (uint32_t column = 0; column < 4; column++) {
+    Schema key_schema({table_schema.GetColumn(column)});
+    catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+        GetTxn(), "counter_index" + std::to_string(column), "counter_bench", table_schema, key_schema, {column}, 8);
+  }
+
+  std::vector<std::pair<std::string, const AbstractExpression *>> columns;
+  for (uint32_t column = 0; column < table_schema.GetColumnCount(); column++) {
+    const auto &name = table_schema.GetColumn(column).GetName();
+    columns.emplace_back(name, MakeColumnValueExpression(table_schema, 0, name));
+  }
+  auto *out_schema = MakeOutputSchema(columns);
+  SeqScanPlanNode scan_plan{out_schema, nullptr, table_info->oid_};
+  for (uint32_t column : {4, 0}) {
+    std::unordered_map<uint32_t, UpdateInfo> update_attrs{};
+    update_attrs.emplace(column, UpdateInfo{UpdateType::Add, column == 0 ? 0 : 1});
+    UpdatePlanNode update_plan{&scan_plan, table_info->oid_, update_attrs};
+    auto start = std::chrono::steady_clock::now();
+    GetExecutionEngine()->Execute(&update_plan, nullptr, GetTxn(), GetExecutorContext());
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("update %s: %d rows in %ld ms\n", table_schema.GetColumn(column).GetName().c_str(), num_rows,  // NOLINT
+           static_cast<long>(ms));  // NOLINT
+  }
+}
+
 // DELETE FROM test_1 WHERE col_a == 50;
 TEST_F(ExecutorTest, SimpleDeleteTest) {
   // Construct query plan
@@ -487,6 +933,54 @@ TEST_F(ExecutorTest, SimpleHashJoinTest) {
   }
 }
 
+// SELECT l.colA, r.colA, l.colB FROM test_1 l JOIN test_1 r ON l.colB = r.colB, with a memory budget that forces the
+// hash join to partition both inputs (and to re-partition, since colB only has 10 distinct values)
+TEST_F(ExecutorTest, SpillingHashJoinTest) {
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  const Schema *scan_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto left_plan = std::make_unique<SeqScanPlanNode>(scan_schema, nullptr, table_info->oid_);
+  auto right_plan = std::make_unique<SeqScanPlanNode>(scan_schema, nullptr, table_info->oid_);
+
+  auto *left_col_a = MakeColumnValueExpression(*scan_schema, 0, "colA");
+  auto *left_col_b = MakeColumnValueExpression(*scan_schema, 0, "colB");
+  auto *right_col_a = MakeColumnValueExpression(*scan_schema, 1, "colA");
+  auto *right_col_b = MakeColumnValueExpression(*scan_schema, 1, "colB");
+  const Schema *out_schema =
+      MakeOutputSchema({{"left_colA", left_col_a}, {"right_colA", right_col_a}, {"colB", left_col_b}});
+  auto join_plan = std::make_unique<HashJoinPlanNode>(
+      out_schema, std::vector<const AbstractPlanNode *>{left_plan.get(), right_plan.get()}, left_col_b, right_col_b);
+
+  // Every pair of rows with the same colB must be produced exactly once.
+  std::vector<Tuple> scan_result{};
+  GetExecutionEngine()->Execute(left_plan.get(), &scan_result, GetTxn(), GetExecutorContext());
+  std::unordered_map<int32_t, size_t> frequency{};
+  for (const auto &tuple : scan_result) {
+    frequency[tuple.GetValue(scan_schema, 1).GetAs<int32_t>()]++;
+  }
+  size_t expected = 0;
+  for (const auto &entry : frequency) {
+    expected += entry.second * entry.second;
+  }
+
+  for (size_t work_memory : {static_cast<size_t>(WORK_MEMORY_SIZE), static_cast<size_t>(PAGE_SIZE)}) {
+    GetExecutorContext()->SetWorkMemory(work_memory);
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(join_plan.get(), &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), expected);
+
+    std::unordered_set<int64_t> pairs{};
+    for (const auto &tuple : result_set) {
+      auto left_a = tuple.GetValue(out_schema, 0).GetAs<int32_t>();
+      auto right_a = tuple.GetValue(out_schema, 1).GetAs<int32_t>();
+      ASSERT_TRUE(pairs.insert(static_cast<int64_t>(left_a) * TEST1_SIZE + right_a).second);
+    }
+  }
+  GetExecutorContext()->SetWorkMemory(WORK_MEMORY_SIZE);
+}
+
 // SELECT COUNT(col_a), SUM(col_a), min(col_a), max(col_a) from test_1;
 TEST_F(ExecutorTest, SimpleAggregationTest) {
   const Schema *scan_schema;
@@ -564,8 +1058,8 @@ TEST_F(ExecutorTest, SimpleGroupByAggregation) {
     std::vector<const AbstractExpression *> aggregate_cols{col_a, col_c};
     std::vector<AggregationType> agg_types{AggregationType::CountAggregate, AggregationType::SumAggregate};
     const AbstractExpression *count_a = MakeAggregateValueExpression(false, 0);
-    const AbstractExpression *groupby_b = MakeAggregateValueExpression(true, 1);
-    const AbstractExpression* sum_c=MakeAggregateValueExpression(false,2);
+    const AbstractExpression *groupby_b = MakeAggregateValueExpression(true, 0);
+    const AbstractExpression* sum_c=MakeAggregateValueExpression(false,1);
     // Make having clause
     const AbstractExpression *having = MakeComparisonExpression(
         count_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(100)), ComparisonType::GreaterThan);
@@ -593,6 +1087,284 @@ TEST_F(ExecutorTest, SimpleGroupByAggregation) {
   }
 }
 
+// SELECT colA, COUNT(colA), MAX(colB) FROM test_1 GROUP BY colA, with several workers and a budget that forces spilling
+TEST_F(ExecutorTest, ParallelSpillingAggregation) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+  const Schema *scan_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto scan_plan = std::make_unique<SeqScanPlanNode>(scan_schema, nullptr, table_info->oid_);
+
+  const AbstractExpression *groupby_a = MakeAggregateValueExpression(true, 0);
+  const AbstractExpression *count_a = MakeAggregateValueExpression(false, 0);
+  const AbstractExpression *max_b = MakeAggregateValueExpression(false, 1);
+  const Schema *agg_schema = MakeOutputSchema({{"colA", groupby_a}, {"countA", count_a}, {"maxB", max_b}});
+  auto agg_plan = std::make_unique<AggregationPlanNode>(
+      agg_schema, scan_plan.get(), nullptr, std::vector<const AbstractExpression *>{col_a},
+      std::vector<const AbstractExpression *>{col_a, col_b},
+      std::vector<AggregationType>{AggregationType::CountAggregate, AggregationType::MaxAggregate});
+
+  for (size_t num_threads : {1, 4}) {
+    for (size_t work_memory : {static_cast<size_t>(WORK_MEMORY_SIZE), static_cast<size_t>(PAGE_SIZE)}) {
+      auto exec_ctx = MakeExecutorContext(num_threads);
+      exec_ctx->SetWorkMemory(work_memory);
+      std::vector<Tuple> result_set{};
+      GetExecutionEngine()->Execute(agg_plan.get(), &result_set, GetTxn(), exec_ctx.get());
+
+      // colA is unique, so every group holds exactly one row.
+      ASSERT_EQ(result_set.size(), TEST1_SIZE);
+      std::unordered_set<int32_t> encountered{};
+      for (const auto &tuple : result_set) {
+        auto a = tuple.GetValue(agg_schema, agg_schema->GetColIdx("colA")).GetAs<int32_t>();
+        ASSERT_TRUE(encountered.insert(a).second);
+        ASSERT_EQ(tuple.GetValue(agg_schema, agg_schema->GetColIdx("countA")).GetAs<int32_t>(), 1);
+        auto b = tuple.GetValue(agg_schema, agg_schema->GetColIdx("maxB")).GetAs<int32_t>();
+        ASSERT_TRUE(0 <= b && b < 10);
+      }
+    }
+  }
+}
+
+// SELECT l.colA, r.colA FROM gather_test l JOIN gather_test r ON l.colA = r.colA WHERE l.colA < 100, and
+// SELECT colB, COUNT(colA) FROM gather_test GROUP BY colB, both run as copies under a Gather
+TEST_F(ExecutorTest, GatherTest) {
+  Schema table_schema({Column("colA", TypeId::INTEGER), Column("colB", TypeId::INTEGER)});
+  auto table_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "gather_test", table_schema);
+  const int32_t num_rows = 20000;
+  std::vector<Tuple> rows;
+  for (int32_t i = 0; i < num_rows; i++) {
+    rows.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i % 100)},
+                      &table_schema);
+  }
+  std::vector<RID> rids;
+  ASSERT_TRUE(table_info->table_->InsertTuples(rows, &rids, GetTxn()));
+
+  auto *col_a = MakeColumnValueExpression(table_schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(table_schema, 0, "colB");
+  auto *scan_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto *predicate = MakeComparisonExpression(col_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(100)),
+                                             ComparisonType::LessThan);
+  SeqScanPlanNode build_plan{scan_schema, predicate, table_info->oid_};
+  SeqScanPlanNode probe_plan{scan_schema, nullptr, table_info->oid_};
+
+  // The probe side is split into morsels, every copy builds the whole left side.
+  auto *left_a = MakeColumnValueExpression(*scan_schema, 0, "colA");
+  auto *right_a = MakeColumnValueExpression(*scan_schema, 1, "colA");
+  auto *join_schema = MakeOutputSchema({{"leftA", left_a}, {"rightA", right_a}});
+  HashJoinPlanNode join_plan{join_schema, {&build_plan, &probe_plan}, left_a, right_a};
+  GatherPlanNode gather_join_plan{join_schema, &join_plan};
+
+  // Copies aggregate disjoint groups once the scan is repartitioned on the group by column.
+  RepartitionPlanNode repartition_plan{scan_schema, &probe_plan, {col_b}};
+  const AbstractExpression *groupby_b = MakeAggregateValueExpression(true, 0);
+  const AbstractExpression *count_a = MakeAggregateValueExpression(false, 0);
+  auto *agg_schema = MakeOutputSchema({{"colB", groupby_b}, {"countA", count_a}});
+  AggregationPlanNode agg_plan{agg_schema,
+                               &repartition_plan,
+                               nullptr,
+                               std::vector<const AbstractExpression *>{col_b},
+                               std::vector<const AbstractExpression *>{col_a},
+                               std::vector<AggregationType>{AggregationType::CountAggregate}};
+  GatherPlanNode gather_agg_plan{agg_schema, &agg_plan};
+
+  for (size_t num_threads : {1, 4}) {
+    auto exec_ctx = MakeExecutorContext(num_threads);
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&gather_join_plan, &result_set, GetTxn(), exec_ctx.get());
+    ASSERT_EQ(result_set.size(), 100);
+    std::unordered_set<int32_t> encountered{};
+    for (const auto &tuple : result_set) {
+      auto a = tuple.GetValue(join_schema, 0).GetAs<int32_t>();
+      ASSERT_EQ(a, tuple.GetValue(join_schema, 1).GetAs<int32_t>());
+      ASSERT_TRUE(encountered.insert(a).second);
+    }
+
+    result_set.clear();
+    GetExecutionEngine()->Execute(&gather_agg_plan, &result_set, GetTxn(), exec_ctx.get());
+    ASSERT_EQ(result_set.size(), 100);
+    encountered.clear();
+    for (const auto &tuple : result_set) {
+      ASSERT_TRUE(encountered.insert(tuple.GetValue(agg_schema, 0).GetAs<int32_t>()).second);
+      ASSERT_EQ(tuple.GetValue(agg_schema, 1).GetAs<int32_t>(), num_rows / 100);
+    }
+  }
+}
+
+// SELECT outer.colA, outer.colB, inner.colA FROM test_1 outer JOIN test_1 inner ON outer.colB = inner.colA,
+// probing an index on inner.colA
+TEST_F(ExecutorTest, NestedIndexJoinTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a bigint");
+  GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index1", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{});
+
+  auto outer_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto outer_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto outer_schema = MakeOutputSchema({{"colA", outer_a}, {"colB", outer_b}});
+  auto scan_plan = std::make_unique<SeqScanPlanNode>(outer_schema, nullptr, table_info->oid_);
+
+  auto join_outer_a = MakeColumnValueExpression(*outer_schema, 0, "colA");
+  auto join_outer_b = MakeColumnValueExpression(*outer_schema, 0, "colB");
+  auto join_inner_a = MakeColumnValueExpression(schema, 1, "colA");
+  auto predicate = MakeComparisonExpression(join_outer_b, join_inner_a, ComparisonType::Equal);
+  auto out_schema =
+      MakeOutputSchema({{"outer_a", join_outer_a}, {"outer_b", join_outer_b}, {"inner_a", join_inner_a}});
+  NestedIndexJoinPlanNode join_plan{out_schema, {scan_plan.get()}, predicate, table_info->oid_, "index1",
+                                    outer_schema, &schema};
+
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+
+  // colA is unique and colB lies in [0, 10), so every outer row finds exactly one inner row.
+  ASSERT_EQ(result_set.size(), TEST1_SIZE);
+  std::unordered_set<int32_t> encountered{};
+  for (const auto &tuple : result_set) {
+    ASSERT_TRUE(encountered.insert(tuple.GetValue(out_schema, 0).GetAs<int32_t>()).second);
+    ASSERT_EQ(tuple.GetValue(out_schema, 1).GetAs<int32_t>(), tuple.GetValue(out_schema, 2).GetAs<int32_t>());
+  }
+
+  // A B+ tree index on inner.colB has a hundred entries for every key, each probe walks them all. Every inner row
+  // matches the outer row whose colA is its colB.
+  Schema b_key_schema({Column("colB", TypeId::INTEGER)});
+  auto *b_index = GetExecutorContext()->GetCatalog()->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      GetTxn(), "index2", "test_1", schema, b_key_schema, {1}, 8);
+  std::vector<RID> b3_rids;
+  std::vector<RID> expected_b3_rids;
+  Tuple b3_key({ValueFactory::GetIntegerValue(3)}, &b_key_schema);
+  b_index->index_->ScanKey(b3_key, &b3_rids, GetTxn());
+  for (auto it = table_info->table_->Begin(GetTxn()); it != table_info->table_->End(); ++it) {
+    if (it->GetValue(&schema, 1).GetAs<int32_t>() == 3) {
+      expected_b3_rids.push_back(it->GetRid());
+    }
+  }
+  // The entries of a key are ordered by RID.
+  std::sort(expected_b3_rids.begin(), expected_b3_rids.end(),
+            [](const RID &left, const RID &right) { return left.Get() < right.Get(); });
+  ASSERT_EQ(b3_rids, expected_b3_rids);
+  b_index->index_->DeleteEntry(b3_key, b3_rids[0], GetTxn());
+  b3_rids.clear();
+  b_index->index_->ScanKey(b3_key, &b3_rids, GetTxn());
+  ASSERT_EQ(b3_rids.size(), expected_b3_rids.size() - 1);
+  b_index->index_->InsertEntry(b3_key, expected_b3_rids[0], GetTxn());
+  auto join_inner_b = MakeColumnValueExpression(schema, 1, "colB");
+  auto b_predicate = MakeComparisonExpression(join_outer_a, join_inner_b, ComparisonType::Equal);
+  auto b_out_schema = MakeOutputSchema({{"outer_a", join_outer_a}, {"inner_b", join_inner_b}});
+  NestedIndexJoinPlanNode b_join_plan{b_out_schema, {scan_plan.get()}, b_predicate, table_info->oid_, "index2",
+                                      outer_schema, &schema};
+  result_set.clear();
+  GetExecutionEngine()->Execute(&b_join_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), TEST1_SIZE);
+  for (const auto &tuple : result_set) {
+    ASSERT_EQ(tuple.GetValue(b_out_schema, 0).GetAs<int32_t>(), tuple.GetValue(b_out_schema, 1).GetAs<int32_t>());
+  }
+}
+
+// SELECT outer.colA, inner.body FROM test_1 outer JOIN overflow_inner inner ON outer.colA = inner.id, where one body
+// is stored on overflow pages
+TEST_F(ExecutorTest, NestedIndexJoinOverflowTest) {
+  Schema inner_schema({Column("id", TypeId::INTEGER), Column("body", TypeId::VARCHAR, 16384)});
+  auto *catalog = GetExecutorContext()->GetCatalog();
+  auto *inner_info = catalog->CreateTable(GetTxn(), "overflow_inner", inner_schema);
+  auto make_body = [](int32_t id) { return id == 3 ? std::string(3 * PAGE_SIZE, 'x') : "body" + std::to_string(id); };
+  RID rid;
+  for (int32_t id = 0; id < 10; id++) {
+    Tuple row({ValueFactory::GetIntegerValue(id), ValueFactory::GetVarcharValue(make_body(id))}, &inner_schema);
+    ASSERT_TRUE(inner_info->table_->InsertTuple(row, &rid, GetTxn()));
+  }
+  Schema key_schema({Column("id", TypeId::INTEGER)});
+  catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(GetTxn(), "overflow_index", "overflow_inner",
+                                                                 inner_schema, key_schema, {0}, 8);
+
+  auto *outer_info = catalog->GetTable("test_1");
+  auto outer_a = MakeColumnValueExpression(outer_info->schema_, 0, "colA");
+  auto outer_schema = MakeOutputSchema({{"colA", outer_a}});
+  auto scan_plan = std::make_unique<SeqScanPlanNode>(outer_schema, nullptr, outer_info->oid_);
+
+  auto join_outer_a = MakeColumnValueExpression(*outer_schema, 0, "colA");
+  auto inner_id = MakeColumnValueExpression(inner_schema, 1, "id");
+  auto inner_body = MakeColumnValueExpression(inner_schema, 1, "body");
+  auto predicate = MakeComparisonExpression(join_outer_a, inner_id, ComparisonType::Equal);
+  auto out_schema = MakeOutputSchema({{"outer_a", join_outer_a}, {"body", inner_body}});
+  NestedIndexJoinPlanNode join_plan{out_schema, {scan_plan.get()}, predicate, inner_info->oid_, "overflow_index",
+                                    outer_schema, &inner_schema};
+
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), 10);
+  for (const auto &tuple : result_set) {
+    ASSERT_EQ(tuple.GetValue(out_schema, 1).ToString(), make_body(tuple.GetValue(out_schema, 0).GetAs<int32_t>()));
+  }
+}
+
+// SELECT colA, colB FROM test_1 ORDER BY colB ASC, colA DESC, in memory and with many spilled runs
+TEST_F(ExecutorTest, SortTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto scan_plan = std::make_unique<SeqScanPlanNode>(out_schema, nullptr, table_info->oid_);
+
+  auto sort_a = MakeColumnValueExpression(*out_schema, 0, "colA");
+  auto sort_b = MakeColumnValueExpression(*out_schema, 0, "colB");
+  auto sort_plan = std::make_unique<SortPlanNode>(
+      out_schema, scan_plan.get(), std::vector<OrderBy>{{OrderByType::Asc, sort_b}, {OrderByType::Desc, sort_a}});
+
+  // The smallest budget forces more runs than can be merged at once.
+  for (size_t work_memory : {static_cast<size_t>(WORK_MEMORY_SIZE), static_cast<size_t>(PAGE_SIZE), size_t{512}}) {
+    GetExecutorContext()->SetWorkMemory(work_memory);
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(sort_plan.get(), &result_set, GetTxn(), GetExecutorContext());
+
+    ASSERT_EQ(result_set.size(), TEST1_SIZE);
+    std::unordered_set<int32_t> encountered{};
+    for (size_t i = 0; i < result_set.size(); i++) {
+      auto a = result_set[i].GetValue(out_schema, 0).GetAs<int32_t>();
+      auto b = result_set[i].GetValue(out_schema, 1).GetAs<int32_t>();
+      ASSERT_TRUE(encountered.insert(a).second);
+      if (i > 0) {
+        auto prev_a = result_set[i - 1].GetValue(out_schema, 0).GetAs<int32_t>();
+        auto prev_b = result_set[i - 1].GetValue(out_schema, 1).GetAs<int32_t>();
+        ASSERT_TRUE(prev_b < b || (prev_b == b && prev_a > a));
+      }
+    }
+  }
+  GetExecutorContext()->SetWorkMemory(WORK_MEMORY_SIZE);
+}
+
+// SELECT colA, colC FROM test_1 ORDER BY colC DESC LIMIT 10, as a LIMIT over a sort and as a TopN plan
+TEST_F(ExecutorTest, TopNTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_c = MakeColumnValueExpression(schema, 0, "colC");
+  auto out_schema = MakeOutputSchema({{"colA", col_a}, {"colC", col_c}});
+  auto scan_plan = std::make_unique<SeqScanPlanNode>(out_schema, nullptr, table_info->oid_);
+
+  std::vector<OrderBy> order_bys{{OrderByType::Desc, MakeColumnValueExpression(*out_schema, 0, "colC")}};
+  auto sort_plan = std::make_unique<SortPlanNode>(out_schema, scan_plan.get(), order_bys);
+  auto limit_plan = std::make_unique<LimitPlanNode>(out_schema, sort_plan.get(), 10);
+  auto topn_plan = std::make_unique<TopNPlanNode>(out_schema, scan_plan.get(), order_bys, 10);
+
+  std::vector<Tuple> sorted{};
+  GetExecutionEngine()->Execute(sort_plan.get(), &sorted, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(sorted.size(), TEST1_SIZE);
+
+  for (const AbstractPlanNode *plan : {static_cast<const AbstractPlanNode *>(limit_plan.get()),
+                                       static_cast<const AbstractPlanNode *>(topn_plan.get())}) {
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), 10);
+    for (size_t i = 0; i < result_set.size(); i++) {
+      // Ties may come out in any order, but the keys must match the full sort.
+      ASSERT_EQ(result_set[i].GetValue(out_schema, 1).GetAs<int32_t>(),
+                sorted[i].GetValue(out_schema, 1).GetAs<int32_t>());
+    }
+  }
+}
+
 // SELECT colA, colB FROM test_3 LIMIT 10
 TEST_F(ExecutorTest, SimpleLimitTest) {
   auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
@@ -658,4 +1430,47 @@ TEST_F(ExecutorTest, SimpleDistinctTest) {
   ASSERT_TRUE(std::equal(results.cbegin(), results.cend(), expected.cbegin()));
 }
 
+// SELECT DISTINCT l.colB, r.colC FROM test_1 l JOIN test_1 r ON l.colB = r.colB, which repeats every (colB, colC)
+// pair of test_1 about a hundred times, in memory and with a budget that forces the distinct to spill
+TEST_F(ExecutorTest, MultiColumnSpillingDistinctTest) {
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *col_c = MakeColumnValueExpression(schema, 0, "colC");
+  const Schema *scan_schema = MakeOutputSchema({{"colB", col_b}, {"colC", col_c}});
+  auto left_plan = std::make_unique<SeqScanPlanNode>(scan_schema, nullptr, table_info->oid_);
+  auto right_plan = std::make_unique<SeqScanPlanNode>(scan_schema, nullptr, table_info->oid_);
+
+  auto *left_col_b = MakeColumnValueExpression(*scan_schema, 0, "colB");
+  auto *right_col_b = MakeColumnValueExpression(*scan_schema, 1, "colB");
+  auto *right_col_c = MakeColumnValueExpression(*scan_schema, 1, "colC");
+  const Schema *out_schema = MakeOutputSchema({{"colB", left_col_b}, {"colC", right_col_c}});
+  auto join_plan = std::make_unique<HashJoinPlanNode>(
+      out_schema, std::vector<const AbstractPlanNode *>{left_plan.get(), right_plan.get()}, left_col_b, right_col_b);
+  auto distinct_plan = std::make_unique<DistinctPlanNode>(out_schema, join_plan.get());
+
+  std::vector<Tuple> scan_result{};
+  GetExecutionEngine()->Execute(left_plan.get(), &scan_result, GetTxn(), GetExecutorContext());
+  std::unordered_set<int64_t> expected{};
+  for (const auto &tuple : scan_result) {
+    expected.insert(static_cast<int64_t>(tuple.GetValue(scan_schema, 0).GetAs<int32_t>()) * 10000 +
+                    tuple.GetValue(scan_schema, 1).GetAs<int32_t>());
+  }
+
+  for (size_t work_memory : {static_cast<size_t>(WORK_MEMORY_SIZE), static_cast<size_t>(PAGE_SIZE)}) {
+    GetExecutorContext()->SetWorkMemory(work_memory);
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(distinct_plan.get(), &result_set, GetTxn(), GetExecutorContext());
+
+    std::unordered_set<int64_t> pairs{};
+    for (const auto &tuple : result_set) {
+      auto pair = static_cast<int64_t>(tuple.GetValue(out_schema, 0).GetAs<int32_t>()) * 10000 +
+                  tuple.GetValue(out_schema, 1).GetAs<int32_t>();
+      ASSERT_TRUE(pairs.insert(pair).second);
+    }
+    ASSERT_EQ(pairs, expected);
+  }
+  GetExecutorContext()->SetWorkMemory(WORK_MEMORY_SIZE);
+}
+
 }  // namespace bustub
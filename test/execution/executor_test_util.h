@@ -81,6 +81,14 @@ class ExecutorTest : public ::testing::Test {
   /** @return The executor context for our test instance. */
   ExecutorContext *GetExecutorContext() { return exec_ctx_.get(); }
 
+  /** @return A new executor context for our test transaction, whose parallel operators use num_threads threads. */
+  std::unique_ptr<ExecutorContext> MakeExecutorContext(size_t num_threads) {
+    auto exec_ctx =
+        std::make_unique<ExecutorContext>(txn_, catalog_.get(), bpm_.get(), txn_mgr_.get(), lock_manager_.get());
+    exec_ctx->SetNumThreads(num_threads);
+    return exec_ctx;
+  }
+
   /** @return The execution engine for our test instance. */
   ExecutionEngine *GetExecutionEngine() { return execution_engine_.get(); }
 
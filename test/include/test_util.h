@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/config.h"
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/util/string_util.h"
@@ -28,6 +29,13 @@
 
 namespace bustub {
 
+/** Turns logging on while in scope, and back off however the test leaves the scope */
+class LoggingGuard {
+ public:
+  LoggingGuard() { enable_logging = true; }
+  ~LoggingGuard() { enable_logging = false; }
+};
+
 auto ParseCreateStatement(const std::string &sql_base) -> std::unique_ptr<Schema> {
   std::string::size_type n;
   std::vector<Column> v{};
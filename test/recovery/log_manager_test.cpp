@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/** @return the LSNs of the records of the log file, in file order */
+auto ReadLogLsns(DiskManager *disk_manager) -> std::vector<lsn_t> {
+  std::vector<lsn_t> lsns;
+  char header[8];
+  int offset = 0;
+  while (disk_manager->ReadLog(header, sizeof(header), offset)) {
+    int32_t size = *reinterpret_cast<int32_t *>(header);
+    if (size <= 0) {
+      break;
+    }
+    lsns.push_back(*reinterpret_cast<lsn_t *>(header + sizeof(int32_t)));
+    offset += size;
+  }
+  return lsns;
+}
+
+// NOLINTNEXTLINE
+TEST(LogManagerTest, GroupCommitTest) {
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  log_manager->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  // Every commit waits for its record to be on disk, concurrent commits share the writes.
+  const int num_threads = 8;
+  const int commits_per_thread = 200;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([log_manager, t] {
+      lsn_t prev_lsn = INVALID_LSN;
+      for (int i = 0; i < commits_per_thread; i++) {
+        LogRecord begin(t, prev_lsn, LogRecordType::BEGIN);
+        prev_lsn = log_manager->AppendLogRecord(&begin);
+        LogRecord commit(t, prev_lsn, LogRecordType::COMMIT);
+        prev_lsn = log_manager->AppendLogRecord(&commit);
+        log_manager->Flush(prev_lsn);
+        ASSERT_GE(log_manager->GetPersistentLSN(), prev_lsn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_LE(disk_manager->GetNumFlushes(), num_threads * commits_per_thread);
+
+  log_manager->StopFlushThread();
+  ASSERT_FALSE(enable_logging);
+  lsn_t num_records = 2 * num_threads * commits_per_thread;
+  ASSERT_EQ(log_manager->GetNextLSN(), num_records);
+  ASSERT_EQ(log_manager->GetPersistentLSN(), num_records - 1);
+
+  // The records are in the file once each, in LSN order.
+  std::vector<lsn_t> lsns = ReadLogLsns(disk_manager);
+  ASSERT_EQ(lsns.size(), static_cast<size_t>(num_records));
+  for (lsn_t i = 0; i < num_records; i++) {
+    ASSERT_EQ(lsns[i], i);
+  }
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(LogManagerTest, NoFlushThreadTest) {
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+
+  // Without the flush thread, a full buffer is written out by the thread appending to it.
+  int num_records = 0;
+  while (disk_manager->GetNumFlushes() == 0) {
+    LogRecord log_record(0, INVALID_LSN, LogRecordType::NEWPAGE, num_records, num_records + 1);
+    ASSERT_EQ(log_manager->AppendLogRecord(&log_record), num_records);
+    num_records++;
+  }
+  ASSERT_GT(num_records * 28, LOG_BUFFER_SIZE);
+  ASSERT_EQ(log_manager->GetPersistentLSN(), num_records - 2);
+
+  // Flush writes out the rest, waiting for records not appended yet would never end.
+  log_manager->Flush(num_records + 100);
+  ASSERT_EQ(log_manager->GetPersistentLSN(), num_records - 1);
+  ASSERT_EQ(ReadLogLsns(disk_manager).size(), static_cast<size_t>(num_records));
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// Microbenchmark: commits/sec at 1, 2, 4, 8 and 16 client threads, every commit waiting for its log record to be
+// durable. Run with --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST(LogManagerTest, DISABLED_GroupCommitBenchmark) {
+  const int commits_per_thread = 2000;
+  for (int num_threads : {1, 2, 4, 8, 16}) {
+    remove("test.db");
+    remove("test.log");
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    LockManager lock_manager;
+    TransactionManager txn_mgr(&lock_manager, &log_manager);
+    log_manager.RunFlushThread();
+    auto task = [&] {
+      for (int i = 0; i < commits_per_thread; i++) {
+        Transaction *txn = txn_mgr.Begin();
+        txn_mgr.Commit(txn);
+        delete txn;
+      }
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back(task);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    log_manager.StopFlushThread();
+    int64_t commits = static_cast<int64_t>(num_threads) * commits_per_thread;
+    printf("%d threads: %ld commits in %ld ms, %ld commits/s, %d log writes\n", num_threads,  // NOLINT
+           static_cast<long>(commits), static_cast<long>(us / 1000),                        // NOLINT
+           static_cast<long>(commits * 1000000 / std::max<int64_t>(us, 1)), disk_manager.GetNumFlushes());  // NOLINT
+    disk_manager.ShutDown();
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+// Microbenchmark: appends/sec at 1, 2, 4, 8 and 16 threads appending without waiting for the flushes.
+// Run with --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST(LogManagerTest, DISABLED_AppendBenchmark) {
+  const int appends_per_thread = 100000;
+  for (int num_threads : {1, 2, 4, 8, 16}) {
+    remove("test.db");
+    remove("test.log");
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    log_manager.RunFlushThread();
+    auto task = [&](int thread) {
+      for (int i = 0; i < appends_per_thread; i++) {
+        LogRecord log_record(thread, INVALID_LSN, LogRecordType::NEWPAGE, i, i + 1);
+        log_manager.AppendLogRecord(&log_record);
+      }
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back(task, i);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    log_manager.StopFlushThread();
+    int64_t appends = static_cast<int64_t>(num_threads) * appends_per_thread;
+    printf("%d threads: %ld appends in %ld ms, %ld appends/s\n", num_threads, static_cast<long>(appends),  // NOLINT
+           static_cast<long>(us / 1000), static_cast<long>(appends * 1000000 / std::max<int64_t>(us, 1)));  // NOLINT
+    disk_manager.ShutDown();
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
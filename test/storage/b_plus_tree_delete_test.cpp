@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <random>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
@@ -20,7 +21,7 @@
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
+TEST(BPlusTreeTests, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -98,7 +99,7 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
+TEST(BPlusTreeTests, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -175,4 +176,86 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, DuplicateKeyTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // small pages, so the values of a key span several leaves
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int64_t num_keys = 4;
+  const int32_t num_values = 20;
+  std::vector<std::pair<int64_t, int32_t>> entries;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    for (int32_t slot = 0; slot < num_values; slot++) {
+      entries.emplace_back(key, slot);
+    }
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(15445));
+  for (auto [key, slot] : entries) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(0, slot), transaction));
+  }
+  // every key & value pair is stored once
+  index_key.SetFromInteger(2);
+  EXPECT_FALSE(tree.Insert(index_key, RID(0, 7), transaction));
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    ASSERT_EQ(rids.size(), num_values);
+    for (int32_t slot = 0; slot < num_values; slot++) {
+      EXPECT_EQ(rids[slot].GetSlotNum(), slot);
+    }
+  }
+
+  // the iterator walks the values of a key in order across leaves
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).first.ToString(), size / num_values + 1);
+    EXPECT_EQ((*iterator).second.GetSlotNum(), size % num_values);
+    size = size + 1;
+  }
+  EXPECT_EQ(size, num_keys * num_values);
+
+  // removing a value leaves the other values of its key
+  index_key.SetFromInteger(2);
+  for (int32_t slot = 0; slot < num_values; slot += 2) {
+    tree.Remove(index_key, RID(0, slot), transaction);
+  }
+  tree.Remove(index_key, RID(0, 0), transaction);
+  rids.clear();
+  tree.GetValue(index_key, &rids);
+  ASSERT_EQ(rids.size(), num_values / 2);
+  for (int32_t i = 0; i < num_values / 2; i++) {
+    EXPECT_EQ(rids[i].GetSlotNum(), 2 * i + 1);
+  }
+
+  for (auto [key, slot] : entries) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, RID(0, slot), transaction);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
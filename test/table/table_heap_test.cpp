@@ -0,0 +1,785 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_heap_test.cpp
+//
+// Identification: test/table/table_heap_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction_manager.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 128)});
+  auto make_tuple = [&schema](int32_t i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(100, 'x'))}, &schema);
+  };
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  const int num_tuples = 2000;
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rid, transaction));
+    rids.push_back(rid);
+  }
+  size_t num_pages = table->GetFreeSpaceMap()->GetPageCount();
+  ASSERT_GT(num_pages, 10);
+
+  // Free every tuple of the first page. As many tuples again fit into that page and the room left on the last one, so
+  // the heap must not grow, and the last page cannot take them all.
+  size_t freed = 0;
+  for (const auto &rid : rids) {
+    if (rid.GetPageId() == table->GetFirstPageId()) {
+      ASSERT_TRUE(table->MarkDelete(rid, transaction));
+      table->ApplyDelete(rid, transaction);
+      freed++;
+    }
+  }
+  ASSERT_GT(freed, 0);
+  size_t reused = 0;
+  for (size_t i = 0; i < freed; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(num_tuples + i), &rid, transaction));
+    reused += rid.GetPageId() == table->GetFirstPageId() ? 1 : 0;
+  }
+  ASSERT_GT(reused, 0);
+  ASSERT_EQ(table->GetFreeSpaceMap()->GetPageCount(), num_pages);
+
+  size_t count = 0;
+  for (auto it = table->Begin(transaction); it != table->End(); ++it) {
+    count++;
+  }
+  ASSERT_EQ(count, num_tuples);
+
+  // Reopening the table reads the persisted map.
+  uint32_t insert_size = TablePage::GetInsertSize(make_tuple(0));
+  page_id_t expected = table->GetFreeSpaceMap()->FindPage(insert_size);
+  TableHeap reopened(buffer_pool_manager, lock_manager, log_manager, table->GetFirstPageId());
+  ASSERT_EQ(reopened.GetFreeSpaceMap()->GetPageCount(), num_pages);
+  ASSERT_EQ(reopened.GetFreeSpaceMap()->FindPage(insert_size), expected);
+
+  // A table whose first page lost its map pointer rebuilds the map from the page list.
+  auto first_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(table->GetFirstPageId()));
+  first_page->SetFsmPageId(INVALID_PAGE_ID);
+  buffer_pool_manager->UnpinPage(table->GetFirstPageId(), true);
+  TableHeap rebuilt(buffer_pool_manager, lock_manager, log_manager, table->GetFirstPageId());
+  ASSERT_EQ(rebuilt.GetFreeSpaceMap()->GetPageCount(), num_pages);
+  ASSERT_NE(rebuilt.GetFreeSpaceMap()->FindPage(insert_size), INVALID_PAGE_ID);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, PaxPageTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 128), Column("c", TypeId::BIGINT),
+                 Column("d", TypeId::VARCHAR, 128)});
+  auto make_tuple = [&schema](int32_t i, size_t length) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(length, 'a' + i % 26)),
+                  ValueFactory::GetBigIntValue(i * 3L), ValueFactory::GetVarcharValue(std::to_string(i))},
+                 &schema);
+  };
+  auto check_tuple = [&schema](const Tuple &tuple, int32_t i, size_t length) {
+    ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+    ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string(length, 'a' + i % 26));
+    ASSERT_EQ(tuple.GetValue(&schema, 2).GetAs<int64_t>(), i * 3L);
+    ASSERT_EQ(tuple.GetValue(&schema, 3).ToString(), std::to_string(i));
+  };
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table =
+      new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, TablePageFormat::PAX, &schema);
+
+  // Lengths vary so pages run out of varlen heap before they run out of rows and the other way around.
+  const int num_tuples = 1000;
+  auto length_of = [](int32_t i) -> size_t { return i % 7 == 0 ? 200 : i % 5; };
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i, length_of(i)), &rid, transaction));
+    rids.push_back(rid);
+  }
+  ASSERT_GT(table->GetFreeSpaceMap()->GetPageCount(), 1);
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple;
+    ASSERT_TRUE(table->GetTuple(rids[i], &tuple, transaction));
+    check_tuple(tuple, i, length_of(i));
+  }
+
+  // Delete every third tuple, grow every other one in place and shrink the rest, then check all survivors.
+  for (int i = 0; i < num_tuples; i += 3) {
+    ASSERT_TRUE(table->MarkDelete(rids[i], transaction));
+    table->ApplyDelete(rids[i], transaction);
+  }
+  std::vector<size_t> lengths(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    lengths[i] = length_of(i);
+    if (i % 3 != 0) {
+      size_t length = i % 2 == 0 ? lengths[i] + 8 : 0;
+      if (table->UpdateTuple(make_tuple(i, length), rids[i], transaction)) {
+        lengths[i] = length;
+      }
+    }
+  }
+  Tuple tuple;
+  ASSERT_FALSE(table->GetTuple(rids[0], &tuple, transaction));
+  int count = 0;
+  for (auto it = table->Begin(transaction); it != table->End(); ++it) {
+    int32_t i = it->GetValue(&schema, 0).GetAs<int32_t>();
+    ASSERT_NE(i % 3, 0);
+    ASSERT_EQ(it->GetRid(), rids[i]);
+    check_tuple(*it, i, lengths[i]);
+    count++;
+  }
+  ASSERT_EQ(count, num_tuples - (num_tuples + 2) / 3);
+
+  // A reopened table keeps inserting PAX rows, into the room the deletes left.
+  size_t num_pages = table->GetFreeSpaceMap()->GetPageCount();
+  TableHeap reopened(buffer_pool_manager, lock_manager, log_manager, table->GetFirstPageId());
+  for (int i = 0; i < num_tuples; i += 3) {
+    RID rid;
+    ASSERT_TRUE(reopened.InsertTuple(make_tuple(i, 2), &rid, transaction));
+    ASSERT_TRUE(reopened.GetTuple(rid, &tuple, transaction));
+    check_tuple(tuple, i, 2);
+  }
+  ASSERT_EQ(reopened.GetFreeSpaceMap()->GetPageCount(), num_pages);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, CompressedPageTest) {
+  Schema schema({Column("id", TypeId::INTEGER), Column("status", TypeId::VARCHAR, 16), Column("ts", TypeId::BIGINT),
+                 Column("flag", TypeId::BOOLEAN), Column("price", TypeId::DECIMAL)});
+  const std::vector<std::string> statuses{"new", "paid", "shipped"};
+  // Sorted ids and timestamps, a handful of strings and prices: what FOR, DICTIONARY and RLE are made for.
+  auto make_tuple = [&](int32_t i, const std::string &status) {
+    Value id = i == 7 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(i);
+    return Tuple({id, ValueFactory::GetVarcharValue(status), ValueFactory::GetBigIntValue(1600000000000L + i * 1000L),
+                  ValueFactory::GetBooleanValue(i % 2 == 0), ValueFactory::GetDecimalValue((i / 100) * 1.5)},
+                 &schema);
+  };
+  auto check_tuple = [&](const Tuple &tuple, int32_t i, const std::string &status) {
+    if (i == 7) {
+      ASSERT_TRUE(tuple.GetValue(&schema, 0).IsNull());
+    } else {
+      ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+    }
+    ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), status);
+    ASSERT_EQ(tuple.GetValue(&schema, 2).GetAs<int64_t>(), 1600000000000L + i * 1000L);
+    ASSERT_EQ(tuple.GetValue(&schema, 3).GetAs<bool>(), i % 2 == 0);
+    ASSERT_EQ(tuple.GetValue(&schema, 4).GetAs<double>(), (i / 100) * 1.5);
+  };
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table =
+      new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, TablePageFormat::COMPRESSED, &schema);
+  TableHeap slotted(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  // Load both tables in batches, as INSERT does.
+  const int num_tuples = 4000;
+  const int batch_size = 256;
+  std::vector<RID> rids;
+  for (int first = 0; first < num_tuples; first += batch_size) {
+    std::vector<Tuple> batch;
+    for (int i = first; i < std::min(first + batch_size, num_tuples); i++) {
+      batch.push_back(make_tuple(i, statuses[i / 50 % statuses.size()]));
+    }
+    std::vector<RID> batch_rids;
+    ASSERT_TRUE(table->InsertTuples(batch, &batch_rids, transaction));
+    rids.insert(rids.end(), batch_rids.begin(), batch_rids.end());
+    ASSERT_TRUE(slotted.InsertTuples(batch, &batch_rids, transaction));
+  }
+  ASSERT_LT(table->GetFreeSpaceMap()->GetPageCount() * 4, slotted.GetFreeSpaceMap()->GetPageCount());
+  std::vector<std::string> status_of(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    status_of[i] = statuses[i / 50 % statuses.size()];
+    Tuple tuple;
+    ASSERT_TRUE(table->GetTuple(rids[i], &tuple, transaction));
+    check_tuple(tuple, i, status_of[i]);
+  }
+
+  // Delete every fifth tuple and give some of the rest a status no segment has seen, which re-encodes their segments
+  // and moves the segments behind them. A segment that outgrows its page keeps the old row.
+  for (int i = 0; i < num_tuples; i += 5) {
+    ASSERT_TRUE(table->MarkDelete(rids[i], transaction));
+    table->ApplyDelete(rids[i], transaction);
+  }
+  for (int i = 1; i < num_tuples; i += 7) {
+    if (i % 5 != 0) {
+      std::string status = "returned-" + std::to_string(i);
+      if (table->UpdateTuple(make_tuple(i, status), rids[i], transaction)) {
+        status_of[i] = status;
+      }
+    }
+  }
+  Tuple tuple;
+  ASSERT_FALSE(table->GetTuple(rids[0], &tuple, transaction));
+  int count = 0;
+  for (auto it = table->Begin(transaction); it != table->End(); ++it) {
+    int32_t i = it->GetValue(&schema, 0).IsNull() ? 7 : it->GetValue(&schema, 0).GetAs<int32_t>();
+    ASSERT_NE(i % 5, 0);
+    ASSERT_EQ(it->GetRid(), rids[i]);
+    check_tuple(*it, i, status_of[i]);
+    count++;
+  }
+  ASSERT_EQ(count, num_tuples - num_tuples / 5);
+
+  // A reopened table keeps appending compressed segments.
+  TableHeap reopened(buffer_pool_manager, lock_manager, log_manager, table->GetFirstPageId());
+  for (int i = 0; i < num_tuples; i += 500) {
+    RID rid;
+    ASSERT_TRUE(reopened.InsertTuple(make_tuple(i, "new"), &rid, transaction));
+    ASSERT_TRUE(reopened.GetTuple(rid, &tuple, transaction));
+    check_tuple(tuple, i, "new");
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ZoneMapTest) {
+  Schema schema({Column("ts", TypeId::BIGINT), Column("b", TypeId::VARCHAR, 128), Column("c", TypeId::INTEGER)});
+  auto make_tuple = [&schema](int64_t ts, const Value &c) {
+    return Tuple({ValueFactory::GetBigIntValue(ts), ValueFactory::GetVarcharValue(std::string(100, 'x')), c}, &schema);
+  };
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table =
+      new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, TablePageFormat::SLOTTED, &schema);
+  ZoneMap *zone_map = table->GetZoneMap();
+  ASSERT_NE(zone_map, nullptr);
+
+  // Append-only time series: every page covers its own range of ts. Column c is NULL on one row of the first page.
+  const int num_tuples = 1000;
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    Value c = i == 3 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(i % 10);
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i, c), &rid, transaction));
+    rids.push_back(rid);
+  }
+  page_id_t first_page_id = table->GetFirstPageId();
+  page_id_t last_page_id = rids.back().GetPageId();
+  ASSERT_NE(first_page_id, last_page_id);
+
+  ColumnValueExpression ts(0, 0, TypeId::BIGINT);
+  ColumnValueExpression b(0, 1, TypeId::VARCHAR);
+  ColumnValueExpression c(0, 2, TypeId::INTEGER);
+  ConstantValueExpression ts_900(ValueFactory::GetBigIntValue(900));
+  ConstantValueExpression ts_2000(ValueFactory::GetBigIntValue(2000));
+  ConstantValueExpression c_20(ValueFactory::GetIntegerValue(20));
+  ConstantValueExpression b_x(ValueFactory::GetVarcharValue("x"));
+  ComparisonExpression ts_ge_900(&ts, &ts_900, ComparisonType::GreaterThanOrEqual);
+  ComparisonExpression ts_eq_900(&ts_900, &ts, ComparisonType::Equal);
+  ComparisonExpression const_lt_ts(&ts_900, &ts, ComparisonType::LessThan);
+  ComparisonExpression ts_gt_2000(&ts, &ts_2000, ComparisonType::GreaterThan);
+  ComparisonExpression c_gt_20(&c, &c_20, ComparisonType::GreaterThan);
+  ComparisonExpression b_eq_x(&b, &b_x, ComparisonType::Equal);
+
+  // Pages before the one holding ts = 900 are stepped over, also with the constant on the left.
+  ASSERT_EQ(zone_map->Skip(first_page_id, INVALID_PAGE_ID, &ts_ge_900), rids[900].GetPageId());
+  ASSERT_EQ(zone_map->Skip(first_page_id, INVALID_PAGE_ID, &ts_eq_900), rids[900].GetPageId());
+  ASSERT_EQ(zone_map->Skip(first_page_id, INVALID_PAGE_ID, &const_lt_ts), rids[901].GetPageId());
+  ASSERT_EQ(zone_map->Skip(first_page_id, INVALID_PAGE_ID, &ts_gt_2000), INVALID_PAGE_ID);
+  ASSERT_EQ(zone_map->Skip(first_page_id, last_page_id, &ts_gt_2000), last_page_id);
+  // Only the first page, which has a NULL in c, may match, and VARCHAR columns are not tracked.
+  ASSERT_EQ(zone_map->Skip(first_page_id, INVALID_PAGE_ID, &c_gt_20), first_page_id);
+  page_id_t second_page_id = table->GetPageIds()[1];
+  ASSERT_EQ(zone_map->Skip(second_page_id, INVALID_PAGE_ID, &c_gt_20), INVALID_PAGE_ID);
+  ASSERT_EQ(zone_map->Skip(first_page_id, INVALID_PAGE_ID, &b_eq_x), first_page_id);
+
+  // An update widens the zone of its page, so the scan finds the new value.
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(5000, ValueFactory::GetIntegerValue(1)), rids[500], transaction));
+  ASSERT_EQ(zone_map->Skip(first_page_id, INVALID_PAGE_ID, &ts_gt_2000), rids[500].GetPageId());
+  size_t count = 0;
+  for (auto it = table->Begin(transaction, &ts_ge_900, &schema, nullptr); it != table->End(); ++it) {
+    ASSERT_GE(it->GetValue(&schema, 0).GetAs<int64_t>(), 900);
+    count++;
+  }
+  ASSERT_EQ(count, num_tuples - 900 + 1);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+TEST(TableHeapTest, OverflowTest) {
+  Schema schema({Column("id", TypeId::INTEGER), Column("body", TypeId::VARCHAR, 16384),
+                 Column("note", TypeId::VARCHAR, 16384)});
+  Schema out_schema({Column("id", TypeId::INTEGER), Column("note", TypeId::VARCHAR, 16384)});
+  auto make_body = [](int32_t i) { return std::string(3 * PAGE_SIZE + i, static_cast<char>('a' + i % 26)); };
+  auto make_tuple = [&schema](int32_t i, const std::string &body, const std::string &note) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(body),
+                  ValueFactory::GetVarcharValue(note)},
+                 &schema);
+  };
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(10, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table =
+      new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, TablePageFormat::SLOTTED, &schema);
+
+  // Every body takes more than three pages. It is moved out, and what is left of the tuples shares a page.
+  const int num_tuples = 20;
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i, make_body(i), "note" + std::to_string(i)), &rid, transaction));
+    rids.push_back(rid);
+  }
+  ASSERT_EQ(table->GetPageIds().size(), 1);
+
+  Tuple tuple;
+  ASSERT_TRUE(table->GetTuple(rids[7], &tuple, transaction));
+  ASSERT_LE(tuple.GetLength(), TableHeap::TOAST_THRESHOLD);
+  ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), make_body(7));
+  ASSERT_EQ(tuple.GetValue(&schema, 2).ToString(), "note7");
+  Tuple copy = tuple;
+  ASSERT_EQ(copy.GetValue(&schema, 1).ToString(), make_body(7));
+
+  // A scan projecting the short columns, and one returning the stored tuples, which read the body when asked.
+  int32_t count = 0;
+  for (auto it = table->Begin(transaction, nullptr, &schema, &out_schema); it != table->End(); ++it) {
+    int32_t id = it->GetValue(&out_schema, 0).GetAs<int32_t>();
+    ASSERT_EQ(it->GetValue(&out_schema, 1).ToString(), "note" + std::to_string(id));
+    count++;
+  }
+  ASSERT_EQ(count, num_tuples);
+  for (auto it = table->Begin(transaction); it != table->End(); ++it) {
+    ASSERT_EQ(it->GetValue(&schema, 1).ToString(), make_body(it->GetValue(&schema, 0).GetAs<int32_t>()));
+  }
+
+  // Of two values together too long, only the longer one has to move. Short tuples stay as they are.
+  std::string long_note(TableHeap::TOAST_THRESHOLD / 2, 'n');
+  std::string longer_note(TableHeap::TOAST_THRESHOLD / 2 + 10, 'm');
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(100, long_note, longer_note), &rid, transaction));
+  ASSERT_TRUE(table->GetTuple(rid, &tuple, transaction));
+  ASSERT_GT(tuple.GetLength(), long_note.size());
+  ASSERT_LE(tuple.GetLength(), TableHeap::TOAST_THRESHOLD);
+  ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), long_note);
+  ASSERT_EQ(tuple.GetValue(&schema, 2).ToString(), longer_note);
+  Tuple short_tuple = make_tuple(101, "short", "x");
+  ASSERT_TRUE(table->InsertTuple(short_tuple, &rid, transaction));
+  ASSERT_TRUE(table->GetTuple(rid, &tuple, transaction));
+  ASSERT_EQ(tuple.GetLength(), short_tuple.GetLength());
+  ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), "short");
+
+  // An update moves the new version's body out too, and the replaced version can be put back.
+  std::string new_body(2 * PAGE_SIZE, 'z');
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(7, new_body, "updated"), rids[7], transaction));
+  ASSERT_TRUE(table->GetTuple(rids[7], &tuple, transaction));
+  ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), new_body);
+  ASSERT_EQ(tuple.GetValue(&schema, 2).ToString(), "updated");
+  Tuple old_version = transaction->GetWriteSet()->back().tuple_;
+  table->RollbackUpdate(old_version, rids[7], transaction);
+  ASSERT_TRUE(table->GetTuple(rids[7], &tuple, transaction));
+  ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), make_body(7));
+  ASSERT_EQ(tuple.GetValue(&schema, 2).ToString(), "note7");
+
+  // Deleting a tuple frees its chain, the others are still there.
+  ASSERT_TRUE(table->MarkDelete(rids[3], transaction));
+  table->ApplyDelete(rids[3], transaction);
+  ASSERT_FALSE(table->GetTuple(rids[3], &tuple, transaction));
+  ASSERT_TRUE(table->GetTuple(rids[4], &tuple, transaction));
+  ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), make_body(4));
+
+  // A heap that does not know its schema cannot move values, a tuple larger than a page still does not fit.
+  auto *plain = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  ASSERT_FALSE(plain->InsertTuple(make_tuple(0, make_body(0), ""), &rid, transaction));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete plain;
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, VacuumTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 128)});
+  auto make_tuple = [&schema](int32_t i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(100, 'x'))}, &schema);
+  };
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+  Transaction *transaction = txn_mgr->Begin();
+  auto *table =
+      new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, TablePageFormat::SLOTTED, &schema);
+
+  // Delete three tuples out of four. The slots of the deleted tuples at the end of a page can be given back.
+  const int num_tuples = 2000;
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rid, transaction));
+    rids.push_back(rid);
+  }
+  std::vector<page_id_t> page_ids = table->GetPageIds();
+  ASSERT_GT(page_ids.size(), 10);
+  std::vector<bool> deleted(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    if (i % 4 != 0) {
+      ASSERT_TRUE(table->MarkDelete(rids[i], transaction));
+      deleted[i] = true;
+    }
+  }
+  txn_mgr->Commit(transaction);
+  delete transaction;
+  transaction = txn_mgr->Begin();
+  // The number of slots at the end of their page whose tuples are gone.
+  auto trailing = [&]() {
+    size_t count = 0;
+    for (int i = 0; i < num_tuples; i++) {
+      if (i + 1 < num_tuples && rids[i + 1].GetPageId() == rids[i].GetPageId()) {
+        continue;
+      }
+      for (int j = i; j >= 0 && rids[j].GetPageId() == rids[i].GetPageId() && deleted[j]; j--) {
+        count++;
+      }
+    }
+    return count;
+  };
+
+  // The last tuple of the heap is deleted by a transaction still running, its slot stays until the delete is applied.
+  Transaction *writer = txn_mgr->Begin();
+  ASSERT_TRUE(table->MarkDelete(rids[num_tuples - 4], writer));
+  size_t reclaimed = trailing();
+  ASSERT_GT(reclaimed, 0);
+  ASSERT_EQ(table->Vacuum(), reclaimed);
+  ASSERT_EQ(table->Vacuum(), 0);
+  txn_mgr->Commit(writer);
+  delete writer;
+  deleted[num_tuples - 4] = true;
+  ASSERT_EQ(table->Vacuum(), trailing() - reclaimed);
+  reclaimed = trailing();
+
+  // No tuple moved, and no page went away.
+  ASSERT_EQ(table->GetPageIds(), page_ids);
+  for (int i = 0; i < num_tuples - 4; i += 4) {
+    Tuple tuple;
+    ASSERT_TRUE(table->GetTuple(rids[i], &tuple, transaction));
+    ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+  }
+  int32_t count = 0;
+  for (auto it = table->Begin(transaction); it != table->End(); ++it) {
+    ASSERT_EQ(it->GetValue(&schema, 0).GetAs<int32_t>() % 4, 0);
+    count++;
+  }
+  ASSERT_EQ(count, num_tuples / 4 - 1);
+  txn_mgr->Commit(transaction);
+  delete transaction;
+
+  // With logging, the slots are given back all the same: empty the last page.
+  {
+    LoggingGuard logging;
+    log_manager->RunFlushThread();
+    transaction = txn_mgr->Begin();
+    for (int i = 0; i < num_tuples; i++) {
+      if (!deleted[i] && rids[i].GetPageId() == page_ids.back()) {
+        ASSERT_TRUE(table->MarkDelete(rids[i], transaction));
+        deleted[i] = true;
+      }
+    }
+    txn_mgr->Commit(transaction);
+    delete transaction;
+    ASSERT_EQ(table->Vacuum(), trailing() - reclaimed);
+    ASSERT_EQ(table->GetPageIds(), page_ids);
+    log_manager->StopFlushThread();
+  }
+
+  // New tuples go to the room made on the pages, a reopened table finds it in its map.
+  transaction = txn_mgr->Begin();
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(num_tuples), &rid, transaction));
+  ASSERT_EQ(table->GetPageIds(), page_ids);
+  TableHeap reopened(buffer_pool_manager, lock_manager, log_manager, table->GetFirstPageId());
+  ASSERT_EQ(reopened.GetPageIds(), page_ids);
+  txn_mgr->Commit(transaction);
+  delete transaction;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, SnapshotTest) {
+  Schema schema({Column("id", TypeId::INTEGER), Column("body", TypeId::VARCHAR, 16384)});
+  auto make_tuple = [&schema](int32_t id, const std::string &body) {
+    return Tuple({ValueFactory::GetIntegerValue(id), ValueFactory::GetVarcharValue(body)}, &schema);
+  };
+  auto read = [&schema](TableHeap *table, const RID &rid, Transaction *txn) {
+    Tuple tuple;
+    return table->GetTuple(rid, &tuple, txn) ? tuple.GetValue(&schema, 0).GetAs<int32_t>() : -1;
+  };
+  auto scan = [&schema](TableHeap *table, Transaction *txn) {
+    std::vector<int32_t> ids;
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      ids.push_back(it->GetValue(&schema, 0).GetAs<int32_t>());
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+  // Versions are only kept with logging, like the locks.
+  LoggingGuard logging;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+
+  // Row 2 has its body on overflow pages.
+  Transaction *loader = txn_mgr->Begin();
+  auto *table =
+      new TableHeap(buffer_pool_manager, lock_manager, log_manager, loader, TablePageFormat::SLOTTED, &schema);
+  std::string long_body(2 * PAGE_SIZE, 'l');
+  std::vector<RID> rids(5);
+  for (int32_t i = 0; i < 5; i++) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i, i == 2 ? long_body : "body"), &rids[i], loader));
+  }
+  txn_mgr->Commit(loader);
+  delete loader;
+
+  // Changes committed after a snapshot began are not seen through it, neither by reads nor by scans.
+  Transaction *snapshot = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT);
+  Transaction *writer = txn_mgr->Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(100, "body"), rids[0], writer));
+  ASSERT_TRUE(table->MarkDelete(rids[1], writer));
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(2, std::string(3 * PAGE_SIZE, 'n')), rids[2], writer));
+  RID new_rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(50, "body"), &new_rid, writer));
+  ASSERT_EQ(read(table, rids[0], snapshot), 0);
+  txn_mgr->Commit(writer);
+  delete writer;
+
+  ASSERT_EQ(read(table, rids[0], snapshot), 0);
+  ASSERT_EQ(read(table, rids[1], snapshot), 1);
+  ASSERT_EQ(read(table, new_rid, snapshot), -1);
+  Tuple tuple;
+  ASSERT_TRUE(table->GetTuple(rids[2], &tuple, snapshot));
+  ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), long_body);
+  ASSERT_EQ(scan(table, snapshot), (std::vector<int32_t>{0, 1, 2, 3, 4}));
+  Transaction *later = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT);
+  ASSERT_EQ(scan(table, later), (std::vector<int32_t>{2, 3, 4, 50, 100}));
+
+  // A scan reads the versions of a page once, and again when a writer changes a row of the page it is on.
+  auto it = table->Begin(later);
+  ASSERT_EQ(it->GetValue(&schema, 0).GetAs<int32_t>(), 100);
+  writer = txn_mgr->Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(400, "body"), rids[4], writer));
+  txn_mgr->Commit(writer);
+  delete writer;
+  std::vector<int32_t> ids;
+  for (++it; it != table->End(); ++it) {
+    ids.push_back(it->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  std::sort(ids.begin(), ids.end());
+  ASSERT_EQ(ids, (std::vector<int32_t>{2, 3, 4, 50}));
+
+  // A snapshot sees its own writes, and cannot overwrite a row changed since it began.
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(300, "body"), rids[3], snapshot));
+  ASSERT_EQ(read(table, rids[3], snapshot), 300);
+  ASSERT_EQ(read(table, rids[3], later), 3);
+  ASSERT_FALSE(table->UpdateTuple(make_tuple(200, "body"), rids[0], snapshot));
+  ASSERT_EQ(snapshot->GetState(), TransactionState::ABORTED);
+  txn_mgr->Abort(snapshot);
+  delete snapshot;
+  ASSERT_EQ(read(table, rids[3], later), 3);
+  txn_mgr->Commit(later);
+  delete later;
+
+  // With no snapshot left, the next commit drops the versions nobody reads any more.
+  ASSERT_TRUE(table->GetVersionStore()->HasVersions(rids[0].GetPageId()));
+  writer = txn_mgr->Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(4, "new body"), rids[4], writer));
+  txn_mgr->Commit(writer);
+  delete writer;
+  ASSERT_FALSE(table->GetVersionStore()->HasVersions(rids[0].GetPageId()));
+  Transaction *reader = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT);
+  ASSERT_EQ(scan(table, reader), (std::vector<int32_t>{2, 3, 4, 50, 100}));
+  txn_mgr->Commit(reader);
+  delete reader;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, SnapshotTransferTest) {
+  Schema schema({Column("balance", TypeId::INTEGER)});
+  auto balance = [&schema](const Tuple &tuple) { return tuple.GetValue(&schema, 0).GetAs<int32_t>(); };
+  LoggingGuard logging;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+
+  const int num_accounts = 20;
+  const int32_t initial = 100;
+  Transaction *loader = txn_mgr->Begin();
+  auto *table =
+      new TableHeap(buffer_pool_manager, lock_manager, log_manager, loader, TablePageFormat::SLOTTED, &schema);
+  std::vector<RID> rids(num_accounts);
+  for (int i = 0; i < num_accounts; i++) {
+    ASSERT_TRUE(table->InsertTuple(Tuple({ValueFactory::GetIntegerValue(initial)}, &schema), &rids[i], loader));
+  }
+  txn_mgr->Commit(loader);
+  delete loader;
+
+  // Writers move money between accounts while snapshots add it up, which always finds every transfer whole.
+  std::atomic<bool> done{false};
+  std::atomic<int> bad_sums{0};
+  std::vector<std::thread> threads;
+  for (int w = 0; w < 2; w++) {
+    threads.emplace_back([&, w] {
+      std::mt19937 rng(w);
+      for (int i = 0; i < 300; i++) {
+        RID from = rids[rng() % num_accounts];
+        RID to = rids[rng() % num_accounts];
+        Transaction *txn = txn_mgr->Begin();
+        // Lock both rows up front, the locks would otherwise be taken under the page latch.
+        Tuple tuple;
+        bool ok = lock_manager->LockExclusive(txn, from) && (to == from || lock_manager->LockExclusive(txn, to)) &&
+                  table->GetTuple(from, &tuple, txn) &&
+                  table->UpdateTuple(Tuple({ValueFactory::GetIntegerValue(balance(tuple) - 1)}, &schema), from, txn) &&
+                  table->GetTuple(to, &tuple, txn) &&
+                  table->UpdateTuple(Tuple({ValueFactory::GetIntegerValue(balance(tuple) + 1)}, &schema), to, txn);
+        if (ok && txn->GetState() != TransactionState::ABORTED) {
+          txn_mgr->Commit(txn);
+        } else {
+          txn_mgr->Abort(txn);
+        }
+        delete txn;
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    while (!done) {
+      Transaction *txn = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT);
+      int32_t sum = 0;
+      for (auto it = table->Begin(txn); it != table->End(); ++it) {
+        sum += balance(*it);
+      }
+      if (sum != num_accounts * initial) {
+        bad_sums++;
+      }
+      txn_mgr->Commit(txn);
+      delete txn;
+    }
+  });
+  threads[0].join();
+  threads[1].join();
+  done = true;
+  threads[2].join();
+  ASSERT_EQ(bad_sums, 0);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+}  // namespace bustub